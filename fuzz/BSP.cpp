@@ -0,0 +1,33 @@
+#include <MOHPC/Formats/BSP.h>
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Managers/FileManager.h>
+#include "FuzzTarget.h"
+
+/**
+ * Load the input as a level.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	using namespace MOHPC;
+
+	static constexpr char fileName[] = "/maps/fuzz.bsp";
+	static const AssetManagerPtr AM = AssetManager::create();
+
+	FileManager* FM = AM->GetFileManager();
+	FM->AddMemoryFile(fileName, data, size);
+
+	try
+	{
+		// not kept, so the next input is loaded again
+		AM->LoadAsset<BSP>(fileName);
+	}
+	catch (AssetError::Base&)
+	{
+	}
+	catch (BSPError::Base&)
+	{
+	}
+
+	FM->RemoveMemoryFile(fileName);
+	return 0;
+}
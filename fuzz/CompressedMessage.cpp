@@ -0,0 +1,28 @@
+#include <MOHPC/Misc/MSG/MSG.h>
+#include <MOHPC/Misc/MSG/Stream.h>
+#include <MOHPC/Network/Types.h>
+#include "FuzzTarget.h"
+
+/**
+ * Decompress the input like the server decompresses the connect command.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	using namespace MOHPC;
+
+	FixedDataMessageStream compressedStream((void*)data, size);
+
+	uint8_t uncompressed[Network::MAX_UDP_DATA_SIZE];
+	FixedDataMessageStream uncompressedStream(uncompressed, sizeof(uncompressed));
+
+	try
+	{
+		CompressedMessage compressedMessage(compressedStream, uncompressedStream);
+		compressedMessage.Decompress(0, sizeof(uncompressed));
+	}
+	catch (StreamMessageException&)
+	{
+	}
+
+	return 0;
+}
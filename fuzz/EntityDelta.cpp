@@ -0,0 +1,132 @@
+#include <MOHPC/Misc/MSG/MSG.h>
+#include <MOHPC/Misc/MSG/Stream.h>
+#include <MOHPC/Misc/MSG/Codec.h>
+#include <MOHPC/Network/InfoTypes.h>
+#include <MOHPC/Network/SerializableTypes.h>
+#include "FuzzTarget.h"
+
+#include <memory>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+// the client never reads more than that in a snapshot
+static constexpr size_t maxDeltas = MAX_ENTITIES_IN_SNAPSHOT;
+
+static void readEntities(MSG& msg, bool scrambled)
+{
+	MsgTypesHelper msgHelper(msg);
+
+	// each state is delta'd from the previous one, the first from nothing
+	std::unique_ptr<entityState_t[]> states(new entityState_t[2]);
+	entityState_t* from = nullptr;
+
+	for (size_t i = 0; i < maxDeltas; ++i)
+	{
+		const entityNum_t newNum = scrambled ? msgHelper.ReadEntityNum2() : msgHelper.ReadEntityNum();
+		entityState_t& to = states[i & 1];
+
+		if (scrambled)
+		{
+			SerializableEntityState_ver15 toSerialize(to, newNum);
+			if (from)
+			{
+				SerializableEntityState_ver15 fromSerialize(*from, newNum);
+				msg.ReadDeltaClass(&fromSerialize, &toSerialize);
+			}
+			else {
+				msg.ReadDeltaClass(nullptr, &toSerialize);
+			}
+		}
+		else
+		{
+			SerializableEntityState toSerialize(to, newNum);
+			if (from)
+			{
+				SerializableEntityState fromSerialize(*from, newNum);
+				msg.ReadDeltaClass(&fromSerialize, &toSerialize);
+			}
+			else {
+				msg.ReadDeltaClass(nullptr, &toSerialize);
+			}
+		}
+
+		from = &to;
+	}
+}
+
+static void readPlayerStates(MSG& msg, bool scrambled)
+{
+	std::unique_ptr<playerState_t[]> states(new playerState_t[2]);
+	playerState_t* from = nullptr;
+
+	for (size_t i = 0; i < maxDeltas; ++i)
+	{
+		playerState_t& to = states[i & 1];
+
+		if (scrambled)
+		{
+			SerializablePlayerState_ver15 toSerialize(to);
+			if (from)
+			{
+				SerializablePlayerState_ver15 fromSerialize(*from);
+				msg.ReadDeltaClass(&fromSerialize, &toSerialize);
+			}
+			else {
+				msg.ReadDeltaClass(nullptr, &toSerialize);
+			}
+		}
+		else
+		{
+			SerializablePlayerState toSerialize(to);
+			if (from)
+			{
+				SerializablePlayerState fromSerialize(*from);
+				msg.ReadDeltaClass(&fromSerialize, &toSerialize);
+			}
+			else {
+				msg.ReadDeltaClass(nullptr, &toSerialize);
+			}
+		}
+
+		from = &to;
+	}
+}
+
+/**
+ * Read a chain of entity or player state deltas from the input, until the input ends.
+ * The first byte selects what to read: bit 0 for the protocol >= 15 fields, bit 1 for player states.
+ * The rest is the bit stream, like in a snapshot.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if (!size) {
+		return 0;
+	}
+
+	const bool scrambled = (data[0] & 1) != 0;
+	const bool playerStates = (data[0] & 2) != 0;
+
+	FixedDataMessageStream stream((void*)(data + 1), size - 1);
+	MSG msg(stream, msgMode_e::Reading);
+	msg.SetCodec(MessageCodecs::Bit);
+
+	try
+	{
+		if (playerStates) {
+			readPlayerStates(msg, scrambled);
+		}
+		else {
+			readEntities(msg, scrambled);
+		}
+	}
+	catch (NetworkException&)
+	{
+	}
+	catch (StreamMessageException&)
+	{
+		// the end of the input
+	}
+
+	return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Entry point of a fuzz target, called with each input.
+ * Inputs that the parser rejects with one of its errors are not crashes, only undefined behaviors and aborts are.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
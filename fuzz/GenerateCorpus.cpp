@@ -0,0 +1,233 @@
+#include <MOHPC/Formats/BSP.h>
+#include <MOHPC/Network/Capture.h>
+#include <MOHPC/Network/Configstring.h>
+#include <MOHPC/Network/InfoTypes.h>
+#include <MOHPC/Network/SerializableTypes.h>
+#include <MOHPC/Network/Server/CaptureGenerator.h>
+#include <MOHPC/Misc/MSG/Codec.h>
+#include <MOHPC/Misc/MSG/MSG.h>
+#include <MOHPC/Misc/MSG/Stream.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+/**
+ * Write the synthetic seeds of the binary fuzz targets.
+ * Text seeds (scripts and TIKI) are written by hand in the corpus directory.
+ */
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+namespace fs = std::filesystem;
+
+static void writeSeed(const fs::path& dir, const char* name, const void* data, size_t size)
+{
+	fs::create_directories(dir);
+
+	const fs::path path = dir / name;
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char*)data, size);
+
+	printf("%s (%zu bytes)\n", path.generic_string().c_str(), size);
+}
+
+static void generateCaptures(const fs::path& dir)
+{
+	static constexpr uint32_t challenge = 0x1234abcd;
+
+	struct seed_t
+	{
+		const char* name;
+		size_t numEntities;
+		size_t numSnapshots;
+	};
+
+	static const seed_t seeds[] =
+	{
+		{ "gamestate.cap", 4, 0 },
+		{ "snapshots.cap", 4, 4 },
+		{ "entities.cap", 32, 2 }
+	};
+
+	for (const seed_t& seed : seeds)
+	{
+		PacketCapture capture;
+		CaptureGenerator generator(challenge);
+		generator.setNumEntities(seed.numEntities);
+		generator.generate(capture, seed.numSnapshots);
+
+		DynamicDataMessageStream stream;
+		capture.save(stream);
+		writeSeed(dir, seed.name, stream.getStorage(), stream.GetLength());
+	}
+}
+
+static void writeDeltaSeed(const fs::path& dir, const char* name, uint8_t selector, void (*writeStates)(MSG&, bool))
+{
+	DynamicDataMessageStream stream;
+	stream.Write(&selector, sizeof(selector));
+
+	{
+		MSG msg(stream, msgMode_e::Writing);
+		msg.SetCodec(MessageCodecs::Bit);
+		writeStates(msg, (selector & 1) != 0);
+		msg.Flush();
+	}
+
+	writeSeed(dir, name, stream.getStorage(), stream.GetLength());
+}
+
+static void writeEntities(MSG& msg, bool scrambled)
+{
+	MsgTypesHelper msgHelper(msg);
+
+	// the first one is delta'd from the null state
+	entityState_t from;
+	entityState_t to;
+	for (size_t i = 0; i < 4; ++i)
+	{
+		const entityNum_t num = (entityNum_t)(MAX_CLIENTS + i);
+		to.number = num;
+		to.eType = entityType_e::modelanim;
+		to.modelindex = (uint16_t)(1 + i);
+		to.netorigin = Vector(i * 64.f, i * -32.f, 16.f);
+		to.origin = to.netorigin;
+		to.netangles = Vector(0.f, i * 45.f, 0.f);
+		to.angles = to.netangles;
+		to.frameInfo[0].time = i * 0.1f;
+
+		if (scrambled) {
+			msgHelper.WriteEntityNum2(num);
+		}
+		else {
+			msgHelper.WriteEntityNum(num);
+		}
+
+		// there is no writer for protocol 15 fields, these are close enough for a seed
+		SerializableEntityState fromSerialize(from, num);
+		SerializableEntityState toSerialize(to, num);
+		msg.WriteDeltaClass(&fromSerialize, &toSerialize);
+
+		from = to;
+	}
+}
+
+static void writePlayerStates(MSG& msg, bool scrambled)
+{
+	playerState_t from;
+	playerState_t to;
+	for (size_t i = 0; i < 4; ++i)
+	{
+		to.commandTime = 10000 + (uint32_t)i * 50;
+		to.origin = Vector(i * 16.f, 0.f, 0.f);
+		to.velocity = Vector(250.f, 0.f, 0.f);
+		to.viewangles = Vector(0.f, i * 10.f, 0.f);
+
+		SerializablePlayerState fromSerialize(from);
+		SerializablePlayerState toSerialize(to);
+		msg.WriteDeltaClass(&fromSerialize, &toSerialize);
+
+		from = to;
+	}
+}
+
+static void generateDeltas(const fs::path& dir)
+{
+	// see EntityDelta.cpp for the first byte
+	writeDeltaSeed(dir, "entities", 0, &writeEntities);
+	writeDeltaSeed(dir, "entities_ver15", 1, &writeEntities);
+	writeDeltaSeed(dir, "playerstates", 2, &writePlayerStates);
+	writeDeltaSeed(dir, "playerstates_ver15", 3, &writePlayerStates);
+}
+
+static void generateCompressed(const fs::path& dir)
+{
+	static const char connectArgs[] = "\"\\challenge\\-12345\\qport\\1234\\protocol\\8\\name\\UnnamedSoldier\\rate\\5000\\snaps\\20\"";
+
+	DynamicDataMessageStream compressedStream;
+	DynamicDataMessageStream uncompressedStream;
+	uncompressedStream.Write(connectArgs, sizeof(connectArgs));
+	uncompressedStream.Seek(0);
+
+	CompressedMessage compression(uncompressedStream, compressedStream);
+	compression.Compress(0, sizeof(connectArgs));
+
+	writeSeed(dir, "connect", compressedStream.getStorage(), compressedStream.GetLength());
+}
+
+static void generateLevel(const fs::path& dir)
+{
+	// same layout as the level header
+	static constexpr size_t numLumps = 28;
+	static constexpr size_t lumpShaders = 0;
+	static constexpr size_t lumpPlanes = 1;
+	static constexpr size_t lumpLightmaps = 2;
+	static constexpr size_t lumpModels = 13;
+	static constexpr size_t lumpEntities = 14;
+	static constexpr size_t headerSize = 12 + numLumps * 8;
+
+	static const char entityString[] = "{\n\"classname\" \"worldspawn\"\n}\n";
+
+	std::vector<uint8_t> level(headerSize, 0);
+	memcpy(level.data(), "2015", 4);
+	// version 19 (Allied Assault) in little-endian
+	level[4] = 19;
+
+	auto addLump = [&level](size_t lumpNum, const void* data, size_t size)
+	{
+		const uint32_t offset = (uint32_t)level.size();
+		const uint32_t length = (uint32_t)size;
+		uint8_t* lump = level.data() + 12 + lumpNum * 8;
+		for (size_t i = 0; i < 4; ++i)
+		{
+			lump[i] = (uint8_t)(offset >> (i * 8));
+			lump[4 + i] = (uint8_t)(length >> (i * 8));
+		}
+
+		level.insert(level.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+	};
+
+	// shader name, surface flags, content flags, subdivisions and fence mask
+	uint8_t shader[140] = { 0 };
+	strcpy((char*)shader, "textures/common/caulk");
+	addLump(lumpShaders, shader, sizeof(shader));
+
+	// floor plane
+	const float plane[4] = { 0.f, 0.f, 1.f, 0.f };
+	addLump(lumpPlanes, plane, sizeof(plane));
+
+	// a single grey lightmap
+	const std::vector<uint8_t> lightmap(BSPData::lightmapMemSize, 128);
+	addLump(lumpLightmaps, lightmap.data(), lightmap.size());
+
+	// the world model, without any surface or brush
+	const float worldModel[10] = { -512.f, -512.f, -512.f, 512.f, 512.f, 512.f, 0.f, 0.f, 0.f, 0.f };
+	addLump(lumpModels, worldModel, sizeof(worldModel));
+
+	addLump(lumpEntities, entityString, sizeof(entityString));
+
+	writeSeed(dir, "empty.bsp", level.data(), level.size());
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <corpus directory>\n", argv[0]);
+		return 1;
+	}
+
+	const fs::path root = argv[1];
+	generateCaptures(root / "ServerMessage");
+	generateDeltas(root / "EntityDelta");
+	generateCompressed(root / "CompressedMessage");
+	generateLevel(root / "BSP");
+
+	return 0;
+}
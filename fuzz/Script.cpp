@@ -0,0 +1,28 @@
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Script/GameScript.h>
+#include <MOHPC/Script/ScriptException.h>
+#include "FuzzTarget.h"
+
+/**
+ * Preprocess, parse and compile the input as a script.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	using namespace MOHPC;
+
+	static const AssetManagerPtr AM = AssetManager::create();
+
+	GameScript* scr = new GameScript();
+	scr->InitAssetManager(AM);
+
+	try
+	{
+		scr->Load(data, size);
+	}
+	catch (ScriptException&)
+	{
+	}
+
+	delete scr;
+	return 0;
+}
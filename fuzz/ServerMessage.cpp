@@ -0,0 +1,56 @@
+#include <MOHPC/Managers/NetworkManager.h>
+#include <MOHPC/Network/Capture.h>
+#include <MOHPC/Network/Channel.h>
+#include <MOHPC/Network/Client/ClientGame.h>
+#include <MOHPC/Network/Client/UserInfo.h>
+#include <MOHPC/Misc/MSG/Stream.h>
+#include "FuzzTarget.h"
+
+/**
+ * Replay the input into a client game connection, the way a server would send it.
+ * The input is a packet capture (see PacketCapture::save()), it holds the protocol,
+ * the challenge and the datagrams, so the gamestate can be followed by snapshots delta'd from it.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	using namespace MOHPC;
+	using namespace MOHPC::Network;
+
+	const PacketCapturePtr capture = PacketCapture::create();
+	try
+	{
+		FixedDataMessageStream stream((void*)data, size);
+		capture->load(stream);
+	}
+	catch (CaptureError::Base&)
+	{
+		return 0;
+	}
+
+	const NetworkManagerPtr manager = makeShared<NetworkManager>();
+	NetAddr4Ptr adr = NetAddr4::create();
+
+	const ReplaySocketPtr socket = ReplaySocket::create(capture, adr, replayMode_e::AsFastAsPossible);
+	try
+	{
+		const ClientGameConnectionPtr connection = ClientGameConnection::create(
+			manager,
+			makeShared<Netchan>(socket, 1),
+			adr,
+			capture->getChallenge(),
+			capture->getProtocol(),
+			ClientInfo::create()
+		);
+		connection->initTime(getCurrentTime());
+
+		// the connection stops reading once the server disconnected it
+		for (size_t i = 0; i < capture->getNumPackets() && !socket->isFinished(); ++i) {
+			manager->processTicks();
+		}
+	}
+	catch (NetworkException&)
+	{
+	}
+
+	return 0;
+}
@@ -0,0 +1,51 @@
+#include "FuzzTarget.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static void runFile(const fs::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	const std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	printf("Running %s (%zu bytes)\n", path.generic_string().c_str(), input.size());
+	LLVMFuzzerTestOneInput(input.data(), input.size());
+}
+
+/**
+ * Used when the compiler doesn't provide libFuzzer.
+ * Each argument is an input file or a directory of inputs (a corpus), all inputs are run once.
+ */
+int main(int argc, char* argv[])
+{
+	size_t numInputs = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const fs::path path = argv[i];
+		if (fs::is_directory(path))
+		{
+			for (const fs::directory_entry& entry : fs::recursive_directory_iterator(path))
+			{
+				if (entry.is_regular_file())
+				{
+					runFile(entry.path());
+					++numInputs;
+				}
+			}
+		}
+		else
+		{
+			runFile(path);
+			++numInputs;
+		}
+	}
+
+	printf("%zu inputs executed\n", numInputs);
+	return 0;
+}
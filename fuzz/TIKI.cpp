@@ -0,0 +1,30 @@
+#include <MOHPC/Formats/TIKI.h>
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Managers/FileManager.h>
+#include "FuzzTarget.h"
+
+/**
+ * Load the input as a TIKI, skeletons and animations it refers to don't exist.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	using namespace MOHPC;
+
+	static constexpr char fileName[] = "/models/fuzz.tik";
+	static const AssetManagerPtr AM = AssetManager::create();
+
+	FileManager* FM = AM->GetFileManager();
+	FM->AddMemoryFile(fileName, data, size);
+
+	try
+	{
+		// not kept, so the next input is loaded again
+		AM->LoadAsset<TIKI>(fileName);
+	}
+	catch (AssetError::Base&)
+	{
+	}
+
+	FM->RemoveMemoryFile(fileName);
+	return 0;
+}
@@ -22,8 +22,12 @@ namespace MOHPC
 		/** Returns the filename of the asset. */
 		MOHPC_EXPORTS const str& GetFilename() const;
 
-		/** Returns the 20-bit hash for this asset. */
-		MOHPC_EXPORTS void HashGetHash(uint8_t* Destination) const;
+		/**
+		 * Get the 20-byte SHA-1 hash of this asset.
+		 *
+		 * @return	false if asset hashing wasn't enabled in the asset manager when the asset was loaded.
+		 */
+		MOHPC_EXPORTS bool HashGetHash(uint8_t* Destination) const;
 
 	protected:
 		MOHPC_EXPORTS Asset();
@@ -31,6 +35,7 @@ namespace MOHPC
 	private:
 		// Called by the asset manager
 		void Init(const char *Filename);
+		void HashInit();
 		void HashFinalize();
 
 	protected:
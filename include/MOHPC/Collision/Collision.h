@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include "../Math.h"
 #include "../Vector.h"
 #include "../Utilities/SharedPtr.h"
@@ -75,6 +76,23 @@ namespace MOHPC
 		}
 	};
 
+	/**
+	 * Compact BSP node, the plane is packed with the children in a single 32 bytes record.
+	 * Nodes are stored in depth-first order so the front child is always next to its parent.
+	 */
+	struct MOHPC_EXPORTS collisionFlatNode_t
+	{
+		float normal[3];
+		float dist;
+		// negative numbers are leafs
+		int32_t children[2];
+		uint8_t type;
+		uint8_t signbits;
+		uint8_t padding[6];
+	};
+
+	static_assert(sizeof(collisionFlatNode_t) == 32, "collisionFlatNode_t must stay 32 bytes long");
+
 	struct MOHPC_EXPORTS collisionLeaf_t
 	{
 		int32_t cluster;
@@ -228,7 +246,6 @@ namespace MOHPC
 
 	struct MOHPC_EXPORTS collisionTerrain_t
 	{
-		size_t checkcount;
 		int32_t surfaceFlags;
 		int32_t contents;
 		uintptr_t shaderNum;
@@ -352,8 +369,6 @@ namespace MOHPC
 		Vector bounds[2];
 		size_t numsides;
 		collisionBrushSide_t* sides;
-		// to avoid repeated testings
-		size_t checkcount;
 
 	public:
 		collisionBrush_t();
@@ -515,8 +530,6 @@ namespace MOHPC
 
 	struct MOHPC_EXPORTS collisionPatch_t
 	{
-		// to avoid repeated testings
-		size_t checkcount;
 		int32_t surfaceFlags;
 		int32_t contents;
 		uintptr_t shaderNum;
@@ -641,19 +654,18 @@ namespace MOHPC
 	};
 
 	/**
-	 * Class used to be able to trace through world full of planes
+	 * Geometry of a collision world, it is never modified by queries.
+	 * Worlds loaded from the same image share it (see CollisionWorldImage), it is copied before being modified.
 	 */
-	class CollisionWorld
+	struct MOHPC_EXPORTS collisionWorldData_t
 	{
-		MOHPC_OBJECT_DECLARATION(CollisionWorld);
-
-	private:
 		Container<collisionFencemask_t> fencemasks;
 		Container<collisionShader_t> shaders;
 		Container<collisionSideEq_t> sideequations;
 		Container<collisionBrushSide_t> brushsides;
 		Container<collisionPlane_t> planes;
 		Container<collisionNode_t> nodes;
+		Container<collisionFlatNode_t> flatNodes;
 		Container<collisionLeaf_t> leafs;
 		Container<intptr_t> leafbrushes;
 		Container<intptr_t> leafsurfaces;
@@ -664,11 +676,38 @@ namespace MOHPC
 		Container<collisionTerrain_t> terrain;
 		Container<collisionPatch_t> patchList;
 
+	public:
+		collisionWorldData_t();
+		~collisionWorldData_t();
+
+		collisionWorldData_t(const collisionWorldData_t&) = delete;
+		collisionWorldData_t& operator=(const collisionWorldData_t&) = delete;
+	};
+	using collisionWorldDataPtr = SharedPtr<collisionWorldData_t>;
+
+	/**
+	 * Class used to be able to trace through world full of planes
+	 */
+	class CollisionWorld
+	{
+		MOHPC_OBJECT_DECLARATION(CollisionWorld);
+
+	private:
+		collisionWorldDataPtr data;
+
 		// incremented on each trace
 		size_t checkcount;
+		// last check count each brush, patch and terrain was tested with, they belong to this world as the data can be shared
+		Container<size_t> brushCheckCounts;
+		Container<size_t> patchCheckCounts;
+		Container<size_t> terrainCheckCounts;
 
 		sphere_t sphere;
 		pointtrace_t g_trace;
+		// model returned by CM_TempBoxModel(), it belongs to each world
+		collisionModel_t box_model;
+		collisionPlane_t* box_planes;
+		collisionBrush_t* box_brush;
 		size_t c_traces;
 		size_t c_patch_traces;
 		size_t c_brush_traces;
@@ -741,52 +780,69 @@ namespace MOHPC
 		MOHPC_EXPORTS collisionPatch_t* getLeafSurface(uintptr_t num) const;
 		MOHPC_EXPORTS void createSurface(collisionPatch_t* patch);
 
+		/**
+		 * Build the compact node tree used for traversal, from nodes and planes.
+		 * This must be called once all nodes have been created, queries will use the slower nodes otherwise.
+		 */
+		MOHPC_EXPORTS void flattenTree();
+		/** Free the compact node tree, queries will walk nodes instead. */
+		MOHPC_EXPORTS void clearFlatTree();
+		/** Return the number of compact nodes, 0 if the tree is not flattened. */
+		MOHPC_EXPORTS size_t getNumFlatNodes() const;
+
+		/**
+		 * Make this world use the geometry of another world, without copying it.
+		 * Queries don't modify the geometry, so both worlds can be traced from different threads.
+		 * It is copied when one of the worlds is modified afterwards.
+		 */
+		MOHPC_EXPORTS void shareData(const CollisionWorld& other);
+
 		template<typename Archive>
 		void save(Archive& ar)
 		{
-			ar << (uint32_t)fencemasks.NumObjects();
-			ar << (uint32_t)shaders.NumObjects();
-			ar << (uint32_t)sideequations.NumObjects();
-			ar << (uint32_t)brushsides.NumObjects();
-			ar << (uint32_t)planes.NumObjects();
-			ar << (uint32_t)nodes.NumObjects();
-			ar << (uint32_t)leafs.NumObjects();
-			ar << (uint32_t)leafbrushes.NumObjects();
-			ar << (uint32_t)leafsurfaces.NumObjects();
-			ar << (uint32_t)leafterrains.NumObjects();
-			ar << (uint32_t)cmodels.NumObjects();
-			ar << (uint32_t)brushes.NumObjects();
-			ar << (uint32_t)terrain.NumObjects();
-			ar << (uint32_t)patchList.NumObjects();
-			ar << (uint32_t)surfaces.NumObjects();
-
-			for (size_t i = 0; i < fencemasks.NumObjects(); ++i) fencemasks[i].save(ar);
-			for (size_t i = 0; i < shaders.NumObjects(); ++i) shaders[i].save(ar, fencemasks.Data());
-			for (size_t i = 0; i < sideequations.NumObjects(); ++i) sideequations[i].serialize(ar);
-			for (size_t i = 0; i < brushsides.NumObjects(); ++i) brushsides[i].save(ar, planes.Data(), sideequations.Data());
-			for (size_t i = 0; i < planes.NumObjects(); ++i) planes[i].serialize(ar);
-			for (size_t i = 0; i < nodes.NumObjects(); ++i) nodes[i].save(ar, planes.Data());
-			for (size_t i = 0; i < leafs.NumObjects(); ++i) leafs[i].serialize(ar);
-			for (size_t i = 0; i < leafbrushes.NumObjects(); ++i) { uint32_t num = (uint32_t)leafbrushes[i]; ar << num; }
-			for (size_t i = 0; i < leafsurfaces.NumObjects(); ++i) { uint32_t num = (uint32_t)leafsurfaces[i]; ar << num; }
-
-			for (size_t i = 0; i < leafterrains.NumObjects(); ++i)
+			ar << (uint32_t)data->fencemasks.NumObjects();
+			ar << (uint32_t)data->shaders.NumObjects();
+			ar << (uint32_t)data->sideequations.NumObjects();
+			ar << (uint32_t)data->brushsides.NumObjects();
+			ar << (uint32_t)data->planes.NumObjects();
+			ar << (uint32_t)data->nodes.NumObjects();
+			ar << (uint32_t)data->leafs.NumObjects();
+			ar << (uint32_t)data->leafbrushes.NumObjects();
+			ar << (uint32_t)data->leafsurfaces.NumObjects();
+			ar << (uint32_t)data->leafterrains.NumObjects();
+			ar << (uint32_t)data->cmodels.NumObjects();
+			ar << (uint32_t)data->brushes.NumObjects();
+			ar << (uint32_t)data->terrain.NumObjects();
+			ar << (uint32_t)data->patchList.NumObjects();
+			ar << (uint32_t)data->surfaces.NumObjects();
+
+			for (size_t i = 0; i < data->fencemasks.NumObjects(); ++i) data->fencemasks[i].save(ar);
+			for (size_t i = 0; i < data->shaders.NumObjects(); ++i) data->shaders[i].save(ar, data->fencemasks.Data());
+			for (size_t i = 0; i < data->sideequations.NumObjects(); ++i) data->sideequations[i].serialize(ar);
+			for (size_t i = 0; i < data->brushsides.NumObjects(); ++i) data->brushsides[i].save(ar, data->planes.Data(), data->sideequations.Data());
+			for (size_t i = 0; i < data->planes.NumObjects(); ++i) data->planes[i].serialize(ar);
+			for (size_t i = 0; i < data->nodes.NumObjects(); ++i) data->nodes[i].save(ar, data->planes.Data());
+			for (size_t i = 0; i < data->leafs.NumObjects(); ++i) data->leafs[i].serialize(ar);
+			for (size_t i = 0; i < data->leafbrushes.NumObjects(); ++i) { uint32_t num = (uint32_t)data->leafbrushes[i]; ar << num; }
+			for (size_t i = 0; i < data->leafsurfaces.NumObjects(); ++i) { uint32_t num = (uint32_t)data->leafsurfaces[i]; ar << num; }
+
+			for (size_t i = 0; i < data->leafterrains.NumObjects(); ++i)
 			{
-				collisionTerrain_t* ter = leafterrains[i];
+				collisionTerrain_t* ter = data->leafterrains[i];
 
-				const uint32_t terrainNum = ter ? (uint32_t)(ter - terrain.Data()) : -1;
+				const uint32_t terrainNum = ter ? (uint32_t)(ter - data->terrain.Data()) : -1;
 				ar << terrainNum;
 			}
 
-			for (size_t i = 0; i < cmodels.NumObjects(); ++i) cmodels[i].serialize(ar);
-			for (size_t i = 0; i < brushes.NumObjects(); ++i) brushes[i].save(ar, brushsides.Data());
-			for (size_t i = 0; i < terrain.NumObjects(); ++i) terrain[i].serialize(ar);
-			for (size_t i = 0; i < patchList.NumObjects(); ++i) patchList[i].save(ar);
-			for (size_t i = 0; i < surfaces.NumObjects(); ++i)
+			for (size_t i = 0; i < data->cmodels.NumObjects(); ++i) data->cmodels[i].serialize(ar);
+			for (size_t i = 0; i < data->brushes.NumObjects(); ++i) data->brushes[i].save(ar, data->brushsides.Data());
+			for (size_t i = 0; i < data->terrain.NumObjects(); ++i) data->terrain[i].serialize(ar);
+			for (size_t i = 0; i < data->patchList.NumObjects(); ++i) data->patchList[i].save(ar);
+			for (size_t i = 0; i < data->surfaces.NumObjects(); ++i)
 			{
-				collisionPatch_t* patch = surfaces[i];
+				collisionPatch_t* patch = data->surfaces[i];
 
-				const uint32_t patchNum = patch ? (uint32_t)(patch - patchList.Data()) : -1;
+				const uint32_t patchNum = patch ? (uint32_t)(patch - data->patchList.Data()) : -1;
 				ar << patchNum;
 			}
 		}
@@ -827,31 +883,31 @@ namespace MOHPC
 			ar >> numSurfaces;
 
 			clearAll();
-			fencemasks.SetNumObjects(numFenceMasks);
-			shaders.SetNumObjects(numShaders);
-			sideequations.SetNumObjects(numSideEquations);
-			brushsides.SetNumObjects(numBrushSides);
-			planes.SetNumObjects(numPlanes);
-			nodes.SetNumObjects(numNodes);
-			leafs.SetNumObjects(numLeafs);
-			leafbrushes.SetNumObjects(numLeafBrushes);
-			leafsurfaces.SetNumObjects(numLeafSurfaces);
-			leafterrains.SetNumObjects(numLeafTerrains);
-			cmodels.SetNumObjects(numCModels);
-			brushes.SetNumObjects(numBrushes);
-			terrain.SetNumObjects(numTerrains);
-			patchList.SetNumObjects(numPatchList);
-			surfaces.SetNumObjects(numSurfaces);
-
-			for (size_t i = 0; i < numFenceMasks; ++i) fencemasks[i].load(ar);
-			for (size_t i = 0; i < numShaders; ++i) shaders[i].load(ar, fencemasks.Data());
-			for (size_t i = 0; i < numSideEquations; ++i) sideequations[i].serialize(ar);
-			for (size_t i = 0; i < numBrushSides; ++i) brushsides[i].load(ar, planes.Data(), sideequations.Data());
-			for (size_t i = 0; i < numPlanes; ++i) planes[i].serialize(ar);
-			for (size_t i = 0; i < numNodes; ++i) nodes[i].load(ar, planes.Data());
-			for (size_t i = 0; i < numLeafs; ++i) leafs[i].serialize(ar);
-			for (size_t i = 0; i < numLeafBrushes; ++i) { uint32_t num = 0; ar >> num; leafbrushes[i] = num; }
-			for (size_t i = 0; i < numLeafSurfaces; ++i) { uint32_t num = 0; ar >> num; leafsurfaces[i] = num; }
+			data->fencemasks.SetNumObjects(numFenceMasks);
+			data->shaders.SetNumObjects(numShaders);
+			data->sideequations.SetNumObjects(numSideEquations);
+			data->brushsides.SetNumObjects(numBrushSides);
+			data->planes.SetNumObjects(numPlanes);
+			data->nodes.SetNumObjects(numNodes);
+			data->leafs.SetNumObjects(numLeafs);
+			data->leafbrushes.SetNumObjects(numLeafBrushes);
+			data->leafsurfaces.SetNumObjects(numLeafSurfaces);
+			data->leafterrains.SetNumObjects(numLeafTerrains);
+			data->cmodels.SetNumObjects(numCModels);
+			data->brushes.SetNumObjects(numBrushes);
+			data->terrain.SetNumObjects(numTerrains);
+			data->patchList.SetNumObjects(numPatchList);
+			data->surfaces.SetNumObjects(numSurfaces);
+
+			for (size_t i = 0; i < numFenceMasks; ++i) data->fencemasks[i].load(ar);
+			for (size_t i = 0; i < numShaders; ++i) data->shaders[i].load(ar, data->fencemasks.Data());
+			for (size_t i = 0; i < numSideEquations; ++i) data->sideequations[i].serialize(ar);
+			for (size_t i = 0; i < numBrushSides; ++i) data->brushsides[i].load(ar, data->planes.Data(), data->sideequations.Data());
+			for (size_t i = 0; i < numPlanes; ++i) data->planes[i].serialize(ar);
+			for (size_t i = 0; i < numNodes; ++i) data->nodes[i].load(ar, data->planes.Data());
+			for (size_t i = 0; i < numLeafs; ++i) data->leafs[i].serialize(ar);
+			for (size_t i = 0; i < numLeafBrushes; ++i) { uint32_t num = 0; ar >> num; data->leafbrushes[i] = num; }
+			for (size_t i = 0; i < numLeafSurfaces; ++i) { uint32_t num = 0; ar >> num; data->leafsurfaces[i] = num; }
 
 			for (size_t i = 0; i < numLeafTerrains; ++i)
 			{
@@ -859,29 +915,31 @@ namespace MOHPC
 				ar >> terrainNum;
 
 				if (terrainNum != -1) {
-					leafterrains[i] = &terrain[terrainNum];
+					data->leafterrains[i] = &data->terrain[terrainNum];
 				}
 				else {
-					leafterrains[i] = nullptr;
+					data->leafterrains[i] = nullptr;
 				}
 			}
 
-			for (size_t i = 0; i < numCModels; ++i) cmodels[i].serialize(ar);
-			for (size_t i = 0; i < numBrushes; ++i) brushes[i].load(ar, brushsides.Data());
-			for (size_t i = 0; i < numTerrains; ++i) terrain[i].serialize(ar);
-			for (size_t i = 0; i < numPatchList; ++i) patchList[i].load(ar);
+			for (size_t i = 0; i < numCModels; ++i) data->cmodels[i].serialize(ar);
+			for (size_t i = 0; i < numBrushes; ++i) data->brushes[i].load(ar, data->brushsides.Data());
+			for (size_t i = 0; i < numTerrains; ++i) data->terrain[i].serialize(ar);
+			for (size_t i = 0; i < numPatchList; ++i) data->patchList[i].load(ar);
 			for (size_t i = 0; i < numSurfaces; ++i)
 			{
 				uint32_t patchNum = 0;
 				ar >> patchNum;
 
 				if (patchNum != -1) {
-					surfaces[i] = &patchList[patchNum];
+					data->surfaces[i] = &data->patchList[patchNum];
 				}
 				else {
-					surfaces[i] = nullptr;
+					data->surfaces[i] = nullptr;
 				}
 			}
+
+			flattenTree();
 		}
 
 	public:
@@ -911,12 +969,20 @@ namespace MOHPC
 			const Vector& origin, const Vector& angles, bool cylinder);
 
 	private:
+		collisionWorldData_t& detachData();
+		void clearCheckCounts();
+		void CM_NextCheckCount();
+		bool CM_CheckedBrush(const collisionBrush_t* brush);
+		bool CM_CheckedPatch(const collisionPatch_t* patch);
+		bool CM_CheckedTerrain(const collisionTerrain_t* terrain);
+
 		size_t CM_BoxBrushes(const Vector& mins, const Vector& maxs, collisionBrush_t** list, size_t listsize);
 
 		void CM_StoreLeafs(leafList_t* ll, int nodenum);
 		void CM_StoreBrushes(leafList_t* ll, int nodenum);
 
 		void CM_BoxLeafnums_r(leafList_t* ll, int nodenum);
+		void CM_BoxLeafnumsFlat(leafList_t* ll);
 
 		collisionModel_t* CM_ClipHandleToModel(clipHandle_t handle);
 		bool CM_BoundsIntersect(const Vector& mins, const Vector& maxs, const Vector& mins2, const Vector& maxs2);
@@ -947,9 +1013,12 @@ namespace MOHPC
 		bool CM_SightTraceThroughBrush(traceWork_t* tw, collisionBrush_t* brush);
 		bool CM_SightTraceToLeaf(traceWork_t* tw, collisionLeaf_t* leaf);
 		bool CM_SightTraceThroughTree(traceWork_t* tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2);
+		void CM_TraceThroughFlatTree(traceWork_t* tw);
+		bool CM_SightTraceThroughFlatTree(traceWork_t* tw);
 
 	private:
 		int CM_PointLeafnum_r(const Vector& p, int num);
+		int CM_PointLeafnumFlat(const Vector& p);
 		int CM_PointLeafnum(const Vector& p);
 		size_t	CM_BoxLeafnums(const Vector& mins, const Vector& maxs, int* list, size_t listsize, int* lastLeaf);
 		collisionShader_t* CM_ShaderPointer(int iShaderNum);
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../Global.h"
+#include "../Object.h"
+#include "../Common/Container.h"
+#include "../Common/str.h"
+#include "Collision.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace MOHPC
+{
+	class BSP;
+
+	/**
+	 * Versioned binary image of a fully built collision world.
+	 *
+	 * The image is keyed by the content hash of the data the world was built from (see BSP::GetContentHash()),
+	 * so a stale image is rejected instead of being loaded.
+	 * Once created the image never changes, the worlds filled from it share its geometry instead of copying it.
+	 */
+	class CollisionWorldImage
+	{
+		MOHPC_OBJECT_DECLARATION(CollisionWorldImage);
+
+	public:
+		/** Bumped each time the serialized layout of the collision world changes. */
+		static constexpr uint32_t VERSION = 1;
+
+	private:
+		// only holds the geometry, it is never traced
+		CollisionWorldPtr world;
+		uint64_t key;
+
+	private:
+		CollisionWorldImage(uint64_t keyValue);
+
+		void write(Container<uint8_t>& buffer) const;
+		bool read(const uint8_t* buffer, size_t size);
+
+	public:
+		MOHPC_EXPORTS ~CollisionWorldImage();
+
+		/** Serialize a collision world, that was built from data matching the key. */
+		MOHPC_EXPORTS static SharedPtr<CollisionWorldImage> fromWorld(CollisionWorld& cm, uint64_t key);
+
+		/**
+		 * Read an image from a memory block, such as a mapped file. The block isn't referenced afterwards.
+		 * Return nullptr if the block is not an image, is from another version, doesn't match the key or is corrupted.
+		 */
+		MOHPC_EXPORTS static SharedPtr<CollisionWorldImage> fromMemory(const void* buffer, size_t size, uint64_t key);
+
+		/** Same as fromMemory() but read the whole file at once. Return nullptr if it doesn't exist. */
+		MOHPC_EXPORTS static SharedPtr<CollisionWorldImage> fromFile(const char* path, uint64_t key);
+
+		/** Write the image to the specified file. */
+		MOHPC_EXPORTS bool writeFile(const char* path) const;
+
+		/** Fill the collision world from the image, it shares the geometry of the image. Return false if the image is empty. */
+		MOHPC_EXPORTS bool loadWorld(CollisionWorld& cm) const;
+
+		/** Return the key the image was built with. */
+		MOHPC_EXPORTS uint64_t getKey() const;
+
+		/** Return the size of the image, in bytes. The image is serialized to compute it. */
+		MOHPC_EXPORTS size_t getSize() const;
+	};
+	using CollisionWorldImagePtr = SharedPtr<CollisionWorldImage>;
+
+	/**
+	 * Process-wide cache of collision world images, safe to use from multiple threads.
+	 *
+	 * Images are looked up in memory first, then in the cache directory (if any).
+	 * When none match, the world is built from the BSP and the resulting image is written to the directory.
+	 * The most recently used images are kept in memory (see setMaxImages()), others are freed once no user holds them.
+	 */
+	class CollisionWorldCache
+	{
+		MOHPC_OBJECT_DECLARATION(CollisionWorldCache);
+
+	private:
+		struct imageEntry_t
+		{
+			// held while the image is loaded or built, so concurrent users of the same level wait for a single build
+			std::mutex buildMutex;
+			// protected by imagesMutex
+			CollisionWorldImagePtr image;
+			uint64_t lastUse = 0;
+		};
+
+		str directory;
+		// protects the map and the images of entries, never held while an image is built
+		std::mutex imagesMutex;
+		std::map<uint64_t, SharedPtr<imageEntry_t>> images;
+		uint64_t useCount;
+		size_t maxImages;
+
+	private:
+		/** The directory can be empty, images will then be kept in memory only. */
+		CollisionWorldCache(const char* directoryValue);
+
+		void evictImages();
+
+	public:
+		MOHPC_EXPORTS ~CollisionWorldCache();
+
+		/** Return the image of the BSP collision world, building it if necessary. */
+		MOHPC_EXPORTS CollisionWorldImagePtr getImage(BSP& bsp);
+
+		/** Fill the collision world from the cached image of the BSP. */
+		MOHPC_EXPORTS void fillCollisionWorld(BSP& bsp, CollisionWorld& cm);
+
+		/** Forget images that are no longer used outside of the cache. */
+		MOHPC_EXPORTS void purge();
+
+		/** Set the number of most recently used images kept in memory, 4 by default. */
+		MOHPC_EXPORTS void setMaxImages(size_t maxImagesValue);
+
+		/** Return the path of the image file matching the key. */
+		MOHPC_EXPORTS str getImagePath(uint64_t key) const;
+	};
+	using CollisionWorldCachePtr = SharedPtr<CollisionWorldCache>;
+}
@@ -2,8 +2,21 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <new>
 #include "../Global.h"
 
+/** Make new and delete of a class allocate with allocateMemory() and freeMemory(). */
+#define MOHPC_MEMORY_OPERATORS() \
+	static void* operator new(size_t size) \
+	{ \
+		void* ptr = MOHPC::allocateMemory(size); \
+		if (!ptr) throw std::bad_alloc(); \
+		return ptr; \
+	} \
+	static void operator delete(void* ptr) { MOHPC::freeMemory(ptr); } \
+	static void* operator new(size_t, void* where) { return where; } \
+	static void operator delete(void*, void*) {}
+
 namespace MOHPC
 {
 	extern "C"
@@ -11,4 +24,155 @@ namespace MOHPC
 		MOHPC_EXPORTS void* allocateMemory(size_t size);
 		MOHPC_EXPORTS void freeMemory(void* ptr);
 	}
-}
\ No newline at end of file
+
+	/** Subsystem that allocations are accounted to. */
+	enum class memoryTag_e : uint8_t
+	{
+		General,
+		BSP,
+		TIKI,
+		Script,
+		Network,
+		Max
+	};
+
+	/**
+	 * Interface of the allocator behind allocateMemory() and freeMemory().
+	 * A block is always freed by the allocator that allocated it, even if another allocator was set since.
+	 */
+	class MOHPC_EXPORTS IAllocator
+	{
+	public:
+		virtual ~IAllocator() = default;
+
+		/** Return a block of at least the specified size, aligned for any type. Return null on failure. */
+		virtual void* allocate(size_t size) = 0;
+
+		/** Free a block returned by allocate(), the size is the one it was allocated with. */
+		virtual void deallocate(void* ptr, size_t size) = 0;
+	};
+
+	/**
+	 * The default allocator.
+	 * Small blocks are taken from pools of fixed size classes, each thread caches a list of free blocks
+	 * so most allocations don't lock. Bigger blocks are allocated with malloc.
+	 * Pooled memory is reused but never returned to the system.
+	 */
+	class MOHPC_EXPORTS PoolAllocator : public IAllocator
+	{
+	public:
+		/** Blocks up to this size are pooled. */
+		static constexpr size_t maxPooledSize = 512;
+
+		void* allocate(size_t size) override;
+		void deallocate(void* ptr, size_t size) override;
+
+		static PoolAllocator& get();
+	};
+
+	/**
+	 * Allocator forwarding to malloc and free.
+	 * It's the default when building with the address sanitizer, so errors are not hidden in pools.
+	 */
+	class MOHPC_EXPORTS MallocAllocator : public IAllocator
+	{
+	public:
+		void* allocate(size_t size) override;
+		void deallocate(void* ptr, size_t size) override;
+
+		static MallocAllocator& get();
+	};
+
+	/**
+	 * Set the allocator used by allocateMemory() from now on, null restores the default.
+	 * The allocator must stay alive until all blocks it allocated are freed.
+	 */
+	MOHPC_EXPORTS void setAllocator(IAllocator* allocator);
+
+	/** Return the allocator used by allocateMemory(). */
+	MOHPC_EXPORTS IAllocator* getAllocator();
+
+	/** Allocation statistics of a tag. */
+	struct MemoryStats
+	{
+		// number of blocks that were allocated
+		size_t numAllocations;
+		// number of blocks that were freed
+		size_t numFrees;
+		// requested bytes that are not freed yet
+		size_t bytesInUse;
+		// highest number of bytes in use
+		size_t peakBytesInUse;
+	};
+
+	/** Return the statistics of allocations made with the specified tag. Can be called from any thread. */
+	MOHPC_EXPORTS MemoryStats getMemoryStats(memoryTag_e tag);
+
+	/**
+	 * Account allocations made by the current thread to a tag, until the scope ends.
+	 * Scopes can be nested.
+	 */
+	class MOHPC_EXPORTS MemoryTagScope
+	{
+	public:
+		MemoryTagScope(memoryTag_e tag);
+		~MemoryTagScope();
+
+		MemoryTagScope(const MemoryTagScope&) = delete;
+		MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+	private:
+		memoryTag_e previousTag;
+	};
+
+	/** Return the tag that allocations of the current thread are accounted to. */
+	MOHPC_EXPORTS memoryTag_e getMemoryTag();
+
+	/**
+	 * Bump allocator where blocks are not freed individually, but all at once with reset().
+	 * Suited for data that is only needed during a load. It is not thread-safe.
+	 */
+	class MOHPC_EXPORTS MemoryArena
+	{
+	public:
+		MemoryArena(memoryTag_e tag = memoryTag_e::General, size_t chunkSize = 64 * 1024);
+		~MemoryArena();
+
+		MemoryArena(const MemoryArena&) = delete;
+		MemoryArena& operator=(const MemoryArena&) = delete;
+
+		/** Return a block aligned for any type, valid until the arena is reset. Throw std::bad_alloc on failure. */
+		void* allocate(size_t size);
+
+		/** Free all blocks. */
+		void reset();
+
+		/** Return the number of bytes allocated since the last reset. */
+		size_t getUsedSize() const;
+
+	private:
+		struct Chunk;
+
+		Chunk* chunks;
+		size_t chunkSize;
+		size_t usedSize;
+		size_t numBlocks;
+		memoryTag_e tag;
+	};
+
+	/**
+	 * Reset an arena when the scope ends, so its blocks are freed on every exit path.
+	 */
+	class MOHPC_EXPORTS MemoryArenaScope
+	{
+	public:
+		MemoryArenaScope(MemoryArena& arena);
+		~MemoryArenaScope();
+
+		MemoryArenaScope(const MemoryArenaScope&) = delete;
+		MemoryArenaScope& operator=(const MemoryArenaScope&) = delete;
+
+	private:
+		MemoryArena& arena;
+	};
+}
@@ -2,6 +2,8 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include "Memory.h"
 
 namespace MOHPC
 {
@@ -31,8 +33,7 @@ namespace MOHPC
 		Entry					*next;
 
 	public:
-		//void *operator new( size_t size );
-		//void operator delete( void *ptr );
+		MOHPC_MEMORY_OPERATORS();
 
 		Entry(const k& inKey);
 
@@ -179,23 +180,10 @@ namespace MOHPC
 	template< typename k >
 	intptr_t HashCode(const k& key);
 
-	/*
-	template< typename k, typename v >
-	void *Entry< k, v >::operator new( size_t size )
-	{
-		return con_set< k, v >::Entry_allocator.Alloc();
-	}
-
-	template< typename k, typename v >
-	void Entry< k, v >::operator delete( void *ptr )
-	{
-		con_set< k, v >::Entry_allocator.Free( ptr );
-	}
-	*/
-
 	template< typename k, typename v >
 	Entry< k, v >::Entry(const k& inKey)
 		: key(inKey)
+		, value()
 	{
 		index = 0;
 		next = nullptr;
@@ -365,13 +353,11 @@ namespace MOHPC
 
 		entry = new Entry<k, v>(key);
 
-		if (defaultEntry == nullptr)
-		{
+		// the default entry can be cleared by remove() while other entries are still in the table
+		entry->next = table[index];
+
+		if (defaultEntry == nullptr) {
 			defaultEntry = entry;
-			entry->next = nullptr;
-		}
-		else {
-			entry->next = table[index];
 		}
 
 		entry->key = key;
@@ -2,6 +2,7 @@
 
 #include "../Class.h"
 #include "../Common/Container.h"
+#include "../Common/con_set.h"
 
 namespace MOHPC
 {
@@ -13,26 +14,44 @@ namespace MOHPC
 		public:
 			Class* obj;
 			float time;
+			// order of insertion, elements of the same time come out first in, first out
+			size_t sequence;
 		};
 
 	private:
+		// binary heap ordered by time
 		Container<con_timer::Element> m_Elements;
+		// position of each object in the heap
+		con_map<Class*, uintptr_t> m_Indexes;
+		size_t m_Sequence;
 		bool m_bDirty;
 		float m_time;
 
 	public:
 		con_timer();
 
+		/** Add an object, or move it to the new time if it is already in the timer. */
 		void AddElement(Class *e, float time);
 		void RemoveElement(Class *e);
 
 		Class* GetNextElement(float& foundTime);
 
+		/** Returns the number of objects in the timer. */
+		size_t NumElements() const;
+
 		void SetDirty() { m_bDirty = true; };
 		bool IsDirty() { return m_bDirty; };
 		void SetTime(float time) { m_time = time; };
 
 		static void ArchiveElement(Archiver& arc, Element *e);
 		virtual void Archive(Archiver& arc);
+
+	private:
+		static bool ElementBefore(const Element& e1, const Element& e2);
+		void SetElementAt(size_t index, const Element& element);
+		void SiftUp(size_t index);
+		void SiftDown(size_t index);
+		void RemoveElementAt(size_t index);
+		void RebuildHeap();
 	};
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Global.h"
+#include "Memory.h"
 #include <cassert>
 #include <cstring>
 #include <cstdio>
@@ -19,11 +20,13 @@ namespace MOHPC
 	class strdata
 	{
 	public:
+		MOHPC_MEMORY_OPERATORS();
+
 		strdata() : data(NULL), refcount(0), alloced(0), len(0) {}
 		~strdata()
 		{
 			if (data)
-				delete[] data;
+				freeMemory(data);
 		}
 
 		void AddRef() { refcount++; }
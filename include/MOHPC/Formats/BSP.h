@@ -8,9 +8,11 @@
 #include "../Common/str.h"
 #include "../Vector.h"
 #include "../Utilities/SharedPtr.h"
+#include "../Collision/Collision.h"
 
 #include <exception>
 #include <cstdint>
+#include <mutex>
 
 namespace MOHPC
 {
@@ -573,6 +575,13 @@ namespace MOHPC
 		/** Fill the specified collision world for tracing, etc... */
 		MOHPC_EXPORTS void FillCollisionWorld(CollisionWorld& cm);
 
+		/**
+		 * Returns a 64-bit hash of the file content (the CRC32 of the file, and its length).
+		 * It is used to match data built from the level, like collision world images.
+		 * The file is read again on the first call, so loading levels that never need it isn't slowed down.
+		 */
+		MOHPC_EXPORTS uint64_t GetContentHash() const;
+
 		static bool PlaneFromPoints(vec4_t plane, vec3_t a, vec3_t b, vec3_t c);
 
 	protected:
@@ -581,6 +590,7 @@ namespace MOHPC
 	private:
 		BSPData::Plane::PlaneType PlaneTypeForNormal(const Vector& Normal);
 		uintptr_t PointLeafNum_r(const MOHPC::Vector p, intptr_t num);
+		uintptr_t PointLeafNumFlat(const MOHPC::Vector p);
 
 		//void PreAllocateLevelData(const File_Header *Header);
 		void LoadShaders(const BSPFile::GameLump* GameLump);
@@ -664,6 +674,7 @@ namespace MOHPC
 		Container<BSPData::BrushSide> brushSides;
 		Container<BSPData::Brush> brushes;
 		Container<BSPData::Node> nodes;
+		Container<collisionFlatNode_t> flatNodes;
 		Container<BSPData::Leaf> leafs;
 		Container<uintptr_t> leafBrushes;
 		Container<uintptr_t> leafSurfaces;
@@ -684,6 +695,12 @@ namespace MOHPC
 		Container<uint8_t> visibility;
 		char* entityString;
 		size_t entityStringLength;
+		// computed on first use by GetContentHash()
+		mutable std::mutex contentHashMutex;
+		mutable uint64_t contentHash;
+		mutable bool hasContentHash;
+		// file lumps only live while loading
+		MemoryArena loadArena;
 
 		Container<BSPData::TerrainVert> trVerts;
 		Container<BSPData::TerrainTri> trTris;
@@ -737,5 +754,35 @@ namespace MOHPC
 		private:
 			const char* lumpName;
 		};
+
+		/**
+		 * An element of the lump references an element that doesn't exist.
+		 */
+		class IndexOutOfRange : public Base
+		{
+		public:
+			IndexOutOfRange(const char* inLumpName);
+
+			MOHPC_EXPORTS const char* getLumpName() const;
+
+		private:
+			const char* lumpName;
+		};
+
+		/**
+		 * The lump goes past the end of the file.
+		 */
+		class LumpOutOfBounds : public Base
+		{
+		public:
+			LumpOutOfBounds(uint32_t inOffset, uint32_t inLength);
+
+			MOHPC_EXPORTS uint32_t getOffset() const;
+			MOHPC_EXPORTS uint32_t getLength() const;
+
+		private:
+			uint32_t offset;
+			uint32_t length;
+		};
 	}
 }
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../Global.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace MOHPC
+{
+	namespace DXT
+	{
+		enum class Format : uint8_t
+		{
+			DXT1,
+			DXT3,
+			DXT5
+		};
+
+		/** Returns the size in bytes of a 4x4 block. */
+		MOHPC_EXPORTS size_t GetBlockSize(Format format);
+
+		/** Returns the size in bytes of an image, the dimensions are rounded up to full blocks. */
+		MOHPC_EXPORTS size_t GetImageSize(Format format, uint32_t width, uint32_t height);
+
+		/**
+		 * Decode a single 4x4 block into RGBA8 pixels.
+		 *
+		 * @param format	Format of the block.
+		 * @param block		Pointer to the compressed block.
+		 * @param out		Output pixels, must hold 4 rows.
+		 * @param stride	Distance in bytes between two rows of the output.
+		 */
+		MOHPC_EXPORTS void DecodeBlock(Format format, const uint8_t* block, uint8_t* out, size_t stride);
+
+		/**
+		 * Decode a whole image into RGBA8 pixels.
+		 *
+		 * @param format	Format of the image.
+		 * @param in		Compressed blocks, GetImageSize() bytes.
+		 * @param width		Width of the image, doesn't need to be a multiple of 4.
+		 * @param height	Height of the image, doesn't need to be a multiple of 4.
+		 * @param out		Output pixels, must hold width * height * 4 bytes.
+		 */
+		MOHPC_EXPORTS void DecodeImage(Format format, const uint8_t* in, uint32_t width, uint32_t height, uint8_t* out);
+	}
+}
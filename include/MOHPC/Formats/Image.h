@@ -3,6 +3,9 @@
 #include "../Global.h"
 #include "../Asset.h"
 #include "../Utilities/SharedPtr.h"
+#include "../Common/Container.h"
+
+#include <vector>
 
 namespace MOHPC
 {
@@ -13,6 +16,23 @@ namespace MOHPC
 		IF_RGBA
 	};
 
+	/** File formats that can be decoded straight to RGBA8. */
+	enum class ImageFileFormat : uint8_t
+	{
+		Unknown,
+		TGA,
+		JPEG
+	};
+
+	/** A level of the mip chain. */
+	struct ImageMipmap
+	{
+		const uint8_t* data;
+		uint32_t dataSize;
+		uint32_t width;
+		uint32_t height;
+	};
+
 	class Image : public Asset
 	{
 		CLASS_BODY(Image);
@@ -25,6 +45,50 @@ namespace MOHPC
 		MOHPC_EXPORTS uint32_t GetWidth() const;
 		MOHPC_EXPORTS uint32_t GetHeight() const;
 
+		/**
+		 * Generate the box-filtered mip chain of the image, down to 1x1.
+		 * Returns false if the image has no pixels.
+		 */
+		MOHPC_EXPORTS bool GenerateMipmaps();
+
+		/** Returns the number of mip levels, the first level is the image itself. 0 if mipmaps were not generated. */
+		MOHPC_EXPORTS size_t GetNumMipmaps() const;
+
+		/** Returns the mip level at the specified number. */
+		MOHPC_EXPORTS const ImageMipmap& GetMipmap(size_t level) const;
+
+		/** Returns the number of bytes of a pixel in the specified format, 0 if unknown. */
+		MOHPC_EXPORTS static uint32_t GetBytesPerPixel(PixelFormat format);
+
+		/**
+		 * Box-filter pixels into an image half the size (rounded down, at least 1 pixel).
+		 * Each output pixel is the average of a 2x2 square, the last row/column of odd dimensions is dropped.
+		 */
+		MOHPC_EXPORTS static void DownsampleBox(const uint8_t* in, uint32_t inWidth, uint32_t inHeight, uint32_t bytesPerPixel, uint8_t* out);
+
+		/** Returns the file format from the extension of the file name. */
+		MOHPC_EXPORTS static ImageFileFormat GetFileFormat(const char* fileName);
+
+		/**
+		 * Read the dimensions of an image file without decoding the pixels.
+		 * Returns false if the file is invalid or not supported.
+		 */
+		MOHPC_EXPORTS static bool DecodeHeader(ImageFileFormat format, const void* buf, size_t len, uint32_t& outWidth, uint32_t& outHeight);
+
+		/**
+		 * Decode an image file to RGBA8 pixels, rows from top to bottom.
+		 * The output must hold width * height * 4 bytes, see DecodeHeader().
+		 * Returns false if the file is invalid, not supported or if the output is too small.
+		 */
+		MOHPC_EXPORTS static bool DecodeRGBA(ImageFileFormat format, const void* buf, size_t len, uint8_t* out, size_t outSize);
+
+		/**
+		 * Decode an image file to RGBA8 pixels, rows from top to bottom.
+		 * The output is resized to the image, keep it between calls to avoid allocating for each image.
+		 * Returns false if the file is invalid or not supported.
+		 */
+		MOHPC_EXPORTS static bool DecodeRGBA(ImageFileFormat format, const void* buf, size_t len, std::vector<uint8_t>& out, uint32_t& outWidth, uint32_t& outHeight);
+
 	public:
 		MOHPC_EXPORTS Image();
 		MOHPC_EXPORTS ~Image();
@@ -36,6 +100,7 @@ namespace MOHPC
 		void LoadJPEG(const char *name, void *buf, std::streamsize len);
 		void LoadTGA(const char *name, void *buf, std::streamsize len);
 		void LoadDDS(const char *name, void *buf, std::streamsize len);
+		void LoadRGBA(ImageFileFormat format, const char *name, void *buf, std::streamsize len);
 
 	private:
 		uint8_t *data;
@@ -43,6 +108,8 @@ namespace MOHPC
 		uint32_t width;
 		uint32_t height;
 		PixelFormat pixelFormat;
+		Container<ImageMipmap> mipmaps;
+		uint8_t* mipmapData;
 	};
 	using ImagePtr = SharedPtr<Image>;
 }
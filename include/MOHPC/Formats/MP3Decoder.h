@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../Global.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace MOHPC
+{
+	/**
+	 * Information read from the frame headers of an MP3 file.
+	 */
+	struct mp3Info_t
+	{
+		uint32_t numChannels;
+		uint32_t sampleRate;
+		// number of sample frames (one sample per channel)
+		size_t numSampleFrames;
+	};
+
+	/**
+	 * Streaming MP3 decoder.
+	 * PCM samples are decoded into buffers provided by the caller, as much as requested each time.
+	 * The MP3 data must stay valid during the lifetime of the decoder.
+	 */
+	class MP3Decoder
+	{
+	public:
+		/**
+		 * Read the frame headers without decoding the samples.
+		 * This is much faster than decoding and gives the size of the decoded data.
+		 *
+		 * @param	data	MP3 data.
+		 * @param	size	Size of the data.
+		 * @param	info	Information about the file.
+		 * @return	false if there is no valid frame.
+		 */
+		MOHPC_EXPORTS static bool GetInfo(const void* data, size_t size, mp3Info_t& info);
+
+	public:
+		MOHPC_EXPORTS MP3Decoder(const void* data, size_t size);
+		MOHPC_EXPORTS ~MP3Decoder();
+		MP3Decoder(const MP3Decoder& other) = delete;
+		MP3Decoder& operator=(const MP3Decoder& other) = delete;
+
+		/**
+		 * Decode the next samples as signed 16-bit PCM, interleaved and in native byte order.
+		 *
+		 * @param	samples			Output buffer, must hold maxSampleFrames * getNumChannels() samples.
+		 * @param	maxSampleFrames	Maximum number of sample frames to decode.
+		 * @return	The number of sample frames decoded, 0 at the end of the stream.
+		 */
+		MOHPC_EXPORTS size_t decode(int16_t* samples, size_t maxSampleFrames);
+
+		/** Return the number of channels, 0 until the first frame is decoded (see prepare()). */
+		MOHPC_EXPORTS uint32_t getNumChannels() const;
+
+		/** Return the sample rate, known after the first frame. */
+		MOHPC_EXPORTS uint32_t getSampleRate() const;
+
+		/**
+		 * Decode the first frame so the number of channels and the sample rate are known before decoding samples.
+		 *
+		 * @return	false if there is no valid frame.
+		 */
+		MOHPC_EXPORTS bool prepare();
+
+		/** Return true if the end of the stream was reached. */
+		MOHPC_EXPORTS bool isFinished() const;
+
+	private:
+		bool decodeFrame();
+
+	private:
+		struct madState_t;
+
+		madState_t* state;
+		// copy of the end of the data followed by the padding needed to decode the last frame
+		std::vector<uint8_t> guardBuffer;
+		// position in the samples of the current frame
+		uint32_t frameSampleNum;
+		uint32_t numChannels;
+		uint32_t sampleRate;
+		bool guarded;
+		bool finished;
+	};
+}
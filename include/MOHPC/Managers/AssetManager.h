@@ -29,6 +29,15 @@ namespace MOHPC
 		/** Get the virtual file manager associated with the asset manager. */
 		MOHPC_EXPORTS FileManager* GetFileManager() const;
 
+		/**
+		 * Enable or disable hashing the content of assets while they are loaded.
+		 * Hashing is disabled by default, it only applies to assets loaded afterward.
+		 */
+		MOHPC_EXPORTS void SetAssetHashing(bool enabled);
+
+		/** Returns whether or not the content of loaded assets is hashed. */
+		MOHPC_EXPORTS bool IsAssetHashingEnabled() const;
+
 		/** Return a manager class check the *Managers* folder. */
 		template<class T>
 		SharedPtr<T> GetManager()
@@ -74,6 +83,7 @@ namespace MOHPC
 
 	private:
 		mutable FileManager* FM;
+		bool assetHashing;
 
 		/**
 		 * Shared pointer, because each manager is a storage, part of the asset manager
@@ -30,7 +30,12 @@ namespace MOHPC
 	private:
 		static EventDef *lastEventDef;
 
-		EventQueueNode EventQueue;
+		// pending events, as a binary heap ordered by fire time
+		Container<EventQueueNode*> EventQueue;
+		// nodes are allocated by blocks and recycled
+		Container<EventQueueNode*> eventNodeBlocks;
+		EventQueueNode* freeEventNodes;
+		size_t eventSequence;
 		bool bEventSystemStarted;
 		static size_t totalEvents;
 
@@ -45,6 +50,8 @@ namespace MOHPC
 		static void UnloadEvents();
 		MOHPC_EXPORTS static size_t NumEventCommands();
 		MOHPC_EXPORTS void ProcessPendingEvents();
+		/** Returns the number of events waiting to be processed. */
+		MOHPC_EXPORTS size_t NumPendingEvents() const;
 		MOHPC_EXPORTS void ShutdownEvents(void);
 		MOHPC_EXPORTS void ArchiveEvents(Archiver &arc);
 		MOHPC_EXPORTS void UnarchiveEvents(Archiver &arc);
@@ -82,6 +89,16 @@ namespace MOHPC
 		virtual void Init() override;
 
 	private:
+		EventQueueNode* AllocateEventNode();
+		void FreeEventNode(EventQueueNode* node);
+		void FreeEventNodes();
+		void InsertEventNode(EventQueueNode* node);
+		void RemoveEventNode(EventQueueNode* node);
+		void RescheduleEventNode(EventQueueNode* node, double time);
+		void SiftEventUp(size_t index);
+		void SiftEventDown(size_t index);
+		static bool EventFiresBefore(const EventQueueNode* node1, const EventQueueNode* node2);
+
 #ifdef _WIN32
 		static int compareEvents(void *context, const void *arg1, const void *arg2);
 #else
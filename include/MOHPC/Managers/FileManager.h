@@ -89,6 +89,9 @@ namespace MOHPC
 		/** Return the stream associated with this file. */
 		std::istream* GetStream() const;
 
+		/** Return the size of the file. The position of the stream is restored if the size has to be found. */
+		std::streamsize GetLength() const;
+
 		/**
 		 * Read the entire stream and return the total size read
 		 *
@@ -128,6 +131,23 @@ namespace MOHPC
 		 */
 		bool AddPakFile(const char* Filename, const char* CategoryName = nullptr);
 
+		/**
+		 * Add a file that only exists in memory, it overrides files from paks and directories in all categories.
+		 *
+		 * @param Filename - The game path to the file.
+		 * @param Data - The content of the file, it is copied.
+		 * @param Size - The size of the content.
+		 */
+		void AddMemoryFile(const char* Filename, const void* Data, size_t Size);
+
+		/**
+		 * Remove a file that was added with AddMemoryFile().
+		 *
+		 * @param Filename - The game path to the file.
+		 * @return true if the file was removed.
+		 */
+		bool RemoveMemoryFile(const char* Filename);
+
 		/**
 		 * Auto add standard pak files and directories from root game directory.
 		 *
@@ -5,6 +5,7 @@
 #include "../Common/Container.h"
 #include "../Common/str.h"
 #include "../Network/Types.h"
+#include "../Network/Metrics.h"
 
 namespace MOHPC
 {
@@ -17,6 +18,8 @@ namespace MOHPC
 
 	private:
 		Container<class ITickableNetwork*> tickables;
+		Network::ChannelMetricsPtr totalMetrics;
+		Network::MetricHistogram tickTimes;
 
 	public:
 		MOHPC_EXPORTS NetworkManager();
@@ -32,6 +35,12 @@ namespace MOHPC
 
 		MOHPC_EXPORTS void addTickable(ITickableNetwork* tickable);
 		MOHPC_EXPORTS void removeTickable(ITickableNetwork* tickable);
+
+		/** Return the traffic of all connections. Can be read from any thread. */
+		MOHPC_EXPORTS const Network::ChannelMetricsPtr& getTotalMetrics() const;
+
+		/** Return the time taken by each processTicks() call, in microseconds. Can be read from any thread. */
+		MOHPC_EXPORTS const Network::MetricHistogram& getTickTimes() const;
 	};
 	using NetworkManagerPtr = SharedPtr<NetworkManager>;
 
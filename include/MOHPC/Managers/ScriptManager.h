@@ -10,6 +10,8 @@
 #include "../Common/con_timer.h"
 #include "../Script/Parm.h"
 
+#include <mutex>
+
 namespace MOHPC
 {
 	class Listener;
@@ -45,12 +47,18 @@ namespace MOHPC
 		/** The string dictionary, used to cache strings into a number. */
 		con_arrayset<str, str> StringDict;
 
+		/** Scripts can be compiled from multiple threads, all of them adding strings. */
+		std::mutex StringDictMutex;
+
 		/** The head of the script container. */
 		ScriptContainer* ContainerHead;
 
 		/** Parm instance for scripts. */
 		Parm parm;
 
+		/** Directory of compiled scripts, empty if scripts are always compiled from source. */
+		str compiledScriptDirectory;
+
 	public:
 		FlagList flags;
 
@@ -113,6 +121,15 @@ namespace MOHPC
 
 		MOHPC_EXPORTS Parm* GetParm();
 
+		/**
+		 * Set the directory where compiled scripts are cached.
+		 * Scripts are then loaded from there when their source hasn't changed, instead of being compiled.
+		 */
+		MOHPC_EXPORTS void SetCompiledScriptDirectory(const char* directory);
+
+		/** Return the path of the compiled script matching the source hash. */
+		MOHPC_EXPORTS str GetCompiledScriptPath(uint64_t sourceHash) const;
+
 	protected:
 		virtual void Init() override;
 	};
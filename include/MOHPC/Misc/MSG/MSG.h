@@ -92,6 +92,7 @@ namespace MOHPC
 		IMessageCodec* msgCodec;
 		msgMode_e mode;
 		size_t bit;
+		size_t serializedBits;
 		uint8_t bitData[32];
 
 	public:
@@ -218,6 +219,9 @@ namespace MOHPC
 		/** Return the current bit position of the message. */
 		size_t GetBitPosition() const;
 
+		/** Return the number of bits read or written since the message was created, before being encoded by the codec. */
+		size_t GetSerializedBits() const;
+
 		/** Return whether or not this message is for reading. */
 		bool IsReading() noexcept;
 
@@ -515,6 +519,12 @@ public:
 		/** Read an entity number (protocol >= 15). */
 		uint16_t ReadEntityNum2();
 
+		/** Write an entity number. */
+		void WriteEntityNum(uint16_t num);
+
+		/** Write an entity number (protocol >= 15). */
+		void WriteEntityNum2(uint16_t num);
+
 		/** Write a coordinate value. */
 		void WriteCoord(float& value);
 
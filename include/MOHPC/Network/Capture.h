@@ -0,0 +1,260 @@
+/**
+ * Recording and replay of the datagrams of a connection.
+ *
+ * A capture holds the datagrams with the time they were received or sent at,
+ * it can be replayed into a client game connection without any server.
+ */
+
+#pragma once
+
+#include "../Global.h"
+#include "../Object.h"
+#include "../Utilities/SharedPtr.h"
+#include "Types.h"
+#include "Socket.h"
+
+#include <chrono>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace MOHPC
+{
+	class IMessageStream;
+
+	namespace Network
+	{
+		enum class captureDirection_e : unsigned char
+		{
+			/** The datagram was received from the remote host. */
+			Received,
+			/** The datagram was sent to the remote host. */
+			Sent
+		};
+
+		/**
+		 * Datagram recorded in a capture.
+		 */
+		class CapturedPacket
+		{
+		public:
+			CapturedPacket(uint64_t time, captureDirection_e direction, size_t offset, size_t size);
+
+			/** Return the time of the datagram, in microseconds since the start of the capture. */
+			MOHPC_EXPORTS uint64_t getTime() const;
+
+			/** Return whether the datagram was received or sent. */
+			MOHPC_EXPORTS captureDirection_e getDirection() const;
+
+			/** Return the size of the datagram. */
+			MOHPC_EXPORTS size_t getSize() const;
+
+			/** Return the position of the datagram in the data of the capture. */
+			size_t getOffset() const;
+
+		private:
+			uint64_t time;
+			size_t offset;
+			uint16_t size;
+			captureDirection_e direction;
+		};
+
+		/**
+		 * Datagrams of a connection, in the order they were received or sent.
+		 */
+		class PacketCapture
+		{
+			MOHPC_OBJECT_DECLARATION(PacketCapture);
+
+		public:
+			static constexpr uint32_t CAPTURE_VERSION = 1;
+
+		public:
+			MOHPC_EXPORTS PacketCapture();
+			MOHPC_EXPORTS PacketCapture(const protocolType_c& protocol, uint32_t challenge);
+
+			/** Set the protocol of the connection, the replayed connection must use the same. */
+			MOHPC_EXPORTS void setProtocol(const protocolType_c& protocol);
+			MOHPC_EXPORTS const protocolType_c& getProtocol() const;
+
+			/** Set the challenge of the connection, the replayed connection needs it to decode server messages. */
+			MOHPC_EXPORTS void setChallenge(uint32_t challenge);
+			MOHPC_EXPORTS uint32_t getChallenge() const;
+
+			/**
+			 * Add a datagram at the end of the capture.
+			 *
+			 * @param	time		Time in microseconds since the start of the capture.
+			 * @param	direction	Whether the datagram was received or sent.
+			 * @param	data		Content of the datagram.
+			 * @param	size		Size of the datagram, up to MAX_UDP_DATA_SIZE.
+			 */
+			MOHPC_EXPORTS void addPacket(uint64_t time, captureDirection_e direction, const void* data, size_t size);
+
+			/** Return the number of datagrams. */
+			MOHPC_EXPORTS size_t getNumPackets() const;
+
+			/** Return the datagram at the specified index. */
+			MOHPC_EXPORTS const CapturedPacket& getPacket(size_t index) const;
+
+			/** Return the content of the datagram at the specified index. */
+			MOHPC_EXPORTS const uint8_t* getPacketData(size_t index) const;
+
+			/** Remove all datagrams. */
+			MOHPC_EXPORTS void clear();
+
+			/** Write the capture to the stream. Values are stored in little-endian. */
+			MOHPC_EXPORTS void save(IMessageStream& stream) const;
+
+			/**
+			 * Replace the capture with the one read from the stream.
+			 *
+			 * @throw	CaptureError::Base	If the capture is invalid.
+			 */
+			MOHPC_EXPORTS void load(IMessageStream& stream);
+
+		private:
+			protocolType_c protocol;
+			uint32_t challenge;
+			std::vector<CapturedPacket> packets;
+			std::vector<uint8_t> data;
+		};
+		using PacketCapturePtr = SharedPtr<PacketCapture>;
+		using ConstPacketCapturePtr = SharedPtr<const PacketCapture>;
+
+		/**
+		 * Socket that records all datagrams going through another socket.
+		 */
+		class CaptureSocket : public IUdpSocket
+		{
+			MOHPC_OBJECT_DECLARATION(CaptureSocket);
+
+		public:
+			/**
+			 * @param	socket		The socket to record.
+			 * @param	capture		The capture to add datagrams to, the time starts when the socket is created.
+			 */
+			MOHPC_EXPORTS CaptureSocket(const IUdpSocketPtr& socket, const PacketCapturePtr& capture);
+
+			bool wait(size_t timeout) override;
+			bool dataAvailable() override;
+			size_t send(const NetAddr& to, const void* buf, size_t bufsize) override;
+			size_t receive(void* buf, size_t maxsize, NetAddrPtr& from) override;
+
+			/** Return the capture being recorded. */
+			MOHPC_EXPORTS const PacketCapturePtr& getCapture() const;
+
+		private:
+			uint64_t getCaptureTime() const;
+
+		private:
+			IUdpSocketPtr socket;
+			PacketCapturePtr capture;
+			std::chrono::steady_clock::time_point startTime;
+		};
+		using CaptureSocketPtr = SharedPtr<CaptureSocket>;
+
+		enum class replayMode_e : unsigned char
+		{
+			/** Each datagram is available once its time has elapsed since the start of the replay. */
+			RealTime,
+			/** Datagrams are available one after another without waiting. */
+			AsFastAsPossible
+		};
+
+		/**
+		 * Socket that receives the datagrams received in a capture.
+		 * Sent datagrams are discarded, the replay doesn't depend on what the client sends.
+		 */
+		class ReplaySocket : public IUdpSocket
+		{
+			MOHPC_OBJECT_DECLARATION(ReplaySocket);
+
+		public:
+			/**
+			 * @param	capture		The capture to replay.
+			 * @param	from		Address the datagrams are received from.
+			 * @param	mode		Whether or not datagrams are delayed like in the capture.
+			 */
+			MOHPC_EXPORTS ReplaySocket(const ConstPacketCapturePtr& capture, const NetAddrPtr& from, replayMode_e mode = replayMode_e::RealTime);
+
+			bool wait(size_t timeout) override;
+			bool dataAvailable() override;
+			size_t send(const NetAddr& to, const void* buf, size_t bufsize) override;
+			size_t receive(void* buf, size_t maxsize, NetAddrPtr& from) override;
+
+			/** Return true when all received datagrams of the capture have been received. */
+			MOHPC_EXPORTS bool isFinished() const;
+
+			/** Start again from the first datagram. */
+			MOHPC_EXPORTS void rewind();
+
+		private:
+			void skipSentPackets();
+			void beginReplay();
+			bool isNextPacketDue();
+
+		private:
+			ConstPacketCapturePtr capture;
+			NetAddrPtr source;
+			size_t packetNum;
+			replayMode_e mode;
+			bool started;
+			std::chrono::steady_clock::time_point startTime;
+		};
+		using ReplaySocketPtr = SharedPtr<ReplaySocket>;
+
+		namespace CaptureError
+		{
+			class Base : public NetworkException {};
+
+			/**
+			 * The stream doesn't start with a capture header.
+			 */
+			class BadHeaderException : public Base
+			{
+			public:
+				MOHPC_EXPORTS str what() const override;
+			};
+
+			/**
+			 * The capture was written with an unsupported version.
+			 */
+			class BadVersionException : public Base
+			{
+			public:
+				BadVersionException(uint32_t inVersion);
+
+				MOHPC_EXPORTS uint32_t getVersion() const;
+				MOHPC_EXPORTS str what() const override;
+
+			private:
+				uint32_t version;
+			};
+
+			/**
+			 * The stream ends before the last datagram.
+			 */
+			class TruncatedException : public Base
+			{
+			public:
+				MOHPC_EXPORTS str what() const override;
+			};
+
+			/**
+			 * A datagram is bigger than an UDP datagram can be.
+			 */
+			class BadPacketSizeException : public Base
+			{
+			public:
+				BadPacketSizeException(size_t inSize);
+
+				MOHPC_EXPORTS size_t getSize() const;
+				MOHPC_EXPORTS str what() const override;
+
+			private:
+				size_t size;
+			};
+		}
+	}
+}
@@ -6,6 +6,7 @@
 #include "../Misc/MSG/Stream.h"
 #include "Types.h"
 #include "Socket.h"
+#include "Metrics.h"
 #include <stdint.h>
 
 namespace MOHPC
@@ -39,13 +40,22 @@ namespace MOHPC
 		{
 		private:
 			IUdpSocketPtr socket;
+			ChannelMetricsPtr metrics;
 
 		public:
 			INetchan(const IUdpSocketPtr& inSocket);
 			virtual ~INetchan() = default;
 
-			/** Read data from the socket to the stream. */
-			virtual bool receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& sequenceNum) = 0;
+			/**
+			 * Read data from the socket.
+			 *
+			 * @param from The address the data was received from.
+			 * @param stream The stream receiving the datagram.
+			 * @param sequenceNum The sequence number of the message.
+			 * @return The stream to parse the message from, or null if there is nothing to parse.
+			 * It is either the input stream, or a stream owned by the channel that stays valid until the next call.
+			 */
+			virtual IMessageStream* receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& sequenceNum) = 0;
 
 			/** Transmit data from stream to the socket. */
 			virtual bool transmit(const NetAddr& to, IMessageStream& stream) = 0;
@@ -58,6 +68,9 @@ namespace MOHPC
 
 			/** Return the outgoing sequence number */
 			virtual uint16_t getOutgoingSequence() const;
+
+			/** Return the traffic of this channel. Can be read from any thread. */
+			MOHPC_EXPORTS const ChannelMetricsPtr& getMetrics() const;
 		};
 
 		using INetchanPtr = SharedPtr<INetchan>;
@@ -68,17 +81,21 @@ namespace MOHPC
 
 		protected:
 			uint16_t qport;
-			uint16_t incomingSequence;
+			uint32_t incomingSequence;
 			uint32_t outgoingSequence;
 			uint16_t dropped;
 			uint16_t fragmentSequence;
-			DynamicDataMessageStream fragmentStream;
+			// fragments are written at their final offset, after room for the server header,
+			// so the completed message is parsed in place
+			size_t fragmentLength;
+			FixedDataMessageStream fragmentStream;
+			uint8_t fragmentBuffer[sizeof(uint32_t) + MAX_MSGLEN];
 
 		public:
 			MOHPC_EXPORTS Netchan(const IUdpSocketPtr& existingSocket, uint16_t inQport);
 			~Netchan();
 
-			virtual bool receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& sequenceNum) override;
+			virtual IMessageStream* receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& sequenceNum) override;
 			virtual bool transmit(const NetAddr& to, IMessageStream& stream) override;
 			virtual uint16_t getOutgoingSequence() const override;
 
@@ -99,7 +116,7 @@ namespace MOHPC
 			MOHPC_EXPORTS ConnectionlessChan();
 			MOHPC_EXPORTS ConnectionlessChan(const IUdpSocketPtr& existingSocket);
 
-			virtual bool receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& sequenceNum) override;
+			virtual IMessageStream* receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& sequenceNum) override;
 			virtual bool transmit(const NetAddr& to, IMessageStream& stream) override;
 		};
 	}
@@ -1120,6 +1120,14 @@ namespace MOHPC
 			void buildSolidList();
 			//====
 
+			/**
+			 * Solid entities broadphase
+			 */
+			void invalidateSolidBounds();
+			void buildSolidBounds(CollisionWorld& cm);
+			size_t querySolidBounds(const Vector& mins, const Vector& maxs, uintptr_t* list) const;
+			//====
+
 			/**
 			 * Player state calculation
 			 */
@@ -1172,6 +1180,15 @@ namespace MOHPC
 		protected:
 			ClientImports imports;
 
+		private:
+			/** World-space bounds of a solid entity, used to skip entities that can't be touched by a trace. */
+			struct solidBounds_t
+			{
+				Vector mins;
+				Vector maxs;
+				uintptr_t solidNum;
+			};
+
 		private:
 			uint64_t svTime;
 			TraceFunction traceFunction;
@@ -1182,6 +1199,9 @@ namespace MOHPC
 			uintptr_t latestCommandSequence;
 			size_t numSolidEntities;
 			size_t numTriggerEntities;
+			size_t numSolidBounds;
+			float solidBoundsMaxWidth;
+			const CollisionWorld* solidBoundsWorld;
 			uint32_t physicsTime;
 			float frameInterpolation;
 			float cameraFov;
@@ -1204,6 +1224,7 @@ namespace MOHPC
 			EntityInfo clientEnts[MAX_GENTITIES];
 			EntityInfo* solidEntities[MAX_ENTITIES_IN_SNAPSHOT];
 			EntityInfo* triggerEntities[MAX_ENTITIES_IN_SNAPSHOT];
+			solidBounds_t solidBounds[MAX_ENTITIES_IN_SNAPSHOT];
 			bool nextFrameTeleport : 1;
 			bool thisFrameTeleport : 1;
 			bool validPPS : 1;
@@ -6,6 +6,7 @@
 #include "../Encoding.h"
 #include "../Event.h"
 #include "../Configstring.h"
+#include "../Metrics.h"
 #include "../../Utilities/HandlerList.h"
 #include "../../Utilities/Info.h"
 #include "../../Utilities/PropertyMap.h"
@@ -15,6 +16,7 @@
 #include "../../Managers/NetworkManager.h"
 #include "UserInfo.h"
 #include "Imports.h"
+#include "SnapshotPublisher.h"
 #include <stdint.h>
 #include <functional>
 #include <type_traits>
@@ -40,6 +42,9 @@ namespace MOHPC
 		class INetchan;
 		struct gameState_t;
 
+		/** One bit for each configstring num. */
+		using configStringChanges_t = std::bitset<MAX_CONFIGSTRINGS>;
+
 		using ClientGameConnectionPtr = SharedPtr<class ClientGameConnection>;
 
 		namespace ClientHandlers
@@ -84,6 +89,15 @@ namespace MOHPC
 			 */
 			struct Configstring : public HandlerNotifyBase<void(csNum_t csNum, const char* configString)> {};
 
+			/**
+			 * Called once per tick if configstrings were modified during the tick,
+			 * after the Configstring handler was called for each of them.
+			 *
+			 * @param	changed		Bit set for each modified configstring num.
+			 * @param	gameState	The game state holding the configstrings.
+			 */
+			struct ConfigstringsChanged : public HandlerNotifyBase<void(const configStringChanges_t& changed, const gameState_t& gameState)> {};
+
 			/**
 			 * Called when a sound started to play/stopped.
 			 *
@@ -188,6 +202,12 @@ namespace MOHPC
 		{
 		};
 
+		/**
+		 * Configstrings are stored in slots, one per configstring num, inside a fixed buffer.
+		 * A string is replaced in place when it fits in the space of its slot,
+		 * otherwise it is appended at the end of the buffer.
+		 * The buffer is compacted when there is no space left at the end.
+		 */
 		struct gameState_t
 		{
 			static constexpr size_t MAX_GAMESTATE_CHARS = 40000;
@@ -205,18 +225,27 @@ namespace MOHPC
 			const char* getConfigStringChecked(csNum_t num) const;
 
 			/**
-			 * Return the configstring at the specified number.
+			 * Set the configstring at the specified number.
 			 *
 			 * @param	num				Config string ID. Must be < MAX_CONFIGSTRINGS
 			 * @param	configString	The value to put in.
-			 * @param	sz				Size of the config string
+			 * @param	sz				Size of the config string, without the null character.
 			 */
 			MOHPC_EXPORTS void setConfigString(csNum_t num, const char* configString, size_t sz);
 
-		public:
+			/** Empty all configstrings. */
+			MOHPC_EXPORTS void clear();
+
+		private:
+			void append(csNum_t num, const char* configString, size_t len);
+			void compact();
+
+		private:
+			// end of the used part of the buffer
 			size_t dataCount;
-			size_t stringOffsets[MAX_CONFIGSTRINGS];
-			// could have made stringData a dynamic buffer
+			uint16_t stringOffsets[MAX_CONFIGSTRINGS];
+			// chars that can be written at the offset of each string, including the null character
+			uint16_t stringCapacities[MAX_CONFIGSTRINGS];
 			char stringData[MAX_GAMESTATE_CHARS];
 		};
 
@@ -359,6 +388,7 @@ namespace MOHPC
 				FunctionList<ClientHandlers::Error> errorHandler;
 				FunctionList<ClientHandlers::PlayerstateRead> playerStateReadHandler;
 				FunctionList<ClientHandlers::Configstring> configStringHandler;
+				FunctionList<ClientHandlers::ConfigstringsChanged> configStringsChangedHandler;
 				FunctionList<ClientHandlers::Sound> soundHandler;
 				FunctionList<ClientHandlers::CenterPrint> centerPrintHandler;
 				FunctionList<ClientHandlers::LocationPrint> locationPrintHandler;
@@ -400,6 +430,9 @@ namespace MOHPC
 			CGameModuleBase* cgameModule;
 			EncodingPtr encoder;
 			INetchanPtr netchan;
+			// kept after the channel is wiped, for readers on other threads
+			ChannelMetricsPtr channelMetrics;
+			protocolType_c protocol;
 			ClientInfoPtr userInfo;
 			uint64_t realTimeStart;
 			uint64_t serverStartTime;
@@ -432,9 +465,12 @@ namespace MOHPC
 			char serverCmdStrings[MAX_STRING_CHARS * MAX_RELIABLE_COMMANDS];
 			usereyes_t userEyes;
 			gameState_t gameState;
+			configStringChanges_t changedConfigStrings;
 			DownloadManager downloadState;
 			ClientSnapshot currentSnap;
 			ClientSnapshot snapshots[PACKET_BACKUP];
+			SnapshotPublisher snapshotPublisher;
+			ClientMetrics metrics;
 			usercmd_t cmds[CMD_BACKUP];
 			outPacket_t outPackets[CMD_BACKUP];
 			entityState_t entityBaselines[MAX_GENTITIES];
@@ -476,6 +512,12 @@ namespace MOHPC
 			/** Retrieve the current game state. */
 			MOHPC_EXPORTS const gameState_t& getGameState() const;
 
+			/** Return the metrics of this connection. Can be read from any thread. */
+			MOHPC_EXPORTS const ClientMetrics& getMetrics() const;
+
+			/** Return the traffic of the channel. Can be read from any thread. */
+			MOHPC_EXPORTS const ChannelMetricsPtr& getChannelMetrics() const;
+
 			/** Retrieve the CGame module. */
 			MOHPC_EXPORTS CGameModuleBase* getCGModule();
 
@@ -510,6 +552,12 @@ namespace MOHPC
 			 */
 			MOHPC_EXPORTS bool getSnapshot(uintptr_t snapshotNum, SnapshotInfo& outSnapshot) const;
 
+			/**
+			 * Return the publisher of snapshots, for reading them from other threads.
+			 * Call enable() on it before the connection parses snapshots, then each new snapshot is published.
+			 */
+			MOHPC_EXPORTS SnapshotPublisher& getSnapshotPublisher();
+
 			/** Return the time at which the server started (in milliseconds). */
 			MOHPC_EXPORTS uint64_t getServerStartTime() const;
 
@@ -525,6 +573,12 @@ namespace MOHPC
 			/** Return the current client number. */
 			MOHPC_EXPORTS uint32_t getClientNum() const;
 
+			/** Return the protocol used by the server. */
+			MOHPC_EXPORTS const protocolType_c& getProtocol() const;
+
+			/** Return the challenge used to encode messages, needed to replay a capture of the connection. */
+			MOHPC_EXPORTS uint32_t getChallenge() const;
+
 			/** Return the current user input number. */
 			MOHPC_EXPORTS uint32_t getCurrentServerMessageSequence() const;
 
@@ -612,6 +666,7 @@ namespace MOHPC
 			void configStringModified(csNum_t num, const char* newString, bool notify = true);
 			void notifyConfigStringChange(csNum_t num, const char* newString);
 			void notifyAllConfigStringChanges();
+			void flushConfigStringChanges();
 			void systemInfoChanged();
 
 			bool readyToSendPacket(uint64_t currentTime) const;
@@ -643,6 +698,7 @@ namespace MOHPC
 			const ClientSnapshot* readOldSnapshot(MSG& msg, ClientSnapshot& snap) const;
 			void readAreaMask(MSG& msg, ClientSnapshot& snap);
 			void setNewSnap(ClientSnapshot& newSnap);
+			void publishSnapshot();
 
 		private:
 			static StringMessage readStringMessage_normal(MSG& msg);
@@ -14,6 +14,7 @@ namespace MOHPC
 	namespace Network
 	{
 		struct gameState_t;
+		class ClientMetrics;
 
 		/**
 		 * Various imports for anything wanting to use ClientConnection APIs.
@@ -34,6 +35,7 @@ namespace MOHPC
 			std::function<StringMessage(MSG& msg)> readStringMessage;
 			std::function<void(const char* cmd)> addReliableCommand;
 			std::function<const ClientInfoPtr&()> getUserInfo;
+			std::function<ClientMetrics&()> getMetrics;
 		};
 	}
 }
\ No newline at end of file
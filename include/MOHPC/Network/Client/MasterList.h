@@ -2,6 +2,7 @@
 
 #include "Server.h"
 #include "GamespyRequest.h"
+#include "MasterListDecoder.h"
 #include "../../Utilities/RequestHandler.h"
 #include "../../Managers/NetworkManager.h"
 #include "../../Global.h"
@@ -18,6 +19,8 @@ namespace MOHPC
 	namespace Network
 	{
 		using FoundServerCallback = std::function<void(const IServerPtr& server)>;
+		/** Called with the addresses decoded from each piece of the list, they are only valid during the call. */
+		using FoundServerAddressesCallback = std::function<void(const serverAddress_t* addresses, size_t numAddresses)>;
 		using MasterServerDone = std::function<void()>;
 
 		enum class gameListType_e : uint8_t
@@ -88,12 +91,14 @@ namespace MOHPC
 				const uint8_t* key;
 				const char* game;
 				FoundServerCallback callback;
+				FoundServerAddressesCallback addressesCallback;
 				MasterServerDone doneCallback;
-				size_t pendingLen;
-				char pendingData[6];
+				MasterListDecoder decoder;
+				std::vector<serverAddress_t> addresses;
 
 			public:
 				Request_FetchServers(const NetworkManagerPtr& networkManager, gameListType_e inGameType, FoundServerCallback&& inCallback, MasterServerDone&& doneCallback);
+				Request_FetchServers(const NetworkManagerPtr& networkManager, gameListType_e inGameType, FoundServerAddressesCallback&& inCallback, MasterServerDone&& doneCallback);
 
 				virtual void generateInfo(Info& info);
 				virtual SharedPtr<IRequestBase> process(RequestData& data) override;
@@ -114,6 +119,19 @@ namespace MOHPC
 			MOHPC_EXPORTS ServerList(const NetworkManagerPtr& inManager, gameListType_e type);
 
 			MOHPC_EXPORTS virtual void fetch(FoundServerCallback&& callback, MasterServerDone&& doneCallback) override;
+
+			/**
+			 * Fetch the list of servers as plain addresses, without creating a server object for each of them.
+			 * Use createServer() to query the ones that are needed.
+			 *
+			 * @param	callback		Called with the addresses decoded from each piece of the list.
+			 * @param	doneCallback	Called when the whole list was received.
+			 */
+			MOHPC_EXPORTS void fetchAddresses(FoundServerAddressesCallback&& callback, MasterServerDone&& doneCallback = MasterServerDone());
+
+			/** Create a server that can be queried, from an address returned by fetchAddresses(). */
+			MOHPC_EXPORTS IServerPtr createServer(const serverAddress_t& address) const;
+
 			virtual void tick(uint64_t deltaTime, uint64_t currentTime) override;
 
 		private:
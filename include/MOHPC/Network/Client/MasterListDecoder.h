@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../../Global.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace MOHPC
+{
+	namespace Network
+	{
+		/**
+		 * IPv4 address and port of a server, as listed by the master server.
+		 */
+		struct serverAddress_t
+		{
+			uint8_t ip[4];
+			// in host byte order
+			uint16_t port;
+		};
+
+		/**
+		 * Decoder of the compressed list sent by the master server.
+		 * The list is made of records of 6 bytes (IPv4 address and port in network byte order) and ends with \final\.
+		 * The list can be fed in pieces of any size.
+		 */
+		class MasterListDecoder
+		{
+		public:
+			/** Size of an address record. */
+			static constexpr size_t RECORD_SIZE = 6;
+
+		public:
+			MOHPC_EXPORTS MasterListDecoder();
+
+			/**
+			 * Decode a piece of the list, appending addresses to the output.
+			 *
+			 * @param	data		Received data.
+			 * @param	size		Size of the data.
+			 * @param	addresses	List to append addresses to.
+			 * @return	true if the end of the list was reached.
+			 */
+			MOHPC_EXPORTS bool decode(const uint8_t* data, size_t size, std::vector<serverAddress_t>& addresses);
+
+			/** Return true if the end of the list was reached. */
+			MOHPC_EXPORTS bool isFinished() const;
+
+			/** Start decoding a new list. */
+			MOHPC_EXPORTS void reset();
+
+		private:
+			size_t decodeRecords(const uint8_t* data, size_t size, std::vector<serverAddress_t>& addresses);
+
+		private:
+			// end of the previous piece, large enough for the end marker
+			uint8_t pendingData[RECORD_SIZE + 1];
+			size_t pendingLen;
+			bool finished;
+		};
+	}
+}
@@ -0,0 +1,125 @@
+/**
+ * Publication of parsed snapshots to other threads.
+ *
+ * The network thread fills a free slot and makes it the latest snapshot, readers take a reference to the latest one.
+ * Neither side waits on the other: a slot that is referenced is never written to,
+ * and the network thread skips the publication when every slot is referenced.
+ */
+
+#pragma once
+
+#include "../../Global.h"
+#include "../InfoTypes.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+namespace MOHPC
+{
+	namespace Network
+	{
+		class SnapshotPublisher;
+
+		/**
+		 * Reference to a published snapshot. The snapshot doesn't change as long as the reference is held.
+		 */
+		class MOHPC_EXPORTS PublishedSnapshotRef
+		{
+			friend class SnapshotPublisher;
+
+		public:
+			PublishedSnapshotRef();
+			PublishedSnapshotRef(PublishedSnapshotRef&& other);
+			PublishedSnapshotRef& operator=(PublishedSnapshotRef&& other);
+			PublishedSnapshotRef(const PublishedSnapshotRef& other) = delete;
+			PublishedSnapshotRef& operator=(const PublishedSnapshotRef& other) = delete;
+			~PublishedSnapshotRef();
+
+			/** Release the snapshot before the reference goes out of scope. */
+			void reset();
+
+			/** Return the snapshot, or nullptr if nothing was published. */
+			const SnapshotInfo* get() const;
+			const SnapshotInfo* operator->() const;
+			const SnapshotInfo& operator*() const;
+			explicit operator bool() const;
+
+			/** Return the message number of the snapshot. */
+			uint32_t getMessageNum() const;
+
+			/** Return the publication number, increasing with each publication. */
+			uint64_t getPublication() const;
+
+		private:
+			PublishedSnapshotRef(const SnapshotPublisher* inPublisher, size_t inSlotNum);
+
+		private:
+			const SnapshotPublisher* publisher;
+			size_t slotNum;
+		};
+
+		class MOHPC_EXPORTS SnapshotPublisher
+		{
+			friend class PublishedSnapshotRef;
+
+		public:
+			static constexpr size_t NUM_SLOTS = 8;
+
+		public:
+			SnapshotPublisher();
+			~SnapshotPublisher();
+
+			/**
+			 * Allocate the slots, nothing is published before.
+			 * Must be called before any reader can acquire snapshots.
+			 */
+			void enable();
+
+			/** Return true if enabled. */
+			bool isEnabled() const;
+
+			/**
+			 * Return a free slot to fill, or nullptr if every slot is referenced by readers.
+			 * Must be followed by endPublish(). Only one thread can publish.
+			 */
+			SnapshotInfo* beginPublish();
+
+			/**
+			 * Make the slot returned by beginPublish() the latest snapshot.
+			 *
+			 * @param	messageNum	Message number of the snapshot.
+			 */
+			void endPublish(uint32_t messageNum);
+
+			/** Give back the slot returned by beginPublish() without publishing it. */
+			void cancelPublish();
+
+			/**
+			 * Return a reference to the latest snapshot. Can be called from any thread.
+			 * The reference is empty if nothing was published yet.
+			 */
+			PublishedSnapshotRef acquireLatest() const;
+
+			/** Return the number of snapshots that were published. */
+			uint64_t getNumPublished() const;
+
+			/** Return the number of snapshots that couldn't be published because readers were holding every slot. */
+			uint64_t getNumSkipped() const;
+
+		private:
+			void release(size_t slotNum) const;
+
+		private:
+			struct slot_t;
+
+			std::unique_ptr<slot_t[]> slots;
+			// publication number and slot of the latest snapshot
+			std::atomic<uint64_t> latest;
+			std::atomic<uint64_t> numPublished;
+			std::atomic<uint64_t> numSkipped;
+			size_t writingSlot;
+			size_t nextSlot;
+		};
+	}
+}
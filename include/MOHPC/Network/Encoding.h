@@ -50,6 +50,7 @@ namespace MOHPC
 			MOHPC_EXPORTS uint32_t getReliableAcknowledge() const;
 			MOHPC_EXPORTS void setSecretKey(uint32_t num);
 			MOHPC_EXPORTS uint32_t getSecretKey() const;
+			MOHPC_EXPORTS uint32_t getChallenge() const;
 
 		private:
 			uint32_t XORKeyIndex(size_t i, size_t& index, const uint8_t* string);
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "../Global.h"
+#include "../Object.h"
+#include "../Utilities/SharedPtr.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace MOHPC
+{
+	namespace Network
+	{
+		/**
+		 * Counter updated by the network thread that can be read from any other thread.
+		 * Updates are relaxed atomic additions, cheap enough to be left in release builds.
+		 */
+		class MetricCounter
+		{
+		public:
+			MetricCounter()
+				: value(0)
+			{}
+
+			MetricCounter(const MetricCounter&) = delete;
+			MetricCounter& operator=(const MetricCounter&) = delete;
+
+			/** Add the amount to the counter. */
+			void add(uint64_t amount = 1)
+			{
+				value.fetch_add(amount, std::memory_order_relaxed);
+			}
+
+			/** Return the current value of the counter. */
+			uint64_t get() const
+			{
+				return value.load(std::memory_order_relaxed);
+			}
+
+			/** Set the counter back to 0. */
+			void reset()
+			{
+				value.store(0, std::memory_order_relaxed);
+			}
+
+		private:
+			std::atomic<uint64_t> value;
+		};
+
+		/**
+		 * Histogram of values (such as durations) with fixed power of two buckets,
+		 * updated by the network thread and readable from any other thread.
+		 * Bucket 0 counts the value 0, bucket N counts values from 2^(N-1) to 2^N - 1,
+		 * the last bucket also counts all values above.
+		 */
+		class MetricHistogram
+		{
+		public:
+			static constexpr size_t NUM_BUCKETS = 32;
+
+		public:
+			MOHPC_EXPORTS MetricHistogram();
+
+			MetricHistogram(const MetricHistogram&) = delete;
+			MetricHistogram& operator=(const MetricHistogram&) = delete;
+
+			/** Count the value in its bucket. */
+			MOHPC_EXPORTS void record(uint64_t value);
+
+			/** Return the number of recorded values. */
+			MOHPC_EXPORTS uint64_t getCount() const;
+
+			/** Return the sum of recorded values. */
+			MOHPC_EXPORTS uint64_t getSum() const;
+
+			/** Return the highest recorded value. */
+			MOHPC_EXPORTS uint64_t getMax() const;
+
+			/** Return the number of values counted by the bucket. */
+			MOHPC_EXPORTS uint64_t getBucketCount(size_t bucketNum) const;
+
+			/**
+			 * Return the estimated value below which the specified percentage of values fall.
+			 * The estimation is the highest value of the bucket holding the percentile.
+			 *
+			 * @param	percentile	Percentage, from 0 to 100.
+			 */
+			MOHPC_EXPORTS uint64_t getPercentile(double percentile) const;
+
+			/** Clear all buckets. */
+			MOHPC_EXPORTS void reset();
+
+			/** Return the bucket that counts the value. */
+			MOHPC_EXPORTS static size_t getBucketNum(uint64_t value);
+
+			/** Return the highest value counted by the bucket. */
+			MOHPC_EXPORTS static uint64_t getBucketLimit(size_t bucketNum);
+
+		private:
+			std::atomic<uint64_t> buckets[NUM_BUCKETS];
+			std::atomic<uint64_t> count;
+			std::atomic<uint64_t> sum;
+			std::atomic<uint64_t> max;
+		};
+
+		/**
+		 * Traffic of a channel or of a group of channels.
+		 * Updates are forwarded to the parent so a server or the network manager
+		 * have the total traffic of all their connections.
+		 */
+		class ChannelMetrics
+		{
+			MOHPC_OBJECT_DECLARATION(ChannelMetrics);
+
+		public:
+			MOHPC_EXPORTS ChannelMetrics();
+			MOHPC_EXPORTS ChannelMetrics(const SharedPtr<ChannelMetrics>& parent);
+
+			/** Set the metrics to forward updates to. Must be set before the channel is used. */
+			MOHPC_EXPORTS void setParent(const SharedPtr<ChannelMetrics>& parent);
+
+			MOHPC_EXPORTS void packetReceived(size_t size);
+			MOHPC_EXPORTS void packetSent(size_t size);
+			MOHPC_EXPORTS void packetsDropped(size_t numPackets);
+			MOHPC_EXPORTS void packetOutOfOrder();
+			MOHPC_EXPORTS void fragmentReceived();
+			MOHPC_EXPORTS void fragmentSent();
+			MOHPC_EXPORTS void messageReassembled();
+
+		public:
+			MetricCounter packetsIn;
+			MetricCounter packetsOut;
+			MetricCounter bytesIn;
+			MetricCounter bytesOut;
+			// sequences that were never received
+			MetricCounter droppedPackets;
+			// packets received after a newer sequence, discarded
+			MetricCounter outOfOrderPackets;
+			MetricCounter fragmentsIn;
+			MetricCounter fragmentsOut;
+			// messages rebuilt from fragments
+			MetricCounter reassembledMessages;
+
+		private:
+			SharedPtr<ChannelMetrics> parent;
+		};
+		using ChannelMetricsPtr = SharedPtr<ChannelMetrics>;
+
+		/**
+		 * Metrics of a game connection to a server.
+		 */
+		class ClientMetrics
+		{
+		public:
+			// size of server messages as received, Huffman compressed
+			MetricCounter compressedBytesIn;
+			// size of server messages once decompressed
+			MetricCounter uncompressedBytesIn;
+			// size of client messages once compressed
+			MetricCounter compressedBytesOut;
+			// size of client messages before compression
+			MetricCounter uncompressedBytesOut;
+			MetricCounter gameStates;
+			MetricCounter snapshots;
+			// the predicted origin didn't match the origin from the server
+			MetricCounter predictionErrors;
+			// time to parse each snapshot, in microseconds
+			MetricHistogram snapshotParseTime;
+			// ping of each snapshot, in milliseconds
+			MetricHistogram ping;
+		};
+	}
+}
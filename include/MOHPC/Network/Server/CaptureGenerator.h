@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../../Global.h"
+#include "../Capture.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace MOHPC
+{
+	namespace Network
+	{
+		/**
+		 * Generate the capture of a connection to a server, without any server.
+		 * The capture starts with the gamestate, followed by snapshots of players and entities moving around,
+		 * encoded like the server host encodes messages.
+		 * Only the protocol of MOHAA >= 1.1 is generated.
+		 */
+		class CaptureGenerator
+		{
+		public:
+			/**
+			 * @param	challenge	Challenge used to encode messages, the replayed connection must use the same.
+			 */
+			MOHPC_EXPORTS CaptureGenerator(uint32_t challenge);
+
+			/** Set the number of entities in each snapshot (64 by default). */
+			MOHPC_EXPORTS void setNumEntities(size_t numEntities);
+
+			/** Set the time between two snapshots in milliseconds (50 by default). */
+			MOHPC_EXPORTS void setFrameTime(uint32_t frameTime);
+
+			/** Make entities solid, with the bounding box of a standing or crouching player (not solid by default). */
+			MOHPC_EXPORTS void setSolidEntities(bool solidEntities);
+
+			/**
+			 * Send a server command with a snapshot.
+			 *
+			 * @param	snapNum	Index of the snapshot, starting from 0.
+			 * @param	command	Command to execute on the client, like "cs 2 \"value\"".
+			 */
+			MOHPC_EXPORTS void addServerCommand(size_t snapNum, const char* command);
+
+			/**
+			 * Add the gamestate and the snapshots to the capture.
+			 *
+			 * @param	capture			Capture to fill, the protocol and the challenge are also set.
+			 * @param	numSnapshots	Number of snapshots to generate.
+			 */
+			MOHPC_EXPORTS void generate(PacketCapture& capture, size_t numSnapshots);
+
+		private:
+			struct serverCommand_t
+			{
+				size_t snapNum;
+				std::string command;
+			};
+
+			std::vector<serverCommand_t> serverCommands;
+			uint32_t challenge;
+			uint32_t frameTime;
+			size_t numEntities;
+			bool solidEntities;
+		};
+	}
+}
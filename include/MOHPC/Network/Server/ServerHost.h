@@ -7,6 +7,7 @@
 #include "../Socket.h"
 #include "../Encoding.h"
 #include "../Channel.h"
+#include "../Metrics.h"
 
 #include "../../Common/Container.h"
 
@@ -44,16 +45,26 @@ namespace MOHPC
 			uint32_t clientSequence;
 
 		public:
-			ClientData(const IUdpSocketPtr& socket, const NetAddrPtr& from, uint16_t qport, uint32_t challengeNum);
+			ClientData(const IUdpSocketPtr& socket, const NetAddrPtr& from, uint16_t qport, uint32_t challengeNum, const ChannelMetricsPtr& serverMetrics);
 
 			const NetAddr& getAddress() const;
 			uint16_t getQPort() const;
 			Encoding& getEncoding() const;
 			uint32_t newSequence();
 
+			/**
+			 * Encode a server message written for the client.
+			 * The message starts with the sequence number followed by the reliable acknowledge.
+			 */
+			void encodeMessage(uint8_t* data, size_t len, uint32_t sequenceNum);
+
+			/** Return the traffic of the client, also added to the server traffic. */
+			const ChannelMetricsPtr& getMetrics() const;
+
 		private:
 			IUdpSocketPtr socket;
 			EncodingPtr encoding;
+			ChannelMetricsPtr metrics;
 			NetAddrPtr source;
 			uint32_t challengeNum;
 			uint32_t sequenceNum;
@@ -82,6 +93,9 @@ namespace MOHPC
 
 			void processClient(ClientData& client, uint32_t sequenceNum, IMessageStream& stream, MSG& msg);
 
+			/** Return the traffic of the server and all its clients. Can be read from any thread. */
+			MOHPC_EXPORTS const ChannelMetricsPtr& getMetrics() const;
+
 		private:
 			void connectionLessReply(const NetAddr& target, const char* reply);
 
@@ -94,6 +108,7 @@ namespace MOHPC
 			uint32_t serverId;
 			IUdpSocketPtr serverSocket;
 			INetchanPtr conChan;
+			ChannelMetricsPtr metrics;
 			Container<ClientDataPtr> clientList;
 			Container<Challenge> challenges;
 		};
@@ -0,0 +1,1051 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+//
+// bg_pmove_imp.h -- the part of the player movement that collides, templated over the collision
+
+#pragma once
+
+#include "../../Managers/ShaderManager.h"
+
+namespace MOHPC
+{
+	/*
+	===================
+	PM_AirMove
+
+	===================
+	*/
+	template<typename Collision>
+	void Pmove::PM_AirMove( Collision& collision )
+	{
+		Vector		wishvel;
+		float		   fmove;
+		float       smove;
+		Vector		wishdir;
+		float		   wishspeed;
+		float		   scale;
+		usercmd_t	cmd;
+
+		PM_GetMove( &fmove, &smove );
+
+		pm.ps->pm_time = 0;
+
+		cmd = pm.cmd;
+		scale = PM_CmdScale( &cmd );
+
+		wishvel[ 0 ] = pml.flat_forward[ 0 ] * fmove - pml.flat_left[ 0 ] * smove;
+		wishvel[ 1 ] = pml.flat_forward[ 1 ] * fmove - pml.flat_left[ 1 ] * smove;
+		wishvel[ 2 ] = 0;
+
+		VecCopy( wishvel, wishdir );
+		wishspeed = VectorNormalize( wishdir );
+		wishspeed *= scale;
+
+		// not on ground, so little effect on velocity
+		PM_Accelerate( wishdir, wishspeed, pm_airaccelerate );
+
+		// we may have a ground plane that is very steep, even
+		// though we don't have a groundentity
+		// slide along the steep plane
+		if( pml.groundPlane )
+		{
+			PM_ClipVelocity( pm.ps->velocity, pml.groundTrace.plane.normal, pm.ps->velocity, OVERCLIP );
+		}
+
+		PM_StepSlideMove( collision, true );
+
+		PM_CheckTerminalVelocity();
+	}
+
+	template<typename Collision>
+	bool Pmove::PM_FeetOnGround(Collision& collision, const Vector& pos)
+	{
+		const Vector min4x4(-8, 0, 0);
+		const Vector max4x4(4, 4, 8);
+		Vector start;
+		Vector end;
+		trace_t trace;
+
+		VecCopy(pos, start);
+		VecCopy(pos, end);
+		// Some fixes not present in Quake3/OpenMOHAA
+		end[2] -= 16.1f;
+
+		collision.trace( &trace, start, min4x4, max4x4, end, pm.ps->clientNum, pm.tracemask, true, false );
+
+		return trace.fraction != 1.0f;
+	}
+
+	template<typename Collision>
+	bool Pmove::PM_FindBestFallPos(Collision& collision, const Vector& pos, Vector& bestdir)
+	{ 
+		trace_t trace;
+		Vector ang;
+		Vector dir;
+		Vector start;
+		Vector end;
+		Vector move;
+		int i;
+		bool set;
+		float radius;
+
+		VectorClear( bestdir );
+
+		set = false;
+
+		radius = pm.maxs[ 0 ] - pm.mins[ 0 ] + 1.0f;
+
+		VecCopy( pos, start );
+		start[ 2 ] -= 16.1f;
+
+		VecSet( ang, 0, pm.ps->viewangles[ 1 ], 0 );
+		for( i = 0; i < 16; i++, ang[ 1 ] += 22.5f )
+		{
+			AngleVectorsLeft( ang, dir, NULL, NULL );
+			VectorMA( pos, radius, dir, move );
+
+			collision.trace( &trace, pos, pm.mins, pm.maxs, move, pm.ps->clientNum, pm.tracemask, true, false );
+
+			VecCopy( trace.endpos, end );
+			end[ 2 ] = start[ 2 ];
+
+			collision.trace( &trace, trace.endpos, pm.mins, pm.maxs, end, pm.ps->clientNum, pm.tracemask, true, false );
+			if( trace.fraction == 1.0f )
+			{
+				VecCopy( trace.endpos, end );
+				collision.trace( &trace, end, pm.mins, pm.maxs, start, pm.ps->clientNum, pm.tracemask, true, false );
+
+				if( trace.fraction < 1.0f )
+				{
+					VecAdd( bestdir, trace.plane.normal, bestdir );
+					set = true;
+				}
+			}
+		}
+
+		if( !set || !VectorNormalize( bestdir ) )
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	template<typename Collision>
+	void Pmove::PM_CheckFeet(Collision& collision, const Vector& vWishdir)
+	{
+		Vector		temp;
+		trace_t		trace;
+
+		if( pm.stepped )
+		{
+			pm.ps->feetfalling = 0;
+			return;
+		}
+
+		if( !pm.ps->walking )
+		{
+			return;
+		}
+
+		VectorMA( pm.ps->origin, 0.2f, pm.ps->velocity, temp );
+		temp[ 2 ] = pm.ps->origin[ 2 ] + 2;
+		if( PM_FeetOnGround( collision, pm.ps->origin ) || PM_FeetOnGround( collision, temp ) )
+		{
+			pm.ps->feetfalling = 0;
+			return;
+		}
+
+		if( pm.ps->feetfalling > 0 )
+		{
+			pm.ps->feetfalling--;
+		}
+
+		if( !pm.ps->feetfalling )
+		{
+			if( !PM_FindBestFallPos( collision, pm.ps->origin, pm.ps->falldir ) ) {
+				return;
+			}
+
+			pm.ps->feetfalling = 5;
+		}
+
+		VectorMA( pm.ps->origin, 15.0f * pml.frametime, pm.ps->falldir, temp );
+
+		collision.trace( &trace, pm.ps->origin, pm.mins, pm.maxs, temp, pm.ps->clientNum, pm.tracemask, true, false );
+		if( trace.fraction == 0 )
+		{
+			pm.ps->feetfalling = 0;
+			return;
+		}
+
+		if( ( vWishdir[ 0 ] == 0.0f && vWishdir[ 1 ] == 0.0f ) ||
+			DotProduct( vWishdir, pm.ps->falldir ) > 0.0f )
+		{
+			pm.ps->walking = false;
+			VecCopy( trace.endpos, pm.ps->origin );
+		}
+	}
+
+	/*
+	===================
+	PM_WalkMove
+
+	===================
+	*/
+	template<typename Collision>
+	void Pmove::PM_WalkMove( Collision& collision ) {
+		int			i;
+		Vector		wishvel;
+		float		fmove, smove;
+		Vector		wishdir;
+		float		wishspeed;
+		float		scale;
+		usercmd_t	cmd;
+		float		accelerate;
+
+		PM_Friction();
+
+		PM_GetMove( &fmove, &smove );
+
+		cmd = pm.cmd;
+		scale = PM_CmdScale( &cmd );
+
+		if( ( pm.cmd.buttons.flags & BUTTON_RUN ) && fmove && !smove )
+		{
+			pm.ps->pm_time += pml.msec;
+		}
+		else
+		{
+			pm.ps->pm_time = 0;
+		}
+
+		// project the forward and right directions onto the ground plane
+		PM_ClipVelocity( pml.flat_forward, pml.groundTrace.plane.normal, pml.flat_forward, OVERCLIP );
+		PM_ClipVelocity( pml.flat_left, pml.groundTrace.plane.normal, pml.flat_left, OVERCLIP );
+		//
+		VectorNormalize( pml.flat_forward );
+		VectorNormalize( pml.flat_left );
+
+		for( i = 0; i < 3; i++ )
+		{
+			wishvel[ i ] = pml.flat_forward[ i ] * fmove - pml.flat_left[ i ] * smove;
+		}
+
+		VecCopy( wishvel, wishdir );
+		wishspeed = VectorNormalize( wishdir );
+		wishspeed *= scale;
+
+		// clamp the speed lower if wading or walking on the bottom
+		if( pm.waterlevel )
+		{
+			float	waterScale;
+
+			if( pm.waterlevel == 1.0f )
+			{
+				waterScale = 0.80f;
+			}
+			else
+			{
+				waterScale = 0.5f;
+			}
+
+			if( wishspeed > pm.ps->speed * waterScale ) {
+				wishspeed = pm.ps->speed * waterScale;
+			}
+		}
+
+		if( pml.groundTrace.surfaceFlags & SURF_SLICK ) {
+			accelerate = pm_airaccelerate;
+		} else {
+			accelerate = pm_accelerate;
+		}
+
+		PM_Accelerate( wishdir, wishspeed, accelerate );
+
+		if( pml.groundTrace.surfaceFlags & SURF_SLICK ) {
+			pm.ps->velocity[ 2 ] -= pm.ps->gravity * pml.frametime;
+		}
+
+		// slide along the ground plane
+		PM_ClipVelocity( pm.ps->velocity, pml.groundTrace.plane.normal,
+			pm.ps->velocity, OVERCLIP );
+
+		// don't do anything if standing still
+		if( pm.ps->velocity[ 0 ] || pm.ps->velocity[ 1 ] )
+		{
+			PM_StepSlideMove( collision, true );
+		}
+
+		PM_CheckFeet( collision, wishdir );
+	}
+
+	/*
+	=============
+	PM_CorrectAllSolid
+	=============
+	*/
+	// Some code has not been fixed in OpenMOHAA
+	template<typename Collision>
+	int Pmove::PM_CorrectAllSolid(Collision& collision)
+	{
+		int			i, j, k;
+		Vector		point, point2;
+		trace_t		trace, trace2;
+
+		if ( pm.debugLevel ) {
+			//Com_Printf("%i:allsolid\n", c_pmove);
+		}
+
+		// jitter around
+		for (i = -1; i <= 1; i++) {
+			for (j = -1; j <= 1; j++) {
+				for (k = -1; k <= 1; k++) {
+					VecCopy(pm.ps->origin, point);
+					point[0] += (float) i;
+					point[1] += (float) j;
+					point[2] += (float) k;
+					collision.trace( &trace, point, pm.mins, pm.maxs, point, pm.ps->clientNum, pm.tracemask, true, false );
+					if ( !trace.allsolid && !trace.startsolid ) {
+						pm.ps->origin[0] = point[0];
+						pm.ps->origin[1] = point[1];
+						pm.ps->origin[2] = point[2];
+						point2 = point;
+						point2[2] -= 0.25f;
+
+						collision.trace( &trace2, point, pm.mins, pm.maxs, point2, pm.ps->clientNum, pm.tracemask, true, false );
+						pml.groundTrace = trace2;
+						pm.ps->groundTrace = trace2;
+						return true;
+					}
+				}
+			}
+		}
+
+		//pm.ps->groundEntityNum = ENTITYNUM_NONE;
+		//pml.groundPlane = false;
+		//pml.walking = false;
+
+		return false;
+	}
+
+	/*
+	=============
+	PM_GroundTrace
+	=============
+	*/
+	template<typename Collision>
+	void Pmove::PM_GroundTrace( Collision& collision ) {
+		Vector		point;
+		trace_t		trace;
+
+		point[ 0 ] = pm.ps->origin[ 0 ];
+		point[ 1 ] = pm.ps->origin[ 1 ];
+		point[ 2 ] = pm.ps->origin[ 2 ] - 0.25f;
+
+		collision.trace( &trace, pm.ps->origin, pm.mins, pm.maxs, point, pm.ps->clientNum, pm.tracemask, true, false );
+
+		pml.groundTrace = trace;
+		pm.ps->groundTrace = trace;
+
+		// do something corrective if the trace starts in a solid...
+		if ( trace.allsolid || trace.startsolid )
+		{
+			if( !PM_CorrectAllSolid(collision) ) {
+				trace.fraction = 1.0f;
+			}
+		}
+
+		// if the trace didn't hit anything, we are in free fall
+		if ( trace.fraction == 1.0 )
+		{
+			pm.ps->groundEntityNum = ENTITYNUM_NONE;
+			pml.groundPlane = false;
+			pml.walking = false;
+
+			pm.ps->walking = pml.walking;
+			pm.ps->groundPlane = pml.groundPlane;
+			return;
+		}
+
+		// check if getting thrown off the ground
+		if( pm.ps->velocity[ 2 ] > 0.0f && DotProduct( pm.ps->velocity, trace.plane.normal ) > 150.0f )
+		{
+			if ( pm.debugLevel ) {
+				//Com_Printf("%i:kickoff\n", c_pmove);
+			}
+
+			pm.ps->groundEntityNum = ENTITYNUM_NONE;
+			pml.groundPlane = false;
+			pml.walking = false;
+
+			pm.ps->walking = pml.walking;
+			pm.ps->groundPlane = pml.groundPlane;
+			return;
+		}
+
+		// slopes that are too steep will not be considered onground
+		if( trace.plane.normal[ 2 ] < MIN_WALK_NORMAL )
+		{
+			Vector oldvel;
+			float d;
+
+			if ( pm.debugLevel ) {
+				//Com_Printf("%i:steep\n", c_pmove);
+			}
+
+			VecCopy( pm.ps->velocity, oldvel );
+			VecSet( pm.ps->velocity, 0, 0, -1.0f / pml.frametime );
+			PM_SlideMove( collision, false );
+
+			d = VectorLength( pm.ps->velocity );
+			VecCopy( oldvel, pm.ps->velocity );
+
+			if( d > ( 0.1f / pml.frametime ) )
+			{
+				pm.ps->groundEntityNum = ENTITYNUM_NONE;
+				pml.groundPlane = true;
+				pml.walking = false;
+
+				pm.ps->walking = pml.walking;
+				pm.ps->groundPlane = pml.groundPlane;
+				return;
+			}
+		}
+
+		pml.groundPlane = true;
+		pml.walking = true;
+
+		if ( pm.ps->groundEntityNum == ENTITYNUM_NONE )
+		{
+			// just hit the ground
+			if ( pm.debugLevel ) {
+				//Com_Printf( "%i:Land\n", c_pmove );
+			}
+
+			PM_CrashLand();
+		}
+
+		pm.ps->groundEntityNum = trace.entityNum;
+
+		PM_AddTouchEnt( trace.entityNum );
+
+		pm.ps->walking = pml.walking;
+		pm.ps->groundPlane = pml.groundPlane;
+	}
+
+
+	/*
+	=============
+	PM_SetWaterLevel	FIXME: avoid this twice?  certainly if not moving
+	=============
+	*/
+	template<typename Collision>
+	void Pmove::PM_SetWaterLevel( Collision& collision ) {
+		Vector		point;
+		int			cont;
+		int			sample1;
+		int			sample2;
+
+		//
+		// get waterlevel, accounting for ducking
+		//
+		pm.waterlevel = 0;
+		pm.watertype = 0;
+
+		point[0] = pm.ps->origin[0];
+		point[1] = pm.ps->origin[1];
+		point[2] = pm.ps->origin[2] + MINS_Z + 1;
+		cont = collision.pointContents( point, pm.ps->clientNum );
+
+		if ( cont & MASK_WATER ) {
+			sample2 = pm.ps->viewheight - MINS_Z;
+			sample1 = sample2 / 2;
+
+			pm.watertype = cont;
+			pm.waterlevel = 1;
+			point[2] = pm.ps->origin[2] + MINS_Z + sample1;
+			cont = collision.pointContents( point, pm.ps->clientNum );
+			if ( cont & MASK_WATER ) {
+				pm.waterlevel = 2;
+				point[2] = pm.ps->origin[2] + MINS_Z + sample2;
+				cont = collision.pointContents( point, pm.ps->clientNum );
+				if ( cont & MASK_WATER ){
+					pm.waterlevel = 3;
+				}
+			}
+		}
+
+	}
+
+	/*
+	================
+	PmoveSingle
+
+	================
+	*/
+
+	template<typename Collision>
+	void Pmove::moveSingle(Collision& collision)
+	{
+		Vector tempVec;
+		bool walking;
+
+		// this counter lets us debug movement problems with a journal
+		// by setting a conditional breakpoint fot the previous frame
+		c_pmove++;
+
+		// clear results
+		pm.numtouch = 0;
+		pm.watertype = 0;
+		pm.waterlevel = 0;
+
+		if( pm.ps->stats[(size_t)playerstat_e::STAT_HEALTH] <= 0 ) {
+			pm.tracemask &= ~( CONTENTS_BODY | CONTENTS_NOBOTCLIP );	// corpses can fly through bodies
+		}
+
+		if( pm.ps->pm_type == pmType_e::ClimbWall )
+		{
+			pm.ps->fLeanAngle = 0.0f;
+			pm.cmd.buttons.flags &= ~( BUTTON_LEANLEFT | BUTTON_LEANRIGHT );
+		}
+
+		// clear all pmove local vars
+		memset( &pml, 0, sizeof( pml ) );
+
+		// determine the time
+		pml.msec = pm.cmd.serverTime - pm.ps->commandTime;
+		if ( pml.msec < 1 ) {
+			pml.msec = 1;
+		} else if ( pml.msec > 200 ) {
+			pml.msec = 200;
+		}
+
+		pm.ps->commandTime = pm.cmd.serverTime;
+
+		// save old org in case we get stuck
+		VecCopy( pm.ps->origin, pml.previous_origin );
+
+		// save old velocity for crashlanding
+		VecCopy( pm.ps->velocity, pml.previous_velocity );
+
+		pml.frametime = float(pml.msec * 0.001);
+
+		if ((pm.cmd.buttons.flags & (BUTTON_LEANLEFT | BUTTON_LEANRIGHT) &&
+			(pm.cmd.buttons.flags & (BUTTON_LEANLEFT | BUTTON_LEANRIGHT)) != (BUTTON_LEANLEFT | BUTTON_LEANRIGHT))
+			&& canLean(pm.cmd))
+		{
+			if( pm.cmd.buttons.flags & BUTTON_LEANLEFT )
+			{
+				if( pm.ps->fLeanAngle <= -40.0f )
+				{
+					pm.ps->fLeanAngle = -40.0f;
+				}
+				else
+				{
+					float fAngle = pml.frametime * ( -40.0f - pm.ps->fLeanAngle );
+					float fLeanAngle = pml.frametime * -4.0f;
+
+					if( fAngle * 10.0f <= fLeanAngle ) {
+						fLeanAngle = fAngle * 10.0f;
+					}
+
+					pm.ps->fLeanAngle += fLeanAngle;
+				}
+			}
+			else
+			{
+				if( pm.ps->fLeanAngle >= 40.0f )
+				{
+					pm.ps->fLeanAngle = 40.0f;
+				}
+				else
+				{
+					float fAngle = 40.0f - pm.ps->fLeanAngle;
+					float fLeanAngle = pml.frametime * 4.0f;
+					float fMult = pml.frametime * fAngle;
+
+					if( fLeanAngle <= fMult * 10.0f )
+					{
+						fLeanAngle = fMult * 10.0f;
+					}
+					else
+					{
+						fLeanAngle = fMult;
+					}
+
+					pm.ps->fLeanAngle += fLeanAngle;
+				}
+			}
+		}
+		else if( pm.ps->fLeanAngle )
+		{
+			float fAngle = pm.ps->fLeanAngle * pml.frametime * 15.0f;
+
+			if( pm.ps->fLeanAngle <= 0.0f )
+			{
+				float fLeanAngle = -4.0f * pml.frametime;
+
+				if( fAngle <= fLeanAngle )
+				{
+					fLeanAngle = fAngle;
+				}
+
+				pm.ps->fLeanAngle -= fLeanAngle;
+			}
+			else
+			{
+				float fLeanAngle = pml.frametime * 4.0f;
+
+				if( fLeanAngle <= fAngle ) {
+					fLeanAngle = fAngle;
+				}
+
+				pm.ps->fLeanAngle -= fLeanAngle;
+			}
+		}
+
+		if (shouldClearLean()) {
+			pm.ps->fLeanAngle = 0.f;
+		}
+
+		// update the viewangles
+		PM_UpdateViewAngles( pm.ps, &pm.cmd );
+
+		AngleVectorsLeft( pm.ps->viewangles, pml.forward, pml.left, pml.up );
+		VectorClear( tempVec );
+		// yaw
+		tempVec[ 1 ] = pm.ps->viewangles[ 1 ];
+		AngleVectorsLeft( tempVec, pml.flat_forward, pml.flat_left, pml.flat_up );
+
+		if (pm.ps->pm_type >= pmType_e::Dead)
+		{
+			pm.cmd.forwardmove = 0;
+			pm.cmd.rightmove = 0;
+			pm.cmd.upmove = 0;
+			pm.ps->fLeanAngle = 0.0f;
+		}
+
+		if (pm.ps->pm_type == pmType_e::Noclip)
+		{
+			PM_NoclipMove();
+			PM_DropTimers();
+			return;
+		}
+
+		if ((pm.ps->pm_flags & PMF_NO_MOVE) || (pm.ps->pm_flags & PMF_FROZEN))
+		{
+			PM_CheckDuck();
+			return;
+		}
+
+		// set watertype, and waterlevel
+		PM_SetWaterLevel(collision);
+		pml.previous_waterlevel = pm.waterlevel;
+
+		// set mins, maxs, and viewheight
+		PM_CheckDuck();
+
+		// set groundentity
+		PM_GroundTrace(collision);
+
+		if ( pm.ps->pm_type == pmType_e::Dead ) {
+			PM_DeadMove();
+		}
+
+		PM_DropTimers();
+
+		if ( pml.walking ) {
+			// walking on ground
+			PM_WalkMove(collision);
+		} else {
+			// airborne
+			PM_AirMove(collision);
+		}
+
+		walking = pml.walking;
+
+		// set groundentity, watertype, and waterlevel
+		PM_GroundTrace(collision);
+		PM_SetWaterLevel(collision);
+
+		// don't fall down stairs or do really short falls
+		if( !pml.walking && ( walking || ( ( pml.previous_velocity[ 2 ] >= 0 ) && ( pm.ps->velocity[ 2 ] <= 0 ) ) ) )
+		{
+			Vector   point;
+			trace_t  trace;
+
+			point[ 0 ] = pm.ps->origin[ 0 ];
+			point[ 1 ] = pm.ps->origin[ 1 ];
+			point[ 2 ] = pm.ps->origin[ 2 ] - STEPSIZE;
+
+			collision.trace( &trace, pm.ps->origin, pm.mins, pm.maxs, point, pm.ps->clientNum, pm.tracemask, true, false );
+			if( ( trace.fraction < 1.0f ) && ( !trace.allsolid ) )
+			{
+				VecCopy( trace.endpos, pm.ps->origin );
+
+				// allow client to smooth out the step
+				pm.stepped = true;
+
+				// requantify the player's position
+				PM_GroundTrace(collision);
+				PM_SetWaterLevel(collision);
+			}
+		}
+
+		// entering / leaving water splashes
+		PM_WaterEvents();
+	}
+
+	template<typename Collision>
+	void Pmove::move(Collision& collision)
+	{
+		unsigned int finalTime = pm.cmd.serverTime;
+
+		if (finalTime < pm.ps->commandTime)
+		{
+			// should not happen
+			return;
+		}
+
+		if (finalTime > pm.ps->commandTime + 1000) {
+			pm.ps->commandTime = finalTime - 1000;
+		}
+
+		// chop the move up if it is too long, to prevent framerate
+		// dependent behavior
+		while (pm.ps->commandTime != finalTime) {
+			int		msec;
+
+			msec = finalTime - pm.ps->commandTime;
+
+			if (pm.pmove_fixed)
+			{
+				if (msec > pm.pmove_msec) {
+					msec = pm.pmove_msec;
+				}
+			}
+			else if (msec > 66) {
+				msec = 66;
+			}
+
+			pm.cmd.serverTime = pm.ps->commandTime + msec;
+			moveSingle(collision);
+		}
+	}
+
+	// bg_slidemove.c -- part of bg_pmove functionality
+
+	/*
+
+	input: origin, velocity, bounds, groundPlane, trace function
+
+	output: origin, velocity, impacts, stairup boolean
+
+	*/
+
+	/*
+	==================
+	PM_SlideMove
+
+	Returns true if the velocity was clipped in some way
+	==================
+	*/
+	template<typename Collision>
+	bool Pmove::PM_SlideMove( Collision& collision, bool gravity )
+	{
+		static constexpr int MAX_CLIP_PLANES = 5;
+		int			bumpcount, numbumps;
+		Vector		dir;
+		float		d;
+		int			numplanes;
+		Vector		planes[ MAX_CLIP_PLANES ];
+		Vector		primal_velocity;
+		Vector		clipVelocity;
+		int			i, j, k;
+		trace_t	trace;
+		Vector		end;
+		float		time_left;
+		float		into;
+		Vector		endVelocity;
+		Vector		endClipVelocity;
+
+		numbumps = 4;
+
+		VecCopy( pm.ps->velocity, primal_velocity );
+
+		if( gravity ) {
+			VecCopy( pm.ps->velocity, endVelocity );
+			endVelocity[ 2 ] -= pm.ps->gravity * pml.frametime;
+			pm.ps->velocity[ 2 ] = ( pm.ps->velocity[ 2 ] + endVelocity[ 2 ] ) * 0.5f;
+			primal_velocity[ 2 ] = endVelocity[ 2 ];
+			if( pml.groundPlane ) {
+				// slide along the ground plane
+				PM_ClipVelocity( pm.ps->velocity, pml.groundTrace.plane.normal,
+					pm.ps->velocity, OVERCLIP );
+			}
+		}
+
+		time_left = pml.frametime;
+
+		// never turn against the ground plane
+		if( pml.groundPlane ) {
+			numplanes = 1;
+			VecCopy( pml.groundTrace.plane.normal, planes[ 0 ] );
+		}
+		else {
+			numplanes = 0;
+		}
+
+		// never turn against original velocity
+		VectorNormalize2( pm.ps->velocity, planes[ numplanes ] );
+		numplanes++;
+
+		for( bumpcount = 0; bumpcount < numbumps; bumpcount++ ) {
+
+			// calculate position we are trying to move to
+			VectorMA( pm.ps->origin, time_left, pm.ps->velocity, end );
+
+			// see if we can make it there
+			collision.trace( &trace, pm.ps->origin, pm.mins, pm.maxs, end, pm.ps->clientNum, pm.tracemask, true, false );
+
+			if( trace.allsolid ) {
+				// entity is completely trapped in another solid
+				pm.ps->velocity[ 2 ] = 0;	// don't build up falling damage, but allow sideways acceleration
+				return true;
+			}
+
+			if( trace.fraction > 0 ) {
+				// actually covered some distance
+				VecCopy( trace.endpos, pm.ps->origin );
+			}
+
+			if( trace.fraction == 1 ) {
+				break;		// moved the entire distance
+			}
+
+			if( ( trace.plane.normal[ 2 ] < MIN_WALK_NORMAL ) && ( trace.plane.normal[ 2 ] > 0 ) )
+			{
+				// treat steep walls as vertical
+				trace.plane.normal[ 2 ] = 0;
+				VectorNormalizeFast( trace.plane.normal );
+			}
+
+			// save entity for contact
+			PM_AddTouchEnt( trace.entityNum );
+
+			time_left -= time_left * trace.fraction;
+
+			if( numplanes >= MAX_CLIP_PLANES ) {
+				// this shouldn't really happen
+				VectorClear( pm.ps->velocity );
+				return true;
+			}
+
+			//
+			// if this is the same plane we hit before, nudge velocity
+			// out along it, which fixes some epsilon issues with
+			// non-axial planes
+			//
+			for( i = 0; i < numplanes; i++ ) {
+				if( DotProduct( trace.plane.normal, planes[ i ] ) > 0.99 ) {
+					VecAdd( trace.plane.normal, pm.ps->velocity, pm.ps->velocity );
+					break;
+				}
+			}
+			if( i < numplanes ) {
+				continue;
+			}
+			VecCopy( trace.plane.normal, planes[ numplanes ] );
+			numplanes++;
+
+			//
+			// modify velocity so it parallels all of the clip planes
+			//
+
+			// find a plane that it enters
+			for( i = 0; i < numplanes; i++ ) {
+				into = DotProduct( pm.ps->velocity, planes[ i ] );
+				if( into >= 0.1 ) {
+					continue;		// move doesn't interact with the plane
+				}
+
+				// see how hard we are hitting things
+				if( -into > pml.impactSpeed ) {
+					pml.impactSpeed = -into;
+				}
+
+				// slide along the plane
+				PM_ClipVelocity( pm.ps->velocity, planes[ i ], clipVelocity, OVERCLIP );
+
+				// slide along the plane
+				PM_ClipVelocity( endVelocity, planes[ i ], endClipVelocity, OVERCLIP );
+
+				// see if there is a second plane that the new move enters
+				for( j = 0; j < numplanes; j++ ) {
+					if( j == i ) {
+						continue;
+					}
+					if( DotProduct( clipVelocity, planes[ j ] ) >= 0.1 ) {
+						continue;		// move doesn't interact with the plane
+					}
+
+					// try clipping the move to the plane
+					PM_ClipVelocity( clipVelocity, planes[ j ], clipVelocity, OVERCLIP );
+					PM_ClipVelocity( endClipVelocity, planes[ j ], endClipVelocity, OVERCLIP );
+
+					// see if it goes back into the first clip plane
+					if( DotProduct( clipVelocity, planes[ i ] ) >= 0 ) {
+						continue;
+					}
+
+					// slide the original velocity along the crease
+					CrossProduct(planes[i], planes[j], dir);
+					VectorNormalize(dir);
+					d = DotProduct(dir, pm.ps->velocity);
+					VectorScale(dir, d, clipVelocity);
+					// Removed useless math that are present in Quake3/OpenMOHAA
+					d = DotProduct(dir, endVelocity);
+					VectorScale(dir, d, endClipVelocity);
+
+					// see if there is a third plane the the new move enters
+					for( k = 0; k < numplanes; k++ ) {
+						if( k == i || k == j ) {
+							continue;
+						}
+						if( DotProduct( clipVelocity, planes[ k ] ) >= 0.1 ) {
+							continue;		// move doesn't interact with the plane
+						}
+
+						// stop dead at a tripple plane interaction
+						VectorClear( pm.ps->velocity );
+						return true;
+					}
+				}
+
+				// if we have fixed all interactions, try another move
+				VecCopy( clipVelocity, pm.ps->velocity );
+				VecCopy( endClipVelocity, endVelocity );
+				break;
+			}
+		}
+
+		if( gravity ) {
+			VecCopy( endVelocity, pm.ps->velocity );
+		}
+
+		return ( bumpcount != 0 );
+	}
+
+	/*
+	==================
+	PM_StepSlideMove
+
+	==================
+	*/
+	template<typename Collision>
+	void Pmove::PM_StepSlideMove( Collision& collision, bool gravity )
+	{
+		Vector start_o;
+		Vector start_v;
+		Vector nostep_o;
+		Vector nostep_v;
+		trace_t trace;
+		bool bWasOnGoodGround;
+		Vector up;
+		Vector down;
+
+		VecCopy( pm.ps->origin, start_o );
+		VecCopy( pm.ps->velocity, start_v );
+
+		if ( PM_SlideMove( collision, gravity ) == 0 ) {
+			return;		// we got exactly where we wanted to go first try	
+		}
+
+		VecCopy( start_o, down );
+		down[ 2 ] -= STEPSIZE;
+		collision.trace( &trace, start_o, pm.mins, pm.maxs, down, pm.ps->clientNum, pm.tracemask, true, false );
+		VecSet( up, 0, 0, 1 );
+
+		// never step up when you still have up velocity
+		if( pm.ps->velocity[ 2 ] > 0 && ( trace.fraction == 1.0f || 
+			DotProduct( trace.plane.normal, up ) < MIN_WALK_NORMAL ) ) {
+			return;
+		}
+
+		if( pml.groundPlane && pml.groundTrace.plane.normal[ 2 ] >= MIN_WALK_NORMAL )
+		{
+			bWasOnGoodGround = true;
+		}
+		else
+		{
+			bWasOnGoodGround = false;
+		}
+
+		VecCopy( start_o, up );
+		up[ 2 ] += STEPSIZE;
+
+		// test the player position if they were a stepheight higher
+		collision.trace( &trace, up, pm.mins, pm.maxs, up, pm.ps->clientNum, pm.tracemask, true, false );
+		if( trace.allsolid )
+		{
+			up[ 2 ] -= 9.0f;
+			collision.trace( &trace, up, pm.mins, pm.maxs, up, pm.ps->clientNum, pm.tracemask, true, false );
+			if( trace.allsolid )
+			{
+				return;
+			}
+		}
+
+		VecCopy( pm.ps->origin, nostep_o );
+		VecCopy( pm.ps->velocity, nostep_v );
+
+		// try slidemove from this position
+		VecCopy( up, pm.ps->origin );
+		VecCopy( start_v, pm.ps->velocity );
+
+		PM_SlideMove( collision, gravity );
+
+		// push down the final amount
+		VecCopy( pm.ps->origin, down );
+		down[ 2 ] -= STEPSIZE;
+
+		collision.trace( &trace, pm.ps->origin, pm.mins, pm.maxs, down, pm.ps->clientNum, pm.tracemask, true, false );
+		if( !trace.allsolid )
+		{
+			if( bWasOnGoodGround && trace.fraction < 1.0 && trace.plane.normal[ 2 ] < MIN_WALK_NORMAL )
+			{
+	 			VecCopy( nostep_o, pm.ps->origin );
+				VecCopy( nostep_v, pm.ps->velocity );
+				return;
+			}
+
+			VecCopy( trace.endpos, pm.ps->origin );
+		}
+
+		if ( trace.fraction < 1.0f ) {
+			PM_ClipVelocity( pm.ps->velocity, trace.plane.normal, pm.ps->velocity, OVERCLIP );
+		}
+
+		pm.stepped = true;
+	}
+}
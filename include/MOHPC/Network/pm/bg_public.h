@@ -119,6 +119,7 @@ namespace MOHPC
 	static constexpr unsigned int SOLID_BMODEL = 0xffffff;
 
 	class playerState_t;
+	class CollisionWorld;
 
 	using TraceFunction = Function<void(trace_t* results, const Vector& start, const Vector& mins, const Vector& maxs, const Vector& end, uintptr_t passEntityNum, uintptr_t contentMask, bool capsule, bool traceDeep)>;
 	using PointContentsFunction = Function<uint32_t(const Vector& point, uintptr_t passEntityNum)>;
@@ -198,43 +199,106 @@ namespace MOHPC
 		pml_t();
 	};
 
+	/**
+	 * Input and output of one player for Pmove::moveBatch().
+	 */
+	struct pmoveBatch_t
+	{
+		// state (in / out)
+		playerState_t* ps;
+		// command (in)
+		usercmd_t cmd;
+		// collide against these types of surfaces (in)
+		int tracemask;
+
+		// results (out)
+		int moveresult;
+		bool stepped;
+		int pmoveEvent;
+	};
+
+	// movement parameters
+	extern MOHPC_EXPORTS float pm_stopspeed;
+	extern MOHPC_EXPORTS float pm_duckScale;
+	extern MOHPC_EXPORTS float pm_swimScale;
+	extern MOHPC_EXPORTS float pm_wadeScale;
+
+	extern MOHPC_EXPORTS float pm_accelerate;
+	extern MOHPC_EXPORTS float pm_airaccelerate;
+	extern MOHPC_EXPORTS float pm_wateraccelerate;
+
+	extern MOHPC_EXPORTS float pm_friction;
+	extern MOHPC_EXPORTS float pm_waterfriction;
+	extern MOHPC_EXPORTS float pm_flightfriction;
+
 	// FIXME: Make it an abstract interface for versions
-	class Pmove
+	class MOHPC_EXPORTS Pmove
 	{
 	public:
-		MOHPC_EXPORTS Pmove();
+		Pmove();
 		virtual ~Pmove() = default;
 
-		MOHPC_EXPORTS pmove_t& get();
+		pmove_t& get();
 
 		// if a full pmove isn't done on the client, you can just update the angles
 		void PM_GetMove(float* pfForward, float* pfRight);
 		static void PM_UpdateViewAngles(playerState_t* ps, const usercmd_t* cmd);
 		void move_GroundTrace();
-		MOHPC_EXPORTS void move();
+
+		/** Move using the trace and pointcontents callbacks of pmove_t. */
+		void move();
+
+		/**
+		 * Move against the world only, without going through the callbacks of pmove_t.
+		 * This is faster when entities don't need to be clipped against, like when validating movement.
+		 */
+		void move(CollisionWorld& cm);
+
+		/**
+		 * Move with a custom collision, its calls are resolved at compile time so they can be inlined.
+		 * The callbacks of pmove_t are not used.
+		 *
+		 * @param	collision	Object with the following methods:
+		 *						void trace(trace_t* results, const Vector& start, const Vector& mins, const Vector& maxs, const Vector& end, uintptr_t passEntityNum, uintptr_t contentMask, bool capsule, bool traceDeep)
+		 *						uint32_t pointContents(const Vector& point, uintptr_t passEntityNum)
+		 */
+		template<typename Collision>
+		void move(Collision& collision);
+
+		/**
+		 * Move each player with its own command, in a single call.
+		 * The other settings of pmove_t (pmove_fixed, noFootsteps...) are shared by all moves.
+		 *
+		 * @param	cm			World to collide against.
+		 * @param	moves		List of players to move.
+		 * @param	numMoves	Number of players in the list.
+		 */
+		void moveBatch(CollisionWorld& cm, pmoveBatch_t* moves, size_t numMoves);
+
 		void moveAdjustAngleSettings(Vector& vViewAngles, Vector& vAngles, playerState_t* pPlayerState, entityState_t* pEntState);
 		void moveAdjustAngleSettings_Client(Vector& vViewAngles, Vector& vAngles, playerState_t* pPlayerState, entityState_t* pEntState);
 
 	private:
-		void PM_AirMove();
-		bool PM_FeetOnGround(const Vector& pos);
-		bool PM_FindBestFallPos(const Vector& pos, Vector& bestdir);
-		void PM_CheckFeet(const Vector& vWishdir);
-		void PM_WalkMove();
+		// Collision is a class with trace() and pointContents(), see move(Collision&)
+		template<typename Collision> void PM_AirMove(Collision& collision);
+		template<typename Collision> bool PM_FeetOnGround(Collision& collision, const Vector& pos);
+		template<typename Collision> bool PM_FindBestFallPos(Collision& collision, const Vector& pos, Vector& bestdir);
+		template<typename Collision> void PM_CheckFeet(Collision& collision, const Vector& vWishdir);
+		template<typename Collision> void PM_WalkMove(Collision& collision);
 		void PM_DeadMove();
 		void PM_NoclipMove();
 		void PM_CrashLand();
-		int PM_CorrectAllSolid();
-		void PM_GroundTrace();
-		void PM_SetWaterLevel();
+		template<typename Collision> int PM_CorrectAllSolid(Collision& collision);
+		template<typename Collision> void PM_GroundTrace(Collision& collision);
+		template<typename Collision> void PM_SetWaterLevel(Collision& collision);
 		void PM_CheckDuck();
 		void PM_Footsteps();
 		void PM_WaterEvents();
 		void PM_DropTimers();
-		void moveSingle();
+		template<typename Collision> void moveSingle(Collision& collision);
 		void moveAdjustViewAngleSettings_OnLadder(Vector& vViewAngles, Vector& vAngles, playerState_t* pPlayerState, entityState_t* pEntState);
-		bool PM_SlideMove(bool gravity);
-		void PM_StepSlideMove(bool gravity);
+		template<typename Collision> bool PM_SlideMove(Collision& collision, bool gravity);
+		template<typename Collision> void PM_StepSlideMove(Collision& collision, bool gravity);
 		void PM_AddEvent(int newEvent);
 		void PM_ClipVelocity(const Vector& in, const Vector& normal, Vector& out, float overbounce);
 		void PM_AddTouchEnt(int entityNum);
@@ -343,3 +407,5 @@ namespace MOHPC
 	void BG_PlayerStateToEntityState( playerState_t *ps, entityState_t *s, bool snap );
 	void BG_PlayerStateToEntityStateExtraPolate( playerState_t *ps, entityState_t *s, int time, bool snap );
 };
+
+#include "bg_pmove_imp.h"
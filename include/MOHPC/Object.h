@@ -11,11 +11,20 @@ namespace MOHPC
 
 #define MOHPC_OBJECT_DECLARATION(c) \
 	public: \
-	template<typename...Args> static SharedPtr<c> create(Args&&...args) { return makePtr(new (allocate()) c(std::forward<Args>(args)...)); } \
+	template<typename...Args> static SharedPtr<c> create(Args&&...args) \
+	{ \
+		void* memory = allocate(); \
+		c* instance; \
+		/** Placement new doesn't free the memory if the constructor throws */ \
+		try { instance = new (memory) c(std::forward<Args>(args)...); } \
+		catch (...) { deallocate(memory); throw; } \
+		return makePtr(instance); \
+	} \
 	private: \
 	MOHPC_EXPORTS static SharedPtr<c> makePtr(c* ThisPtr); \
 	MOHPC_EXPORTS static void destroy(c* instance); \
 	MOHPC_EXPORTS static void* allocate(); \
+	MOHPC_EXPORTS static void deallocate(void* memory); \
 
 #define MOHPC_OBJECT_DEFINITION(c) \
 	MOHPC::SharedPtr<c> c::makePtr(c* ThisPtr) { return MOHPC::SharedPtr<c>(ThisPtr, &c::destroy); } \
@@ -28,7 +37,8 @@ namespace MOHPC
 		/** Free up memory */ \
 		delete[] reinterpret_cast<unsigned char*>(instance); \
 	} \
-	void* c::allocate() { return new unsigned char[sizeof(c)]; };
+	void* c::allocate() { return new unsigned char[sizeof(c)]; } \
+	void c::deallocate(void* memory) { delete[] reinterpret_cast<unsigned char*>(memory); }
 
 	class Object
 	{
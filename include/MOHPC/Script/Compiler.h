@@ -2,6 +2,7 @@
 
 #include "ScriptClass.h"
 #include "ScriptOpcodes.h"
+#include "GameScript.h"
 #include <MOHPC/Script/parser/parsetree.h>
 
 namespace MOHPC
@@ -72,12 +73,15 @@ namespace MOHPC
 		char PrevVarStackOffset();
 		void AbsorbPrevOpcode();
 		void ClearPrevOpcode();
+		void FuseWithPrevOpcode(int opcode);
 
 		void AddBreakJumpLocation(unsigned char *pos);
 		void AddContinueJumpLocation(unsigned char *pos);
 		void AddJumpLocation(unsigned char *pos);
 		void AddJumpBackLocation(unsigned char *pos);
 		void AddJumpToLocation(unsigned char *pos);
+		void AddRelocation(unsigned char *pos, scriptRelocationType_e type);
+		void RemoveRelocations(unsigned char *pos);
 
 		bool BuiltinReadVariable(unsigned int sourcePos, int type, uintptr_t eventnum);
 		bool BuiltinWriteVariable(unsigned int sourcePos, int type, uintptr_t eventnum);
@@ -96,6 +100,7 @@ namespace MOHPC
 		void EmitContinue(unsigned int sourcePos);
 		void EmitDoWhileJump(sval_t while_stmt, sval_t while_expr, unsigned int sourcePos);
 		void EmitEof(unsigned int sourcePos);
+		void EmitEventOperand(uintptr_t eventnum, scriptRelocationType_e type);
 		void EmitField(sval_t listener_val, sval_t field_val, unsigned int sourcePos);
 		void EmitFloat(float value, unsigned int sourcePos);
 		void EmitFunc1(int opcode, unsigned int sourcePos);
@@ -115,11 +120,14 @@ namespace MOHPC
 		void EmitNop();
 		int	 EmitNot(unsigned int sourcePos);
 		void EmitOpcode(int opcode, unsigned int sourcePos);
+		/** Emit an opcode whose stack usage depends on its operands, such as the number of parameters. */
+		void EmitOpcode(int opcode, int iVarStackOffset, unsigned int sourcePos);
 		void EmitParameter(sval_u lhs, unsigned int sourcePos);
 		int	 EmitParameterList(sval_t event_parameter_list);
 		void EmitRef(sval_t val, unsigned int sourcePos);
 		void EmitStatementList(sval_t val);
 		void EmitString(str value, unsigned int sourcePos);
+		void EmitStringOperand(unsigned int index);
 		void EmitSwitch(sval_t val, unsigned int sourcePos);
 		void EmitValue(sval_t val);
 		void EmitValue(ScriptVariable& var, unsigned int sourcePos);
@@ -148,10 +156,12 @@ namespace MOHPC
 		void Optimize(unsigned char *progBuffer);
 
 		void CompileAssemble(const char *filename, const char *outputfile);
-		bool GetCompiledScript(GameScript *scr);
+		bool GetCompiledScript(GameScript *scr, const char *filename, uint64_t sourceHash);
+		bool SaveCompiledScript(GameScript *scr, const char *filename, uint64_t sourceHash);
 
 		static str GetLine(str content, int line);
 	};
 
-	extern ScriptCompiler* Compiler;
+	/** The compiler of the current thread, used by the parser. */
+	extern thread_local ScriptCompiler* Compiler;
 };
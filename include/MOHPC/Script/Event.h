@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ScriptClass.h"
+#include "ScriptVariable.h"
 #include "../Common/Container.h"
 
 namespace MOHPC
@@ -183,12 +184,20 @@ namespace MOHPC
 	{
 		friend class ScriptVM;
 
+	public:
+		/** Number of arguments stored inside the event itself, without allocating. */
+		static constexpr uint16_t INLINE_ARGS = 4;
+
 	public:
 		bool fromScript;
 		uintptr_t eventnum;
 		uint16_t dataSize;
+		uint16_t maxDataSize;
 		ScriptVariable *data;
 
+	private:
+		ScriptVariable inlineData[INLINE_ARGS];
+
 #ifdef _DEBUG
 		// should be used only for debugging purposes
 		str name;
@@ -196,12 +205,15 @@ namespace MOHPC
 
 	public:
 		CLASS_PROTOTYPE(Event);
+		MOHPC_MEMORY_OPERATORS();
 
-		bool operator==(Event ev) { return eventnum == ev.eventnum; }
-		bool operator!=(Event ev) { return eventnum != ev.eventnum; }
+		bool operator==(const Event& ev) const { return eventnum == ev.eventnum; }
+		bool operator!=(const Event& ev) const { return eventnum != ev.eventnum; }
 
 		Event();
 		Event(uintptr_t eventnum);
+		Event(const Event& other);
+		Event& operator=(const Event& other);
 		Event
 		(
 			const char *command,
@@ -235,6 +247,9 @@ namespace MOHPC
 
 		void Clear(void);
 
+		/** Make room for count arguments, small events use the inline storage. */
+		void ReserveArgs(uint16_t count);
+
 		void CheckPos(uintptr_t pos);
 
 		bool GetBoolean(uintptr_t pos);
@@ -267,6 +282,10 @@ namespace MOHPC
 
 		const char *GetFormat();
 		size_t NumArgs();
+
+	private:
+		void CopyArgs(const Event& other);
+		void FreeArgs();
 	};
 
 #define					NODE_CANCEL				1
@@ -279,6 +298,12 @@ namespace MOHPC
 		int flags;
 		SafePtr<Listener> m_sourceobject;
 
+		// order of posting, for events that fire at the same time
+		size_t sequence;
+		// position in the event manager heap
+		size_t heapIndex;
+
+		// list of pending events of the source object
 		EventQueueNode		*prev;
 		EventQueueNode		*next;
 
@@ -286,7 +311,7 @@ namespace MOHPC
 		str name;
 #endif
 
-		EventQueueNode() { prev = this; next = this; }
+		EventQueueNode() { event = nullptr; time = 0; flags = 0; sequence = 0; heapIndex = 0; prev = nullptr; next = nullptr; }
 		Listener	*GetSourceObject(void) { return m_sourceobject; }
 		void		SetSourceObject(Listener *obj) { m_sourceobject = obj; }
 	};
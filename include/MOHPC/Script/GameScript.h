@@ -2,6 +2,9 @@
 
 #include "AbstractScript.h"
 #include "StateScript.h"
+#include "../Common/Container.h"
+
+#include <cstdint>
 
 namespace MOHPC
 {
@@ -9,6 +12,27 @@ namespace MOHPC
 	class ScriptThread;
 	class GameScript;
 
+	/** Kind of operand that must be resolved again when a compiled script is loaded. */
+	enum class scriptRelocationType_e : uint8_t
+	{
+		/** const_str from the script manager's string dictionary. */
+		String,
+		/** Event number of a normal command. */
+		NormalEvent,
+		/** Event number of a command with a return value. */
+		ReturnEvent,
+		/** Pointer to a switch StateScript. */
+		SwitchState
+	};
+
+	typedef struct {
+		/** Offset of the operand in the program buffer. */
+		uint32_t offset;
+
+		/** What the operand is. */
+		scriptRelocationType_e type;
+	} script_relocation_t;
+
 	class CatchBlock
 	{
 	public:
@@ -26,6 +50,9 @@ namespace MOHPC
 		// try/throw variable
 		Container<CatchBlock *> m_CatchBlocks;
 
+		// switch variable, owned by the script
+		Container<StateScript *> m_SwitchStates;
+
 	public:
 		// program variables
 		StateScript* m_State;
@@ -39,6 +66,13 @@ namespace MOHPC
 		// stack variables
 		unsigned int requiredStackSize;
 
+		// operands that are specific to the current process, recorded by the compiler
+		Container<script_relocation_t> m_Relocations;
+
+	public:
+		/** Bumped each time the compiled script format or the opcodes change. */
+		static constexpr uint32_t COMPILED_VERSION = 3;
+
 	public:
 
 		GameScript();
@@ -51,6 +85,19 @@ namespace MOHPC
 
 		void Close();
 		void Load(const void *sourceBuffer, size_t sourceLength);
+		void SetSource(const void *sourceBuffer, size_t sourceLength);
+
+		/** Return the key used to find the compiled version of the source. */
+		static uint64_t GetSourceHash(const void *sourceBuffer, size_t sourceLength);
+
+		/** Serialize the compiled program, labels and source positions. */
+		bool SaveCompiled(uint64_t sourceHash, Container<uint8_t>& out);
+
+		/**
+		 * Load a program that was serialized with SaveCompiled().
+		 * Return false if the data is from another version, doesn't match the source hash or is corrupted.
+		 */
+		bool LoadCompiled(const uint8_t *data, size_t length, uint64_t sourceHash);
 
 
 		bool GetCodePos(unsigned char *codePos, str& filename, uintptr_t& pos);
@@ -29,12 +29,18 @@ namespace MOHPC
 
 	class Listener : public ScriptClass
 	{
+		friend class EventManager;
+
 	public:
 		con_set<const_str, ConList> *m_NotifyList;
 		con_set<const_str, ConList> *m_WaitForList;
 		con_set<const_str, ConList> *m_EndList;
 		ScriptVariableList *vars;
 
+	private:
+		// first of the events posted by this listener
+		EventQueueNode* m_pendingEvents;
+
 	private:
 		void ExecuteScriptInternal(Event *ev, ScriptVariable& scriptVariable);
 		void ExecuteThreadInternal(Event *ev, ScriptVariable& returnValue);
@@ -154,6 +154,17 @@ namespace MOHPC
 		OP_END,
 		OP_RETURN,
 
+		// superinstructions, they replace the first opcode of a pair
+		// and keep the layout, the second opcode is skipped at runtime
+		OP_BIN_EQUALITY_VAR_JUMP_FALSE4,
+		OP_BIN_INEQUALITY_VAR_JUMP_FALSE4,
+		OP_BIN_LESS_THAN_VAR_JUMP_FALSE4,
+		OP_BIN_GREATER_THAN_VAR_JUMP_FALSE4,
+		OP_BIN_LESS_THAN_OR_EQUAL_VAR_JUMP_FALSE4,
+		OP_BIN_GREATER_THAN_OR_EQUAL_VAR_JUMP_FALSE4,
+		OP_STORE_INT1_BIN_PLUS,
+		OP_STORE_INT1_BIN_MINUS,
+
 		OP_PREVIOUS,
 		OP_MAX = OP_PREVIOUS
 	};
@@ -164,4 +175,5 @@ namespace MOHPC
 	int OpcodeVarStackOffset(int opcode);
 	void SetOpcodeVarStackOffset(int opcode, int iVarStackOffset);
 	bool IsExternalOpcode(int opcode);
+	int SuperOpcode(int opcode, int nextOpcode);
 };
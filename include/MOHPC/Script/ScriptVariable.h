@@ -98,7 +98,29 @@ namespace MOHPC
 		void		setValue(const ScriptVariable& var);
 	};
 
-	class ScriptVariable : public BaseScriptClass {
+	/**
+	 * Script variables don't keep a reference to their asset manager to stay small,
+	 * the managers used to resolve constant strings and targetnames are taken
+	 * from the script object that is running on the current thread.
+	 */
+	class ScriptVariableContext
+	{
+	public:
+		MOHPC_EXPORTS ScriptVariableContext(const BaseScriptClass* owner);
+		MOHPC_EXPORTS ~ScriptVariableContext();
+
+		/** Return the script object running on this thread, or NULL. */
+		MOHPC_EXPORTS static const BaseScriptClass* GetOwner();
+
+	private:
+		const BaseScriptClass* previousOwner;
+	};
+
+	/**
+	 * Value used by the VM stack, events and arrays.
+	 * It is a plain tagged union of 16 bytes, types that don't fit are stored on the heap.
+	 */
+	class ScriptVariable {
 	public:
 		const_str		key;		// variable name
 		unsigned char	type;		// variable type
@@ -128,6 +150,9 @@ namespace MOHPC
 		void					ClearInternal();
 		void					ClearPointerInternal();
 
+		static SharedPtr<class GameManager>		GetGameManager();
+		static SharedPtr<class ScriptManager>	GetScriptManager();
+
 	public:
 		ScriptVariable();
 		ScriptVariable(const ScriptVariable& variable);
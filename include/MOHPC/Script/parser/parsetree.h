@@ -114,5 +114,5 @@ namespace MOHPC
 		yyparsedata() { total_length = 0, braces_count = 0, line_count = 0, pos = 0; val = sval_t(); sourceBuffer = nullptr; gameScript = nullptr; }
 	};
 
-	extern yyparsedata parsedata;
+	extern thread_local yyparsedata parsedata;
 };
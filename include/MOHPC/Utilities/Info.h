@@ -3,6 +3,7 @@
 #include "../Global.h"
 #include "../Common/str.h"
 #include <stdint.h>
+#include <vector>
 
 namespace MOHPC
 {
@@ -32,11 +33,54 @@ namespace MOHPC
 		void deleteTmps();
 	};
 
+	/**
+	 * Key and value in an infostring, they are not null-terminated.
+	 */
+	struct InfoKeyValue
+	{
+		const char* key;
+		const char* value;
+		size_t keyLen;
+		size_t valueLen;
+	};
+
+	/**
+	 * Index of the keys of an infostring, parsed in one pass.
+	 * Keys are hashed without case so looking up a key doesn't scan the infostring.
+	 * The infostring must stay valid as long as the index is used.
+	 */
+	class MOHPC_EXPORTS InfoIndex
+	{
+	private:
+		std::vector<InfoKeyValue> keyValues;
+		// index + 1 of the key value, 0 if empty
+		std::vector<uint32_t> slots;
+
+	public:
+		InfoIndex();
+		InfoIndex(const char* text, size_t size);
+
+		/** Index a new infostring, up to the size or the first null character. */
+		void parse(const char* text, size_t size);
+
+		/**
+		 * Return the key and the value, nullptr if the key doesn't exist.
+		 * The first one is returned if the key appears more than once.
+		 */
+		const InfoKeyValue* find(const char* key) const;
+		const InfoKeyValue* find(const char* key, size_t keyLen) const;
+
+		/** Return the number of keys, in the order of the infostring. */
+		size_t getNumKeys() const;
+		const InfoKeyValue& getKeyValue(size_t index) const;
+	};
+
 	class MOHPC_EXPORTS ReadOnlyInfo
 	{
 	private:
 		const char* keyBuffer;
 		size_t size;
+		InfoIndex index;
 
 	public:
 		ReadOnlyInfo();
@@ -47,6 +91,7 @@ namespace MOHPC
 		ReadOnlyInfo& operator=(ReadOnlyInfo&& other) noexcept;
 
 		str ValueForKey(const char* key) const;
+		/** Return the value in the infostring, an empty string if the key doesn't exist. */
 		const char* ValueForKey(const char* key, size_t& outLen) const;
 		uint32_t IntValueForKey(const char* key) const;
 		uint64_t LongValueForKey(const char* key) const;
@@ -54,15 +99,30 @@ namespace MOHPC
 		const char* GetString() const;
 		size_t GetInfoLength() const;
 
+		/** Return the index of the keys. */
+		const InfoIndex& GetIndex() const;
+
 		InfoIterator createConstIterator() const;
 	};
 
+	/**
+	 * Infostring that can be modified.
+	 * Keys are hashed without case, the infostring is only written when it is requested after modifications.
+	 */
 	class MOHPC_EXPORTS Info
 	{
 	private:
-		char* keyBuffer;
-		size_t alloced;
-		size_t size;
+		struct entry_t
+		{
+			str key;
+			str value;
+		};
+
+		std::vector<entry_t> entries;
+		// index + 1 of the entry, 0 if empty
+		std::vector<uint32_t> slots;
+		mutable std::vector<char> keyBuffer;
+		mutable bool modified;
 
 	public:
 		Info();
@@ -71,16 +131,22 @@ namespace MOHPC
 		~Info();
 		Info& operator=(Info&& info);
 
+		/** Set the value of the key, the key keeps its place if it already exists. */
 		void SetValueForKey(const char* key, const char* value);
 		void RemoveKey(const char* key);
 		str ValueForKey(const char* key) const;
 		uint32_t IntValueForKey(const char* key) const;
 		uint64_t LongValueForKey(const char* key) const;
 
+		/** Return the infostring, nullptr if there are no keys. */
 		const char* GetString() const;
 		size_t GetInfoLength() const;
 
 		InfoIterator createConstIterator() const;
+
+	private:
+		void serialize() const;
+		void rebuildSlots();
 	};
 
 	class JsonStyleBeautifier
@@ -12,6 +12,17 @@ using namespace MOHPC;
 
 MOHPC_OBJECT_DEFINITION(AssetManager);
 
+namespace MOHPC
+{
+	class Hasher
+	{
+	public:
+		CSHA1 sha1;
+		// an asset can copy the hash of another asset that is already complete
+		bool finalized = false;
+	};
+}
+
 template<>
 intptr_t MOHPC::HashCode<std::type_index>(const std::type_index& key)
 {
@@ -21,6 +32,7 @@ intptr_t MOHPC::HashCode<std::type_index>(const std::type_index& key)
 AssetManager::AssetManager()
 {
 	FM = NULL;
+	assetHashing = false;
 
 	MOHPC_LOG(Verbose, "MOHPC %s version %s build %d", VERSION_ARCHITECTURE, VERSION_SHORT_STRING, VERSION_BUILD);
 }
@@ -68,6 +80,16 @@ FileManager* AssetManager::GetFileManager() const
 	return FM;
 }
 
+void AssetManager::SetAssetHashing(bool enabled)
+{
+	assetHashing = enabled;
+}
+
+bool AssetManager::IsAssetHashingEnabled() const
+{
+	return assetHashing;
+}
+
 void AssetManager::AddManager(const std::type_index& ti, const SharedPtr<Manager>& manager)
 {
 	//m_managers[ti] = manager;
@@ -120,6 +142,10 @@ bool AssetManager::CacheLoadAsset(const char *Filename, const SharedPtr<Asset>&
 {
 	A->InitAssetManager(shared_from_this());
 	A->Init(Filename);
+	if (assetHashing) {
+		A->HashInit();
+	}
+
 	if (!A->Load())
 	{
 		// Can't continue
@@ -193,7 +219,7 @@ Asset::~Asset()
 {
 	if (Hash)
 	{
-		delete (CSHA1*)Hash;
+		delete Hash;
 	}
 }
 
@@ -212,57 +238,57 @@ const str& Asset::GetFilename() const
 	return Filename;
 }
 
-void Asset::HashGetHash(uint8_t* Destination) const
+bool Asset::HashGetHash(uint8_t* Destination) const
 {
-	/*
-	if (Hash)
-	{
-		CSHA1* SHA1 = (CSHA1*)Hash;
-		SHA1->GetHash(Destination);
+	if (Hash && Hash->finalized) {
+		return Hash->sha1.GetHash(Destination);
 	}
-	*/
+
+	return false;
 }
 
-void Asset::HashUpdate(const uint8_t* Data, std::streamsize Length)
+void Asset::HashInit()
 {
-	/*
 	if (!Hash)
 	{
-		Hash = (class Hasher*)new CSHA1;
+		Hash = new Hasher;
 	}
+}
 
-	CSHA1* SHA1 = (CSHA1*)Hash;
-	SHA1->Update(Data, (UINT_32)Length);
-	*/
+void Asset::HashUpdate(const uint8_t* Data, std::streamsize Length)
+{
+	// only hashed when enabled in the asset manager
+	if (Hash && !Hash->finalized)
+	{
+		Hash->sha1.Update(Data, (UINT_32)Length);
+	}
 }
 
 void Asset::HashCopy(const Asset* A)
 {
-	/*
 	if (A->Hash)
 	{
 		if (!Hash)
 		{
-			Hash = (class Hasher*)new CSHA1;
+			Hash = new Hasher;
 		}
 
-		CSHA1* SHA1 = (CSHA1*)Hash;
-		*SHA1 = *(CSHA1*)A->Hash;
+		Hash->sha1 = A->Hash->sha1;
+		Hash->finalized = A->Hash->finalized;
 	}
 	else if (Hash)
 	{
-		delete (CSHA1*)Hash;
+		delete Hash;
 		Hash = nullptr;
 	}
-	*/
 }
 
 void Asset::HashFinalize()
 {
-	if (Hash)
+	if (Hash && !Hash->finalized)
 	{
-		CSHA1* SHA1 = (CSHA1*)Hash;
-		SHA1->Final();
+		Hash->sha1.Final();
+		Hash->finalized = true;
 	}
 }
 
@@ -1,12 +1,9 @@
 #include <MOHPC/Collision/Collision.h>
 #include <MOHPC/Managers/ShaderManager.h>
+#include "CollisionPrivate.h"
 
 using namespace MOHPC;
 
-collisionModel_t box_model;
-collisionPlane_t* box_planes;
-collisionBrush_t* box_brush;
-
 static constexpr float SURFACE_CLIP_EPSILON = 0.125f;
 static constexpr clipHandle_t BOX_MODEL_HANDLE = 1023;
 
@@ -88,8 +85,7 @@ MOHPC::terrainCollide_t::terrainCollide_t()
 }
 
 MOHPC::collisionTerrain_t::collisionTerrain_t()
-	: checkcount(0)
-	, surfaceFlags(0)
+	: surfaceFlags(0)
 	, contents(0)
 	, shaderNum(0)
 {
@@ -124,7 +120,6 @@ MOHPC::collisionBrush_t::collisionBrush_t()
 	, contents(0)
 	, numsides(0)
 	, sides(nullptr)
-	, checkcount(0)
 {
 }
 
@@ -152,8 +147,7 @@ MOHPC::patchCollide_t::patchCollide_t()
 }
 
 MOHPC::collisionPatch_t::collisionPatch_t()
-	: checkcount(0)
-	, surfaceFlags(0)
+	: surfaceFlags(0)
 	, contents(0)
 	, shaderNum(0)
 	, subdivisions(0)
@@ -193,10 +187,26 @@ static void SetPlaneSignbits(collisionPlane_t* out)
 	out->signbits = bits;
 }
 
+MOHPC::collisionWorldData_t::collisionWorldData_t()
+{
+}
+
+MOHPC::collisionWorldData_t::~collisionWorldData_t()
+{
+	for (size_t i = 0; i < patchList.NumObjects(); ++i)
+	{
+		delete[] patchList[i].pc.planes;
+		delete[] patchList[i].pc.facets;
+	}
+}
+
 MOHPC_OBJECT_DEFINITION(CollisionWorld);
 
 CollisionWorld::CollisionWorld()
+	: data(makeShared<collisionWorldData_t>())
 {
+	box_planes = nullptr;
+	box_brush = nullptr;
 	checkcount = 0;
 	c_traces = 0;
 	c_patch_traces = 0;
@@ -210,80 +220,69 @@ CollisionWorld::~CollisionWorld()
 
 collisionFencemask_t* CollisionWorld::createFenceMask()
 {
-	return new(fencemasks) collisionFencemask_t();
+	return new(detachData().fencemasks) collisionFencemask_t();
 }
 
 collisionShader_t* CollisionWorld::createShader()
 {
-	return new(shaders) collisionShader_t();
+	return new(detachData().shaders) collisionShader_t();
 }
 
 collisionSideEq_t* CollisionWorld::createSideEquation()
 {
-	return new(sideequations) collisionSideEq_t();
+	return new(detachData().sideequations) collisionSideEq_t();
 }
 
 collisionBrushSide_t* CollisionWorld::createBrushSide()
 {
-	return new(brushsides) collisionBrushSide_t();
+	return new(detachData().brushsides) collisionBrushSide_t();
 }
 
 collisionPlane_t* CollisionWorld::createPlane()
 {
-	return new(planes) collisionPlane_t();
+	return new(detachData().planes) collisionPlane_t();
 }
 
 collisionNode_t* CollisionWorld::createNode()
 {
-	return new(nodes) collisionNode_t();
+	return new(detachData().nodes) collisionNode_t();
 }
 
 collisionLeaf_t* CollisionWorld::createLeaf()
 {
-	return new(leafs) collisionLeaf_t();
+	return new(detachData().leafs) collisionLeaf_t();
 }
 
 void CollisionWorld::createLeafTerrain(collisionTerrain_t* terrain)
 {
-	leafterrains.AddObject(terrain);
+	detachData().leafterrains.AddObject(terrain);
 }
 
 collisionModel_t* CollisionWorld::createModel()
 {
-	return new(cmodels) collisionModel_t();
+	return new(detachData().cmodels) collisionModel_t();
 }
 
 collisionBrush_t* CollisionWorld::createBrush()
 {
-	return new(brushes) collisionBrush_t();
+	return new(detachData().brushes) collisionBrush_t();
 }
 
 collisionPatch_t* CollisionWorld::createPatch()
 {
-	return new(patchList) collisionPatch_t();
+	return new(detachData().patchList) collisionPatch_t();
 }
 
 collisionTerrain_t* CollisionWorld::createTerrain()
 {
-	return new(terrain) collisionTerrain_t();
+	return new(detachData().terrain) collisionTerrain_t();
 }
 
 void MOHPC::CollisionWorld::clearAll()
 {
-	fencemasks.FreeObjectList();
-	shaders.FreeObjectList();
-	brushsides.FreeObjectList();
-	planes.FreeObjectList();
-	nodes.FreeObjectList();
-	leafs.FreeObjectList();
-	leafbrushes.FreeObjectList();
-	leafsurfaces.FreeObjectList();
-	leafterrains.FreeObjectList();
-	cmodels.FreeObjectList();
-	brushes.FreeObjectList();
-	surfaces.FreeObjectList();
-	terrain.FreeObjectList();
-	patchList.FreeObjectList();
+	// other worlds can still be using the previous data
+	data = makeShared<collisionWorldData_t>();
+	clearCheckCounts();
 }
 
 void MOHPC::CollisionWorld::reserve(
@@ -304,181 +303,291 @@ void MOHPC::CollisionWorld::reserve(
 	size_t numPatchList
 )
 {
-	fencemasks.Resize(numFenceMasks);
-	shaders.Resize(numShaders);
-	brushsides.Resize(numBrushSides);
-	planes.Resize(numPlanes);
-	nodes.Resize(numNodes);
-	leafs.Resize(numLeafs);
-	leafbrushes.Resize(numLeafBrushes);
-	leafsurfaces.Resize(numLeafSurfaces);
-	leafterrains.Resize(numLeafTerrains);
-	cmodels.Resize(numCModels);
-	brushes.Resize(numBrushes);
-	surfaces.Resize(numSurfaces);
-	terrain.Resize(numTerrains);
-	patchList.Resize(numPatchList);
+	collisionWorldData_t& worldData = detachData();
+	worldData.fencemasks.Resize(numFenceMasks);
+	worldData.shaders.Resize(numShaders);
+	worldData.brushsides.Resize(numBrushSides);
+	worldData.planes.Resize(numPlanes);
+	worldData.nodes.Resize(numNodes);
+	worldData.leafs.Resize(numLeafs);
+	worldData.leafbrushes.Resize(numLeafBrushes);
+	worldData.leafsurfaces.Resize(numLeafSurfaces);
+	worldData.leafterrains.Resize(numLeafTerrains);
+	worldData.cmodels.Resize(numCModels);
+	worldData.brushes.Resize(numBrushes);
+	worldData.surfaces.Resize(numSurfaces);
+	worldData.terrain.Resize(numTerrains);
+	worldData.patchList.Resize(numPatchList);
 }
 
 MOHPC::collisionFencemask_t* MOHPC::CollisionWorld::getFenceMask(uintptr_t num) const
 {
-	return &fencemasks[num];
+	return &data->fencemasks[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumFenceMasks() const
 {
-	return fencemasks.NumObjects();
+	return data->fencemasks.NumObjects();
 }
 
 MOHPC::collisionShader_t* MOHPC::CollisionWorld::getShader(uintptr_t num) const
 {
-	return &shaders[num];
+	return &data->shaders[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumShaders() const
 {
-	return shaders.NumObjects();
+	return data->shaders.NumObjects();
 }
 
 MOHPC::collisionSideEq_t* MOHPC::CollisionWorld::getSideEquation(uintptr_t num) const
 {
-	return &sideequations[num];
+	return &data->sideequations[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumSideEquations() const
 {
-	return sideequations.NumObjects();
+	return data->sideequations.NumObjects();
 }
 
 MOHPC::collisionBrushSide_t* MOHPC::CollisionWorld::getBrushSide(uintptr_t num) const
 {
-	return &brushsides[num];
+	return &data->brushsides[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumBrushSides() const
 {
-	return brushsides.NumObjects();
+	return data->brushsides.NumObjects();
 }
 
 MOHPC::collisionPlane_t* MOHPC::CollisionWorld::getPlane(uintptr_t num) const
 {
-	return &planes[num];
+	return &data->planes[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumPlanes() const
 {
-	return planes.NumObjects();
+	return data->planes.NumObjects();
 }
 
 MOHPC::collisionNode_t* MOHPC::CollisionWorld::getNode(uintptr_t num) const
 {
-	return &nodes[num];
+	return &data->nodes[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumNodes() const
 {
-	return nodes.NumObjects();
+	return data->nodes.NumObjects();
+}
+
+void MOHPC::CollisionWorld::flattenTree()
+{
+	collisionWorldData_t& worldData = detachData();
+	CM_FlattenTree(worldData.flatNodes, worldData.nodes.NumObjects(), [&worldData](int32_t num, collisionFlatNode_t& flatNode)
+	{
+		const collisionNode_t& node = worldData.nodes[num];
+		const collisionPlane_t* plane = node.plane;
+
+		VecCopy(plane->normal, flatNode.normal);
+		flatNode.dist = plane->dist;
+		flatNode.type = plane->type;
+		flatNode.signbits = plane->signbits;
+		flatNode.children[0] = node.children[0];
+		flatNode.children[1] = node.children[1];
+	});
+}
+
+void MOHPC::CollisionWorld::clearFlatTree()
+{
+	detachData().flatNodes.FreeObjectList();
+}
+
+size_t MOHPC::CollisionWorld::getNumFlatNodes() const
+{
+	return data->flatNodes.NumObjects();
+}
+
+void MOHPC::CollisionWorld::shareData(const CollisionWorld& other)
+{
+	data = other.data;
+	clearCheckCounts();
+}
+
+void MOHPC::CollisionWorld::clearCheckCounts()
+{
+	// marks of the previous data could match upcoming traces
+	brushCheckCounts.FreeObjectList();
+	patchCheckCounts.FreeObjectList();
+	terrainCheckCounts.FreeObjectList();
+}
+
+MOHPC::collisionWorldData_t& MOHPC::CollisionWorld::detachData()
+{
+	if (data.use_count() > 1)
+	{
+		// other worlds use it, modify a copy
+		Container<uint8_t> buffer;
+		collisionImageWriter writer(buffer);
+		save(writer);
+		writer.finish();
+
+		collisionImageReader reader(buffer.Data(), buffer.NumObjects());
+		load(reader);
+	}
+
+	return *data;
+}
+
+void MOHPC::CollisionWorld::CM_NextCheckCount()
+{
+	// brushes, patches and terrains can be added between traces
+	if (brushCheckCounts.NumObjects() != data->brushes.NumObjects()) {
+		brushCheckCounts.SetNumObjects(data->brushes.NumObjects());
+	}
+
+	if (patchCheckCounts.NumObjects() != data->patchList.NumObjects()) {
+		patchCheckCounts.SetNumObjects(data->patchList.NumObjects());
+	}
+
+	if (terrainCheckCounts.NumObjects() != data->terrain.NumObjects()) {
+		terrainCheckCounts.SetNumObjects(data->terrain.NumObjects());
+	}
+
+	checkcount++;
+}
+
+bool MOHPC::CollisionWorld::CM_CheckedBrush(const collisionBrush_t* brush)
+{
+	size_t& brushCheckCount = brushCheckCounts[brush - data->brushes.Data()];
+	if (brushCheckCount == checkcount) {
+		return true;
+	}
+
+	brushCheckCount = checkcount;
+	return false;
+}
+
+bool MOHPC::CollisionWorld::CM_CheckedPatch(const collisionPatch_t* patch)
+{
+	size_t& patchCheckCount = patchCheckCounts[patch - data->patchList.Data()];
+	if (patchCheckCount == checkcount) {
+		return true;
+	}
+
+	patchCheckCount = checkcount;
+	return false;
+}
+
+bool MOHPC::CollisionWorld::CM_CheckedTerrain(const collisionTerrain_t* terrain)
+{
+	size_t& terrainCheckCount = terrainCheckCounts[terrain - data->terrain.Data()];
+	if (terrainCheckCount == checkcount) {
+		return true;
+	}
+
+	terrainCheckCount = checkcount;
+	return false;
 }
 
 MOHPC::collisionLeaf_t* MOHPC::CollisionWorld::getLeaf(uintptr_t num) const
 {
-	return &leafs[num];
+	return &data->leafs[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumLeafs() const
 {
-	return leafs.NumObjects();
+	return data->leafs.NumObjects();
 }
 
 void CollisionWorld::createLeafBrush(uintptr_t num)
 {
-	leafbrushes.AddObject(num);
+	detachData().leafbrushes.AddObject(num);
 }
 
 void CollisionWorld::createLeafSurface(uintptr_t num)
 {
-	leafsurfaces.AddObject(num);
+	detachData().leafsurfaces.AddObject(num);
 }
 
 MOHPC::collisionModel_t* MOHPC::CollisionWorld::getModel(uintptr_t num) const
 {
-	return &cmodels[num];
+	return &data->cmodels[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumModels() const
 {
-	return cmodels.NumObjects();
+	return data->cmodels.NumObjects();
 }
 
 MOHPC::collisionBrush_t* MOHPC::CollisionWorld::getBrush(uintptr_t num) const
 {
-	return &brushes[num];
+	return &data->brushes[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumBrushes() const
 {
-	return brushes.NumObjects();
+	return data->brushes.NumObjects();
 }
 
 MOHPC::collisionPatch_t* MOHPC::CollisionWorld::getPatch(uintptr_t num) const
 {
-	return &patchList[num];
+	return &data->patchList[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumPatches() const
 {
-	return patchList.NumObjects();
+	return data->patchList.NumObjects();
 }
 
 MOHPC::collisionTerrain_t* MOHPC::CollisionWorld::getTerrain(uintptr_t num) const
 {
-	return &terrain[num];
+	return &data->terrain[num];
 }
 
 
 size_t MOHPC::CollisionWorld::getNumTerrains() const
 {
-	return terrain.NumObjects();
+	return data->terrain.NumObjects();
 }
 
 size_t MOHPC::CollisionWorld::getNumLeafTerrains() const
 {
-	return leafterrains.NumObjects();
+	return data->leafterrains.NumObjects();
 }
 
 collisionTerrain_t* MOHPC::CollisionWorld::getLeafTerrain(uintptr_t num) const
 {
-	return leafterrains[num];
+	return data->leafterrains[num];
 }
 
 size_t MOHPC::CollisionWorld::getNumLeafBrushes() const
 {
-	return leafbrushes.NumObjects();
+	return data->leafbrushes.NumObjects();
 }
 
 collisionBrush_t* MOHPC::CollisionWorld::getLeafBrush(uintptr_t num) const
 {
-	return &brushes[leafbrushes[num]];
+	return &data->brushes[data->leafbrushes[num]];
 }
 
 size_t MOHPC::CollisionWorld::getNumLeafSurfaces() const
 {
-	return leafsurfaces.NumObjects();
+	return data->leafsurfaces.NumObjects();
 }
 
 collisionPatch_t* MOHPC::CollisionWorld::getLeafSurface(uintptr_t num) const
 {
-	return surfaces[leafsurfaces[num]];
+	return data->surfaces[data->leafsurfaces[num]];
 }
 
 void MOHPC::CollisionWorld::createSurface(collisionPatch_t* patch)
 {
-	surfaces.AddObject(patch);
+	detachData().surfaces.AddObject(patch);
 }
 
 clipHandle_t MOHPC::CollisionWorld::inlineModel(uint32_t index)
 {
-	if (index >= cmodels.NumObjects()) {
+	if (index >= data->cmodels.NumObjects()) {
 		return 0;
 	}
 
@@ -573,7 +682,8 @@ float CollisionWorld::CM_VectorDistanceSquared(vec3_t p1, vec3_t p2) {
 	return VectorLengthSquared(dir);
 }
 
-int BoxOnPlaneSide(vec3_t emins, vec3_t emaxs, const collisionPlane_t* p)
+template<typename PlaneType>
+int BoxOnPlaneSide(const vec3_t emins, const vec3_t emaxs, const PlaneType* p)
 {
 	float	dist1, dist2;
 	int		sides;
@@ -667,8 +777,8 @@ collisionModel_t* CollisionWorld::CM_ClipHandleToModel(clipHandle_t handle)
 		return nullptr;
 	}
 
-	if (handle < cmodels.NumObjects()) {
-		return &cmodels[handle];
+	if (handle < data->cmodels.NumObjects()) {
+		return &data->cmodels[handle];
 	}
 	if (handle == BOX_MODEL_HANDLE) {
 		return &box_model;
@@ -695,27 +805,28 @@ void CollisionWorld::CM_InitBoxHull()
 	collisionPlane_t* p;
 	collisionBrushSide_t* s;
 
-	planes.SetNumObjectsUninitialized(12);
-	box_planes = &planes[0];
+	collisionWorldData_t& worldData = detachData();
+	worldData.planes.SetNumObjectsUninitialized(12);
+	box_planes = &worldData.planes[0];
 
 	// Create 6 sides
-	brushsides.SetNumObjectsUninitialized(6);
+	worldData.brushsides.SetNumObjectsUninitialized(6);
 
 	box_brush = createBrush();
 	box_brush->numsides = 6;
-	box_brush->sides = &this->brushsides[0];
+	box_brush->sides = &worldData.brushsides[0];
 	box_brush->contents = ContentFlags::CONTENTS_BBOX;
 
 	box_model.leaf.numLeafBrushes = 1;
-	box_model.leaf.firstLeafBrush = (uint32_t)this->leafbrushes.NumObjects();
-	createLeafBrush(box_brush - brushes.Data());
+	box_model.leaf.firstLeafBrush = (uint32_t)worldData.leafbrushes.NumObjects();
+	createLeafBrush(box_brush - worldData.brushes.Data());
 
 	for (i = 0; i < 6; i++)
 	{
 		side = i & 1;
 
 		// brush sides
-		s = &brushsides[i];
+		s = &worldData.brushsides[i];
 		s->plane = &box_planes[i * 2 + side]; // &this->planes[(this->planes.NumObjects() + i * 2 + side)];
 		s->surfaceFlags = 0;
 
@@ -851,14 +962,13 @@ void CollisionWorld::CM_TestInLeaf(traceWork_t* tw, collisionLeaf_t* leaf)
 	// test box position against all brushes in the leaf
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++)
 	{
-		const uintptr_t brushnum = this->leafbrushes[leaf->firstLeafBrush + k];
-		collisionBrush_t* b = &this->brushes[brushnum];
-		if (b->checkcount == this->checkcount)
+		const uintptr_t brushnum = data->leafbrushes[leaf->firstLeafBrush + k];
+		collisionBrush_t* b = &data->brushes[brushnum];
+		if (CM_CheckedBrush(b))
 		{
 			// already checked this brush in another leaf
 			continue;
 		}
-		b->checkcount = this->checkcount;
 
 		if (!(b->contents & tw->contents)) {
 			continue;
@@ -873,17 +983,16 @@ void CollisionWorld::CM_TestInLeaf(traceWork_t* tw, collisionLeaf_t* leaf)
 	// test against all patches
 	for (uintptr_t k = 0; k < leaf->numLeafSurfaces; k++)
 	{
-		const uintptr_t patchnum = this->leafsurfaces[leaf->firstLeafSurface + k];
-		collisionPatch_t* patch = this->surfaces[patchnum];
+		const uintptr_t patchnum = data->leafsurfaces[leaf->firstLeafSurface + k];
+		collisionPatch_t* patch = data->surfaces[patchnum];
 		if (!patch) {
 			continue;
 		}
-		if (patch->checkcount == this->checkcount)
+		if (CM_CheckedPatch(patch))
 		{
 			// already checked this brush in another leaf
 			continue;
 		}
-		patch->checkcount = this->checkcount;
 
 		if (!(patch->contents & tw->contents)) {
 			continue;
@@ -899,16 +1008,15 @@ void CollisionWorld::CM_TestInLeaf(traceWork_t* tw, collisionLeaf_t* leaf)
 
 	for (uintptr_t k = 0; k < leaf->numLeafTerrains; k++)
 	{
-		collisionTerrain_t* terrain = this->leafterrains[leaf->firstLeafTerrain + k];
+		collisionTerrain_t* terrain = data->leafterrains[leaf->firstLeafTerrain + k];
 		if (!terrain) {
 			continue;
 		}
-		if (terrain->checkcount == this->checkcount)
+		if (CM_CheckedTerrain(terrain))
 		{
 			// already checked this brush in another leaf
 			continue;
 		}
-		terrain->checkcount = this->checkcount;
 
 		if (CollisionWorld::CM_PositionTestInTerrainCollide(tw, &terrain->tc))
 		{
@@ -1053,15 +1161,20 @@ void CollisionWorld::CM_PositionTest(traceWork_t * tw) {
 	ll.lastLeaf = 0;
 	ll.overflowed = false;
 
-	this->checkcount++;
+	CM_NextCheckCount();
 
-	CollisionWorld::CM_BoxLeafnums_r(&ll, 0);
+	if (data->flatNodes.NumObjects()) {
+		CollisionWorld::CM_BoxLeafnumsFlat(&ll);
+	}
+	else {
+		CollisionWorld::CM_BoxLeafnums_r(&ll, 0);
+	}
 
-	this->checkcount++;
+	CM_NextCheckCount();
 
 	// test the contents of the leafs
 	for (i = 0; i < ll.count; i++) {
-		CollisionWorld::CM_TestInLeaf(tw, &this->leafs[leafs[i]]);
+		CollisionWorld::CM_TestInLeaf(tw, &data->leafs[leafs[i]]);
 		if (tw->trace.allsolid) {
 			break;
 		}
@@ -1401,14 +1514,13 @@ void CollisionWorld::CM_TraceToLeaf(traceWork_t * tw, collisionLeaf_t * leaf)
 		// test box position against all brushes in the leaf
 		for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++)
 		{
-			const intptr_t leafNum = leafbrushes[leaf->firstLeafBrush + k];
-			collisionBrush_t* b = &brushes[leafNum];
-			if (b->checkcount == checkcount)
+			const intptr_t leafNum = data->leafbrushes[leaf->firstLeafBrush + k];
+			collisionBrush_t* b = &data->brushes[leafNum];
+			if (CM_CheckedBrush(b))
 			{
 				// already checked this brush in another leaf
 				continue;
 			}
-			b->checkcount = checkcount;
 
 			if (!(b->contents & tw->contents)) {
 				continue;
@@ -1426,17 +1538,16 @@ void CollisionWorld::CM_TraceToLeaf(traceWork_t * tw, collisionLeaf_t * leaf)
 		// test against all patches
 		for (uintptr_t k = 0; k < leaf->numLeafSurfaces; k++)
 		{
-			const intptr_t leafNum = leafsurfaces[leaf->firstLeafSurface + k];
-			collisionPatch_t* patch = surfaces[leafNum];
+			const intptr_t leafNum = data->leafsurfaces[leaf->firstLeafSurface + k];
+			collisionPatch_t* patch = data->surfaces[leafNum];
 			if (!patch) {
 				continue;
 			}
-			if (patch->checkcount == checkcount)
+			if (CM_CheckedPatch(patch))
 			{
 				// already checked this brush in another leaf
 				continue;
 			}
-			patch->checkcount = checkcount;
 
 			if (!(patch->contents & tw->contents)) {
 				continue;
@@ -1454,16 +1565,15 @@ void CollisionWorld::CM_TraceToLeaf(traceWork_t * tw, collisionLeaf_t * leaf)
 		// test against all terrains
 		for (uintptr_t k = 0; k < leaf->numLeafTerrains; k++)
 		{
-			collisionTerrain_t* terrain = this->leafterrains[leaf->firstLeafTerrain + k];
+			collisionTerrain_t* terrain = data->leafterrains[leaf->firstLeafTerrain + k];
 			if (!terrain) {
 				continue;
 			}
-			if (terrain->checkcount == checkcount)
+			if (CM_CheckedTerrain(terrain))
 			{
 				// already checked this brush in another leaf
 				continue;
 			}
-			terrain->checkcount = checkcount;
 
 			CollisionWorld::CM_TraceThroughTerrain(tw, terrain);
 			if (!tw->trace.fraction) {
@@ -1792,7 +1902,7 @@ void CollisionWorld::CM_TraceThroughTree(traceWork_t * tw, int num, float p1f, f
 
 	// if < 0, we are in a leaf node
 	if (num < 0) {
-		CollisionWorld::CM_TraceToLeaf(tw, &this->leafs[-1 - num]);
+		CollisionWorld::CM_TraceToLeaf(tw, &data->leafs[-1 - num]);
 		return;
 	}
 
@@ -1800,7 +1910,7 @@ void CollisionWorld::CM_TraceThroughTree(traceWork_t * tw, int num, float p1f, f
 	// find the point distances to the seperating plane
 	// and the offset for the size of the box
 	//
-	node = &this->nodes[num];
+	node = &data->nodes[num];
 	plane = node->plane;
 
 	// adjust the plane distance apropriately for mins/maxs
@@ -1884,6 +1994,139 @@ void CollisionWorld::CM_TraceThroughTree(traceWork_t * tw, int num, float p1f, f
 	CollisionWorld::CM_TraceThroughTree(tw, node->children[side ^ 1], midf, p2f, mid, p2);
 }
 
+/*
+==================
+CollisionWorld::CM_TraceThroughFlatTree
+
+Same as CM_TraceThroughTree but walks the compact tree with an explicit stack.
+The near side is walked first so leafs are visited in the same order.
+==================
+*/
+void CollisionWorld::CM_TraceThroughFlatTree(traceWork_t* tw) {
+	struct traceStack_t
+	{
+		int		num;
+		float	p1f;
+		float	p2f;
+		vec3_t	p1;
+		vec3_t	p2;
+	};
+
+	const collisionFlatNode_t* const nodeList = data->flatNodes.Data();
+	const collisionFlatNode_t* node;
+	traceStack_t	stack[CM_MAX_TREE_DEPTH + 1];
+	traceStack_t	cur;
+	traceStack_t*	far;
+	size_t		stackSize = 0;
+	float		t1, t2, offset;
+	float		frac, frac2;
+	float		idist;
+	int			side;
+
+	cur.num = 0;
+	cur.p1f = 0;
+	cur.p2f = 1;
+	VecCopy(tw->start, cur.p1);
+	VecCopy(tw->end, cur.p2);
+	stack[stackSize++] = cur;
+
+	while (stackSize) {
+		cur = stack[--stackSize];
+
+		while (1) {
+			if (tw->trace.fraction <= cur.p1f) {
+				break;		// already hit something nearer
+			}
+
+			// if < 0, we are in a leaf node
+			if (cur.num < 0) {
+				CollisionWorld::CM_TraceToLeaf(tw, &data->leafs[-1 - cur.num]);
+				break;
+			}
+
+			node = &nodeList[cur.num];
+
+			// adjust the plane distance apropriately for mins/maxs
+			if (node->type < 3) {
+				t1 = cur.p1[node->type] - node->dist;
+				t2 = cur.p2[node->type] - node->dist;
+				offset = tw->extents[node->type];
+			}
+			else {
+				t1 = DotProduct(node->normal, cur.p1) - node->dist;
+				t2 = DotProduct(node->normal, cur.p2) - node->dist;
+				if (tw->isPoint) {
+					offset = 0;
+				}
+				else {
+					// this is silly
+					offset = 2048;
+				}
+			}
+
+			// see which sides we need to consider
+			if (t1 >= offset + 1 && t2 >= offset + 1) {
+				cur.num = node->children[0];
+				continue;
+			}
+			if (t1 < -offset - 1 && t2 < -offset - 1) {
+				cur.num = node->children[1];
+				continue;
+			}
+
+			// put the crosspoint SURFACE_CLIP_EPSILON pixels on the near side
+			if (t1 < t2) {
+				idist = 1.0f / (t1 - t2);
+				side = 1;
+				frac2 = (t1 + offset + SURFACE_CLIP_EPSILON) * idist;
+				frac = (t1 - offset + SURFACE_CLIP_EPSILON) * idist;
+			}
+			else if (t1 > t2) {
+				idist = 1.0f / (t1 - t2);
+				side = 0;
+				frac2 = (t1 - offset - SURFACE_CLIP_EPSILON) * idist;
+				frac = (t1 + offset + SURFACE_CLIP_EPSILON) * idist;
+			}
+			else {
+				side = 0;
+				frac = 1;
+				frac2 = 0;
+			}
+
+			// move up to the node
+			if (frac < 0) {
+				frac = 0;
+			}
+			if (frac > 1) {
+				frac = 1;
+			}
+
+			// go past the node, walked once the near side is done
+			if (frac2 < 0) {
+				frac2 = 0;
+			}
+			if (frac2 > 1) {
+				frac2 = 1;
+			}
+
+			far = &stack[stackSize++];
+			far->num = node->children[side ^ 1];
+			far->p1f = cur.p1f + (cur.p2f - cur.p1f) * frac2;
+			far->p2f = cur.p2f;
+			far->p1[0] = cur.p1[0] + frac2 * (cur.p2[0] - cur.p1[0]);
+			far->p1[1] = cur.p1[1] + frac2 * (cur.p2[1] - cur.p1[1]);
+			far->p1[2] = cur.p1[2] + frac2 * (cur.p2[2] - cur.p1[2]);
+			VecCopy(cur.p2, far->p2);
+
+			cur.num = node->children[side];
+			cur.p2f = cur.p1f + (cur.p2f - cur.p1f) * frac;
+			cur.p2[0] = cur.p1[0] + frac * (cur.p2[0] - cur.p1[0]);
+			cur.p2[1] = cur.p1[1] + frac * (cur.p2[1] - cur.p1[1]);
+			cur.p2[2] = cur.p1[2] + frac * (cur.p2[2] - cur.p1[2]);
+		}
+	}
+}
+
 //======================================================================
 
 /*
@@ -1901,7 +2144,7 @@ void CollisionWorld::CM_BoxTrace(trace_t * results, const Vector& start, const V
 
 	cmod = CollisionWorld::CM_ClipHandleToModel(model);
 
-	this->checkcount++;		// for multi-check avoidance
+	CM_NextCheckCount();		// for multi-check avoidance
 
 	c_traces++;				// for statistics, may be zeroed
 
@@ -2014,6 +2257,9 @@ void CollisionWorld::CM_BoxTrace(trace_t * results, const Vector& start, const V
 		if (model) {
 			CollisionWorld::CM_TraceToLeaf(&tw, &cmod->leaf);
 		}
+		else if (data->flatNodes.NumObjects()) {
+			CollisionWorld::CM_TraceThroughFlatTree(&tw);
+		}
 		else {
 			CollisionWorld::CM_TraceThroughTree(&tw, 0, 0, 1, tw.start, tw.end);
 		}
@@ -2199,11 +2445,10 @@ bool CollisionWorld::CM_SightTraceToLeaf(traceWork_t* tw, collisionLeaf_t* leaf)
 
 	// test box position against all brushes in the leaf
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++) {
-		b = &this->brushes[this->leafbrushes[leaf->firstLeafBrush + k]];
-		if (b->checkcount == this->checkcount) {
+		b = &data->brushes[data->leafbrushes[leaf->firstLeafBrush + k]];
+		if (CM_CheckedBrush(b)) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = this->checkcount;
 
 		if (!(b->contents & tw->contents)) {
 			continue;
@@ -2216,14 +2461,13 @@ bool CollisionWorld::CM_SightTraceToLeaf(traceWork_t* tw, collisionLeaf_t* leaf)
 
 	// test against all patches
 	for (uintptr_t k = 0; k < leaf->numLeafSurfaces; k++) {
-		patch = this->surfaces[this->leafsurfaces[leaf->firstLeafSurface + k]];
+		patch = data->surfaces[data->leafsurfaces[leaf->firstLeafSurface + k]];
 		if (!patch) {
 			continue;
 		}
-		if (patch->checkcount == this->checkcount) {
+		if (CM_CheckedPatch(patch)) {
 			continue;	// already checked this brush in another leaf
 		}
-		patch->checkcount = this->checkcount;
 
 		if (!(patch->contents & tw->contents)) {
 			continue;
@@ -2236,14 +2480,13 @@ bool CollisionWorld::CM_SightTraceToLeaf(traceWork_t* tw, collisionLeaf_t* leaf)
 
 	// test against all terrains
 	for (uintptr_t k = 0; k < leaf->numLeafTerrains; k++) {
-		terrain = this->leafterrains[leaf->firstLeafTerrain + k];
+		terrain = data->leafterrains[leaf->firstLeafTerrain + k];
 		if (!terrain) {
 			continue;
 		}
-		if (terrain->checkcount == this->checkcount) {
+		if (CM_CheckedTerrain(terrain)) {
 			continue;
 		}
-		terrain->checkcount = this->checkcount;
 
 		if (!CollisionWorld::CM_SightTraceThroughTerrain(tw, terrain)) {
 			return false;
@@ -2275,14 +2518,14 @@ bool CollisionWorld::CM_SightTraceThroughTree(traceWork_t * tw, int num, float p
 
 	// if < 0, we are in a leaf node
 	if (num < 0) {
-		return CollisionWorld::CM_SightTraceToLeaf(tw, &this->leafs[-1 - num]);
+		return CollisionWorld::CM_SightTraceToLeaf(tw, &data->leafs[-1 - num]);
 	}
 
 	//
 	// find the point distances to the seperating plane
 	// and the offset for the size of the box
 	//
-	node = &this->nodes[num];
+	node = &data->nodes[num];
 	plane = node->plane;
 
 	// adjust the plane distance apropriately for mins/maxs
@@ -2366,6 +2609,132 @@ bool CollisionWorld::CM_SightTraceThroughTree(traceWork_t * tw, int num, float p
 	return CollisionWorld::CM_SightTraceThroughTree(tw, node->children[side ^ 1], midf, p2f, mid, p2);
 }
 
+
+/*
+==================
+CollisionWorld::CM_SightTraceThroughFlatTree
+
+Same as CM_SightTraceThroughTree but walks the compact tree with an explicit stack
+==================
+*/
+bool CollisionWorld::CM_SightTraceThroughFlatTree(traceWork_t* tw) {
+	struct traceStack_t
+	{
+		int		num;
+		vec3_t	p1;
+		vec3_t	p2;
+	};
+
+	const collisionFlatNode_t* const nodeList = data->flatNodes.Data();
+	const collisionFlatNode_t* node;
+	traceStack_t	stack[CM_MAX_TREE_DEPTH + 1];
+	traceStack_t	cur;
+	traceStack_t*	far;
+	size_t		stackSize = 0;
+	float		t1, t2, offset;
+	float		frac, frac2;
+	float		idist;
+	int			side;
+
+	cur.num = 0;
+	VecCopy(tw->start, cur.p1);
+	VecCopy(tw->end, cur.p2);
+	stack[stackSize++] = cur;
+
+	while (stackSize) {
+		cur = stack[--stackSize];
+
+		while (1) {
+			// if < 0, we are in a leaf node
+			if (cur.num < 0) {
+				if (!CollisionWorld::CM_SightTraceToLeaf(tw, &data->leafs[-1 - cur.num])) {
+					return false;
+				}
+				break;
+			}
+
+			node = &nodeList[cur.num];
+
+			// adjust the plane distance apropriately for mins/maxs
+			if (node->type < 3) {
+				t1 = cur.p1[node->type] - node->dist;
+				t2 = cur.p2[node->type] - node->dist;
+				offset = tw->extents[node->type];
+			}
+			else {
+				t1 = DotProduct(node->normal, cur.p1) - node->dist;
+				t2 = DotProduct(node->normal, cur.p2) - node->dist;
+				if (tw->isPoint) {
+					offset = 0;
+				}
+				else {
+					// this is silly
+					offset = 2048;
+				}
+			}
+
+			// see which sides we need to consider
+			if (t1 >= offset + 1 && t2 >= offset + 1) {
+				cur.num = node->children[0];
+				continue;
+			}
+			if (t1 < -offset - 1 && t2 < -offset - 1) {
+				cur.num = node->children[1];
+				continue;
+			}
+
+			// put the crosspoint SURFACE_CLIP_EPSILON pixels on the near side
+			if (t1 < t2) {
+				idist = 1.0f / (t1 - t2);
+				side = 1;
+				frac2 = (t1 + offset + SURFACE_CLIP_EPSILON) * idist;
+				frac = (t1 - offset + SURFACE_CLIP_EPSILON) * idist;
+			}
+			else if (t1 > t2) {
+				idist = 1.0f / (t1 - t2);
+				side = 0;
+				frac2 = (t1 - offset - SURFACE_CLIP_EPSILON) * idist;
+				frac = (t1 + offset + SURFACE_CLIP_EPSILON) * idist;
+			}
+			else {
+				side = 0;
+				frac = 1;
+				frac2 = 0;
+			}
+
+			// move up to the node
+			if (frac < 0) {
+				frac = 0;
+			}
+			if (frac > 1) {
+				frac = 1;
+			}
+
+			// go past the node, walked once the near side is done
+			if (frac2 < 0) {
+				frac2 = 0;
+			}
+			if (frac2 > 1) {
+				frac2 = 1;
+			}
+
+			far = &stack[stackSize++];
+			far->num = node->children[side ^ 1];
+			far->p1[0] = cur.p1[0] + frac2 * (cur.p2[0] - cur.p1[0]);
+			far->p1[1] = cur.p1[1] + frac2 * (cur.p2[1] - cur.p1[1]);
+			far->p1[2] = cur.p1[2] + frac2 * (cur.p2[2] - cur.p1[2]);
+			VecCopy(cur.p2, far->p2);
+
+			cur.num = node->children[side];
+			cur.p2[0] = cur.p1[0] + frac * (cur.p2[0] - cur.p1[0]);
+			cur.p2[1] = cur.p1[1] + frac * (cur.p2[1] - cur.p1[1]);
+			cur.p2[2] = cur.p1[2] + frac * (cur.p2[2] - cur.p1[2]);
+		}
+	}
+
+	return true;
+}
+
 /*
 ==================
 CollisionWorld::CM_BoxSightTrace
@@ -2381,11 +2750,11 @@ bool CollisionWorld::CM_BoxSightTrace(const Vector& start, const Vector& end, co
 
 	cmod = CollisionWorld::CM_ClipHandleToModel(model);
 
-	this->checkcount++;		// for multi-check avoidance
+	CM_NextCheckCount();		// for multi-check avoidance
 
 	c_traces++;				// for statistics, may be zeroed
 
-	if (!this->nodes.NumObjects()) {
+	if (!data->nodes.NumObjects()) {
 		return false;
 	}
 
@@ -2498,6 +2867,9 @@ bool CollisionWorld::CM_BoxSightTrace(const Vector& start, const Vector& end, co
 		if (model) {
 			bPassed = CollisionWorld::CM_SightTraceToLeaf(&tw, &cmod->leaf);
 		}
+		else if (data->flatNodes.NumObjects()) {
+			bPassed = CollisionWorld::CM_SightTraceThroughFlatTree(&tw);
+		}
 		else {
 			bPassed = CollisionWorld::CM_SightTraceThroughTree(&tw, 0, 0, 1, tw.start, tw.end);
 		}
@@ -2594,7 +2966,7 @@ int CollisionWorld::CM_PointLeafnum_r(const Vector& p, int num) {
 
 	while (num >= 0)
 	{
-		node = &this->nodes[num];
+		node = &data->nodes[num];
 		plane = node->plane;
 
 		if (plane->type < 3)
@@ -2613,13 +2985,51 @@ int CollisionWorld::CM_PointLeafnum_r(const Vector& p, int num) {
 	return -1 - num;
 }
 
+/*
+==================
+CollisionWorld::CM_PointLeafnumFlat
+
+Same as CM_PointLeafnum_r but walks the compact tree
+==================
+*/
+int CollisionWorld::CM_PointLeafnumFlat(const Vector& p) {
+	const collisionFlatNode_t* const nodeList = data->flatNodes.Data();
+	const collisionFlatNode_t* node;
+	float		d;
+	int			num = 0;
+
+	while (num >= 0)
+	{
+		node = &nodeList[num];
+
+		if (node->type < 3)
+			d = p[node->type] - node->dist;
+		else
+			d = DotProduct(node->normal, p) - node->dist;
+		if (d < 0)
+			num = node->children[1];
+		else
+			num = node->children[0];
+	}
+
+	// optimize counter
+	c_pointcontents++;
+
+	return -1 - num;
+}
+
 int CollisionWorld::CM_PointLeafnum(const Vector& p)
 {
-	if (!this->nodes.NumObjects())
+	if (!data->nodes.NumObjects())
 	{
 		// collision data not loaded
 		return 0;
 	}
+
+	if (data->flatNodes.NumObjects()) {
+		return CollisionWorld::CM_PointLeafnumFlat(p);
+	}
+
 	return CollisionWorld::CM_PointLeafnum_r(p, 0);
 }
 
@@ -2639,7 +3049,7 @@ void CollisionWorld::CM_StoreLeafs(leafList_t* ll, int nodenum) {
 	leafNum = -1 - nodenum;
 
 	// store the lastLeaf even if the list is overflowed
-	if (this->leafs[leafNum].cluster != -1) {
+	if (data->leafs[leafNum].cluster != -1) {
 		ll->lastLeaf = leafNum;
 	}
 
@@ -2658,18 +3068,17 @@ void CollisionWorld::CM_StoreBrushes(leafList_t* ll, int nodenum) {
 
 	leafnum = -1 - nodenum;
 
-	leaf = &this->leafs[leafnum];
+	leaf = &data->leafs[leafnum];
 
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++) {
-		brushnum = this->leafbrushes[leaf->firstLeafBrush + k];
-		b = &this->brushes[brushnum];
-		if (b->checkcount == this->checkcount)
+		brushnum = data->leafbrushes[leaf->firstLeafBrush + k];
+		b = &data->brushes[brushnum];
+		if (CM_CheckedBrush(b))
 		{
 			// already checked this brush in another leaf
 			continue;
 		}
 
-		b->checkcount = this->checkcount;
 		int i;
 		for (i = 0; i < 3; i++) {
 			if (b->bounds[0][i] >= ll->bounds[1][i] || b->bounds[1][i] <= ll->bounds[0][i]) {
@@ -2689,7 +3098,7 @@ void CollisionWorld::CM_StoreBrushes(leafList_t* ll, int nodenum) {
 #if 0
 	// store patches?
 	for (k = 0; k < leaf->numLeafSurfaces; k++) {
-		patch = this->surfaces[this->leafsurfaces[leaf->firstleafsurface + k]];
+		patch = data->surfaces[data->leafsurfaces[leaf->firstleafsurface + k]];
 		if (!patch) {
 			continue;
 		}
@@ -2715,7 +3124,7 @@ void CollisionWorld::CM_BoxLeafnums_r(leafList_t* ll, int nodenum) {
 			return;
 		}
 
-		node = &this->nodes[nodenum];
+		node = &data->nodes[nodenum];
 		plane = node->plane;
 		s = BoxOnPlaneSide(ll->bounds[0], ll->bounds[1], plane);
 		if (s == 1) {
@@ -2732,6 +3141,49 @@ void CollisionWorld::CM_BoxLeafnums_r(leafList_t* ll, int nodenum) {
 	}
 }
 
+/*
+=============
+CollisionWorld::CM_BoxLeafnumsFlat
+
+Same as CM_BoxLeafnums_r but walks the compact tree with an explicit stack
+=============
+*/
+void CollisionWorld::CM_BoxLeafnumsFlat(leafList_t* ll) {
+	const collisionFlatNode_t* const nodeList = data->flatNodes.Data();
+	const collisionFlatNode_t* node;
+	int			stack[CM_MAX_TREE_DEPTH + 1];
+	size_t		stackSize = 0;
+	int			nodenum;
+	int			s;
+
+	stack[stackSize++] = 0;
+
+	while (stackSize) {
+		nodenum = stack[--stackSize];
+
+		while (1) {
+			if (nodenum < 0) {
+				(this->*ll->storeLeafs)(ll, nodenum);
+				break;
+			}
+
+			node = &nodeList[nodenum];
+			s = BoxOnPlaneSide(ll->bounds[0], ll->bounds[1], node);
+			if (s == 1) {
+				nodenum = node->children[0];
+			}
+			else if (s == 2) {
+				nodenum = node->children[1];
+			}
+			else {
+				// go down both, front first
+				stack[stackSize++] = node->children[1];
+				nodenum = node->children[0];
+			}
+		}
+	}
+}
+
 /*
 ==================
 CollisionWorld::CM_BoxLeafnums
@@ -2740,7 +3192,7 @@ CollisionWorld::CM_BoxLeafnums
 size_t	CollisionWorld::CM_BoxLeafnums(const Vector& mins, const Vector& maxs, int* list, size_t listsize, int* lastLeaf) {
 	leafList_t	ll;
 
-	this->checkcount++;
+	CM_NextCheckCount();
 
 	VecCopy(mins, ll.bounds[0]);
 	VecCopy(maxs, ll.bounds[1]);
@@ -2751,7 +3203,12 @@ size_t	CollisionWorld::CM_BoxLeafnums(const Vector& mins, const Vector& maxs, in
 	ll.lastLeaf = 0;
 	ll.overflowed = false;
 
-	CollisionWorld::CM_BoxLeafnums_r(&ll, 0);
+	if (data->flatNodes.NumObjects()) {
+		CollisionWorld::CM_BoxLeafnumsFlat(&ll);
+	}
+	else {
+		CollisionWorld::CM_BoxLeafnums_r(&ll, 0);
+	}
 
 	*lastLeaf = ll.lastLeaf;
 	return ll.count;
@@ -2765,7 +3222,7 @@ CollisionWorld::CM_BoxBrushes
 size_t CollisionWorld::CM_BoxBrushes(const Vector& mins, const Vector& maxs, collisionBrush_t** list, size_t listsize) {
 	leafList_t	ll;
 
-	this->checkcount++;
+	CM_NextCheckCount();
 
 	VecCopy(mins, ll.bounds[0]);
 	VecCopy(maxs, ll.bounds[1]);
@@ -2776,7 +3233,12 @@ size_t CollisionWorld::CM_BoxBrushes(const Vector& mins, const Vector& maxs, col
 	ll.lastLeaf = 0;
 	ll.overflowed = false;
 
-	CollisionWorld::CM_BoxLeafnums_r(&ll, 0);
+	if (data->flatNodes.NumObjects()) {
+		CollisionWorld::CM_BoxLeafnumsFlat(&ll);
+	}
+	else {
+		CollisionWorld::CM_BoxLeafnums_r(&ll, 0);
+	}
 
 	return ll.count;
 }
@@ -2788,7 +3250,7 @@ CollisionWorld::CM_ShaderPointer
 */
 collisionShader_t* CollisionWorld::CM_ShaderPointer(int iShaderNum)
 {
-	return (collisionShader_t*)&this->shaders[iShaderNum];
+	return (collisionShader_t*)&data->shaders[iShaderNum];
 }
 
 
@@ -2810,7 +3272,7 @@ int CollisionWorld::CM_PointContents(const vec3_t p, clipHandle_t model) {
 	float		d;
 	collisionModel_t* clipm;
 
-	if (!this->nodes.NumObjects()) {	// map not loaded
+	if (!data->nodes.NumObjects()) {	// map not loaded
 		return 0;
 	}
 
@@ -2819,14 +3281,14 @@ int CollisionWorld::CM_PointContents(const vec3_t p, clipHandle_t model) {
 		leaf = &clipm->leaf;
 	}
 	else {
-		leafnum = CollisionWorld::CM_PointLeafnum_r(p, 0);
-		leaf = &this->leafs[leafnum];
+		leafnum = CollisionWorld::CM_PointLeafnum(p);
+		leaf = &data->leafs[leafnum];
 	}
 
 	contents = 0;
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++) {
-		brushnum = this->leafbrushes[leaf->firstLeafBrush + k];
-		b = &this->brushes[brushnum];
+		brushnum = data->leafbrushes[leaf->firstLeafBrush + k];
+		b = &data->brushes[brushnum];
 
 		if (!CollisionWorld::CM_BoundsIntersectPoint(b->bounds[0], b->bounds[1], p)) {
 			continue;
@@ -2862,7 +3324,7 @@ uintptr_t CollisionWorld::CM_PointBrushNum(const vec3_t p, clipHandle_t model) {
 	collisionBrush_t* b;
 	collisionModel_t* clipm;
 
-	if (!this->nodes.NumObjects()) {
+	if (!data->nodes.NumObjects()) {
 		return 0;
 	}
 
@@ -2871,12 +3333,12 @@ uintptr_t CollisionWorld::CM_PointBrushNum(const vec3_t p, clipHandle_t model) {
 		leaf = &clipm->leaf;
 	}
 	else {
-		leaf = &this->leafs[CollisionWorld::CM_PointLeafnum_r(p, 0)];
+		leaf = &data->leafs[CollisionWorld::CM_PointLeafnum(p)];
 	}
 
 	for (uintptr_t k = 0; k < leaf->numLeafBrushes; k++) {
-		brushnum = this->leafbrushes[leaf->firstLeafBrush + k];
-		b = &this->brushes[brushnum];
+		brushnum = data->leafbrushes[leaf->firstLeafBrush + k];
+		b = &data->brushes[brushnum];
 
 		// see if the point is in the brush
 		uintptr_t i;
@@ -2982,7 +3444,7 @@ bool CollisionWorld::CM_TraceThroughFence(const traceWork_t* tw, const collision
 
 	// FIXME?
 
-	pMask = shaders[side->shaderNum].mask;
+	pMask = data->shaders[side->shaderNum].mask;
 	if (!pMask) {
 		return true;
 	}
@@ -0,0 +1,359 @@
+#include <Shared.h>
+#include <MOHPC/Collision/CollisionCache.h>
+#include <MOHPC/Formats/BSP.h>
+#include <MOHPC/Misc/crc32.h>
+#include <MOHPC/Log.h>
+#include "CollisionPrivate.h"
+
+#include <cstdio>
+
+#define MOHPC_LOG_NAMESPACE "collision_cache"
+
+using namespace MOHPC;
+
+static constexpr char CACHE_IDENT[4] = { 'C', 'M', 'W', 'I' };
+
+namespace MOHPC
+{
+	struct collisionImageHeader_t
+	{
+		char ident[4];
+		uint32_t version;
+		// size of uintptr_t, as some fields are serialized with their native size
+		uint32_t pointerSize;
+		// crc32 of the serialized world
+		uint32_t dataCrc;
+		uint64_t key;
+		uint64_t dataLength;
+	};
+}
+
+MOHPC_OBJECT_DEFINITION(CollisionWorldImage);
+
+CollisionWorldImage::CollisionWorldImage(uint64_t keyValue)
+	: key(keyValue)
+{
+}
+
+CollisionWorldImage::~CollisionWorldImage()
+{
+}
+
+CollisionWorldImagePtr CollisionWorldImage::fromWorld(CollisionWorld& cm, uint64_t key)
+{
+	CollisionWorldImagePtr image = CollisionWorldImage::create(key);
+	image->world = CollisionWorld::create();
+	image->world->shareData(cm);
+
+	return image;
+}
+
+void CollisionWorldImage::write(Container<uint8_t>& buffer) const
+{
+	collisionImageHeader_t header;
+	memset(&header, 0, sizeof(header));
+
+	// reserve room for the header, it is filled once the world has been written
+	collisionImageWriter ar(buffer);
+	ar.write(&header, sizeof(header));
+	world->save(ar);
+	ar.finish();
+
+	const uint8_t* worldData = buffer.Data() + sizeof(header);
+	const size_t worldLength = buffer.NumObjects() - sizeof(header);
+
+	memcpy(header.ident, CACHE_IDENT, sizeof(header.ident));
+	header.version = VERSION;
+	header.pointerSize = sizeof(uintptr_t);
+	header.dataCrc = crc32_hash(worldData, worldLength, 0);
+	header.key = key;
+	header.dataLength = worldLength;
+	memcpy(buffer.Data(), &header, sizeof(header));
+}
+
+static bool validateImage(const uint8_t* buffer, size_t size, uint64_t key)
+{
+	if (size < sizeof(collisionImageHeader_t)) {
+		return false;
+	}
+
+	collisionImageHeader_t header;
+	memcpy(&header, buffer, sizeof(header));
+
+	if (memcmp(header.ident, CACHE_IDENT, sizeof(header.ident))) {
+		return false;
+	}
+
+	if (header.version != CollisionWorldImage::VERSION || header.pointerSize != sizeof(uintptr_t))
+	{
+		MOHPC_LOG(Verbose, "ignoring image version %u (expected %u)", header.version, CollisionWorldImage::VERSION);
+		return false;
+	}
+
+	if (header.key != key)
+	{
+		// the source has changed since the image was made
+		return false;
+	}
+
+	if (header.dataLength != size - sizeof(header)) {
+		return false;
+	}
+
+	if (crc32_hash(buffer + sizeof(header), (size_t)header.dataLength, 0) != header.dataCrc)
+	{
+		MOHPC_LOG(Warning, "corrupted image (checksum mismatch)");
+		return false;
+	}
+
+	return true;
+}
+
+bool CollisionWorldImage::read(const uint8_t* buffer, size_t size)
+{
+	if (!validateImage(buffer, size, key)) {
+		return false;
+	}
+
+	world = CollisionWorld::create();
+
+	collisionImageReader ar(buffer + sizeof(collisionImageHeader_t), size - sizeof(collisionImageHeader_t));
+	world->load(ar);
+
+	if (ar.hasOverflowed() || !ar.isFullyRead())
+	{
+		MOHPC_LOG(Warning, "image doesn't match the collision world layout");
+		world = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+CollisionWorldImagePtr CollisionWorldImage::fromMemory(const void* buffer, size_t size, uint64_t key)
+{
+	CollisionWorldImagePtr image = CollisionWorldImage::create(key);
+	if (!image->read((const uint8_t*)buffer, size)) {
+		return nullptr;
+	}
+
+	return image;
+}
+
+CollisionWorldImagePtr CollisionWorldImage::fromFile(const char* path, uint64_t key)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		return nullptr;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long fileLength = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	Container<uint8_t> buffer;
+	size_t numRead = 0;
+	if (fileLength > 0)
+	{
+		buffer.SetNumObjectsUninitialized(fileLength);
+		numRead = fread(buffer.Data(), 1, fileLength, file);
+	}
+
+	fclose(file);
+
+	if (numRead != (size_t)fileLength) {
+		return nullptr;
+	}
+
+	return fromMemory(buffer.Data(), buffer.NumObjects(), key);
+}
+
+bool CollisionWorldImage::writeFile(const char* path) const
+{
+	Container<uint8_t> buffer;
+	write(buffer);
+
+	FILE* file = fopen(path, "wb");
+	if (!file)
+	{
+		MOHPC_LOG(Warning, "couldn't open '%s' for writing", path);
+		return false;
+	}
+
+	const size_t written = fwrite(buffer.Data(), 1, buffer.NumObjects(), file);
+	fclose(file);
+
+	if (written != buffer.NumObjects())
+	{
+		// don't leave a truncated image behind
+		remove(path);
+		return false;
+	}
+
+	return true;
+}
+
+bool CollisionWorldImage::loadWorld(CollisionWorld& cm) const
+{
+	if (!world) {
+		return false;
+	}
+
+	// the geometry is copied only if the world gets modified
+	cm.shareData(*world);
+	return true;
+}
+
+uint64_t CollisionWorldImage::getKey() const
+{
+	return key;
+}
+
+size_t CollisionWorldImage::getSize() const
+{
+	Container<uint8_t> buffer;
+	write(buffer);
+
+	return buffer.NumObjects();
+}
+
+MOHPC_OBJECT_DEFINITION(CollisionWorldCache);
+
+CollisionWorldCache::CollisionWorldCache(const char* directoryValue)
+	: directory(directoryValue ? directoryValue : "")
+	, useCount(0)
+	, maxImages(4)
+{
+}
+
+CollisionWorldCache::~CollisionWorldCache()
+{
+}
+
+str CollisionWorldCache::getImagePath(uint64_t key) const
+{
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "%016llx.cmwi", (unsigned long long)key);
+
+	return directory + "/" + fileName;
+}
+
+CollisionWorldImagePtr CollisionWorldCache::getImage(BSP& bsp)
+{
+	const uint64_t key = bsp.GetContentHash();
+
+	SharedPtr<imageEntry_t> entry;
+	{
+		std::lock_guard<std::mutex> lock(imagesMutex);
+
+		SharedPtr<imageEntry_t>& found = images[key];
+		if (!found) {
+			found = makeShared<imageEntry_t>();
+		}
+		else if (found->image)
+		{
+			found->lastUse = ++useCount;
+			return found->image;
+		}
+
+		entry = found;
+	}
+
+	// other levels can be looked up or built meanwhile
+	std::lock_guard<std::mutex> buildLock(entry->buildMutex);
+
+	{
+		std::lock_guard<std::mutex> lock(imagesMutex);
+
+		// built by another thread while waiting
+		if (entry->image)
+		{
+			entry->lastUse = ++useCount;
+			return entry->image;
+		}
+	}
+
+	CollisionWorldImagePtr image;
+	if (directory.length())
+	{
+		image = CollisionWorldImage::fromFile(getImagePath(key).c_str(), key);
+	}
+
+	if (!image)
+	{
+		CollisionWorld cm;
+		bsp.FillCollisionWorld(cm);
+		image = CollisionWorldImage::fromWorld(cm, key);
+
+		if (directory.length()) {
+			image->writeFile(getImagePath(key).c_str());
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(imagesMutex);
+	entry->image = image;
+	entry->lastUse = ++useCount;
+	evictImages();
+
+	return image;
+}
+
+void CollisionWorldCache::fillCollisionWorld(BSP& bsp, CollisionWorld& cm)
+{
+	const CollisionWorldImagePtr image = getImage(bsp);
+	if (!image->loadWorld(cm))
+	{
+		// shouldn't happen as images are validated, but fallback to the slow path
+		bsp.FillCollisionWorld(cm);
+	}
+}
+
+void CollisionWorldCache::evictImages()
+{
+	size_t numImages = 0;
+	for (auto it = images.begin(); it != images.end(); ++it)
+	{
+		if (it->second->image) {
+			++numImages;
+		}
+	}
+
+	for (; numImages > maxImages; --numImages)
+	{
+		// release the least recently used image, users still holding it keep it alive
+		imageEntry_t* oldest = nullptr;
+		for (auto it = images.begin(); it != images.end(); ++it)
+		{
+			imageEntry_t* entry = it->second.get();
+			if (entry->image && (!oldest || entry->lastUse < oldest->lastUse)) {
+				oldest = entry;
+			}
+		}
+
+		oldest->image = nullptr;
+	}
+}
+
+void CollisionWorldCache::purge()
+{
+	std::lock_guard<std::mutex> lock(imagesMutex);
+
+	for (auto it = images.begin(); it != images.end();)
+	{
+		// entries that are being built are still referenced by the building thread
+		if (it->second.use_count() == 1 && (!it->second->image || it->second->image.use_count() == 1)) {
+			it = images.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void CollisionWorldCache::setMaxImages(size_t maxImagesValue)
+{
+	std::lock_guard<std::mutex> lock(imagesMutex);
+
+	maxImages = maxImagesValue;
+	evictImages();
+}
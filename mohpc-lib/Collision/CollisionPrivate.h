@@ -0,0 +1,206 @@
+#pragma once
+
+#include <MOHPC/Collision/Collision.h>
+
+#include <cstring>
+#include <type_traits>
+
+namespace MOHPC
+{
+	/** Maximum depth of a tree that can be flattened, this is the size of the traversal stack. */
+	static constexpr size_t CM_MAX_TREE_DEPTH = 256;
+
+	/**
+	 * Rebuild a BSP tree into compact nodes, in depth-first order.
+	 *
+	 * @param	out			Compact nodes, the root is the first node.
+	 * @param	numNodes	Number of nodes in the source tree.
+	 * @param	fillNode	Called as fillNode(num, node) to fill the plane and the children of a source node.
+	 * @return	false if the tree is deeper than CM_MAX_TREE_DEPTH, in that case out is left empty.
+	 */
+	template<typename NodeFunc>
+	bool CM_FlattenTree(Container<collisionFlatNode_t>& out, size_t numNodes, NodeFunc&& fillNode)
+	{
+		struct pendingNode_t
+		{
+			int32_t num;
+			int32_t* parentChild;
+			size_t depth;
+		};
+
+		out.FreeObjectList();
+		if (!numNodes) {
+			return true;
+		}
+
+		out.Resize(numNodes);
+
+		Container<pendingNode_t> pending;
+		pending.AddObject(pendingNode_t{ 0, nullptr, 0 });
+
+		while (pending.NumObjects())
+		{
+			const pendingNode_t current = pending[pending.NumObjects() - 1];
+			pending.RemoveObjectAt(pending.NumObjects());
+
+			if (current.depth >= CM_MAX_TREE_DEPTH || out.NumObjects() >= numNodes)
+			{
+				// too deep or the tree is looping
+				out.FreeObjectList();
+				return false;
+			}
+
+			const int32_t flatNum = (int32_t)out.AddObjectUninitialized() - 1;
+			if (current.parentChild) {
+				*current.parentChild = flatNum;
+			}
+
+			collisionFlatNode_t* node = &out[flatNum];
+			memset(node, 0, sizeof(collisionFlatNode_t));
+			fillNode(current.num, *node);
+
+			// the back child is visited last
+			for (intptr_t i = 1; i >= 0; --i)
+			{
+				if (node->children[i] >= 0) {
+					pending.AddObject(pendingNode_t{ node->children[i], &node->children[i], current.depth + 1 });
+				}
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Write the collision world into a growing buffer.
+	 */
+	class collisionImageWriter
+	{
+	private:
+		Container<uint8_t>& data;
+		size_t pos;
+
+	public:
+		collisionImageWriter(Container<uint8_t>& dataRef)
+			: data(dataRef)
+			, pos(0)
+		{
+		}
+
+		void write(const void* value, size_t size)
+		{
+			if (pos + size > data.NumObjects()) {
+				data.SetNumObjectsUninitialized(data.NumObjects() * 2 + size);
+			}
+
+			memcpy(data.Data() + pos, value, size);
+			pos += size;
+		}
+
+		/** Trim the buffer to what has been written. */
+		void finish()
+		{
+			data.SetNumObjectsUninitialized(pos);
+		}
+
+		template<typename T>
+		void operator()(T& value)
+		{
+			*this << value;
+		}
+
+		template<typename T>
+		collisionImageWriter& operator<<(T value)
+		{
+			static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be written directly");
+			write(&value, sizeof(value));
+			return *this;
+		}
+
+		collisionImageWriter& operator<<(const str& value)
+		{
+			const uint32_t len = (uint32_t)value.length();
+			*this << len;
+			write(value.c_str(), len);
+			return *this;
+		}
+	};
+
+	/**
+	 * Read the collision world from a buffer, without going past its end.
+	 */
+	class collisionImageReader
+	{
+	private:
+		const uint8_t* data;
+		size_t dataSize;
+		size_t dataPos;
+		bool overflowed;
+
+	public:
+		collisionImageReader(const uint8_t* inData, size_t inDataSize)
+			: data(inData)
+			, dataSize(inDataSize)
+			, dataPos(0)
+			, overflowed(false)
+		{
+		}
+
+		void read(void* value, size_t size)
+		{
+			if (size > dataSize - dataPos)
+			{
+				// don't leave anything uninitialized
+				memset(value, 0, size);
+				dataPos = dataSize;
+				overflowed = true;
+				return;
+			}
+
+			memcpy(value, data + dataPos, size);
+			dataPos += size;
+		}
+
+		bool hasOverflowed() const
+		{
+			return overflowed;
+		}
+
+		bool isFullyRead() const
+		{
+			return dataPos == dataSize;
+		}
+
+		template<typename T>
+		void operator()(T& value)
+		{
+			*this >> value;
+		}
+
+		template<typename T>
+		collisionImageReader& operator>>(T& value)
+		{
+			static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be read directly");
+			read(&value, sizeof(value));
+			return *this;
+		}
+
+		collisionImageReader& operator>>(str& value)
+		{
+			uint32_t len = 0;
+			*this >> len;
+
+			if (len > dataSize - dataPos)
+			{
+				dataPos = dataSize;
+				overflowed = true;
+				value = str();
+				return *this;
+			}
+
+			value = str((const char*)data + dataPos, len);
+			dataPos += len;
+			return *this;
+		}
+	};
+}
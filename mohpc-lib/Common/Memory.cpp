@@ -1,14 +1,437 @@
 #include <MOHPC/Common/Memory.h>
+#include <atomic>
 #include <cstdlib>
+#include <mutex>
+#include <new>
 
 using namespace MOHPC;
 
+#if defined(__SANITIZE_ADDRESS__)
+#define MOHPC_MALLOC_BY_DEFAULT 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define MOHPC_MALLOC_BY_DEFAULT 1
+#endif
+#endif
+
+// prepended to blocks returned by allocateMemory
+struct blockHeader_t
+{
+	IAllocator* allocator;
+	uint32_t size;
+	memoryTag_e tag;
+};
+
+// keeps the returned memory aligned for any type
+static constexpr size_t headerSize = 16;
+static_assert(sizeof(blockHeader_t) <= headerSize, "the block header is too big");
+
+struct tagStats_t
+{
+	std::atomic<size_t> numAllocations;
+	std::atomic<size_t> numFrees;
+	std::atomic<size_t> bytesInUse;
+	std::atomic<size_t> peakBytesInUse;
+};
+
+// zero-initialized before any dynamic initialization, so static objects can allocate
+static tagStats_t tagStats[(size_t)memoryTag_e::Max];
+static std::atomic<IAllocator*> currentAllocator{ nullptr };
+static thread_local memoryTag_e currentTag = memoryTag_e::General;
+
+static void addAllocations(memoryTag_e tag, size_t count, size_t size)
+{
+	tagStats_t& stats = tagStats[(size_t)tag];
+	stats.numAllocations.fetch_add(count, std::memory_order_relaxed);
+
+	const size_t inUse = stats.bytesInUse.fetch_add(size, std::memory_order_relaxed) + size;
+	size_t peak = stats.peakBytesInUse.load(std::memory_order_relaxed);
+	while (inUse > peak && !stats.peakBytesInUse.compare_exchange_weak(peak, inUse, std::memory_order_relaxed));
+}
+
+static void removeAllocations(memoryTag_e tag, size_t count, size_t size)
+{
+	tagStats_t& stats = tagStats[(size_t)tag];
+	stats.numFrees.fetch_add(count, std::memory_order_relaxed);
+	stats.bytesInUse.fetch_sub(size, std::memory_order_relaxed);
+}
+
+static IAllocator& getDefaultAllocator()
+{
+#if MOHPC_MALLOC_BY_DEFAULT
+	return MallocAllocator::get();
+#else
+	return PoolAllocator::get();
+#endif
+}
+
 void* MOHPC::allocateMemory(size_t size)
 {
-	return malloc(size);
+	if (size > UINT32_MAX) {
+		// can't be stored in the header
+		return nullptr;
+	}
+
+	IAllocator* allocator = getAllocator();
+	blockHeader_t* header = (blockHeader_t*)allocator->allocate(headerSize + size);
+	if (!header) {
+		return nullptr;
+	}
+
+	header->allocator = allocator;
+	header->size = (uint32_t)size;
+	header->tag = currentTag;
+	addAllocations(header->tag, 1, size);
+
+	return (uint8_t*)header + headerSize;
 }
 
 void MOHPC::freeMemory(void* ptr)
 {
-	free(ptr);
-}
\ No newline at end of file
+	if (!ptr) {
+		return;
+	}
+
+	blockHeader_t* header = (blockHeader_t*)((uint8_t*)ptr - headerSize);
+	removeAllocations(header->tag, 1, header->size);
+	header->allocator->deallocate(header, headerSize + header->size);
+}
+
+void MOHPC::setAllocator(IAllocator* allocator)
+{
+	currentAllocator.store(allocator, std::memory_order_release);
+}
+
+IAllocator* MOHPC::getAllocator()
+{
+	IAllocator* allocator = currentAllocator.load(std::memory_order_acquire);
+	return allocator ? allocator : &getDefaultAllocator();
+}
+
+MemoryStats MOHPC::getMemoryStats(memoryTag_e tag)
+{
+	const tagStats_t& stats = tagStats[(size_t)tag];
+
+	MemoryStats result;
+	result.numAllocations = stats.numAllocations.load(std::memory_order_relaxed);
+	result.numFrees = stats.numFrees.load(std::memory_order_relaxed);
+	result.bytesInUse = stats.bytesInUse.load(std::memory_order_relaxed);
+	result.peakBytesInUse = stats.peakBytesInUse.load(std::memory_order_relaxed);
+	return result;
+}
+
+MemoryTagScope::MemoryTagScope(memoryTag_e tag)
+	: previousTag(currentTag)
+{
+	currentTag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+	currentTag = previousTag;
+}
+
+memoryTag_e MOHPC::getMemoryTag()
+{
+	return currentTag;
+}
+
+//==
+// Pool allocator
+//==
+
+static constexpr size_t poolGranularity = 16;
+static constexpr size_t numSizeClasses = PoolAllocator::maxPooledSize / poolGranularity;
+static constexpr size_t poolChunkSize = 64 * 1024;
+// number of blocks moved at once between a thread cache and the shared pool
+static constexpr size_t poolBatchSize = 32;
+
+struct freeBlock_t
+{
+	freeBlock_t* next;
+};
+
+struct sizeClass_t
+{
+	std::mutex lock;
+	freeBlock_t* freeList = nullptr;
+	// chunks are kept referenced, they are never freed
+	void* chunks = nullptr;
+};
+
+struct threadCache_t
+{
+	freeBlock_t* freeLists[numSizeClasses] = {};
+	size_t numFree[numSizeClasses] = {};
+
+	~threadCache_t();
+};
+
+static thread_local threadCache_t threadCache;
+// blocks freed by destructors running after the thread cache is gone go to the shared pool
+static thread_local bool threadCacheDestroyed = false;
+
+static sizeClass_t* getSizeClasses()
+{
+	// never destroyed, blocks can be freed by static destructors
+	static sizeClass_t* sizeClasses = new sizeClass_t[numSizeClasses];
+	return sizeClasses;
+}
+
+static size_t getSizeClassIndex(size_t size)
+{
+	return size ? (size - 1) / poolGranularity : 0;
+}
+
+static freeBlock_t* fetchBlocks(size_t classIndex, size_t maxBlocks, size_t& numFetched)
+{
+	sizeClass_t& sizeClass = getSizeClasses()[classIndex];
+	std::lock_guard<std::mutex> lock(sizeClass.lock);
+
+	if (!sizeClass.freeList)
+	{
+		// carve a new chunk, the first block links the chunks together
+		const size_t blockSize = (classIndex + 1) * poolGranularity;
+		uint8_t* chunk = (uint8_t*)std::malloc(poolChunkSize);
+		if (!chunk) {
+			return nullptr;
+		}
+
+		*(void**)chunk = sizeClass.chunks;
+		sizeClass.chunks = chunk;
+
+		for (size_t offset = blockSize * (poolChunkSize / blockSize - 1); offset > 0; offset -= blockSize)
+		{
+			freeBlock_t* block = (freeBlock_t*)(chunk + offset);
+			block->next = sizeClass.freeList;
+			sizeClass.freeList = block;
+		}
+	}
+
+	freeBlock_t* first = sizeClass.freeList;
+	freeBlock_t* last = first;
+	numFetched = 1;
+	while (last->next && numFetched < maxBlocks)
+	{
+		last = last->next;
+		++numFetched;
+	}
+
+	sizeClass.freeList = last->next;
+	last->next = nullptr;
+	return first;
+}
+
+static void releaseBlocks(size_t classIndex, freeBlock_t* first, freeBlock_t* last)
+{
+	sizeClass_t& sizeClass = getSizeClasses()[classIndex];
+	std::lock_guard<std::mutex> lock(sizeClass.lock);
+
+	last->next = sizeClass.freeList;
+	sizeClass.freeList = first;
+}
+
+threadCache_t::~threadCache_t()
+{
+	for (size_t i = 0; i < numSizeClasses; ++i)
+	{
+		freeBlock_t* first = freeLists[i];
+		if (first)
+		{
+			freeBlock_t* last = first;
+			while (last->next) last = last->next;
+
+			releaseBlocks(i, first, last);
+		}
+	}
+
+	threadCacheDestroyed = true;
+}
+
+void* PoolAllocator::allocate(size_t size)
+{
+	if (size > maxPooledSize) {
+		return std::malloc(size);
+	}
+
+	const size_t classIndex = getSizeClassIndex(size);
+	if (threadCacheDestroyed)
+	{
+		size_t numFetched;
+		return fetchBlocks(classIndex, 1, numFetched);
+	}
+
+	threadCache_t& cache = threadCache;
+	freeBlock_t* block = cache.freeLists[classIndex];
+	if (!block)
+	{
+		block = fetchBlocks(classIndex, poolBatchSize, cache.numFree[classIndex]);
+		if (!block) {
+			return nullptr;
+		}
+	}
+
+	cache.freeLists[classIndex] = block->next;
+	cache.numFree[classIndex]--;
+	return block;
+}
+
+void PoolAllocator::deallocate(void* ptr, size_t size)
+{
+	if (size > maxPooledSize)
+	{
+		std::free(ptr);
+		return;
+	}
+
+	const size_t classIndex = getSizeClassIndex(size);
+	freeBlock_t* block = (freeBlock_t*)ptr;
+	if (threadCacheDestroyed)
+	{
+		releaseBlocks(classIndex, block, block);
+		return;
+	}
+
+	threadCache_t& cache = threadCache;
+	block->next = cache.freeLists[classIndex];
+	cache.freeLists[classIndex] = block;
+
+	if (++cache.numFree[classIndex] > poolBatchSize * 2)
+	{
+		// give a batch back so other threads can use it
+		freeBlock_t* last = block;
+		for (size_t i = 1; i < poolBatchSize; ++i) {
+			last = last->next;
+		}
+
+		cache.freeLists[classIndex] = last->next;
+		cache.numFree[classIndex] -= poolBatchSize;
+		releaseBlocks(classIndex, block, last);
+	}
+}
+
+PoolAllocator& PoolAllocator::get()
+{
+	// never destroyed, like the pools
+	static PoolAllocator* instance = new PoolAllocator;
+	return *instance;
+}
+
+void* MallocAllocator::allocate(size_t size)
+{
+	return std::malloc(size);
+}
+
+void MallocAllocator::deallocate(void* ptr, size_t)
+{
+	std::free(ptr);
+}
+
+MallocAllocator& MallocAllocator::get()
+{
+	static MallocAllocator* instance = new MallocAllocator;
+	return *instance;
+}
+
+//==
+// Memory arena
+//==
+
+struct MemoryArena::Chunk
+{
+	Chunk* next;
+	size_t size;
+	size_t used;
+};
+
+// keeps the memory after the chunk header aligned for any type
+static constexpr size_t chunkHeaderSize = 32;
+
+MemoryArena::MemoryArena(memoryTag_e inTag, size_t inChunkSize)
+	: chunks(nullptr)
+	, chunkSize(inChunkSize)
+	, usedSize(0)
+	, numBlocks(0)
+	, tag(inTag)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+	reset();
+}
+
+void* MemoryArena::allocate(size_t size)
+{
+	static_assert(sizeof(Chunk) <= chunkHeaderSize, "the chunk header is too big");
+
+	size = (size + 15) & ~size_t(15);
+
+	if (!chunks || chunks->used + size > chunks->size)
+	{
+		const size_t newChunkSize = size > chunkSize ? size : chunkSize;
+		Chunk* chunk = (Chunk*)std::malloc(chunkHeaderSize + newChunkSize);
+		if (!chunk) {
+			throw std::bad_alloc();
+		}
+
+		chunk->size = newChunkSize;
+		chunk->used = 0;
+
+		if (chunks && size > chunkSize)
+		{
+			// big blocks get their own chunk, the current one still has room for smaller blocks
+			chunk->next = chunks->next;
+			chunks->next = chunk;
+		}
+		else
+		{
+			chunk->next = chunks;
+			chunks = chunk;
+		}
+
+		chunk->used = size;
+		usedSize += size;
+		++numBlocks;
+		addAllocations(tag, 1, size);
+		return (uint8_t*)chunk + chunkHeaderSize;
+	}
+
+	void* ptr = (uint8_t*)chunks + chunkHeaderSize + chunks->used;
+	chunks->used += size;
+	usedSize += size;
+	++numBlocks;
+	addAllocations(tag, 1, size);
+	return ptr;
+}
+
+void MemoryArena::reset()
+{
+	Chunk* next;
+	for (Chunk* chunk = chunks; chunk; chunk = next)
+	{
+		next = chunk->next;
+		std::free(chunk);
+	}
+
+	removeAllocations(tag, numBlocks, usedSize);
+
+	chunks = nullptr;
+	usedSize = 0;
+	numBlocks = 0;
+}
+
+size_t MemoryArena::getUsedSize() const
+{
+	return usedSize;
+}
+
+MemoryArenaScope::MemoryArenaScope(MemoryArena& inArena)
+	: arena(inArena)
+{
+}
+
+MemoryArenaScope::~MemoryArenaScope()
+{
+	arena.reset();
+}
@@ -1,68 +1,176 @@
 #include <Shared.h>
 #include <MOHPC/Common/con_timer.h>
 #include <MOHPC/Script/Archiver.h>
-#include <MOHPC/Script/Archiver.h>
 
 using namespace MOHPC;
 
+template<>
+intptr_t MOHPC::HashCode< Class * >(Class * const& key)
+{
+	return (intptr_t)key;
+}
+
 con_timer::con_timer()
 {
+	m_Sequence = 0;
 	m_time = 0;
 	m_bDirty = false;
 }
 
-void con_timer::AddElement(Class *e, float time)
+bool con_timer::ElementBefore(const Element& e1, const Element& e2)
 {
-	Element element;
+	if (e1.time != e2.time) {
+		return e1.time < e2.time;
+	}
+
+	return e1.sequence < e2.sequence;
+}
 
-	element.obj = e;
-	element.time = time;
+void con_timer::SetElementAt(size_t index, const Element& element)
+{
+	m_Elements[index] = element;
+	m_Indexes[element.obj] = index;
+}
 
-	m_Elements.AddObject(element);
+void con_timer::SiftUp(size_t index)
+{
+	const Element element = m_Elements[index];
 
-	if (time <= m_time)
+	while (index > 0)
 	{
-		SetDirty();
+		const size_t parentIndex = (index - 1) / 2;
+		if (!ElementBefore(element, m_Elements[parentIndex])) {
+			break;
+		}
+
+		SetElementAt(index, m_Elements[parentIndex]);
+		index = parentIndex;
 	}
+
+	SetElementAt(index, element);
 }
 
-void con_timer::RemoveElement(Class *e)
+void con_timer::SiftDown(size_t index)
 {
-	for (intptr_t i = m_Elements.NumObjects(); i > 0; i--)
+	const size_t numElements = m_Elements.NumObjects();
+	const Element element = m_Elements[index];
+
+	for (;;)
 	{
-		Element *index = &m_Elements.ObjectAt(i);
+		size_t childIndex = index * 2 + 1;
+		if (childIndex >= numElements) {
+			break;
+		}
+
+		// pick the child that comes first
+		if (childIndex + 1 < numElements && ElementBefore(m_Elements[childIndex + 1], m_Elements[childIndex])) {
+			++childIndex;
+		}
 
-		if (index->obj == e)
-		{
-			m_Elements.RemoveObjectAt(i);
-			return;
+		if (!ElementBefore(m_Elements[childIndex], element)) {
+			break;
 		}
+
+		SetElementAt(index, m_Elements[childIndex]);
+		index = childIndex;
 	}
+
+	SetElementAt(index, element);
 }
 
-Class *con_timer::GetNextElement(float& foundtime)
+void con_timer::RemoveElementAt(size_t index)
 {
-	float best_time;
-	intptr_t foundIndex;
-	Class* result;
+	const size_t lastIndex = m_Elements.NumObjects() - 1;
 
-	foundIndex = 0;
-	best_time = m_time;
+	m_Indexes.remove(m_Elements[index].obj);
 
-	for (intptr_t i = m_Elements.NumObjects(); i > 0; i--)
+	if (index != lastIndex)
 	{
-		if (m_Elements.ObjectAt(i).time <= best_time)
-		{
-			best_time = m_Elements.ObjectAt(i).time;
-			foundIndex = i;
+		// move the last element into the hole, and put it at its place
+		const Element last = m_Elements[lastIndex];
+		m_Elements.RemoveObjectAt(lastIndex + 1);
+		SetElementAt(index, last);
+
+		if (index > 0 && ElementBefore(last, m_Elements[(index - 1) / 2])) {
+			SiftUp(index);
+		}
+		else {
+			SiftDown(index);
 		}
 	}
+	else {
+		m_Elements.RemoveObjectAt(lastIndex + 1);
+	}
+}
+
+void con_timer::RebuildHeap()
+{
+	m_Indexes.clear();
+
+	const size_t numElements = m_Elements.NumObjects();
+	for (size_t i = 0; i < numElements; ++i) {
+		m_Indexes[m_Elements[i].obj] = i;
+	}
+
+	for (size_t i = numElements / 2; i > 0; --i) {
+		SiftDown(i - 1);
+	}
+}
 
-	if (foundIndex)
+void con_timer::AddElement(Class *e, float time)
+{
+	uintptr_t* index = m_Indexes.find(e);
+	if (index)
 	{
-		result = m_Elements.ObjectAt(foundIndex).obj;
-		m_Elements.RemoveObjectAt(foundIndex);
-		foundtime = best_time;
+		// only reschedule
+		Element element = m_Elements[*index];
+		const bool later = time >= element.time;
+		element.time = time;
+		element.sequence = m_Sequence++;
+		m_Elements[*index] = element;
+
+		if (later) {
+			SiftDown(*index);
+		}
+		else {
+			SiftUp(*index);
+		}
+	}
+	else
+	{
+		Element element;
+
+		element.obj = e;
+		element.time = time;
+		element.sequence = m_Sequence++;
+
+		m_Elements.AddObject(element);
+		SiftUp(m_Elements.NumObjects() - 1);
+	}
+
+	if (time <= m_time)
+	{
+		SetDirty();
+	}
+}
+
+void con_timer::RemoveElement(Class *e)
+{
+	const uintptr_t* index = m_Indexes.find(e);
+	if (index) {
+		RemoveElementAt(*index);
+	}
+}
+
+Class *con_timer::GetNextElement(float& foundtime)
+{
+	Class* result;
+
+	if (m_Elements.NumObjects() && m_Elements[0].time <= m_time)
+	{
+		result = m_Elements[0].obj;
+		foundtime = m_Elements[0].time;
+		RemoveElementAt(0);
 	}
 	else
 	{
@@ -73,6 +181,11 @@ Class *con_timer::GetNextElement(float& foundtime)
 	return result;
 }
 
+size_t con_timer::NumElements() const
+{
+	return m_Elements.NumObjects();
+}
+
 void con_timer::ArchiveElement(Archiver& arc, Element *e)
 {
 	/*
@@ -88,5 +201,22 @@ void con_timer::Archive(Archiver& arc)
 	arc.ArchiveInteger(&m_inttime);
 	*/
 
+	// archive in firing order so that elements of the same time keep their order once loaded
+	m_Elements.Sort([](const void* elem1, const void* elem2) -> int
+	{
+		const Element& e1 = *(const Element*)elem1;
+		const Element& e2 = *(const Element*)elem2;
+		return ElementBefore(e1, e2) ? -1 : ElementBefore(e2, e1) ? 1 : 0;
+	});
+
 	m_Elements.Archive(arc, con_timer::ArchiveElement);
+
+	// the sequence isn't archived, it comes from the order
+	for (size_t i = 0; i < m_Elements.NumObjects(); ++i) {
+		m_Elements[i].sequence = i;
+	}
+	m_Sequence = m_Elements.NumObjects();
+
+	// a sorted array is already a heap, but the indexes must be rebuilt
+	RebuildHeap();
 }
@@ -255,7 +255,8 @@ void str::append
 
 	assert(text);
 
-	if (text)
+	// nothing is allocated when appending an empty string to an empty string
+	if (text && *text)
 	{
 		len = length();
 		len += strlen(text);
@@ -270,6 +271,10 @@ void str::append(const str& text)
 {
 	size_t len;
 
+	if (!text.length()) {
+		return;
+	}
+
 	len = length();
 	len += text.length();
 	EnsureAlloced(len + 1);
@@ -349,7 +354,7 @@ void str::operator=(const char* text)
 		m_data = new strdata;
 		m_data->len = len;
 		m_data->alloced = len + 1;
-		m_data->data = new char[len + 1];
+		m_data->data = (char*)allocateMemory(len + 1);
 		strcpy(m_data->data, text);
 	}
 }
@@ -607,7 +612,11 @@ void str::tolower
 )
 
 {
-	assert(m_data);
+	if (!m_data)
+	{
+		// empty string
+		return;
+	}
 
 	EnsureDataWritable();
 
@@ -620,7 +629,11 @@ void str::toupper
 )
 
 {
-	assert(m_data);
+	if (!m_data)
+	{
+		// empty string
+		return;
+	}
 
 	EnsureDataWritable();
 
@@ -1076,7 +1089,7 @@ void str::EnsureAlloced
 		{
 			m_data = new strdata;
 
-			m_data->data = new char[amount];
+			m_data->data = (char*)allocateMemory(amount);
 			m_data->alloced = amount;
 
 			m_data->data[0] = '\0';
@@ -1119,7 +1132,7 @@ void str::EnsureAlloced
 		m_data->alloced = newsize;
 	}
 
-	newbuffer = new char[m_data->alloced];
+	newbuffer = (char*)allocateMemory(m_data->alloced);
 
 	if (wasalloced && keepold)
 	{
@@ -1128,7 +1141,7 @@ void str::EnsureAlloced
 
 	if (m_data->data)
 	{
-		delete[] m_data->data;
+		freeMemory(m_data->data);
 	}
 
 	m_data->data = newbuffer;
@@ -10,10 +10,14 @@
 #include <MOHPC/Collision/Collision.h>
 #include <MOHPC/Misc/Endian.h>
 #include <MOHPC/Misc/EndianHelpers.h>
+#include <MOHPC/Misc/crc32.h>
 #include "BSP_Curve.h"
+#include "../../Collision/CollisionPrivate.h"
+#include "../../Utilities/ParallelFor.h"
 #include <chrono>
 #include <algorithm>
 #include <functional>
+#include <vector>
 
 /*
 #ifdef DEBUG
@@ -96,12 +100,12 @@ namespace BSPFile
 {
 	struct GameLump
 	{
+		// allocated from the load arena
 		void* buffer;
 		size_t length;
 
 	public:
 		GameLump();
-		~GameLump();
 	};
 
 	struct flump_t
@@ -363,13 +367,6 @@ BSPFile::GameLump::GameLump()
 {
 }
 
-BSPFile::GameLump::~GameLump()
-{
-	if (buffer) {
-		delete[] (uint8_t*)buffer;
-	}
-}
-
 const char* BSPData::Brush::GetName() const
 {
 	return name.c_str();
@@ -668,11 +665,14 @@ static bool BrushIsTouching(BSPData::Brush* b1, BSPData::Brush* b2)
 CLASS_DEFINITION(BSP);
 
 BSP::BSP()
+	: loadArena(memoryTag_e::BSP)
 {
 	numClusters = 0;
 	numAreas = 0;
 	entityString = NULL;
 	entityStringLength = 0;
+	contentHash = 0;
+	hasContentHash = false;
 }
 
 BSP::~BSP()
@@ -696,6 +696,10 @@ BSP::~BSP()
 
 bool BSP::Load()
 {
+	MemoryTagScope tagScope(memoryTag_e::BSP);
+	// the lump buffers are freed once loaded, or when the load fails
+	MemoryArenaScope arenaScope(loadArena);
+
 	const FilePtr file = GetFileManager()->OpenFile(GetFilename().c_str());
 	if (!file) {
 		throw AssetError::AssetNotFound(GetFilename());
@@ -703,10 +707,10 @@ bool BSP::Load()
 
 	std::istream* stream = file->GetStream();
 
-	BSPFile::fheader_t Header;
+	BSPFile::fheader_t Header{ 0 };
 	stream->read((char*)&Header, sizeof(Header));
 
-	if (memcmp(Header.ident, BSP_IDENT, sizeof(Header.ident)) && memcmp(Header.ident, BSP_EXPANSIONS_IDENT, sizeof(Header.ident)))
+	if (stream->gcount() != sizeof(Header) || (memcmp(Header.ident, BSP_IDENT, sizeof(Header.ident)) && memcmp(Header.ident, BSP_EXPANSIONS_IDENT, sizeof(Header.ident))))
 	{
 		MOHPC_LOG(Error, "'%s' has wrong header", GetFilename().c_str());
 		throw BSPError::BadHeader((uint8_t*)Header.ident);
@@ -1344,9 +1348,10 @@ void BSP::LoadShaders(const BSPFile::GameLump* GameLump)
 		{
 			out->surfaceFlags = Endian.LittleLong(in->surfaceFlags);
 			out->contentFlags = Endian.LittleLong(in->contentFlags);
-			out->shaderName = in->shader;
+			// the name is not terminated when it fills the field
+			out->shaderName = str(in->shader, strnlen(in->shader, sizeof(in->shader)));
 			out->subdivisions = Endian.LittleLong(in->subdivisions);
-			out->shader = shaderManager->GetShader(in->shader);
+			out->shader = shaderManager->GetShader(out->shaderName.c_str());
 		}
 	}
 }
@@ -1619,6 +1624,9 @@ void BSP::LoadSurfaces(const BSPFile::GameLump* surfaces, const BSPFile::GameLum
 		const BSPFile::fvertice_t* InVerts = (BSPFile::fvertice_t*)vertices->buffer;
 		int32_t* InIndexes = (int32_t*)Indices->buffer;
 
+		// patches are subdivided and their collision generated afterward, on all cores
+		std::vector<size_t> patchSurfaces;
+
 		for (size_t i = 0; i < count; i++, in++, out++)
 		{
 			out->lightmapNum = Endian.LittleLong(in->lightmapNum);
@@ -1634,8 +1642,8 @@ void BSP::LoadSurfaces(const BSPFile::GameLump* surfaces, const BSPFile::GameLum
 			switch (Endian.LittleLong(in->surfaceType))
 			{
 			case MST_PATCH:
-				ParseMesh(in, InVerts, out);
-				break;
+				patchSurfaces.push_back(i);
+				continue;
 			case MST_TRIANGLE_SOUP:
 				ParseTriSurf(in, InVerts, InIndexes, out);
 				break;
@@ -1646,6 +1654,17 @@ void BSP::LoadSurfaces(const BSPFile::GameLump* surfaces, const BSPFile::GameLum
 
 			out->CalculateCentroid();
 		}
+
+		// each patch only writes to its own surface, so the result is the same as doing it serially
+		const BSPFile::fsurface_t* inSurfaces = (BSPFile::fsurface_t*)surfaces->buffer;
+		Surface* outSurfaces = this->surfaces.data();
+
+		ParallelFor(patchSurfaces.size(), [&](size_t p)
+		{
+			const size_t surfaceNum = patchSurfaces[p];
+			ParseMesh(&inSurfaces[surfaceNum], InVerts, &outSurfaces[surfaceNum]);
+			outSurfaces[surfaceNum].CalculateCentroid();
+		});
 	}
 }
 
@@ -1902,6 +1921,19 @@ void BSP::LoadNodes(const BSPFile::GameLump* GameLump)
 				out->children[j] = Endian.LittleLong(in->children[j]);
 			}
 		}
+
+		// compact tree for point queries
+		CM_FlattenTree(flatNodes, count, [this](int32_t num, collisionFlatNode_t& flatNode)
+		{
+			const Node& node = nodes[num];
+
+			VecCopy(node.plane->normal, flatNode.normal);
+			flatNode.dist = node.plane->distance;
+			flatNode.type = (uint8_t)node.plane->type;
+			flatNode.signbits = node.plane->signBits;
+			flatNode.children[0] = node.children[0];
+			flatNode.children[1] = node.children[1];
+		});
 	}
 }
 
@@ -1942,6 +1974,12 @@ void BSP::LoadSubmodels(const BSPFile::GameLump* GameLump)
 		size_t numLeafSurfaces = 0;
 		for (size_t i = 0; i < count; i++)
 		{
+			const uint64_t lastSurface = (uint64_t)Endian.LittleLong(in[i].firstSurface) + Endian.LittleLong(in[i].numSurfaces);
+			const uint64_t lastBrush = (uint64_t)Endian.LittleLong(in[i].firstBrush) + Endian.LittleLong(in[i].numBrushes);
+			if (lastSurface > surfaces.size() || lastBrush > brushes.size()) {
+				throw BSPError::IndexOutOfRange("submodels");
+			}
+
 			numLeafBrushes += Endian.LittleLong(in[i].numBrushes);
 			numLeafSurfaces += Endian.LittleLong(in[i].numSurfaces);
 		}
@@ -2006,6 +2044,11 @@ void BSP::LoadSubmodels(const BSPFile::GameLump* GameLump)
 			startLeafBrush += out->leaf.numLeafBrushes;
 		}
 	}
+	else
+	{
+		// there must be at least the world
+		throw BSPError::FunnyLumpSize("submodels");
+	}
 }
 
 void BSP::LoadEntityString(const BSPFile::GameLump* GameLump)
@@ -2339,14 +2382,20 @@ void BSP::FillCollisionWorld(CollisionWorld& cm)
 		}
 	}
 
+	// Generate terrain collisions on all cores, they're added below in order
+	std::vector<TerrainCollide> terrainCollisions(terrainPatches.NumObjects());
+	ParallelFor(terrainPatches.NumObjects(), [&](size_t i)
+	{
+		GenerateTerrainCollide(&terrainPatches[i], terrainCollisions[i]);
+	}, 32);
+
 	// Put terrains
 	for (size_t i = 0; i < terrainPatches.NumObjects(); ++i)
 	{
 		const TerrainPatch& terrain = terrainPatches[i];
 		const BSPData::Shader* shader = terrain.shader;
 
-		TerrainCollide collision;
-		GenerateTerrainCollide(&terrain, collision);
+		const TerrainCollide& collision = terrainCollisions[i];
 
 		collisionTerrain_t* colTerrain = cm.createTerrain();
 		colTerrain->tc.vBounds[0] = collision.vBounds[0];
@@ -2414,6 +2463,40 @@ void BSP::FillCollisionWorld(CollisionWorld& cm)
 		colModel->leaf.numLeafSurfaces = (uint32_t)bmodel.leaf.numLeafSurfaces;
 		colModel->leaf.numLeafTerrains = (uint32_t)bmodel.leaf.numLeafTerrains;
 	}
+
+	cm.flattenTree();
+}
+
+uint64_t BSP::GetContentHash() const
+{
+	std::lock_guard<std::mutex> lock(contentHashMutex);
+
+	if (!hasContentHash)
+	{
+		const FilePtr file = GetFileManager()->OpenFile(GetFilename().c_str());
+		if (!file) {
+			throw AssetError::AssetNotFound(GetFilename());
+		}
+
+		std::istream* stream = file->GetStream();
+
+		uint32_t crc = 0;
+		uint32_t length = 0;
+		char buffer[16384];
+		do
+		{
+			stream->read(buffer, sizeof(buffer));
+
+			const size_t numRead = (size_t)stream->gcount();
+			crc = crc32_hash(buffer, numRead, crc);
+			length += (uint32_t)numRead;
+		} while (*stream);
+
+		contentHash = ((uint64_t)length << 32) | crc;
+		hasContentHash = true;
+	}
+
+	return contentHash;
 }
 
 void BSP::FloodArea(size_t areaNum, uint32_t floodNum, uint32_t& floodValid)
@@ -2521,16 +2604,24 @@ void BSP::ColorShiftLightingFloats3(vec3_t in, vec3_t out, float scale)
 
 uint32_t BSP::LoadLump(const FilePtr& file, BSPFile::flump_t* lump, BSPFile::GameLump* gameLump, size_t size)
 {
+	const uint32_t fileOffset = Endian.LittleLong(lump->fileOffset);
 	const uint32_t fileLength = Endian.LittleLong(lump->fileLength);
 	gameLump->length = fileLength;
 
 	if (fileLength)
 	{
-		gameLump->buffer = new uint8_t[fileLength];
+		if ((uint64_t)fileOffset + fileLength > (uint64_t)file->GetLength())
+		{
+			// don't allocate what can't be read
+			gameLump->buffer = nullptr;
+			gameLump->length = 0;
+			throw BSPError::LumpOutOfBounds(fileOffset, fileLength);
+		}
+
+		gameLump->buffer = loadArena.allocate(fileLength);
 
 		std::istream* Stream = file->GetStream();
 
-		const uint32_t fileOffset = Endian.LittleLong(lump->fileOffset);
 		Stream->seekg(fileOffset, Stream->beg);
 		Stream->read((char*)gameLump->buffer, fileLength);
 
@@ -3011,6 +3102,10 @@ uintptr_t BSP::PointLeafNum(const Vector p)
 		return 0;
 	}
 
+	if (flatNodes.size()) {
+		return PointLeafNumFlat(p);
+	}
+
 	return PointLeafNum_r(p, 0);
 }
 
@@ -3039,6 +3134,32 @@ uintptr_t BSP::PointLeafNum_r(const Vector p, intptr_t num)
 	return -1 - num;
 }
 
+uintptr_t BSP::PointLeafNumFlat(const Vector p)
+{
+	const collisionFlatNode_t* const nodeList = flatNodes.data();
+	intptr_t num = 0;
+	float d;
+
+	while (num >= 0)
+	{
+		const collisionFlatNode_t* node = nodeList + num;
+
+		if (node->type < Plane::PLANE_NON_AXIAL) {
+			d = p[node->type] - node->dist;
+		} else {
+			d = DotProduct(node->normal, p) - node->dist;
+		}
+
+		if (d < 0) {
+			num = node->children[1];
+		} else {
+			num = node->children[0];
+		}
+	}
+
+	return -1 - num;
+}
+
 BSPError::BadHeader::BadHeader(const uint8_t inHeader[4])
 	: foundHeader{ inHeader[0], inHeader[1], inHeader[2], inHeader[3] }
 {
@@ -3069,3 +3190,29 @@ const char* BSPError::FunnyLumpSize::getLumpName() const
 {
 	return lumpName;
 }
+
+BSPError::IndexOutOfRange::IndexOutOfRange(const char* inLumpName)
+	: lumpName(inLumpName)
+{
+}
+
+const char* BSPError::IndexOutOfRange::getLumpName() const
+{
+	return lumpName;
+}
+
+BSPError::LumpOutOfBounds::LumpOutOfBounds(uint32_t inOffset, uint32_t inLength)
+	: offset(inOffset)
+	, length(inLength)
+{
+}
+
+uint32_t BSPError::LumpOutOfBounds::getOffset() const
+{
+	return offset;
+}
+
+uint32_t BSPError::LumpOutOfBounds::getLength() const
+{
+	return length;
+}
@@ -2,9 +2,31 @@
 #include <MOHPC/Formats/BSP.h>
 #include "BSP_Curve.h"
 
+#include <memory>
+
 using namespace MOHPC;
 using namespace BSPData;
 
+/*
+ * Working storage of SubdividePatchToGrid, too large for the stack of worker threads.
+ */
+struct gridScratch_t
+{
+	BSPData::Vertice ctrl[MAX_GRID_SIZE][MAX_GRID_SIZE];
+	int32_t indexes[(MAX_GRID_SIZE - 1)*(MAX_GRID_SIZE - 1) * 2 * 3];
+};
+
+static gridScratch_t& GetGridScratch()
+{
+	// patches can be subdivided from multiple threads
+	static thread_local std::unique_ptr<gridScratch_t> scratch;
+	if (!scratch) {
+		scratch.reset(new gridScratch_t);
+	}
+
+	return *scratch;
+}
+
 static void LerpDrawVert(const BSPData::Vertice* a, const BSPData::Vertice* b, BSPData::Vertice* out)
 {
 	out->xyz[0] = 0.5f * (a->xyz[0] + b->xyz[0]);
@@ -314,10 +336,11 @@ void BSP::SubdividePatchToGrid(int32_t Width, int32_t Height, const Vertice* Poi
 	float len, maxLen;
 	int32_t dir;
 	int32_t t;
-	Vertice ctrl[MAX_GRID_SIZE][MAX_GRID_SIZE];
+	gridScratch_t& scratch = GetGridScratch();
+	Vertice (&ctrl)[MAX_GRID_SIZE][MAX_GRID_SIZE] = scratch.ctrl;
 	float		errorTable[2][MAX_GRID_SIZE];
 	int32_t numIndexes;
-	int32_t indexes[(MAX_GRID_SIZE - 1)*(MAX_GRID_SIZE - 1) * 2 * 3];
+	int32_t* indexes = scratch.indexes;
 	//int32_t consecutiveComplete;
 
 	for (i = 0; i < Width; i++) {
@@ -2,6 +2,8 @@
 #include <MOHPC/Formats/BSP.h>
 #include "Polylib.h"
 
+#include <memory>
+
 using namespace MOHPC;
 using namespace BSPData;
 
@@ -25,6 +27,27 @@ struct cGrid_t {
 	vec3_t points[MAX_GRID_SIZE][MAX_GRID_SIZE];	// [width][height]
 };
 
+/*
+ * Working storage of GeneratePatchCollide, too large for the stack of worker threads.
+ */
+struct patchScratch_t
+{
+	cGrid_t grid;
+	patchWork_t pw;
+	int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2];
+};
+
+static patchScratch_t& GetPatchScratch()
+{
+	// patch collisions can be generated from multiple threads
+	static thread_local std::unique_ptr<patchScratch_t> scratch;
+	if (!scratch) {
+		scratch.reset(new patchScratch_t);
+	}
+
+	return *scratch;
+}
+
 static bool ValidateFacet(patchWork_t& pw, BSPData::Facet *facet) {
 	float		plane[4];
 	int			j;
@@ -736,10 +759,9 @@ typedef enum {
 	EN_LEFT
 } edgeName_t;
 
-static void PatchCollideFromGrid(patchWork_t& pw, cGrid_t *grid, BSPData::PatchCollide *pf) {
+static void PatchCollideFromGrid(patchWork_t& pw, cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], BSPData::PatchCollide *pf) {
 	int				i, j;
 	float			*p1, *p2, *p3;
-	int				gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2];
 	BSPData::Facet		*facet;
 	int				borders[4];
 	int				noAdjust[4];
@@ -902,7 +924,6 @@ static void PatchCollideFromGrid(patchWork_t& pw, cGrid_t *grid, BSPData::PatchC
 BSPData::PatchCollide* BSP::GeneratePatchCollide(int32_t width, int32_t height, const Vertice *points, float subdivisions)
 {
 	PatchCollide	*pf;
-	cGrid_t			grid;
 	int				i, j;
 
 	if (width <= 2 || height <= 2 || !points) {
@@ -917,7 +938,10 @@ BSPData::PatchCollide* BSP::GeneratePatchCollide(int32_t width, int32_t height,
 		return nullptr;
 	}
 
-	patchWork_t pw;
+	patchScratch_t& scratch = GetPatchScratch();
+	patchWork_t& pw = scratch.pw;
+	cGrid_t& grid = scratch.grid;
+
 	// build a grid
 	grid.width = width;
 	grid.height = height;
@@ -929,13 +953,6 @@ BSPData::PatchCollide* BSP::GeneratePatchCollide(int32_t width, int32_t height,
 		}
 	}
 
-	for (i = 0; i < width; i++) {
-		for (j = 0; j < height; j++) {
-			FindPlane(pw, grid.points[i][j], grid.points[i + 1][j], grid.points[i + 1][j + 1]);
-			FindPlane(pw, grid.points[i + 1][j + 1], grid.points[i][j + 1], grid.points[i][j]);
-		}
-	}
-
 	// subdivide the grid
 	SetGridWrapWidth(&grid);
 	SubdivideGridColumns(&grid, subdivisions);
@@ -959,7 +976,7 @@ BSPData::PatchCollide* BSP::GeneratePatchCollide(int32_t width, int32_t height,
 	}
 
 	// generate a bsp tree for the surface
-	PatchCollideFromGrid(pw, &grid, pf);
+	PatchCollideFromGrid(pw, &grid, scratch.gridPlanes, pf);
 
 	// expand by one unit for epsilon purposes
 	pf->bounds[0][0] -= 1;
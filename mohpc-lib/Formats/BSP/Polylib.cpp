@@ -9,13 +9,6 @@
 
 namespace MOHPC
 {
-// counters are only bumped when running single threaded,
-// because they are an awful coherence problem
-int	c_active_windings;
-int	c_peak_windings;
-int	c_winding_allocs;
-int	c_winding_points;
-
 void pw(winding_t *w)
 {
 	int		i;
@@ -34,12 +27,6 @@ winding_t	*AllocWinding (int points)
 	winding_t	*w;
 	int			s;
 
-	c_winding_allocs++;
-	c_winding_points += points;
-	c_active_windings++;
-	if (c_active_windings > c_peak_windings)
-		c_peak_windings = c_active_windings;
-
 	s = sizeof(vec_t)*3*points + sizeof(int);
 	w = (winding_t*)malloc (s);
 	memset (w, 0, s); 
@@ -56,7 +43,6 @@ void FreeWinding (winding_t *w)
 
 	*(unsigned *)w = 0xdeaddead;
 
-	c_active_windings--;
 	free (w);
 }
 
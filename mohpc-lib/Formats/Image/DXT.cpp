@@ -0,0 +1,274 @@
+#include <Shared.h>
+#include <MOHPC/Formats/DXT.h>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DXT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace MOHPC;
+
+/*
+ * Colors are stored as RGBA bytes, in the same order as the output pixels.
+ */
+struct dxtColor_t
+{
+	uint8_t rgba[4];
+};
+
+static void UnpackColor565(uint16_t value, dxtColor_t& out)
+{
+	const uint8_t r = (value >> 11) & 0x1F;
+	const uint8_t g = (value >> 5) & 0x3F;
+	const uint8_t b = value & 0x1F;
+
+	// replicate the high bits into the low bits so that 0x1F gives 0xFF
+	out.rgba[0] = (r << 3) | (r >> 2);
+	out.rgba[1] = (g << 2) | (g >> 4);
+	out.rgba[2] = (b << 3) | (b >> 2);
+	out.rgba[3] = 255;
+}
+
+/*
+====================
+DecodeColorPalette
+
+Build the 4 colors of a color block. When allowTransparent is set (DXT1),
+c0 <= c1 selects the 3 colors mode where the last color is transparent black.
+====================
+*/
+static void DecodeColorPalette(const uint8_t* block, dxtColor_t palette[4], bool allowTransparent)
+{
+	const uint16_t c0 = block[0] | (block[1] << 8);
+	const uint16_t c1 = block[2] | (block[3] << 8);
+
+	UnpackColor565(c0, palette[0]);
+	UnpackColor565(c1, palette[1]);
+
+	if (c0 > c1 || !allowTransparent)
+	{
+		for (size_t i = 0; i < 3; ++i)
+		{
+			const uint32_t a = palette[0].rgba[i];
+			const uint32_t b = palette[1].rgba[i];
+			palette[2].rgba[i] = (uint8_t)((2 * a + b + 1) / 3);
+			palette[3].rgba[i] = (uint8_t)((a + 2 * b + 1) / 3);
+		}
+
+		palette[2].rgba[3] = 255;
+		palette[3].rgba[3] = 255;
+	}
+	else
+	{
+		for (size_t i = 0; i < 3; ++i)
+		{
+			const uint32_t a = palette[0].rgba[i];
+			const uint32_t b = palette[1].rgba[i];
+			palette[2].rgba[i] = (uint8_t)((a + b + 1) / 2);
+		}
+
+		palette[2].rgba[3] = 255;
+		memset(palette[3].rgba, 0, sizeof(palette[3].rgba));
+	}
+}
+
+/*
+====================
+DecodeExplicitAlpha
+
+DXT3 alpha, 4 bits per pixel.
+====================
+*/
+static void DecodeExplicitAlpha(const uint8_t* block, uint8_t alphas[16])
+{
+	for (size_t i = 0; i < 8; ++i)
+	{
+		const uint8_t low = block[i] & 0xF;
+		const uint8_t high = block[i] >> 4;
+		alphas[i * 2] = low | (low << 4);
+		alphas[i * 2 + 1] = high | (high << 4);
+	}
+}
+
+/*
+====================
+DecodeInterpolatedAlpha
+
+DXT5 alpha, 2 endpoints and 3-bit indices into the interpolated alphas.
+====================
+*/
+static void DecodeInterpolatedAlpha(const uint8_t* block, uint8_t alphas[16])
+{
+	const uint32_t a0 = block[0];
+	const uint32_t a1 = block[1];
+
+	uint8_t palette[8];
+	palette[0] = (uint8_t)a0;
+	palette[1] = (uint8_t)a1;
+
+	if (a0 > a1)
+	{
+		for (uint32_t i = 1; i < 7; ++i) {
+			palette[i + 1] = (uint8_t)(((7 - i) * a0 + i * a1 + 3) / 7);
+		}
+	}
+	else
+	{
+		for (uint32_t i = 1; i < 5; ++i) {
+			palette[i + 1] = (uint8_t)(((5 - i) * a0 + i * a1 + 2) / 5);
+		}
+
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	// 16 indices of 3 bits, in 48 bits
+	uint64_t bits = 0;
+	for (size_t i = 0; i < 6; ++i) {
+		bits |= (uint64_t)block[2 + i] << (8 * i);
+	}
+
+	for (size_t i = 0; i < 16; ++i) {
+		alphas[i] = palette[(bits >> (3 * i)) & 7];
+	}
+}
+
+/*
+====================
+WriteBlock
+
+Expand the 2-bit color indices into the output, with optional per-pixel alpha.
+====================
+*/
+static void WriteBlock(const uint8_t* colorBlock, const dxtColor_t palette[4], const uint8_t* alphas, uint8_t* out, size_t stride, uint32_t columns, uint32_t rows)
+{
+	const uint32_t indices = colorBlock[4] | (colorBlock[5] << 8) | (colorBlock[6] << 16) | ((uint32_t)colorBlock[7] << 24);
+
+#ifdef DXT_USE_SSE2
+	// x86 is little-endian, so RGBA bytes loaded as an integer keep their order
+	uint32_t packed[4];
+	memcpy(packed, palette, sizeof(packed));
+
+	const __m128i color0 = _mm_set1_epi32((int)packed[0]);
+	const __m128i color1 = _mm_set1_epi32((int)packed[1]);
+	const __m128i color2 = _mm_set1_epi32((int)packed[2]);
+	const __m128i color3 = _mm_set1_epi32((int)packed[3]);
+	const __m128i three = _mm_set1_epi32(3);
+	const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+
+	for (uint32_t y = 0; y < rows; ++y)
+	{
+		const uint32_t rowIndices = (indices >> (8 * y)) & 0xFF;
+
+		// select the palette color of each lane with masks, SSE2 has no byte shuffle
+		__m128i index = _mm_set_epi32(rowIndices >> 6, rowIndices >> 4, rowIndices >> 2, rowIndices);
+		index = _mm_and_si128(index, three);
+
+		__m128i pixels = _mm_and_si128(_mm_cmpeq_epi32(index, _mm_setzero_si128()), color0);
+		pixels = _mm_or_si128(pixels, _mm_and_si128(_mm_cmpeq_epi32(index, _mm_set1_epi32(1)), color1));
+		pixels = _mm_or_si128(pixels, _mm_and_si128(_mm_cmpeq_epi32(index, _mm_set1_epi32(2)), color2));
+		pixels = _mm_or_si128(pixels, _mm_and_si128(_mm_cmpeq_epi32(index, three), color3));
+
+		if (alphas)
+		{
+			const uint8_t* rowAlphas = alphas + y * 4;
+			const __m128i alpha = _mm_set_epi32(
+				(int)((uint32_t)rowAlphas[3] << 24),
+				(int)((uint32_t)rowAlphas[2] << 24),
+				(int)((uint32_t)rowAlphas[1] << 24),
+				(int)((uint32_t)rowAlphas[0] << 24)
+			);
+			pixels = _mm_or_si128(_mm_and_si128(pixels, rgbMask), alpha);
+		}
+
+		uint8_t* dest = out + y * stride;
+		if (columns == 4) {
+			_mm_storeu_si128((__m128i*)dest, pixels);
+		}
+		else
+		{
+			// partial block on the right edge of the image
+			uint8_t row[16];
+			_mm_storeu_si128((__m128i*)row, pixels);
+			memcpy(dest, row, columns * 4);
+		}
+	}
+#else
+	for (uint32_t y = 0; y < rows; ++y)
+	{
+		uint8_t* dest = out + y * stride;
+
+		for (uint32_t x = 0; x < columns; ++x)
+		{
+			const uint32_t pixelNum = y * 4 + x;
+			const uint32_t index = (indices >> (2 * pixelNum)) & 3;
+
+			memcpy(dest + x * 4, palette[index].rgba, 4);
+			if (alphas) {
+				dest[x * 4 + 3] = alphas[pixelNum];
+			}
+		}
+	}
+#endif
+}
+
+static void DecodeBlockClipped(DXT::Format format, const uint8_t* block, uint8_t* out, size_t stride, uint32_t columns, uint32_t rows)
+{
+	dxtColor_t palette[4];
+	uint8_t alphas[16];
+
+	switch (format)
+	{
+	case DXT::Format::DXT1:
+		DecodeColorPalette(block, palette, true);
+		WriteBlock(block, palette, nullptr, out, stride, columns, rows);
+		break;
+	case DXT::Format::DXT3:
+		DecodeExplicitAlpha(block, alphas);
+		DecodeColorPalette(block + 8, palette, false);
+		WriteBlock(block + 8, palette, alphas, out, stride, columns, rows);
+		break;
+	case DXT::Format::DXT5:
+		DecodeInterpolatedAlpha(block, alphas);
+		DecodeColorPalette(block + 8, palette, false);
+		WriteBlock(block + 8, palette, alphas, out, stride, columns, rows);
+		break;
+	}
+}
+
+size_t DXT::GetBlockSize(Format format)
+{
+	return format == Format::DXT1 ? 8 : 16;
+}
+
+size_t DXT::GetImageSize(Format format, uint32_t width, uint32_t height)
+{
+	const size_t blocksWide = (width + 3) / 4;
+	const size_t blocksHigh = (height + 3) / 4;
+	return blocksWide * blocksHigh * GetBlockSize(format);
+}
+
+void DXT::DecodeBlock(Format format, const uint8_t* block, uint8_t* out, size_t stride)
+{
+	DecodeBlockClipped(format, block, out, stride, 4, 4);
+}
+
+void DXT::DecodeImage(Format format, const uint8_t* in, uint32_t width, uint32_t height, uint8_t* out)
+{
+	const size_t blockSize = GetBlockSize(format);
+	const size_t stride = (size_t)width * 4;
+
+	for (uint32_t y = 0; y < height; y += 4)
+	{
+		const uint32_t rows = height - y < 4 ? height - y : 4;
+
+		for (uint32_t x = 0; x < width; x += 4)
+		{
+			const uint32_t columns = width - x < 4 ? width - x : 4;
+
+			DecodeBlockClipped(format, in, out + y * stride + x * 4, stride, columns, rows);
+			in += blockSize;
+		}
+	}
+}
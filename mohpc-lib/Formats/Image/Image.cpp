@@ -1,6 +1,7 @@
 #include <Shared.h>
 #include <MOHPC/Formats/Image.h>
 #include <MOHPC/Managers/FileManager.h>
+#include "ImagePrivate.h"
 #include <filesystem>
 #include <string>
 
@@ -16,6 +17,7 @@ Image::Image()
 	dataSize = 0;
 	width = height = 0;
 	pixelFormat = PixelFormat::IF_Unknown;
+	mipmapData = nullptr;
 }
 
 Image::~Image()
@@ -24,6 +26,11 @@ Image::~Image()
 	{
 		delete[] data;
 	}
+
+	if (mipmapData)
+	{
+		delete[] mipmapData;
+	}
 }
 
 bool Image::Load()
@@ -88,6 +95,135 @@ bool Image::Load()
 	return true;
 }
 
+/**
+ * Read the dimensions and reject images that are too large to be decoded.
+ */
+static void ReadHeader(ImageFileFormat format, const char *name, const void *buf, size_t len, uint32_t& width, uint32_t& height)
+{
+	switch (format)
+	{
+	case ImageFileFormat::TGA:
+		ReadTGAHeader(name, buf, len, width, height);
+		break;
+	case ImageFileFormat::JPEG:
+		ReadJPEGHeader(name, buf, len, width, height);
+		break;
+	default:
+		throw ImageException("%s: unsupported format", name);
+	}
+
+	if (!width || !height || (uint64_t)width * height * 4 > 0x7FFFFFFF)
+	{
+		throw ImageException("%s has an invalid image size", name);
+	}
+}
+
+static void Decode(ImageFileFormat format, const char *name, const void *buf, size_t len, uint8_t *out)
+{
+	switch (format)
+	{
+	case ImageFileFormat::TGA:
+		DecodeTGA(name, buf, len, out);
+		break;
+	case ImageFileFormat::JPEG:
+		DecodeJPEG(name, buf, len, out);
+		break;
+	default:
+		throw ImageException("%s: unsupported format", name);
+	}
+}
+
+void Image::LoadRGBA(ImageFileFormat format, const char *name, void *buf, std::streamsize len)
+{
+	uint32_t imageWidth, imageHeight;
+	ReadHeader(format, name, buf, (size_t)len, imageWidth, imageHeight);
+
+	const uint32_t imageSize = imageWidth * imageHeight * 4;
+	uint8_t* pixels = new uint8_t[imageSize];
+
+	try
+	{
+		Decode(format, name, buf, (size_t)len, pixels);
+	}
+	catch (std::exception&)
+	{
+		delete[] pixels;
+		throw;
+	}
+
+	data = pixels;
+	dataSize = imageSize;
+	width = imageWidth;
+	height = imageHeight;
+	pixelFormat = PixelFormat::IF_RGBA;
+}
+
+ImageFileFormat Image::GetFileFormat(const char* fileName)
+{
+	const std::string ext = fs::path(fileName).extension().generic_string();
+
+	if (!stricmp(ext.c_str(), ".tga")) {
+		return ImageFileFormat::TGA;
+	}
+	else if (!stricmp(ext.c_str(), ".jpg") || !stricmp(ext.c_str(), ".jpeg")) {
+		return ImageFileFormat::JPEG;
+	}
+
+	return ImageFileFormat::Unknown;
+}
+
+bool Image::DecodeHeader(ImageFileFormat format, const void* buf, size_t len, uint32_t& outWidth, uint32_t& outHeight)
+{
+	try
+	{
+		ReadHeader(format, "image", buf, len, outWidth, outHeight);
+	}
+	catch (std::exception&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool Image::DecodeRGBA(ImageFileFormat format, const void* buf, size_t len, uint8_t* out, size_t outSize)
+{
+	try
+	{
+		uint32_t imageWidth, imageHeight;
+		ReadHeader(format, "image", buf, len, imageWidth, imageHeight);
+
+		if ((size_t)imageWidth * imageHeight * 4 > outSize) {
+			return false;
+		}
+
+		Decode(format, "image", buf, len, out);
+	}
+	catch (std::exception&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool Image::DecodeRGBA(ImageFileFormat format, const void* buf, size_t len, std::vector<uint8_t>& out, uint32_t& outWidth, uint32_t& outHeight)
+{
+	try
+	{
+		ReadHeader(format, "image", buf, len, outWidth, outHeight);
+
+		out.resize((size_t)outWidth * outHeight * 4);
+		Decode(format, "image", buf, len, out.data());
+	}
+	catch (std::exception&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
 uint8_t *Image::GetData() const
 {
 	return data;
@@ -112,3 +248,110 @@ uint32_t Image::GetHeight() const
 {
 	return height;
 }
+
+uint32_t Image::GetBytesPerPixel(PixelFormat format)
+{
+	switch (format)
+	{
+	case PixelFormat::IF_RGB:
+		return 3;
+	case PixelFormat::IF_RGBA:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+bool Image::GenerateMipmaps()
+{
+	const uint32_t bytesPerPixel = GetBytesPerPixel(pixelFormat);
+	if (!data || !width || !height || !bytesPerPixel) {
+		return false;
+	}
+
+	if (mipmapData)
+	{
+		delete[] mipmapData;
+		mipmapData = nullptr;
+	}
+
+	// count levels and the size needed to hold all of them
+	size_t numLevels = 1;
+	size_t totalSize = 0;
+	for (uint32_t w = width, h = height; w > 1 || h > 1; ++numLevels)
+	{
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+		totalSize += (size_t)w * h * bytesPerPixel;
+	}
+
+	mipmaps.FreeObjectList();
+	mipmaps.Resize(numLevels);
+
+	ImageMipmap baseLevel;
+	baseLevel.data = data;
+	baseLevel.dataSize = width * height * bytesPerPixel;
+	baseLevel.width = width;
+	baseLevel.height = height;
+	mipmaps.AddObject(baseLevel);
+
+	if (totalSize) {
+		mipmapData = new uint8_t[totalSize];
+	}
+
+	// all levels are allocated at once, one after another
+	uint8_t* levelData = mipmapData;
+	for (size_t i = 1; i < numLevels; ++i)
+	{
+		const ImageMipmap& previous = mipmaps[i - 1];
+
+		ImageMipmap level;
+		level.width = previous.width > 1 ? previous.width / 2 : 1;
+		level.height = previous.height > 1 ? previous.height / 2 : 1;
+		level.dataSize = level.width * level.height * bytesPerPixel;
+		level.data = levelData;
+
+		DownsampleBox(previous.data, previous.width, previous.height, bytesPerPixel, levelData);
+		levelData += level.dataSize;
+
+		mipmaps.AddObject(level);
+	}
+
+	return true;
+}
+
+size_t Image::GetNumMipmaps() const
+{
+	return mipmaps.NumObjects();
+}
+
+const ImageMipmap& Image::GetMipmap(size_t level) const
+{
+	return mipmaps[level];
+}
+
+void Image::DownsampleBox(const uint8_t* in, uint32_t inWidth, uint32_t inHeight, uint32_t bytesPerPixel, uint8_t* out)
+{
+	const uint32_t outWidth = inWidth > 1 ? inWidth / 2 : 1;
+	const uint32_t outHeight = inHeight > 1 ? inHeight / 2 : 1;
+	const size_t inStride = (size_t)inWidth * bytesPerPixel;
+
+	for (uint32_t y = 0; y < outHeight; ++y)
+	{
+		const uint8_t* row0 = in + (size_t)(y * 2) * inStride;
+		// clamp on single-pixel dimensions
+		const uint8_t* row1 = inHeight > 1 ? row0 + inStride : row0;
+
+		for (uint32_t x = 0; x < outWidth; ++x)
+		{
+			const size_t offset0 = (size_t)(x * 2) * bytesPerPixel;
+			const size_t offset1 = inWidth > 1 ? offset0 + bytesPerPixel : offset0;
+
+			for (uint32_t c = 0; c < bytesPerPixel; ++c)
+			{
+				const uint32_t sum = row0[offset0 + c] + row0[offset1 + c] + row1[offset0 + c] + row1[offset1 + c];
+				*out++ = (uint8_t)((sum + 2) / 4);
+			}
+		}
+	}
+}
@@ -1,5 +1,6 @@
 #include <Shared.h>
 #include <MOHPC/Formats/Image.h>
+#include <MOHPC/Formats/DXT.h>
 #include <MOHPC/Misc/Endian.h>
 #include <cstring>
 #include "ImagePrivate.h"
@@ -411,7 +412,51 @@ void Image::LoadDDS(const char *name, void *buf, std::streamsize len)
 		}
 	}
 
-	data = new uint8_t[(size_t)len];
-	memcpy(data, ddsData, (size_t)len);
+	//
+	// Decode the first level into RGBA8
+	//
+	DXT::Format blockFormat;
+	switch (picFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		blockFormat = DXT::Format::DXT1;
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+		blockFormat = DXT::Format::DXT3;
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		blockFormat = DXT::Format::DXT5;
+		break;
+	case GL_RGBA8:
+	case GL_SRGB8_ALPHA8_EXT:
+	{
+		const size_t size = (size_t)width * height * 4;
+		if ((size_t)len < size)
+		{
+			throw ImageException("DDS File %s is truncated.", name);
+		}
+
+		data = new uint8_t[size];
+		dataSize = (uint32_t)size;
+		memcpy(data, ddsData, size);
+		pixelFormat = PixelFormat::IF_RGBA;
+		return;
+	}
+	default:
+		throw ImageException("DDS File %s has a format that can't be decoded.", name);
+	}
+
+	if ((size_t)len < DXT::GetImageSize(blockFormat, width, height))
+	{
+		throw ImageException("DDS File %s is truncated.", name);
+	}
+
+	const size_t size = (size_t)width * height * 4;
+	data = new uint8_t[size];
+	dataSize = (uint32_t)size;
+	DXT::DecodeImage(blockFormat, ddsData, width, height, data);
 	pixelFormat = PixelFormat::IF_RGBA;
 }
@@ -1,51 +1,87 @@
 #include <Shared.h>
 #include <MOHPC/Formats/Image.h>
+#include "ImagePrivate.h"
 #include <jpeg-9d/jpeglib.h>
+#include <vector>
 
 using namespace MOHPC;
 
-void Image::LoadJPEG(const char *name, void *buf, std::streamsize len)
+/**
+ * Number of rows decoded before they are expanded to RGBA in one pass.
+ * The library outputs at most rec_outbuf_height rows per call, which is usually 1.
+ */
+static constexpr size_t JPEG_STRIP_ROWS = 16;
+
+/**
+ * JPEG decompression object, released when going out of scope.
+ * Errors are thrown as ImageException.
+ */
+struct jpegDecompressor_t
 {
 	/* This struct contains the JPEG decompression parameters and pointers to
 	* working space (which is allocated as needed by the JPEG library).
 	*/
-	struct jpeg_decompress_struct cinfo;
+	jpeg_decompress_struct cinfo;
 
-	/* This struct represents a JPEG error handler.  It is declared separately
-	 * because applications often want to supply a specialized error handler
-	 * (see the second half of this file for an example).  But here we just
-	 * take the easy way out and use the standard error handler, which will
-	 * print a message on stderr and call exit() if compression fails.
+	/* This struct represents a JPEG error handler.
 	 * Note that this struct must live as long as the main JPEG parameter
 	 * struct, to avoid dangling-pointer problems.
 	 */
-	struct jpeg_error_mgr jerr;
+	jpeg_error_mgr jerr;
 
-	cinfo.err = nullptr;
+public:
+	jpegDecompressor_t(const void* buf, size_t len)
+	{
+		/* Step 1: initialize the JPEG decompression object. */
 
-	/* Step 1: initialize the JPEG decompression object. */
+		/* We have to set up the error handler first, in case the initialization
+		 * step fails.  (Unlikely, but it could happen if you are out of memory.)
+		 */
+		cinfo.err = jpeg_std_error(&jerr);
+		cinfo.err->error_exit =
+		[](j_common_ptr cinfo)
+		{
+			char buffer[JMSG_LENGTH_MAX];
+			(*cinfo->err->format_message)(cinfo, buffer);
+			throw ImageException("LoadJPEG: %s", buffer);
+		};
+
+		cinfo.err->output_message =
+		[](j_common_ptr cinfo)
+		{
+		};
+
+		jpeg_create_decompress(&cinfo);
+
+		/* Step 2: specify data source (eg, a file) */
+		jpeg_mem_src(&cinfo, (const unsigned char*)buf, (unsigned long)len);
+	}
 
-	/* We have to set up the error handler first, in case the initialization
-	 * step fails.  (Unlikely, but it could happen if you are out of memory.)
-	 * This routine fills in the contents of struct jerr, and returns jerr's
-	 * address which we place into the link field in cinfo.
-	 */
-	cinfo.err = jpeg_std_error(&jerr);
-	cinfo.err->error_exit =
-	[](j_common_ptr cinfo)
+	~jpegDecompressor_t()
 	{
-		throw(std::exception());
-	};
+		/* This is an important step since it will release a good deal of memory. */
+		jpeg_destroy_decompress(&cinfo);
+	}
 
-	cinfo.err->output_message =
-	[](j_common_ptr cinfo)
-	{
-	};
+	jpegDecompressor_t(const jpegDecompressor_t&) = delete;
+	jpegDecompressor_t& operator=(const jpegDecompressor_t&) = delete;
+};
 
-	jpeg_create_decompress(&cinfo);
+void MOHPC::ReadJPEGHeader(const char *name, const void *buf, size_t len, uint32_t& width, uint32_t& height)
+{
+	jpegDecompressor_t decompressor(buf, len);
 
-	/* Step 2: specify data source (eg, a file) */
-	jpeg_mem_src(&cinfo, (const unsigned char*)buf, (unsigned long)len);
+	/* Step 3: read file parameters with jpeg_read_header() */
+	jpeg_read_header(&decompressor.cinfo, (boolean)true);
+
+	width = decompressor.cinfo.image_width;
+	height = decompressor.cinfo.image_height;
+}
+
+void MOHPC::DecodeJPEG(const char *name, const void *buf, size_t len, uint8_t *out)
+{
+	jpegDecompressor_t decompressor(buf, len);
+	jpeg_decompress_struct& cinfo = decompressor.cinfo;
 
 	/* Step 3: read file parameters with jpeg_read_header() */
 	jpeg_read_header(&cinfo, (boolean)true);
@@ -53,69 +89,67 @@ void Image::LoadJPEG(const char *name, void *buf, std::streamsize len)
 	/* Step 4: set parameters for decompression */
 
 	/*
-	* Make sure it always converts images to RGB color space. This will
-	* automatically convert 8-bit greyscale images to RGB as well.
+	* Grayscale images are kept as is and expanded with the alpha,
+	* anything else is converted to RGB by the library.
 	*/
-	cinfo.out_color_space = JCS_RGB;
+	const bool grayscale = cinfo.jpeg_color_space == JCS_GRAYSCALE;
+	cinfo.out_color_space = grayscale ? JCS_GRAYSCALE : JCS_RGB;
 
 	/* Step 5: Start decompressor */
 
 	jpeg_start_decompress(&cinfo);
 
-	width = cinfo.output_width;
-	height = cinfo.output_height;
-
-	const int32_t pixelcount = width * height;
-
-	const uint32_t memcount = pixelcount * 4;
-	const uint32_t row_stride = cinfo.output_width * cinfo.output_components;
+	const size_t width = cinfo.output_width;
+	const size_t rowSize = width * 4;
+	size_t stripSize = (size_t)cinfo.rec_outbuf_height > JPEG_STRIP_ROWS ? cinfo.rec_outbuf_height : JPEG_STRIP_ROWS;
+	if (stripSize > cinfo.output_height) {
+		stripSize = cinfo.output_height;
+	}
 
-	data = new uint8_t[memcount];
-	dataSize = memcount;
+	// read a strip of scanlines, then expand them to RGBA
+	std::vector<uint8_t> strip(stripSize * width * cinfo.output_components);
+	std::vector<JSAMPROW> stripRows(stripSize);
+	for (size_t i = 0; i < stripSize; ++i) {
+		stripRows[i] = strip.data() + i * width * cinfo.output_components;
+	}
 
-	uint8_t *rbuf;
+	void (*convert)(const uint8_t* in, uint8_t* out, size_t numPixels) = grayscale ? &PixelConvert::GrayToRGBA : &PixelConvert::RGBToRGBA;
 
 	/* Step 6: while (scan lines remain to be read) */
 	/*           jpeg_read_scanlines(...); */
-
-	/* Here we use the library's state variable cinfo.output_scanline as the
-	 * loop counter, so that we don't have to keep track ourselves.
-	 */
-	while(cinfo.output_scanline < cinfo.output_height)
+	while (cinfo.output_scanline < cinfo.output_height)
 	{
-		/* jpeg_read_scanlines expects an array of pointers to scanlines.
-		 * Here the array is only one element long, but you could ask for
-		 * more than one scanline at a time if that's more convenient.
-		 */
-		rbuf = ((data + (row_stride * cinfo.output_scanline)));
-		jpeg_read_scanlines(&cinfo, &rbuf, 1);
+		const size_t firstRow = cinfo.output_scanline;
+
+		// fill the strip with as many calls as needed
+		size_t numRows = 0;
+		while (numRows < stripSize && cinfo.output_scanline < cinfo.output_height)
+		{
+			const size_t readRows = jpeg_read_scanlines(&cinfo, stripRows.data() + numRows, (JDIMENSION)(stripSize - numRows));
+			if (!readRows) {
+				break;
+			}
+
+			numRows += readRows;
+		}
+
+		if (!numRows) {
+			break;
+		}
+
+		// rows are contiguous in both the strip and the output
+		convert(strip.data(), out + firstRow * rowSize, numRows * width);
 	}
 
-	rbuf = data;
-
-	/* Expand from RGB to RGBA */
-	uintptr_t sindex = pixelcount * cinfo.output_components;
-	uintptr_t dindex = memcount;
-
-	do
-	{
-		rbuf[--dindex] = 255;
-		rbuf[--dindex] = rbuf[--sindex];
-		rbuf[--dindex] = rbuf[--sindex];
-		rbuf[--dindex] = rbuf[--sindex];
-	} while(sindex);
-
 	/* Step 7: Finish decompression */
 
 	jpeg_finish_decompress(&cinfo);
 	/* We can ignore the return value since suspension is not possible
-	 * with the stdio data source.
+	 * with the memory data source.
 	 */
+}
 
-	/* Step 8: Release JPEG decompression object */
-
-	/* This is an important step since it will release a good deal of memory. */
-	jpeg_destroy_decompress(&cinfo);
-
-	pixelFormat = PixelFormat::IF_RGB;
+void Image::LoadJPEG(const char *name, void *buf, std::streamsize len)
+{
+	LoadRGBA(ImageFileFormat::JPEG, name, buf, len);
 }
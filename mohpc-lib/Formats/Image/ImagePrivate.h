@@ -1,6 +1,10 @@
 #pragma once
 
+#include <exception>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
 class ImageException : public std::exception
 {
@@ -21,3 +25,26 @@ public:
 		return buf;
 	}
 };
+
+namespace MOHPC
+{
+	/**
+	 * Decoders writing RGBA8 pixels, rows from top to bottom.
+	 * They throw ImageException if the file is invalid.
+	 */
+	void ReadTGAHeader(const char* name, const void* buf, size_t len, uint32_t& width, uint32_t& height);
+	void DecodeTGA(const char* name, const void* buf, size_t len, uint8_t* out);
+	void ReadJPEGHeader(const char* name, const void* buf, size_t len, uint32_t& width, uint32_t& height);
+	void DecodeJPEG(const char* name, const void* buf, size_t len, uint8_t* out);
+
+	/**
+	 * Conversion of pixel rows to RGBA8, using SIMD instructions when the CPU supports them.
+	 */
+	namespace PixelConvert
+	{
+		void RGBToRGBA(const uint8_t* in, uint8_t* out, size_t numPixels);
+		void BGRToRGBA(const uint8_t* in, uint8_t* out, size_t numPixels);
+		void BGRAToRGBA(const uint8_t* in, uint8_t* out, size_t numPixels);
+		void GrayToRGBA(const uint8_t* in, uint8_t* out, size_t numPixels);
+	}
+}
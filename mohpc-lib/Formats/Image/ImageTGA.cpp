@@ -14,21 +14,15 @@ typedef struct _TargaHeader {
 	unsigned char	pixel_size, attributes;
 } TargaHeader;
 
-void Image::LoadTGA(const char *name, void *buf, std::streamsize len)
+/**
+ * Parse and validate the header, and return a pointer to the pixels.
+ */
+static const uint8_t* ParseTGAHeader(const char *name, const uint8_t* buf_p, const uint8_t* end, TargaHeader& targa_header)
 {
-	int32_t columns, rows, numPixels;
-	uint8_t *pixbuf;
-	int32_t row, column;
-	TargaHeader	targa_header;
-	uint8_t *targa_rgba;
-
-	if (len < 18) {
+	if (end - buf_p < 18) {
 		throw ImageException("LoadTGA: header too short (%s)", name);
 	}
 
-	const uint8_t* buf_p = (uint8_t*)buf;
-	const uint8_t* end = (uint8_t*)buf + len;
-
 	targa_header.id_length = buf_p[0];
 	targa_header.colormap_type = buf_p[1];
 	targa_header.image_type = buf_p[2];
@@ -69,214 +63,163 @@ void Image::LoadTGA(const char *name, void *buf, std::streamsize len)
 		throw ImageException("LoadTGA: Only 32 or 24 bit images supported (no colormaps)");
 	}
 
-	columns = targa_header.width;
-	rows = targa_header.height;
-	numPixels = columns * rows * 4;
-
-	if (!columns || !rows || numPixels > 0x7FFFFFFF || numPixels / columns / 4 != rows)
+	if (!targa_header.width || !targa_header.height)
 	{
 		throw ImageException("LoadTGA: %s has an invalid image size", name);
 	}
 
-	targa_rgba = new uint8_t[numPixels];
-
 	if (targa_header.id_length != 0)
 	{
-		if (buf_p + targa_header.id_length > end)
+		if (end - buf_p < targa_header.id_length)
 		{
-			delete[] targa_rgba;
 			throw ImageException("LoadTGA: header too short (%s)", name);
 		}
 
 		buf_p += targa_header.id_length;  // skip TARGA image comment
 	}
 
+	return buf_p;
+}
+
+void MOHPC::ReadTGAHeader(const char *name, const void *buf, size_t len, uint32_t& width, uint32_t& height)
+{
+	TargaHeader targa_header;
+	ParseTGAHeader(name, (const uint8_t*)buf, (const uint8_t*)buf + len, targa_header);
+
+	width = targa_header.width;
+	height = targa_header.height;
+}
+
+void MOHPC::DecodeTGA(const char *name, const void *buf, size_t len, uint8_t *out)
+{
+	TargaHeader targa_header;
+	const uint8_t* end = (const uint8_t*)buf + len;
+	const uint8_t* buf_p = ParseTGAHeader(name, (const uint8_t*)buf, end, targa_header);
+
+	const uint32_t columns = targa_header.width;
+	const uint32_t rows = targa_header.height;
+	const size_t rowSize = (size_t)columns * 4;
+	const size_t bytesPerPixel = targa_header.pixel_size / 8;
+
+	// TTimo: this is the chunk of code to ensure a behavior that meets TGA specs 
+	// bit 5 set => top-down
+	// rows are written at their final place instead of being flipped afterwards
+	const bool topDown = (targa_header.attributes & 0x20) != 0;
+	auto rowPixels = [=](uint32_t row)
+	{
+		return out + (topDown ? row : rows - row - 1) * rowSize;
+	};
+
+	void (*convert)(const uint8_t* in, uint8_t* out, size_t numPixels);
+	switch (targa_header.pixel_size)
+	{
+	case 8:
+		convert = &PixelConvert::GrayToRGBA;
+		break;
+	case 24:
+		convert = &PixelConvert::BGRToRGBA;
+		break;
+	case 32:
+		convert = &PixelConvert::BGRAToRGBA;
+		break;
+	default:
+		throw ImageException("LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name);
+	}
+
 	if (targa_header.image_type == 2 || targa_header.image_type == 3)
 	{
-		if (buf_p + columns * rows*targa_header.pixel_size / 8 > end)
+		// Uncompressed RGB or gray scale image
+		if ((size_t)(end - buf_p) < (size_t)columns * rows * bytesPerPixel)
 		{
-			delete[] targa_rgba;
 			throw ImageException("LoadTGA: file truncated %s", name);
 		}
 
-		// Uncompressed RGB or gray scale image
-		for (row = rows - 1; row >= 0; row--)
+		for (uint32_t row = 0; row < rows; row++)
 		{
-			pixbuf = targa_rgba + row * columns * 4;
-			for (column = 0; column < columns; column++)
-			{
-				unsigned char red, green, blue, alphabyte;
-				switch (targa_header.pixel_size)
-				{
-
-				case 8:
-					blue = *buf_p++;
-					green = blue;
-					red = blue;
-					*pixbuf++ = red;
-					*pixbuf++ = green;
-					*pixbuf++ = blue;
-					*pixbuf++ = 255;
-					break;
-
-				case 24:
-					blue = *buf_p++;
-					green = *buf_p++;
-					red = *buf_p++;
-					*pixbuf++ = red;
-					*pixbuf++ = green;
-					*pixbuf++ = blue;
-					*pixbuf++ = 255;
-					break;
-				case 32:
-					blue = *buf_p++;
-					green = *buf_p++;
-					red = *buf_p++;
-					alphabyte = *buf_p++;
-					*pixbuf++ = red;
-					*pixbuf++ = green;
-					*pixbuf++ = blue;
-					*pixbuf++ = alphabyte;
-					break;
-				default:
-					delete[] targa_rgba;
-					throw ImageException("LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name);
-					break;
-				}
-			}
+			convert(buf_p, rowPixels(row), columns);
+			buf_p += columns * bytesPerPixel;
 		}
 	}
-	else if (targa_header.image_type == 10) {   // Runlength encoded RGB images
-		unsigned char red, green, blue, alphabyte, packetHeader, packetSize, j;
+	else if (targa_header.image_type == 10)
+	{
+		// Runlength encoded RGB images
+		if (targa_header.pixel_size == 8)
+		{
+			throw ImageException("LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name);
+		}
+
+		uint32_t row = 0;
+		uint32_t column = 0;
+		uint8_t* pixbuf = rowPixels(0);
+
+		for (;;)
+		{
+			if (buf_p + 1 > end)
+			{
+				throw ImageException("LoadTGA: file truncated %s", name);
+			}
 
-		for (row = rows - 1; row >= 0; row--) {
-			pixbuf = targa_rgba + row * columns * 4;
-			for (column = 0; column < columns; ) {
-				if (buf_p + 1 > end)
+			const uint8_t packetHeader = *buf_p++;
+			size_t packetSize = 1 + (packetHeader & 0x7f);
+			const bool runLength = (packetHeader & 0x80) != 0;
+
+			uint32_t value = 0;
+			if (runLength)
+			{
+				// run-length packet
+				if ((size_t)(end - buf_p) < bytesPerPixel)
 				{
-					delete[] targa_rgba;
 					throw ImageException("LoadTGA: file truncated %s", name);
 				}
-				packetHeader = *buf_p++;
-				packetSize = 1 + (packetHeader & 0x7f);
-				if (packetHeader & 0x80) {        // run-length packet
-					if (buf_p + targa_header.pixel_size / 8 > end)
-					{
-						delete[] targa_rgba;
-						throw ImageException("LoadTGA: file truncated %s", name);
-					}
-					switch (targa_header.pixel_size) {
-					case 24:
-						blue = *buf_p++;
-						green = *buf_p++;
-						red = *buf_p++;
-						alphabyte = 255;
-						break;
-					case 32:
-						blue = *buf_p++;
-						green = *buf_p++;
-						red = *buf_p++;
-						alphabyte = *buf_p++;
-						break;
-					default:
-						delete[] targa_rgba;
-						throw ImageException("LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name);
-						break;
-					}
 
-					for (j = 0; j < packetSize; j++) {
-						*pixbuf++ = red;
-						*pixbuf++ = green;
-						*pixbuf++ = blue;
-						*pixbuf++ = alphabyte;
-						column++;
-						if (column == columns) { // run spans across rows
-							column = 0;
-							if (row > 0)
-								row--;
-							else
-								goto breakOut;
-							pixbuf = targa_rgba + row * columns * 4;
-						}
-					}
+				convert(buf_p, (uint8_t*)&value, 1);
+				buf_p += bytesPerPixel;
+			}
+			else if ((size_t)(end - buf_p) < bytesPerPixel * packetSize)
+			{
+				// non run-length packet
+				throw ImageException("LoadTGA: file truncated %s", name);
+			}
+
+			// packets can span across rows
+			while (packetSize)
+			{
+				size_t count = columns - column;
+				if (count > packetSize) {
+					count = packetSize;
 				}
-				else {                            // non run-length packet
 
-					if (buf_p + targa_header.pixel_size / 8 * packetSize > end)
-					{
-						delete[] targa_rgba;
-						throw ImageException("LoadTGA: file truncated %s", name);
+				if (runLength)
+				{
+					for (size_t i = 0; i < count; ++i) {
+						memcpy(pixbuf + i * 4, &value, 4);
 					}
-					for (j = 0; j < packetSize; j++) {
-						switch (targa_header.pixel_size) {
-						case 24:
-							blue = *buf_p++;
-							green = *buf_p++;
-							red = *buf_p++;
-							*pixbuf++ = red;
-							*pixbuf++ = green;
-							*pixbuf++ = blue;
-							*pixbuf++ = 255;
-							break;
-						case 32:
-							blue = *buf_p++;
-							green = *buf_p++;
-							red = *buf_p++;
-							alphabyte = *buf_p++;
-							*pixbuf++ = red;
-							*pixbuf++ = green;
-							*pixbuf++ = blue;
-							*pixbuf++ = alphabyte;
-							break;
-						default:
-							delete[] targa_rgba;
-							throw ImageException("LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name);
-							break;
-						}
-						column++;
-						if (column == columns) { // pixel packet run spans across rows
-							column = 0;
-							if (row > 0)
-								row--;
-							else
-								goto breakOut;
-							pixbuf = targa_rgba + row * columns * 4;
-						}
+				}
+				else
+				{
+					convert(buf_p, pixbuf, count);
+					buf_p += count * bytesPerPixel;
+				}
+
+				pixbuf += count * 4;
+				column += (uint32_t)count;
+				packetSize -= count;
+
+				if (column == columns)
+				{
+					column = 0;
+					if (++row == rows) {
+						return;
 					}
+
+					pixbuf = rowPixels(row);
 				}
 			}
-		breakOut:;
-		}
-	}
-
-#if 1
-	// TTimo: this is the chunk of code to ensure a behavior that meets TGA specs 
-	// bit 5 set => top-down
-	if (targa_header.attributes & 0x20)
-	{
-		uint8_t *flip = new uint8_t[columns * 4];
-		uint8_t *src, *dst;
-		for (row = 0; row < rows / 2; row++)
-		{
-			src = targa_rgba + row * 4 * columns;
-			dst = targa_rgba + (rows - row - 1) * 4 * columns;
-			memcpy(flip, src, columns * 4);
-			memcpy(src, dst, columns * 4);
-			memcpy(dst, flip, columns * 4);
 		}
-		delete[] flip;
-	}
-#else
-	// instead we just print a warning
-	if (targa_header.attributes & 0x20)
-	{
-		ri.Printf(PRINT_WARNING, "WARNING: '%s' TGA file header declares top-down image, ignoring\n", name);
 	}
-#endif
+}
 
-	data = targa_rgba;
-	dataSize = numPixels;
-	width = columns;
-	height = rows;
-	pixelFormat = PixelFormat::IF_RGBA;
+void Image::LoadTGA(const char *name, void *buf, std::streamsize len)
+{
+	LoadRGBA(ImageFileFormat::TGA, name, buf, len);
 }
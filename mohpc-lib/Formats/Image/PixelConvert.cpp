@@ -0,0 +1,184 @@
+#include <Shared.h>
+#include "ImagePrivate.h"
+#include "../../Misc/CPUFeatures.h"
+
+#ifdef MOHPC_CPU_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#endif
+
+using namespace MOHPC;
+
+typedef void (*convertFunc_t)(const uint8_t* in, uint8_t* out, size_t numPixels);
+
+static void RGBToRGBA_generic(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	for (size_t i = 0; i < numPixels; ++i)
+	{
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		out[3] = 255;
+		in += 3;
+		out += 4;
+	}
+}
+
+static void BGRToRGBA_generic(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	for (size_t i = 0; i < numPixels; ++i)
+	{
+		out[0] = in[2];
+		out[1] = in[1];
+		out[2] = in[0];
+		out[3] = 255;
+		in += 3;
+		out += 4;
+	}
+}
+
+static void BGRAToRGBA_generic(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	for (size_t i = 0; i < numPixels; ++i)
+	{
+		out[0] = in[2];
+		out[1] = in[1];
+		out[2] = in[0];
+		out[3] = in[3];
+		in += 4;
+		out += 4;
+	}
+}
+
+static void GrayToRGBA_generic(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	for (size_t i = 0; i < numPixels; ++i)
+	{
+		out[0] = out[1] = out[2] = in[i];
+		out[3] = 255;
+		out += 4;
+	}
+}
+
+#ifdef MOHPC_CPU_X86
+
+/*
+====================
+Convert3To4_ssse3
+
+Shuffle 4 pixels of 3 bytes per iteration, 16 bytes are loaded for 12 used
+so the last pixels are left to the generic version.
+====================
+*/
+MOHPC_TARGET("ssse3")
+static size_t Convert3To4_ssse3(const uint8_t* in, uint8_t* out, size_t numPixels, __m128i mask)
+{
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+	size_t i = 0;
+	for (; i + 6 <= numPixels; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128((const __m128i*)(in + i * 3));
+		_mm_storeu_si128((__m128i*)(out + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, mask), alpha));
+	}
+
+	return i;
+}
+
+MOHPC_TARGET("ssse3")
+static void RGBToRGBA_ssse3(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	const __m128i mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const size_t i = Convert3To4_ssse3(in, out, numPixels, mask);
+	RGBToRGBA_generic(in + i * 3, out + i * 4, numPixels - i);
+}
+
+MOHPC_TARGET("ssse3")
+static void BGRToRGBA_ssse3(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	const __m128i mask = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	const size_t i = Convert3To4_ssse3(in, out, numPixels, mask);
+	BGRToRGBA_generic(in + i * 3, out + i * 4, numPixels - i);
+}
+
+MOHPC_TARGET("ssse3")
+static void BGRAToRGBA_ssse3(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+	size_t i = 0;
+	for (; i + 4 <= numPixels; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128((const __m128i*)(in + i * 4));
+		_mm_storeu_si128((__m128i*)(out + i * 4), _mm_shuffle_epi8(pixels, mask));
+	}
+
+	BGRAToRGBA_generic(in + i * 4, out + i * 4, numPixels - i);
+}
+
+MOHPC_TARGET("ssse3")
+static void GrayToRGBA_ssse3(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	const __m128i mask = _mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+	// 16 pixels per iteration, 4 for each shuffle
+	size_t i = 0;
+	for (; i + 16 <= numPixels; i += 16)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(in + i));
+		for (size_t j = 0; j < 4; ++j)
+		{
+			_mm_storeu_si128((__m128i*)(out + (i + j * 4) * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, mask), alpha));
+			pixels = _mm_srli_si128(pixels, 4);
+		}
+	}
+
+	GrayToRGBA_generic(in + i, out + i * 4, numPixels - i);
+}
+#endif
+
+struct convertFuncs_t
+{
+	convertFunc_t rgbToRGBA;
+	convertFunc_t bgrToRGBA;
+	convertFunc_t bgraToRGBA;
+	convertFunc_t grayToRGBA;
+};
+
+static convertFuncs_t SelectConvertFuncs()
+{
+#ifdef MOHPC_CPU_X86
+	if (CPU::GetFeatures().ssse3) {
+		return { &RGBToRGBA_ssse3, &BGRToRGBA_ssse3, &BGRAToRGBA_ssse3, &GrayToRGBA_ssse3 };
+	}
+#endif
+
+	return { &RGBToRGBA_generic, &BGRToRGBA_generic, &BGRAToRGBA_generic, &GrayToRGBA_generic };
+}
+
+static const convertFuncs_t& GetConvertFuncs()
+{
+	static const convertFuncs_t convertFuncs = SelectConvertFuncs();
+	return convertFuncs;
+}
+
+void PixelConvert::RGBToRGBA(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	GetConvertFuncs().rgbToRGBA(in, out, numPixels);
+}
+
+void PixelConvert::BGRToRGBA(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	GetConvertFuncs().bgrToRGBA(in, out, numPixels);
+}
+
+void PixelConvert::BGRAToRGBA(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	GetConvertFuncs().bgraToRGBA(in, out, numPixels);
+}
+
+void PixelConvert::GrayToRGBA(const uint8_t* in, uint8_t* out, size_t numPixels)
+{
+	GetConvertFuncs().grayToRGBA(in, out, numPixels);
+}
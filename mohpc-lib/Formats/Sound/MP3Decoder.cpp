@@ -0,0 +1,231 @@
+#include <Shared.h>
+#include <MOHPC/Formats/MP3Decoder.h>
+#include <libmad/mad.h>
+
+using namespace MOHPC;
+
+struct MP3Decoder::madState_t
+{
+	mad_stream stream;
+	mad_frame frame;
+	mad_synth synth;
+
+public:
+	madState_t()
+	{
+		mad_stream_init(&stream);
+		mad_frame_init(&frame);
+		mad_synth_init(&synth);
+	}
+
+	~madState_t()
+	{
+		mad_synth_finish(&synth);
+		mad_frame_finish(&frame);
+		mad_stream_finish(&stream);
+	}
+};
+
+/**
+ * libmad needs MAD_BUFFER_GUARD bytes after the last frame to decode it.
+ * Feed the stream with a copy of the remaining data followed by zeros.
+ *
+ * @return	false if there is nothing left to decode.
+ */
+static bool FeedGuard(mad_stream& stream, std::vector<uint8_t>& guardBuffer)
+{
+	const uint8_t* remaining = stream.next_frame ? stream.next_frame : stream.buffer;
+	const size_t remainingLen = stream.bufend - remaining;
+	if (!remainingLen) {
+		return false;
+	}
+
+	guardBuffer.assign(remaining, remaining + remainingLen);
+	guardBuffer.insert(guardBuffer.end(), MAD_BUFFER_GUARD, 0);
+	mad_stream_buffer(&stream, guardBuffer.data(), guardBuffer.size());
+	return true;
+}
+
+static inline int16_t scale(mad_fixed_t sample)
+{
+	/* round */
+	sample += (1L << (MAD_F_FRACBITS - 16));
+
+	/* clip */
+	if (sample >= MAD_F_ONE)
+		sample = MAD_F_ONE - 1;
+	else if (sample < -MAD_F_ONE)
+		sample = -MAD_F_ONE;
+
+	/* quantize */
+	return (int16_t)(sample >> (MAD_F_FRACBITS + 1 - 16));
+}
+
+bool MP3Decoder::GetInfo(const void* data, size_t size, mp3Info_t& info)
+{
+	info.numChannels = 0;
+	info.sampleRate = 0;
+	info.numSampleFrames = 0;
+
+	mad_stream stream;
+	mad_header header;
+	std::vector<uint8_t> guardBuffer;
+	bool guarded = false;
+
+	mad_stream_init(&stream);
+	mad_header_init(&header);
+	mad_stream_buffer(&stream, (const unsigned char*)data, size);
+
+	for (;;)
+	{
+		if (mad_header_decode(&header, &stream) == -1)
+		{
+			if (MAD_RECOVERABLE(stream.error)) {
+				continue;
+			}
+
+			if (stream.error == MAD_ERROR_BUFLEN && !guarded && FeedGuard(stream, guardBuffer))
+			{
+				guarded = true;
+				continue;
+			}
+
+			break;
+		}
+
+		if (!info.numChannels)
+		{
+			info.numChannels = MAD_NCHANNELS(&header);
+			info.sampleRate = header.samplerate;
+		}
+
+		info.numSampleFrames += 32 * MAD_NSBSAMPLES(&header);
+	}
+
+	mad_header_finish(&header);
+	mad_stream_finish(&stream);
+
+	return info.numChannels != 0;
+}
+
+MP3Decoder::MP3Decoder(const void* data, size_t size)
+	: state(new madState_t)
+	, frameSampleNum(0)
+	, numChannels(0)
+	, sampleRate(0)
+	, guarded(false)
+	, finished(false)
+{
+	mad_stream_buffer(&state->stream, (const unsigned char*)data, size);
+}
+
+MP3Decoder::~MP3Decoder()
+{
+	delete state;
+}
+
+bool MP3Decoder::decodeFrame()
+{
+	for (;;)
+	{
+		if (mad_frame_decode(&state->frame, &state->stream) == -1)
+		{
+			if (MAD_RECOVERABLE(state->stream.error)) {
+				continue;
+			}
+
+			if (state->stream.error == MAD_ERROR_BUFLEN && !guarded && FeedGuard(state->stream, guardBuffer))
+			{
+				guarded = true;
+				continue;
+			}
+
+			finished = true;
+			return false;
+		}
+
+		mad_synth_frame(&state->synth, &state->frame);
+		frameSampleNum = 0;
+
+		if (!numChannels)
+		{
+			numChannels = state->synth.pcm.channels;
+			sampleRate = state->synth.pcm.samplerate;
+		}
+
+		return true;
+	}
+}
+
+size_t MP3Decoder::decode(int16_t* samples, size_t maxSampleFrames)
+{
+	const mad_pcm& pcm = state->synth.pcm;
+	size_t numDecoded = 0;
+
+	while (numDecoded < maxSampleFrames)
+	{
+		if (frameSampleNum >= pcm.length)
+		{
+			if (finished || !decodeFrame()) {
+				break;
+			}
+
+			continue;
+		}
+
+		size_t count = pcm.length - frameSampleNum;
+		if (count > maxSampleFrames - numDecoded) {
+			count = maxSampleFrames - numDecoded;
+		}
+
+		const mad_fixed_t* left = pcm.samples[0] + frameSampleNum;
+		// the channel count of the first frame is kept for the whole stream
+		const mad_fixed_t* right = pcm.samples[pcm.channels > 1 ? 1 : 0] + frameSampleNum;
+		int16_t* out = samples + numDecoded * numChannels;
+
+		if (numChannels == 2)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				out[0] = scale(left[i]);
+				out[1] = scale(right[i]);
+				out += 2;
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i) {
+				out[i] = scale(left[i]);
+			}
+		}
+
+		frameSampleNum += (uint32_t)count;
+		numDecoded += count;
+	}
+
+	return numDecoded;
+}
+
+bool MP3Decoder::prepare()
+{
+	if (!numChannels && !finished) {
+		decodeFrame();
+	}
+
+	return numChannels != 0;
+}
+
+uint32_t MP3Decoder::getNumChannels() const
+{
+	return numChannels;
+}
+
+uint32_t MP3Decoder::getSampleRate() const
+{
+	return sampleRate;
+}
+
+bool MP3Decoder::isFinished() const
+{
+	return finished && frameSampleNum >= state->synth.pcm.length;
+}
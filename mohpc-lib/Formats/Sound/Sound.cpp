@@ -1,214 +1,49 @@
 #include <Shared.h>
 #include <MOHPC/Formats/Sound.h>
 #include <MOHPC/Managers/FileManager.h>
-//#include <lame/lame.h>
-#include <libmad/mad.h>
-#include <sstream>
-#include <fstream>
+#include <MOHPC/Formats/MP3Decoder.h>
 #include <MOHPC/Misc/Endian.h>
 #include <string.h>
 
 using namespace MOHPC;
 
-static void write_16_bits_low_high(std::stringstream& out, int val)
+static constexpr size_t WAVE_HEADER_SIZE = 44;
+
+static uint8_t* write_16_bits_low_high(uint8_t* out, uint16_t val)
 {
-	unsigned char bytes[2];
-	bytes[0] = (val & 0xff);
-	bytes[1] = ((val >> 8) & 0xff);
-	out.write((const char *)bytes, 2);
+	out[0] = (val & 0xff);
+	out[1] = ((val >> 8) & 0xff);
+	return out + 2;
 }
 
-static void write_32_bits_low_high(std::stringstream& out, int val)
+static uint8_t* write_32_bits_low_high(uint8_t* out, uint32_t val)
 {
-	unsigned char bytes[4];
-	bytes[0] = (val & 0xff);
-	bytes[1] = ((val >> 8) & 0xff);
-	bytes[2] = ((val >> 16) & 0xff);
-	bytes[3] = ((val >> 24) & 0xff);
-	out.write((const char *)bytes, 4);
+	out[0] = (val & 0xff);
+	out[1] = ((val >> 8) & 0xff);
+	out[2] = ((val >> 16) & 0xff);
+	out[3] = ((val >> 24) & 0xff);
+	return out + 4;
 }
 
-static void WriteWaveHeader(std::stringstream& out, int pcmbytes, int freq, int channels, int bits)
+static void WriteWaveHeader(uint8_t* out, uint32_t pcmbytes, uint32_t freq, uint32_t channels, uint32_t bits)
 {
-	int     bytes = (bits + 7) / 8;
+	uint32_t bytes = (bits + 7) / 8;
 
 	/* quick and dirty, but documented */
-	out.write("RIFF", 4); /* label */
-	write_32_bits_low_high(out, pcmbytes + 44 - 8); /* length in bytes without header */
-	out.write("WAVEfmt ", 4 * 2); /* 2 labels */
-	write_32_bits_low_high(out, 2 + 2 + 4 + 4 + 2 + 2); /* length of PCM format declaration area */
-	write_16_bits_low_high(out, 1); /* is PCM? */
-	write_16_bits_low_high(out, channels); /* number of channels */
-	write_32_bits_low_high(out, freq); /* sample frequency in [Hz] */
-	write_32_bits_low_high(out, freq * channels * bytes); /* bytes per second */
-	write_16_bits_low_high(out, channels * bytes); /* bytes per sample time */
-	write_16_bits_low_high(out, bits); /* bits per sample */
-	out.write("data", 4); /* label */
+	memcpy(out, "RIFF", 4); out += 4; /* label */
+	out = write_32_bits_low_high(out, pcmbytes + WAVE_HEADER_SIZE - 8); /* length in bytes without header */
+	memcpy(out, "WAVEfmt ", 4 * 2); out += 4 * 2; /* 2 labels */
+	out = write_32_bits_low_high(out, 2 + 2 + 4 + 4 + 2 + 2); /* length of PCM format declaration area */
+	out = write_16_bits_low_high(out, 1); /* is PCM? */
+	out = write_16_bits_low_high(out, channels); /* number of channels */
+	out = write_32_bits_low_high(out, freq); /* sample frequency in [Hz] */
+	out = write_32_bits_low_high(out, freq * channels * bytes); /* bytes per second */
+	out = write_16_bits_low_high(out, channels * bytes); /* bytes per sample time */
+	out = write_16_bits_low_high(out, bits); /* bits per sample */
+	memcpy(out, "data", 4); out += 4; /* label */
 	write_32_bits_low_high(out, pcmbytes); /* length in bytes of raw PCM data */
 }
 
-struct buffer_s {
-	unsigned char const *start;
-	uint32_t length;
-	std::stringstream stream;
-	uint32_t numSamples;
-	int32_t numChannels;
-	int32_t sampleRate;
-};
-
-static
-enum mad_flow input(void *data,
-	struct mad_stream *stream)
-{
-	buffer_s *buffer = (buffer_s*)data;
-
-	if (!buffer->length)
-		return MAD_FLOW_STOP;
-
-	mad_stream_buffer(stream, buffer->start, buffer->length);
-
-	buffer->length = 0;
-
-	return MAD_FLOW_CONTINUE;
-}
-
-static inline
-signed int scale(mad_fixed_t sample)
-{
-	/* round */
-	sample += (1L << (MAD_F_FRACBITS - 16));
-
-	/* clip */
-	if (sample >= MAD_F_ONE)
-		sample = MAD_F_ONE - 1;
-	else if (sample < -MAD_F_ONE)
-		sample = -MAD_F_ONE;
-
-	/* quantize */
-	return sample >> (MAD_F_FRACBITS + 1 - 16);
-}
-
-static
-enum mad_flow output(void *data,
-	struct mad_header const *header,
-	struct mad_pcm *pcm)
-{
-	buffer_s *buffer = (buffer_s*)data;
-	unsigned int nchannels, nsamples;
-	mad_fixed_t const *left_ch, *right_ch;
-
-	/* pcm->samplerate contains the sampling frequency */
-
-	nchannels = pcm->channels;
-	nsamples = pcm->length;
-	left_ch = pcm->samples[0];
-	right_ch = pcm->samples[1];
-
-	if (!buffer->stream.tellp())
-	{
-		buffer->numChannels = nchannels;
-		buffer->numSamples = 0;
-		buffer->sampleRate = header->samplerate;
-		WriteWaveHeader(buffer->stream, 0x7FFFFFFF, header->samplerate, nchannels, 16);
-	}
-
-	buffer->numSamples += nsamples;
-
-	if (nsamples && nchannels)
-	{
-		size_t datasize = nsamples * sizeof(short) * nchannels;
-		uint8_t* data = new uint8_t[datasize];
-		uint8_t* datap = data;
-
-		if (nchannels == 2)
-		{
-			while (nsamples--)
-			{
-				signed int sample;
-
-				/* output sample(s) in 16-bit signed little-endian PCM */
-
-				sample = scale(*left_ch++);
-
-				unsigned short value = Endian.LittleLong(sample);
-				*(short*)datap = value;
-				datap += sizeof(short);
-
-				sample = scale(*right_ch++);
-
-				value = Endian.LittleLong(sample);
-				*(short*)datap = value;
-				datap += sizeof(short);
-			}
-		}
-		else
-		{
-			while (nsamples--)
-			{
-				signed int sample;
-
-				/* output sample(s) in 16-bit signed little-endian PCM */
-
-				sample = scale(*left_ch++);
-
-				unsigned short value = Endian.LittleLong(sample);
-				*(short*)datap = value;
-				datap += sizeof(short);
-			}
-		}
-
-		buffer->stream.write((const char *)data, datasize);
-		delete[] data;
-	}
-
-	return MAD_FLOW_CONTINUE;
-}
-
-static
-enum mad_flow error(void *data,
-	struct mad_stream *stream,
-	struct mad_frame *frame)
-{
-	buffer_s *buffer = (buffer_s*)data;
-
-	fprintf(stderr, "decoding error 0x%04x (%s) at byte offset %zd\n",
-		stream->error, mad_stream_errorstr(stream),
-		stream->this_frame - buffer->start);
-
-	/* return MAD_FLOW_BREAK here to stop decoding (and propagate an error) */
-
-	return MAD_FLOW_CONTINUE;
-}
-
-static
-int decode(unsigned char const *start, unsigned long length)
-{
-	buffer_s buffer;
-	struct mad_decoder decoder;
-	int result;
-
-	/* initialize our private message structure */
-
-	buffer.start = start;
-	buffer.length = length;
-
-	/* configure input, output, and error functions */
-
-	mad_decoder_init(&decoder, &buffer,
-		input, 0 /* header */, 0 /* filter */, output,
-		error, 0 /* message */);
-
-	/* start decoding */
-
-	result = mad_decoder_run(&decoder, MAD_DECODER_MODE_SYNC);
-
-	/* release the decoder */
-
-	mad_decoder_finish(&decoder);
-
-	return result;
-}
-
 CLASS_DEFINITION(Sound);
 Sound::Sound()
 {
@@ -258,166 +93,44 @@ bool Sound::Load()
 
 bool Sound::DecodeLAME(void *buf, std::streamsize len)
 {
-#if 0
-	lame_t lame = lame_init();
-	lame_set_decode_only(lame, 1);
-	if (lame_init_params(lame) == -1)
-	{
+	// the headers give the size of the decoded data
+	mp3Info_t info;
+	if (!MP3Decoder::GetInfo(buf, (size_t)len, info)) {
 		return false;
 	}
 
-	hip_t hip = hip_decode_init();
-
-	mp3data_struct mp3data;
-	memset(&mp3data, 0, sizeof(mp3data));
-
-	int32_t nChannels = -1;
-	int32_t nSampleRate = -1;
-	std::streamsize mp3_len;
-	uint32_t wavsize = 0;
-	int32_t samples = 0;
-	uint8_t* mp3_buffer = (uint8_t*)buf;
-
-	static const int32_t pcmSize = 4096;
-	static const int32_t mp3Size = 4096;
-
-	short pcm_l_r[pcmSize * 2];
-
-	std::streamsize prevLen = len;
-	std::streamsize remainingLength = len - 4096;
-	if (remainingLength < 0)
-	{
-		remainingLength = 0;
-	}
-
-	std::stringstream wavdata;
-
-	std::streamsize readLen = prevLen - remainingLength;
-	while (readLen > 0)
-	{
-		mp3_len = readLen;
-
-		do
-		{
-			samples = hip_decode1_headers(hip, mp3_buffer, mp3_len, pcm_l_r, pcm_l_r + pcmSize, &mp3data);
-			wavsize += samples;
-
-			if (mp3data.header_parsed == 1)
-			{
-				if (nChannels < 0)
-				{
-					WriteWaveHeader(wavdata, 0x7FFFFFFF, mp3data.samplerate, mp3data.stereo, 16);
-				}
-				nChannels = mp3data.stereo;
-				nSampleRate = mp3data.samplerate;
-			}
-
-			if (samples > 0 && mp3data.header_parsed != 1)
-			{
-				hip_decode_exit(hip);
-				lame_close(lame);
-				return false;
-			}
-
-			for (int32_t i = 0; i < samples; i++)
-			{
-				wavdata.write((const char *)&pcm_l_r[i], sizeof(short));
-				if (nChannels == 2)
-				{
-					wavdata.write((const char *)&pcm_l_r[pcmSize + i], sizeof(short));
-				}
-			}
-			mp3_len = 0;
-		} while (samples > 0);
-
-		mp3_buffer += readLen;
-
-		prevLen = remainingLength;
-		remainingLength -= 4096;
-		if (remainingLength < 0)
-		{
-			remainingLength = 0;
-		}
-		readLen = prevLen - remainingLength;
-	}
-
-	uint32_t dataSize = 0;
-	uint32_t i = (16 / 8) * mp3data.stereo;
-	if (wavsize <= 0)
-	{
-		dataSize = 0;
-	}
-	else if (wavsize > 0xFFFFFFD0 / i)
-	{
-		dataSize = 0xFFFFFFD0;
-	}
-	else
-	{
-		dataSize = wavsize * i;
+	MP3Decoder decoder(buf, (size_t)len);
+	if (!decoder.prepare()) {
+		return false;
 	}
 
-	wavdata.seekp(0, wavdata.beg);
-	WriteWaveHeader(wavdata, dataSize, mp3data.samplerate, mp3data.stereo, 16);
-	wavdata.seekp(0, wavdata.end);
+	const size_t sampleFrameSize = decoder.getNumChannels() * sizeof(int16_t);
 
-	if (wavdata.good())
-	{
-		dataLen = wavdata.tellp();
-		data = new uint8_t[dataLen];
-		wavdata.read((char*)data, dataLen);
+	size_t maxSampleFrames = info.numSampleFrames;
+	if (maxSampleFrames > (0xFFFFFFD0 - WAVE_HEADER_SIZE) / sampleFrameSize) {
+		maxSampleFrames = (0xFFFFFFD0 - WAVE_HEADER_SIZE) / sampleFrameSize;
 	}
 
-	hip_decode_exit(hip);
-	lame_close(lame);
-#else
-	buffer_s buffer;
-	struct mad_decoder decoder;
-	int result;
-
-	/* initialize our private message structure */
-	buffer.start = (const unsigned char*)buf;
-	buffer.length = (uint32_t)len;
-
-	/* configure input, output, and error functions */
-	mad_decoder_init(&decoder, &buffer,
-		input, 0 /* header */, 0 /* filter */, output,
-		error, 0 /* message */);
-
-	/* start decoding */
-	result = mad_decoder_run(&decoder, MAD_DECODER_MODE_SYNC);
+	// samples are decoded straight after the header
+	uint8_t* wavData = new uint8_t[WAVE_HEADER_SIZE + maxSampleFrames * sampleFrameSize];
+	int16_t* samples = (int16_t*)(wavData + WAVE_HEADER_SIZE);
 
-	/* release the decoder */
-	mad_decoder_finish(&decoder);
+	const size_t numSampleFrames = decoder.decode(samples, maxSampleFrames);
+	const size_t numSamples = numSampleFrames * decoder.getNumChannels();
 
-	if (result != -1)
+	if (Endian.LittleShort(1) != 1)
 	{
-		uint32_t dataSize = 0;
-		uint32_t i = (16 / 8) * buffer.numChannels;
-		if (buffer.numSamples <= 0)
-		{
-			dataSize = 0;
-		}
-		else if (buffer.numSamples > 0xFFFFFFD0 / i)
-		{
-			dataSize = 0xFFFFFFD0;
-		}
-		else
-		{
-			dataSize = buffer.numSamples * i;
+		// wave data is little-endian
+		for (size_t i = 0; i < numSamples; ++i) {
+			samples[i] = Endian.LittleShort(samples[i]);
 		}
+	}
 
-		buffer.stream.seekp(0, buffer.stream.beg);
-		WriteWaveHeader(buffer.stream, dataSize, buffer.sampleRate, buffer.numChannels, 16);
-		buffer.stream.seekp(0, buffer.stream.end);
+	const uint32_t pcmBytes = (uint32_t)(numSampleFrames * sampleFrameSize);
+	WriteWaveHeader(wavData, pcmBytes, decoder.getSampleRate(), decoder.getNumChannels(), 16);
 
-		if (buffer.stream.good())
-		{
-			dataLen = (size_t)buffer.stream.tellp();
-			data = new uint8_t[dataLen];
-			buffer.stream.read((char*)data, dataLen);
-		}
-	}
-#endif
+	data = wavData;
+	dataLen = WAVE_HEADER_SIZE + pcmBytes;
 
 	return true;
 }
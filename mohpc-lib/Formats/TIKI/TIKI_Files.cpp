@@ -8,6 +8,8 @@ using namespace MOHPC;
 
 bool TIKI::Load()
 {
+	MemoryTagScope tagScope(memoryTag_e::TIKI);
+
 	if (tikianim)
 	{
 		delete tikianim;
@@ -230,7 +232,8 @@ bool TIKI::LoadTIKIModel(const char* Filename, const dloaddef_t* ld)
 			{
 				Skeleton *mesh = meshes[j].get();
 
-				TIKISurface* tikiSurf = &surfaces[surfOffset];
+				// the mesh may not have any surface
+				TIKISurface* tikiSurf = surfaces.data() + surfOffset;
 
 				for (size_t k = 0; k < mesh->Surfaces.size(); k++)
 				{
@@ -257,7 +260,8 @@ bool TIKI::LoadTIKIModel(const char* Filename, const dloaddef_t* ld)
 			{
 				Skeleton *mesh = meshes[j].get();
 
-				TIKISurface* tikiSurf = &surfaces[surfOffset];
+				// the mesh may not have any surface
+				TIKISurface* tikiSurf = surfaces.data() + surfOffset;
 
 				for (size_t k = 0; k < mesh->Surfaces.size(); k++)
 				{
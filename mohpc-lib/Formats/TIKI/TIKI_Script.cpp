@@ -776,7 +776,8 @@ const char *TikiScript::GetToken(bool crossline)
 			*token_p++ = *i->script_p++;
 		}
 
-		if (token_p == &i->token[MAXTOKEN])
+		// keep room for the terminator
+		if (token_p == &i->token[MAXTOKEN - 1])
 		{
 			TIKI_DPrintf("Token too large on line %i in file %s\n", i->line, i->Filename());
 			break;
@@ -1099,11 +1100,16 @@ const char *TikiScript::GetString(bool crossline)
 		{
 			TIKI_DPrintf("End of token file reached prematurely while reading string on\n"
 				"line %d in file %s\n", startline, i->filename);
+			*token_p = 0;
+			return i->token;
 		}
 
-		if (token_p == &i->token[MAXTOKEN])
+		// keep room for the terminator
+		if (token_p == &i->token[MAXTOKEN - 1])
 		{
 			TIKI_DPrintf("String too large on line %i in file %s\n", i->line, i->filename);
+			*token_p = 0;
+			return i->token;
 		}
 	}
 
@@ -28,10 +28,15 @@ intptr_t MOHPC::HashCode< command_t >(const command_t& key)
 	return HashCode< str >(key.command);
 }
 
+// number of nodes allocated at once
+static constexpr size_t EVENT_NODE_BLOCK_SIZE = 256;
+
 CLASS_DEFINITION(EventManager)
 EventManager::EventManager()
 {
-
+	freeEventNodes = nullptr;
+	eventSequence = 0;
+	bEventSystemStarted = false;
 }
 
 EventManager::~EventManager()
@@ -42,25 +47,208 @@ EventManager::~EventManager()
 		ClearEventList();
 		//UnloadEvents();
 	}
+
+	FreeEventNodes();
 }
 
 void EventManager::ClearEventList()
 {
-	EventQueueNode *node = EventQueue.next, *tmp;
-
-	while (node != &EventQueue)
+	const size_t numEvents = EventQueue.NumObjects();
+	for (size_t i = 0; i < numEvents; ++i)
 	{
-		tmp = node->next;
+		EventQueueNode* node = EventQueue[i];
+
+		// detach the node from its listener
+		Listener* obj = node->GetSourceObject();
+		if (obj) {
+			obj->m_pendingEvents = nullptr;
+		}
 
 		delete node->event;
-		delete node;
+		FreeEventNode(node);
+	}
+
+	EventQueue.ClearObjectList();
+}
+
+EventQueueNode* EventManager::AllocateEventNode()
+{
+	if (!freeEventNodes)
+	{
+		EventQueueNode* block = new EventQueueNode[EVENT_NODE_BLOCK_SIZE];
+		eventNodeBlocks.AddObject(block);
+
+		for (size_t i = 0; i < EVENT_NODE_BLOCK_SIZE; ++i)
+		{
+			block[i].next = freeEventNodes;
+			freeEventNodes = &block[i];
+		}
+	}
+
+	EventQueueNode* node = freeEventNodes;
+	freeEventNodes = node->next;
+	node->next = nullptr;
+	return node;
+}
+
+void EventManager::FreeEventNode(EventQueueNode* node)
+{
+	node->event = nullptr;
+	node->SetSourceObject(nullptr);
+	node->prev = nullptr;
+	node->next = freeEventNodes;
+	freeEventNodes = node;
+}
+
+void EventManager::FreeEventNodes()
+{
+	for (size_t i = 0; i < eventNodeBlocks.NumObjects(); ++i) {
+		delete[] eventNodeBlocks[i];
+	}
+
+	eventNodeBlocks.FreeObjectList();
+	freeEventNodes = nullptr;
+}
+
+bool EventManager::EventFiresBefore(const EventQueueNode* node1, const EventQueueNode* node2)
+{
+	if (node1->time != node2->time) {
+		return node1->time < node2->time;
+	}
+
+	// events of the same time fire in the order they were posted
+	return node1->sequence < node2->sequence;
+}
+
+void EventManager::SiftEventUp(size_t index)
+{
+	EventQueueNode* node = EventQueue[index];
+
+	while (index > 0)
+	{
+		const size_t parentIndex = (index - 1) / 2;
+		EventQueueNode* parent = EventQueue[parentIndex];
+		if (!EventFiresBefore(node, parent)) {
+			break;
+		}
+
+		EventQueue[index] = parent;
+		parent->heapIndex = index;
+		index = parentIndex;
+	}
+
+	EventQueue[index] = node;
+	node->heapIndex = index;
+}
+
+void EventManager::SiftEventDown(size_t index)
+{
+	const size_t numEvents = EventQueue.NumObjects();
+	EventQueueNode* node = EventQueue[index];
+
+	for (;;)
+	{
+		size_t childIndex = index * 2 + 1;
+		if (childIndex >= numEvents) {
+			break;
+		}
+
+		// pick the child that fires first
+		if (childIndex + 1 < numEvents && EventFiresBefore(EventQueue[childIndex + 1], EventQueue[childIndex])) {
+			++childIndex;
+		}
+
+		EventQueueNode* child = EventQueue[childIndex];
+		if (!EventFiresBefore(child, node)) {
+			break;
+		}
 
-		node = tmp;
+		EventQueue[index] = child;
+		child->heapIndex = index;
+		index = childIndex;
 	}
 
-	LL_Reset(&EventQueue, next, prev);
+	EventQueue[index] = node;
+	node->heapIndex = index;
+}
+
+void EventManager::InsertEventNode(EventQueueNode* node)
+{
+	node->sequence = eventSequence++;
 
-	//Event_allocator.FreeAll();
+	EventQueue.AddObject(node);
+	SiftEventUp(EventQueue.NumObjects() - 1);
+
+	// link to the listener
+	Listener* obj = node->GetSourceObject();
+	node->prev = nullptr;
+	node->next = obj->m_pendingEvents;
+	if (obj->m_pendingEvents) {
+		obj->m_pendingEvents->prev = node;
+	}
+	obj->m_pendingEvents = node;
+}
+
+void EventManager::RemoveEventNode(EventQueueNode* node)
+{
+	const size_t index = node->heapIndex;
+	const size_t lastIndex = EventQueue.NumObjects() - 1;
+
+	if (index != lastIndex)
+	{
+		// move the last node into the hole, and put it at its place
+		EventQueueNode* last = EventQueue[lastIndex];
+		EventQueue[index] = last;
+		last->heapIndex = index;
+		EventQueue.RemoveObjectAt(lastIndex + 1);
+
+		if (index > 0 && EventFiresBefore(last, EventQueue[(index - 1) / 2])) {
+			SiftEventUp(index);
+		}
+		else {
+			SiftEventDown(index);
+		}
+	}
+	else {
+		EventQueue.RemoveObjectAt(lastIndex + 1);
+	}
+
+	// unlink from the listener
+	if (node->prev) {
+		node->prev->next = node->next;
+	}
+	else
+	{
+		Listener* obj = node->GetSourceObject();
+		if (obj) {
+			obj->m_pendingEvents = node->next;
+		}
+	}
+
+	if (node->next) {
+		node->next->prev = node->prev;
+	}
+
+	node->prev = nullptr;
+	node->next = nullptr;
+}
+
+void EventManager::RescheduleEventNode(EventQueueNode* node, double time)
+{
+	const bool later = time >= node->time;
+	node->time = time;
+
+	if (later) {
+		SiftEventDown(node->heapIndex);
+	}
+	else {
+		SiftEventUp(node->heapIndex);
+	}
+}
+
+size_t EventManager::NumPendingEvents() const
+{
+	return EventQueue.NumObjects();
 }
 
 bool EventManager::EventSystemStarted()
@@ -174,13 +362,12 @@ size_t EventManager::NumEventCommands()
 
 void EventManager::ProcessPendingEvents()
 {
-	EventQueueNode *node;
+	const float t = GetManager<GameManager>()->GetLevel()->GetTimeSeconds();
 
-	while (!LL_Empty(&EventQueue, next, prev))
+	while (EventQueue.NumObjects())
 	{
 		Listener *obj;
-
-		node = EventQueue.next;
+		EventQueueNode *node = EventQueue[0];
 
 		assert(node);
 
@@ -188,18 +375,18 @@ void EventManager::ProcessPendingEvents()
 
 		assert(obj);
 
-		if (node->time > GetManager<GameManager>()->GetLevel()->GetTimeSeconds())
+		if (node->time > t)
 		{
 			break;
 		}
 
-		// the event is removed from its list
-		LL_Remove(node, next, prev);
+		// the event is removed from the queue, the node can be reused right away
+		Event* ev = node->event;
+		RemoveEventNode(node);
+		FreeEventNode(node);
 
 		// ProcessEvent will dispose of this event when it is done
-		obj->ProcessEvent(node->event);
-
-		delete node;
+		obj->ProcessEvent(ev);
 	}
 }
 
@@ -494,20 +681,12 @@ Event *EventManager::NewEvent(const Event* ev)
 
 	newEvent->fromScript = ev->fromScript;
 	newEvent->eventnum = ev->eventnum;
+	newEvent->ReserveArgs(ev->dataSize);
 	newEvent->dataSize = ev->dataSize;
 
-	if (newEvent->dataSize)
-	{
-		newEvent->data = new ScriptVariable[newEvent->dataSize];
-
-		for (uintptr_t i = 0; i < newEvent->dataSize; i++)
-		{
-			newEvent->data[i] = ev->data[i];
-		}
-	}
-	else
+	for (uintptr_t i = 0; i < newEvent->dataSize; i++)
 	{
-		newEvent->data = NULL;
+		newEvent->data[i] = ev->data[i];
 	}
 
 #ifdef _DEBUG
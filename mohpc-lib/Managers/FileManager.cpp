@@ -1,5 +1,6 @@
 #include <Shared.h>
 #include <fstream>
+#include <sstream>
 #include <unordered_map>
 #include <set>
 #include <MOHPC/Managers/FileManager.h>
@@ -227,6 +228,7 @@ namespace MOHPC
 	{
 		FileManagerCategory defaultCategory;
 		std::vector<FileManagerCategory*> categoryList;
+		std::unordered_map<str, std::string, FileNameHash, FileNameMapCompare> memoryFiles;
 	};
 }
 
@@ -308,6 +310,21 @@ std::istream* File::GetStream() const
 	return m_data->LinkedStream;
 }
 
+std::streamsize File::GetLength() const
+{
+	if (!m_data->BufferSize)
+	{
+		// files on disk don't have their size known before
+		std::istream* stream = GetStream();
+		const std::streampos pos = stream->tellg();
+		stream->seekg(0, stream->end);
+		m_data->BufferSize = stream->tellg();
+		stream->seekg(pos, stream->beg);
+	}
+
+	return m_data->BufferSize;
+}
+
 std::streamsize File::ReadBuffer(void** Out)
 {
 	std::streamsize length = 0;
@@ -316,13 +333,7 @@ std::streamsize File::ReadBuffer(void** Out)
 	{
 		std::istream* stream = GetStream();
 
-		if (!m_data->BufferSize)
-		{
-			stream->seekg(0, stream->end);
-			m_data->BufferSize = stream->tellg();
-			stream->seekg(0, stream->beg);
-		}
-		length = m_data->BufferSize;
+		length = GetLength();
 
 		m_data->Buffer = new char[(size_t)m_data->BufferSize + 1];
 		if (m_data->Buffer)
@@ -398,6 +409,16 @@ bool FileManager::AddGameDirectory(const char* Directory, const char* CategoryNa
 	return true;
 }
 
+void FileManager::AddMemoryFile(const char* Filename, const void* Data, size_t Size)
+{
+	m_pData->memoryFiles[GetFixedPath(Filename)].assign((const char*)Data, Size);
+}
+
+bool FileManager::RemoveMemoryFile(const char* Filename)
+{
+	return m_pData->memoryFiles.erase(GetFixedPath(Filename)) != 0;
+}
+
 bool FileManager::AddPakFile(const char* Filename, const char* CategoryName)
 {
 	unzFile ZipFile = unzOpen(Filename);
@@ -502,6 +523,10 @@ bool FileManager::FileExists(const char* Filename, bool bInPakOnly, const char*
 
 	const str NewFilename = GetFixedPath(Filename);
 
+	if (m_pData->memoryFiles.find(NewFilename) != m_pData->memoryFiles.end()) {
+		return true;
+	}
+
 	auto it = Category->m_PakFilesMap.find(NewFilename);
 	if (it != Category->m_PakFilesMap.end())
 	{
@@ -539,6 +564,16 @@ FilePtr FileManager::OpenFile(const char* Filename, const char* CategoryName)
 
 	const str pathString = GetFixedPath(Filename);
 
+	auto memIt = m_pData->memoryFiles.find(pathString);
+	if (memIt != m_pData->memoryFiles.end())
+	{
+		// Found file in memory
+		File* file = new File;
+		file->m_data->BufferSize = memIt->second.length();
+		file->m_data->LinkedStream = new std::istringstream(memIt->second, std::ios::binary);
+		return SharedPtr<File>(file);
+	}
+
 	auto it = Category->m_PakFilesMap.find(pathString);
 	if (it != Category->m_PakFilesMap.end())
 	{
@@ -1,6 +1,7 @@
 #include <MOHPC/Managers/NetworkManager.h>
 #include <vector>
 #include <functional>
+#include <chrono>
 
 using namespace MOHPC;
 using namespace Network;
@@ -16,6 +17,7 @@ uint64_t Network::getCurrentTime()
 }
 
 NetworkManager::NetworkManager()
+	: totalMetrics(ChannelMetrics::create())
 {
 
 }
@@ -35,12 +37,17 @@ void MOHPC::NetworkManager::processTicks()
 	const uint64_t deltaTime = currentTime - lastTickTime;
 	lastTickTime = currentTime;
 
+	using namespace std::chrono;
+	const steady_clock::time_point start = steady_clock::now();
+
 	for (size_t i = 0; i < tickables.NumObjects(); ++i)
 	{
 		// Tick every tickables objects
 		ITickableNetwork* tickable = tickables[i];
 		tickable->tick(deltaTime, currentTime);
 	}
+
+	tickTimes.record(duration_cast<microseconds>(steady_clock::now() - start).count());
 }
 
 void MOHPC::NetworkManager::addTickable(ITickableNetwork* tickable)
@@ -53,6 +60,16 @@ void MOHPC::NetworkManager::removeTickable(ITickableNetwork* tickable)
 	tickables.RemoveObject(tickable);
 }
 
+const ChannelMetricsPtr& MOHPC::NetworkManager::getTotalMetrics() const
+{
+	return totalMetrics;
+}
+
+const MetricHistogram& MOHPC::NetworkManager::getTickTimes() const
+{
+	return tickTimes;
+}
+
 MOHPC::ITickableNetwork::ITickableNetwork(const NetworkManagerPtr& manager)
 	: owner(manager)
 {
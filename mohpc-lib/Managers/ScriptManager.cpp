@@ -11,13 +11,15 @@
 #include <MOHPC/Script/ScriptContainer.h>
 #include <MOHPC/Script/ScriptException.h>
 #include <MOHPC/Script/GameScript.h>
+#include <MOHPC/Script/Compiler.h>
 
 using namespace MOHPC;
 
 CLASS_DEFINITION(ScriptManager);
 ScriptManager::ScriptManager()
+	: stackCount(0)
+	, ContainerHead(NULL)
 {
-
 }
 
 void ScriptManager::Init()
@@ -79,16 +81,19 @@ void ScriptManager::InitConstStrings()
 
 const_str ScriptManager::AddString(const char *s)
 {
+	std::lock_guard<std::mutex> lock(StringDictMutex);
 	return (const_str)StringDict.addKeyIndex(s);
 }
 
 const_str ScriptManager::AddString(const str& s)
 {
+	std::lock_guard<std::mutex> lock(StringDictMutex);
 	return (const_str)StringDict.addKeyIndex(s);
 }
 
 const_str ScriptManager::GetString(const char *s)
 {
+	std::lock_guard<std::mutex> lock(StringDictMutex);
 	const_str cs = (const_str)StringDict.findKeyIndex(s);
 	return cs ? cs : STRING_EMPTY;
 }
@@ -100,6 +105,8 @@ const_str ScriptManager::GetString(const str& s)
 
 const str& ScriptManager::GetString(const_str s)
 {
+	// entries never move, the reference stays valid after the lock is released
+	std::lock_guard<std::mutex> lock(StringDictMutex);
 	return StringDict[s];
 }
 
@@ -316,25 +323,43 @@ GameScript* ScriptManager::GetGameScriptInternal(const str& filename)
 		return scr;
 	}
 
-	scr = new GameScript(filename);
+	// the filename constructor would need the script manager before the asset manager is set
+	scr = new GameScript();
+	scr->InitAssetManager(this);
+	scr->m_Filename = constString;
 
 	m_GameScripts[constString] = scr;
 
-	/*
-	if (GetCompiledScript(scr))
-	{
-		scr->m_Filename = AddString(filename);
-		return scr;
-	}
-	*/
-
 	FilePtr File = GetFileManager()->OpenFile(filename);
 	if (File)
 	{
 		void* sourceBuffer;
 		size_t sourceLength = (size_t)File->ReadBuffer(&sourceBuffer);
 
-		scr->Load(sourceBuffer, sourceLength);
+		if (compiledScriptDirectory.length())
+		{
+			const uint64_t sourceHash = GameScript::GetSourceHash(sourceBuffer, sourceLength);
+			const str compiledPath = GetCompiledScriptPath(sourceHash);
+
+			ScriptCompiler compiler;
+			compiler.InitAssetManager(this);
+
+			if (compiler.GetCompiledScript(scr, compiledPath.c_str(), sourceHash))
+			{
+				// the source is kept for error messages
+				scr->SetSource(sourceBuffer, sourceLength);
+				return scr;
+			}
+
+			scr->Load(sourceBuffer, sourceLength);
+
+			if (scr->successCompile) {
+				compiler.SaveCompiledScript(scr, compiledPath.c_str(), sourceHash);
+			}
+		}
+		else {
+			scr->Load(sourceBuffer, sourceLength);
+		}
 
 		if (!scr->successCompile)
 		{
@@ -449,3 +474,16 @@ Parm* ScriptManager::GetParm()
 	return &parm;
 }
 
+void ScriptManager::SetCompiledScriptDirectory(const char* directory)
+{
+	compiledScriptDirectory = directory ? directory : "";
+}
+
+str ScriptManager::GetCompiledScriptPath(uint64_t sourceHash) const
+{
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "%016llx.scrc", (unsigned long long)sourceHash);
+
+	return compiledScriptDirectory + "/" + fileName;
+}
+
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MOHPC_CPU_X86
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace MOHPC
+{
+namespace CPU
+{
+	/*
+	 * Features queried at runtime, so that a single build can use newer instructions when they are available.
+	 */
+	struct features_t
+	{
+		bool ssse3;
+		bool sse41;
+		bool pclmul;
+		bool sha;
+	};
+
+	inline features_t QueryFeatures()
+	{
+		features_t features{};
+
+#ifdef MOHPC_CPU_X86
+		uint32_t regs[4] = { 0 };
+
+#ifdef _MSC_VER
+		__cpuid((int*)regs, 0);
+		const uint32_t maxLeaf = regs[0];
+
+		__cpuid((int*)regs, 1);
+#else
+		const uint32_t maxLeaf = __get_cpuid_max(0, nullptr);
+		__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+
+		features.ssse3 = (regs[2] & (1 << 9)) != 0;
+		features.sse41 = (regs[2] & (1 << 19)) != 0;
+		features.pclmul = (regs[2] & (1 << 1)) != 0;
+
+		if (maxLeaf >= 7)
+		{
+#ifdef _MSC_VER
+			__cpuidex((int*)regs, 7, 0);
+#else
+			__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+			features.sha = (regs[1] & (1 << 29)) != 0;
+		}
+#endif
+
+		return features;
+	}
+
+	/** Returns the features of the CPU, queried once. */
+	inline const features_t& GetFeatures()
+	{
+		static const features_t features = QueryFeatures();
+		return features;
+	}
+}
+}
+
+#ifdef MOHPC_CPU_X86
+#if defined(__GNUC__) || defined(__clang__)
+// allow using intrinsics of instructions the whole build isn't compiled for
+#define MOHPC_TARGET(features) __attribute__((target(features)))
+#else
+#define MOHPC_TARGET(features)
+#endif
+#endif
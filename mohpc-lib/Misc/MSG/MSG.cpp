@@ -73,6 +73,7 @@ MSG::MSG(IMessageStream& stream, msgMode_e inMode) noexcept
 	, msgCodec(&MessageCodecs::Bit)
 	, mode(inMode)
 	, bit(0)
+	, serializedBits(0)
 	, bitData{ 0 }
 {
 	if(mode == msgMode_e::Reading)
@@ -395,6 +396,11 @@ size_t MSG::GetBitPosition() const
 	return bit;
 }
 
+size_t MSG::GetSerializedBits() const
+{
+	return serializedBits;
+}
+
 bool MSG::IsReading() noexcept
 {
 	return mode == msgMode_e::Reading || mode == msgMode_e::Both;
@@ -422,6 +428,7 @@ void MSG::ReadBits(void* value, intptr_t bits)
 	if (bits < 0) bits = -bits;
 
 	codec().Decode(value, bits, bit, stream(), bitData, sizeof(bitData));
+	serializedBits += bits;
 }
 
 bool MSG::ReadBool()
@@ -595,6 +602,7 @@ MSG& MSG::WriteBits(const void* value, intptr_t bits)
 
 	if (bits < 0) bits = -bits;
 	codec().Encode(value, bits, bit, stream(), bitData, sizeof(bitData));
+	serializedBits += bits;
 
 	return *this;
 }
@@ -1162,6 +1170,16 @@ uint16_t MsgTypesHelper::ReadEntityNum2()
 	return (entNum - 1) & (MAX_GENTITIES - 1);
 }
 
+void MsgTypesHelper::WriteEntityNum(uint16_t num)
+{
+	msg.WriteNumber<uint16_t>(num, GENTITYNUM_BITS);
+}
+
+void MsgTypesHelper::WriteEntityNum2(uint16_t num)
+{
+	msg.WriteNumber<uint16_t>((num + 1) & (MAX_GENTITIES - 1), GENTITYNUM_BITS);
+}
+
 void MsgTypesHelper::WriteCoord(float& value)
 {
 	int32_t bits = int32_t(value * 16.0f);
@@ -13,6 +13,11 @@
 #endif
 
 #include "SHA1.h"
+#include "CPUFeatures.h"
+
+#ifdef MOHPC_CPU_X86
+#include <immintrin.h>
+#endif
 
 #define SHA1_MAX_FILE_BUFFER (32 * 20 * 820)
 
@@ -48,6 +53,90 @@
 
 namespace MOHPC
 {
+#ifdef MOHPC_CPU_X86
+// 4 rounds with the SHA extensions, where the message schedule of the next rounds is computed at the same time
+#define SHA1_SHANI_ROUNDS(e, eNext, m0, m1, m2, m3, func) \
+	e = _mm_sha1nexte_epu32(e, m0); \
+	eNext = abcd; \
+	m1 = _mm_sha1msg2_epu32(m1, m0); \
+	abcd = _mm_sha1rnds4_epu32(abcd, e, func); \
+	m3 = _mm_sha1msg1_epu32(m3, m0); \
+	m2 = _mm_xor_si128(m2, m0);
+
+#define SHA1_SHANI_LOAD(m, offset) \
+	m = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pBuffer + offset)), byteSwap);
+
+/*
+====================
+TransformSHANI
+
+Same as CSHA1::Transform, using the SHA extensions of x86 processors.
+====================
+*/
+MOHPC_TARGET("sha,ssse3,sse4.1")
+static void TransformSHANI(UINT_32* pState, const UINT_8* pBuffer)
+{
+	const __m128i byteSwap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+	__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)pState), 0x1B);
+	__m128i e0 = _mm_set_epi32((int)pState[4], 0, 0, 0);
+	__m128i e1;
+
+	const __m128i abcdSave = abcd;
+	const __m128i e0Save = e0;
+
+	// the schedule of the first rounds is computed before the message is loaded, it's overwritten
+	__m128i msg0, msg1, msg2 = _mm_setzero_si128(), msg3 = _mm_setzero_si128();
+
+	// rounds 0-3
+	SHA1_SHANI_LOAD(msg0, 0);
+	e0 = _mm_add_epi32(e0, msg0);
+	e1 = abcd;
+	abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+	SHA1_SHANI_LOAD(msg1, 16);
+	SHA1_SHANI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 0);
+	SHA1_SHANI_LOAD(msg2, 32);
+	SHA1_SHANI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 0);
+	SHA1_SHANI_LOAD(msg3, 48);
+	SHA1_SHANI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 0);
+
+	// rounds 16-79
+	SHA1_SHANI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 0);
+	SHA1_SHANI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1);
+	SHA1_SHANI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 1);
+	SHA1_SHANI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 1);
+	SHA1_SHANI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 1);
+	SHA1_SHANI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1);
+	SHA1_SHANI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2);
+	SHA1_SHANI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 2);
+	SHA1_SHANI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 2);
+	SHA1_SHANI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 2);
+	SHA1_SHANI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2);
+	SHA1_SHANI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 3);
+	SHA1_SHANI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 3);
+	SHA1_SHANI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 3);
+	SHA1_SHANI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 3);
+	SHA1_SHANI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 3);
+
+	// add the working vars back into state
+	e0 = _mm_sha1nexte_epu32(e0, e0Save);
+	abcd = _mm_add_epi32(abcd, abcdSave);
+
+	_mm_storeu_si128((__m128i*)pState, _mm_shuffle_epi32(abcd, 0x1B));
+	pState[4] = (UINT_32)_mm_extract_epi32(e0, 3);
+}
+
+#undef SHA1_SHANI_LOAD
+#undef SHA1_SHANI_ROUNDS
+
+static bool UseSHANI()
+{
+	const CPU::features_t& features = CPU::GetFeatures();
+	return features.sha && features.ssse3 && features.sse41;
+}
+#endif
+
 CSHA1::CSHA1()
 {
 	m_block = (SHA1_WORKSPACE_BLOCK*)m_workspace;
@@ -90,6 +179,15 @@ void CSHA1::Reset()
 
 void CSHA1::Transform(UINT_32* pState, const UINT_8* pBuffer)
 {
+#ifdef MOHPC_CPU_X86
+	static const bool useSHANI = UseSHANI();
+	if (useSHANI)
+	{
+		TransformSHANI(pState, pBuffer);
+		return;
+	}
+#endif
+
 	UINT_32 a = pState[0], b = pState[1], c = pState[2], d = pState[3], e = pState[4];
 
 	memcpy(m_block, pBuffer, 64);
@@ -1,7 +1,18 @@
 #include <Shared.h>
 #include <MOHPC/Misc/crc32.h>
+#include "CPUFeatures.h"
 
-const uint32_t crc32_tab[] = {
+#include <string.h>
+
+#ifdef MOHPC_CPU_X86
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+using namespace MOHPC;
+
+static constexpr uint32_t crc32_tab[] = {
 	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
 	0xe963a535, 0x9e6495a3,	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
 	0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
@@ -47,13 +58,232 @@ const uint32_t crc32_tab[] = {
 	0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
-uint32_t crc32_hash(const void *buf, size_t size, int base)
+/*
+ * Tables for slice-by-8, table n gives the crc of a byte followed by n zero bytes.
+ */
+struct crc32SliceTables_t
 {
-	const uint8_t *p = (const uint8_t*)buf;
-	uint32_t crc;
+	uint32_t tab[8][256];
+};
+
+static constexpr crc32SliceTables_t MakeSliceTables()
+{
+	crc32SliceTables_t tables{};
+
+	for (size_t i = 0; i < 256; i++) {
+		tables.tab[0][i] = crc32_tab[i];
+	}
+
+	for (size_t i = 0; i < 256; i++)
+	{
+		for (size_t n = 1; n < 8; n++) {
+			tables.tab[n][i] = crc32_tab[tables.tab[n - 1][i] & 0xFF] ^ (tables.tab[n - 1][i] >> 8);
+		}
+	}
 
-	crc = base;
+	return tables;
+}
+
+static constexpr crc32SliceTables_t crc32_slice = MakeSliceTables();
+
+static uint32_t crc32_bytes(const uint8_t *p, size_t size, uint32_t crc)
+{
 	while (size--)
 		crc = crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
 	return crc;
 }
+
+/*
+====================
+crc32_slice8
+
+Process 8 bytes per iteration, with 8 independent table lookups.
+====================
+*/
+static uint32_t crc32_slice8(const uint8_t *p, size_t size, uint32_t crc)
+{
+	// align the input for the 32-bit loads
+	while (size && ((uintptr_t)p & 3))
+	{
+		crc = crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+		size--;
+	}
+
+	while (size >= 8)
+	{
+		uint32_t one, two;
+		memcpy(&one, p, sizeof(one));
+		memcpy(&two, p + 4, sizeof(two));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		one = __builtin_bswap32(one);
+		two = __builtin_bswap32(two);
+#endif
+		one ^= crc;
+
+		crc = crc32_slice.tab[7][one & 0xFF]
+			^ crc32_slice.tab[6][(one >> 8) & 0xFF]
+			^ crc32_slice.tab[5][(one >> 16) & 0xFF]
+			^ crc32_slice.tab[4][one >> 24]
+			^ crc32_slice.tab[3][two & 0xFF]
+			^ crc32_slice.tab[2][(two >> 8) & 0xFF]
+			^ crc32_slice.tab[1][(two >> 16) & 0xFF]
+			^ crc32_slice.tab[0][two >> 24];
+
+		p += 8;
+		size -= 8;
+	}
+
+	return crc32_bytes(p, size, crc);
+}
+
+#ifdef MOHPC_CPU_X86
+
+// smallest input worth folding, the setup costs more than the tables below that
+static constexpr size_t CRC32_CLMUL_MINIMUM_LENGTH = 64;
+
+/*
+====================
+crc32_clmul
+
+Fold 64 bytes per iteration with carry-less multiplications, then reduce to 32 bits.
+The length must be at least 64 and a multiple of 16.
+See "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Intel).
+====================
+*/
+MOHPC_TARGET("pclmul,sse4.1")
+static uint32_t crc32_clmul(const uint8_t *p, size_t size, uint32_t crc)
+{
+	// constants for the reflected polynomial 0xEDB88320
+	alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+	alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+	alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+	alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+	x1 = _mm_loadu_si128((const __m128i*)(p + 0x00));
+	x2 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+	x3 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+	x4 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+
+	x0 = _mm_load_si128((const __m128i*)k1k2);
+
+	p += 64;
+	size -= 64;
+
+	// fold by 4
+	while (size >= 64)
+	{
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+		y5 = _mm_loadu_si128((const __m128i*)(p + 0x00));
+		y6 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+		y7 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+		y8 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+		p += 64;
+		size -= 64;
+	}
+
+	// fold into 128 bits
+	x0 = _mm_load_si128((const __m128i*)k3k4);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	// remaining blocks of 16
+	while (size >= 16)
+	{
+		x2 = _mm_loadu_si128((const __m128i*)p);
+
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+		p += 16;
+		size -= 16;
+	}
+
+	// fold 128 bits to 64 bits
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x1 = _mm_srli_si128(x1, 8);
+	x1 = _mm_xor_si128(x1, x2);
+
+	x0 = _mm_loadl_epi64((const __m128i*)k5k0);
+
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, x3);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	// Barrett reduction to 32 bits
+	x0 = _mm_load_si128((const __m128i*)poly);
+
+	x2 = _mm_and_si128(x1, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+static uint32_t crc32_accelerated(const uint8_t *p, size_t size, uint32_t crc)
+{
+	if (size >= CRC32_CLMUL_MINIMUM_LENGTH)
+	{
+		const size_t foldSize = size & ~(size_t)15;
+		crc = crc32_clmul(p, foldSize, crc);
+		p += foldSize;
+		size -= foldSize;
+	}
+
+	return crc32_slice8(p, size, crc);
+}
+#endif
+
+typedef uint32_t (*crc32Func_t)(const uint8_t *p, size_t size, uint32_t crc);
+
+static crc32Func_t SelectCRC32()
+{
+#ifdef MOHPC_CPU_X86
+	const CPU::features_t& features = CPU::GetFeatures();
+	if (features.pclmul && features.sse41) {
+		return &crc32_accelerated;
+	}
+#endif
+
+	return &crc32_slice8;
+}
+
+uint32_t crc32_hash(const void *buf, size_t size, int base)
+{
+	static const crc32Func_t crc32Func = SelectCRC32();
+
+	return crc32Func((const uint8_t*)buf, size, (uint32_t)base);
+}
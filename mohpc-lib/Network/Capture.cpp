@@ -0,0 +1,403 @@
+#include <MOHPC/Network/Capture.h>
+#include <MOHPC/Misc/MSG/Stream.h>
+#include <MOHPC/Misc/Endian.h>
+
+#include <cstring>
+#include <thread>
+
+using namespace MOHPC;
+using namespace Network;
+
+static constexpr char captureMagic[4] = { 'M', 'P', 'C', 'P' };
+
+CapturedPacket::CapturedPacket(uint64_t inTime, captureDirection_e inDirection, size_t inOffset, size_t inSize)
+	: time(inTime)
+	, offset(inOffset)
+	, size((uint16_t)inSize)
+	, direction(inDirection)
+{
+}
+
+uint64_t CapturedPacket::getTime() const
+{
+	return time;
+}
+
+captureDirection_e CapturedPacket::getDirection() const
+{
+	return direction;
+}
+
+size_t CapturedPacket::getSize() const
+{
+	return size;
+}
+
+size_t CapturedPacket::getOffset() const
+{
+	return offset;
+}
+
+MOHPC_OBJECT_DEFINITION(PacketCapture);
+
+PacketCapture::PacketCapture()
+	: challenge(0)
+{
+}
+
+PacketCapture::PacketCapture(const protocolType_c& inProtocol, uint32_t inChallenge)
+	: protocol(inProtocol)
+	, challenge(inChallenge)
+{
+}
+
+void PacketCapture::setProtocol(const protocolType_c& newProtocol)
+{
+	protocol = newProtocol;
+}
+
+const protocolType_c& PacketCapture::getProtocol() const
+{
+	return protocol;
+}
+
+void PacketCapture::setChallenge(uint32_t newChallenge)
+{
+	challenge = newChallenge;
+}
+
+uint32_t PacketCapture::getChallenge() const
+{
+	return challenge;
+}
+
+void PacketCapture::addPacket(uint64_t time, captureDirection_e direction, const void* packetData, size_t size)
+{
+	if (size > MAX_UDP_DATA_SIZE) {
+		throw CaptureError::BadPacketSizeException(size);
+	}
+
+	packets.emplace_back(time, direction, data.size(), size);
+	data.insert(data.end(), (const uint8_t*)packetData, (const uint8_t*)packetData + size);
+}
+
+size_t PacketCapture::getNumPackets() const
+{
+	return packets.size();
+}
+
+const CapturedPacket& PacketCapture::getPacket(size_t index) const
+{
+	return packets[index];
+}
+
+const uint8_t* PacketCapture::getPacketData(size_t index) const
+{
+	return data.data() + packets[index].getOffset();
+}
+
+void PacketCapture::clear()
+{
+	packets.clear();
+	data.clear();
+}
+
+void PacketCapture::save(IMessageStream& stream) const
+{
+	stream.Write(captureMagic, sizeof(captureMagic));
+
+	const uint32_t version = Endian.LittleInteger(CAPTURE_VERSION);
+	stream.Write(&version, sizeof(version));
+
+	const uint8_t protocolVersion = (uint8_t)protocol.getProtocolVersion();
+	const uint8_t serverType = (uint8_t)protocol.getServerType();
+	stream.Write(&protocolVersion, sizeof(protocolVersion));
+	stream.Write(&serverType, sizeof(serverType));
+
+	const uint32_t challengeValue = Endian.LittleInteger(challenge);
+	stream.Write(&challengeValue, sizeof(challengeValue));
+
+	const uint32_t numPackets = Endian.LittleInteger((uint32_t)packets.size());
+	stream.Write(&numPackets, sizeof(numPackets));
+
+	for (const CapturedPacket& packet : packets)
+	{
+		const uint64_t time = Endian.LittleLong64(packet.getTime());
+		const uint8_t direction = (uint8_t)packet.getDirection();
+		const uint16_t size = Endian.LittleShort((uint16_t)packet.getSize());
+
+		stream.Write(&time, sizeof(time));
+		stream.Write(&direction, sizeof(direction));
+		stream.Write(&size, sizeof(size));
+		stream.Write(data.data() + packet.getOffset(), packet.getSize());
+	}
+}
+
+void PacketCapture::load(IMessageStream& stream)
+{
+	// the stream doesn't check the length exactly, so check it before each read
+	auto readValue = [&stream](void* value, size_t size)
+	{
+		if (stream.GetPosition() + size > stream.GetLength()) {
+			throw CaptureError::TruncatedException();
+		}
+
+		stream.Read(value, size);
+	};
+
+	char magic[sizeof(captureMagic)];
+	if (stream.GetPosition() + sizeof(magic) > stream.GetLength()) {
+		throw CaptureError::BadHeaderException();
+	}
+
+	stream.Read(magic, sizeof(magic));
+	if (memcmp(magic, captureMagic, sizeof(magic))) {
+		throw CaptureError::BadHeaderException();
+	}
+
+	uint32_t version;
+	readValue(&version, sizeof(version));
+	version = Endian.LittleInteger(version);
+	if (version != CAPTURE_VERSION) {
+		throw CaptureError::BadVersionException(version);
+	}
+
+	uint8_t protocolVersion, serverType;
+	readValue(&protocolVersion, sizeof(protocolVersion));
+	readValue(&serverType, sizeof(serverType));
+
+	uint32_t challengeValue;
+	readValue(&challengeValue, sizeof(challengeValue));
+
+	uint32_t numPackets;
+	readValue(&numPackets, sizeof(numPackets));
+	numPackets = Endian.LittleInteger(numPackets);
+
+	clear();
+	protocol = protocolType_c((serverType_e)serverType, (protocolVersion_e)protocolVersion);
+	challenge = Endian.LittleInteger(challengeValue);
+
+	// each datagram is at least a header
+	static constexpr size_t packetHeaderSize = sizeof(uint64_t) + sizeof(uint8_t) + sizeof(uint16_t);
+	if (numPackets > (stream.GetLength() - stream.GetPosition()) / packetHeaderSize) {
+		throw CaptureError::TruncatedException();
+	}
+
+	packets.reserve(numPackets);
+	data.reserve(stream.GetLength() - stream.GetPosition() - numPackets * packetHeaderSize);
+
+	for (size_t i = 0; i < numPackets; ++i)
+	{
+		uint64_t time;
+		uint8_t direction;
+		uint16_t size;
+		readValue(&time, sizeof(time));
+		readValue(&direction, sizeof(direction));
+		readValue(&size, sizeof(size));
+
+		size = Endian.LittleShort(size);
+		if (size > MAX_UDP_DATA_SIZE) {
+			throw CaptureError::BadPacketSizeException(size);
+		}
+
+		const size_t offset = data.size();
+		data.resize(offset + size);
+		readValue(data.data() + offset, size);
+
+		packets.emplace_back(Endian.LittleLong64(time), direction ? captureDirection_e::Sent : captureDirection_e::Received, offset, size);
+	}
+}
+
+MOHPC_OBJECT_DEFINITION(CaptureSocket);
+
+CaptureSocket::CaptureSocket(const IUdpSocketPtr& inSocket, const PacketCapturePtr& inCapture)
+	: socket(inSocket)
+	, capture(inCapture)
+	, startTime(std::chrono::steady_clock::now())
+{
+}
+
+bool CaptureSocket::wait(size_t timeout)
+{
+	return socket->wait(timeout);
+}
+
+bool CaptureSocket::dataAvailable()
+{
+	return socket->dataAvailable();
+}
+
+size_t CaptureSocket::send(const NetAddr& to, const void* buf, size_t bufsize)
+{
+	const size_t len = socket->send(to, buf, bufsize);
+	if (len != (size_t)-1) {
+		capture->addPacket(getCaptureTime(), captureDirection_e::Sent, buf, len);
+	}
+
+	return len;
+}
+
+size_t CaptureSocket::receive(void* buf, size_t maxsize, NetAddrPtr& from)
+{
+	const size_t len = socket->receive(buf, maxsize, from);
+	if (len != (size_t)-1) {
+		capture->addPacket(getCaptureTime(), captureDirection_e::Received, buf, len);
+	}
+
+	return len;
+}
+
+const PacketCapturePtr& CaptureSocket::getCapture() const
+{
+	return capture;
+}
+
+uint64_t CaptureSocket::getCaptureTime() const
+{
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now() - startTime).count();
+}
+
+MOHPC_OBJECT_DEFINITION(ReplaySocket);
+
+ReplaySocket::ReplaySocket(const ConstPacketCapturePtr& inCapture, const NetAddrPtr& from, replayMode_e inMode)
+	: capture(inCapture)
+	, source(from)
+	, packetNum(0)
+	, mode(inMode)
+	, started(false)
+{
+	skipSentPackets();
+}
+
+bool ReplaySocket::wait(size_t timeout)
+{
+	using namespace std::chrono;
+
+	if (isFinished()) {
+		return false;
+	}
+
+	if (mode == replayMode_e::AsFastAsPossible) {
+		return true;
+	}
+
+	beginReplay();
+
+	// sleep until the next datagram or until the timeout
+	const steady_clock::time_point dueTime = startTime + microseconds(capture->getPacket(packetNum).getTime());
+	const steady_clock::time_point timeoutTime = steady_clock::now() + milliseconds(timeout);
+	std::this_thread::sleep_until(dueTime < timeoutTime ? dueTime : timeoutTime);
+
+	return isNextPacketDue();
+}
+
+bool ReplaySocket::dataAvailable()
+{
+	if (isFinished()) {
+		return false;
+	}
+
+	return mode == replayMode_e::AsFastAsPossible || isNextPacketDue();
+}
+
+size_t ReplaySocket::send(const NetAddr& to, const void* buf, size_t bufsize)
+{
+	// the server is not there to receive it
+	return bufsize;
+}
+
+size_t ReplaySocket::receive(void* buf, size_t maxsize, NetAddrPtr& from)
+{
+	if (!dataAvailable()) {
+		return -1;
+	}
+
+	const CapturedPacket& packet = capture->getPacket(packetNum);
+	const size_t len = packet.getSize() < maxsize ? packet.getSize() : maxsize;
+	memcpy(buf, capture->getPacketData(packetNum), len);
+	from = source;
+
+	++packetNum;
+	skipSentPackets();
+
+	return len;
+}
+
+bool ReplaySocket::isFinished() const
+{
+	return packetNum >= capture->getNumPackets();
+}
+
+void ReplaySocket::rewind()
+{
+	packetNum = 0;
+	started = false;
+	skipSentPackets();
+}
+
+void ReplaySocket::skipSentPackets()
+{
+	const size_t numPackets = capture->getNumPackets();
+	while (packetNum < numPackets && capture->getPacket(packetNum).getDirection() == captureDirection_e::Sent) {
+		++packetNum;
+	}
+}
+
+void ReplaySocket::beginReplay()
+{
+	if (!started)
+	{
+		// the time starts when the client starts reading
+		started = true;
+		startTime = std::chrono::steady_clock::now();
+	}
+}
+
+bool ReplaySocket::isNextPacketDue()
+{
+	using namespace std::chrono;
+
+	beginReplay();
+
+	const uint64_t elapsed = duration_cast<microseconds>(steady_clock::now() - startTime).count();
+	return elapsed >= capture->getPacket(packetNum).getTime();
+}
+
+str CaptureError::BadHeaderException::what() const
+{
+	return "Not a packet capture";
+}
+
+CaptureError::BadVersionException::BadVersionException(uint32_t inVersion)
+	: version(inVersion)
+{}
+
+uint32_t CaptureError::BadVersionException::getVersion() const
+{
+	return version;
+}
+
+str CaptureError::BadVersionException::what() const
+{
+	return str((int)getVersion());
+}
+
+str CaptureError::TruncatedException::what() const
+{
+	return "Unexpected end of the packet capture";
+}
+
+CaptureError::BadPacketSizeException::BadPacketSizeException(size_t inSize)
+	: size(inSize)
+{}
+
+size_t CaptureError::BadPacketSizeException::getSize() const
+{
+	return size;
+}
+
+str CaptureError::BadPacketSizeException::what() const
+{
+	return str((int)getSize());
+}
@@ -6,11 +6,14 @@
 #include <MOHPC/Misc/MSG/Stream.h>
 #include <MOHPC/Misc/MSG/Codec.h>
 
+#include <cstring>
+
 using namespace MOHPC;
 using namespace Network;
 
 INetchan::INetchan(const IUdpSocketPtr& inSocket)
 	: socket(inSocket)
+	, metrics(ChannelMetrics::create())
 {
 }
 
@@ -23,6 +26,8 @@ Netchan::Netchan(const IUdpSocketPtr& existingSocket, uint16_t inQport)
 	, outgoingSequence(1)
 	, dropped(false)
 	, fragmentSequence(0)
+	, fragmentLength(0)
+	, fragmentStream(fragmentBuffer, sizeof(fragmentBuffer), 0)
 {
 }
 
@@ -45,18 +50,31 @@ uint16_t Network::INetchan::getOutgoingSequence() const
 	return 0;
 }
 
-bool Network::Netchan::receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& outSeqNum)
+const ChannelMetricsPtr& Network::INetchan::getMetrics() const
+{
+	return metrics;
+}
+
+IMessageStream* Network::Netchan::receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& outSeqNum)
 {
 	uint8_t data[MAX_UDP_DATA_SIZE];
 	size_t len = getSocket()->receive(data, sizeof(data), from);
 	if (len == -1) {
-		return false;
+		return nullptr;
 	}
 
-	stream.Write(data, len);
-	stream.Seek(0);
+	getMetrics()->packetReceived(len);
+
+	if (len < sizeof(uint32_t))
+	{
+		// too short to even have a sequence number
+		return nullptr;
+	}
 
-	MSG msgRead(stream, msgMode_e::Reading);
+	// the header is read from the datagram itself,
+	// so fragments are never written to the input stream
+	FixedDataMessageStream datagram(data, len, len);
+	MSG msgRead(datagram, msgMode_e::Reading);
 
 	msgRead.SetCodec(MessageCodecs::OOB);
 
@@ -65,8 +83,9 @@ bool Network::Netchan::receive(NetAddrPtr& from, IMessageStream& stream, uint32_
 	if (sequenceNum == -1)
 	{
 		outSeqNum = -1;
+		stream.Write(data, len);
 		stream.Seek(sizeof(sequenceNum));
-		return true;
+		return &stream;
 	}
 
 	bool fragmented;
@@ -83,20 +102,28 @@ bool Network::Netchan::receive(NetAddrPtr& from, IMessageStream& stream, uint32_
 	outSeqNum = sequenceNum;
 
 	uint32_t fragmentStart = 0;
-	uint16_t fragmentLength = 0;
+	uint16_t fragmentSize = 0;
 
 	if (fragmented)
 	{
+		if (len < sizeof(uint32_t) * 2 + sizeof(uint16_t)) {
+			return nullptr;
+		}
+
 		fragmentStart = msgRead.ReadUInteger();
-		fragmentLength = msgRead.ReadUShort();
+		fragmentSize = msgRead.ReadUShort();
 	}
 
 	// discard out of order or duplicated packets
-	if (sequenceNum < incomingSequence) {
-		return false;
+	if (sequenceNum < incomingSequence)
+	{
+		getMetrics()->packetOutOfOrder();
+		return nullptr;
 	}
 
 	dropped = sequenceNum - (incomingSequence + 1);
+
+	IMessageStream* messageStream;
 	if (fragmented)
 	{
 		if (sequenceNum != fragmentSequence)
@@ -107,54 +134,56 @@ bool Network::Netchan::receive(NetAddrPtr& from, IMessageStream& stream, uint32_
 			clearFragment();
 		}
 
-		const size_t currentFragmentLength = fragmentStream.GetLength();
-
-		if (fragmentStart != currentFragmentLength)
+		if (fragmentStart != fragmentLength)
 		{
 			// this means that a packet was missed (lost, or wrong order)
 			// the start fragment must match with the current length
-			return false;
+			return nullptr;
 		}
 
-		if (fragmentLength < 0 || msgRead.GetPosition() + fragmentLength > stream.GetLength()) {
-			throw BadFragmentLengthException(fragmentLength);
+		getMetrics()->fragmentReceived();
+
+		const size_t dataStart = msgRead.GetPosition();
+		if (dataStart + fragmentSize > len || fragmentLength + fragmentSize > MAX_MSGLEN) {
+			throw BadFragmentLengthException(fragmentSize);
 		}
 
-		stream.Seek(msgRead.GetPosition());
-		//stream.Read(fragmentBuffer + this->fragmentLength, fragmentLength);
-		fragmentStream.Seek(fragmentLength);
-		fragmentStream.Seek(currentFragmentLength);
-		StreamHelpers::Copy<FRAGMENT_SIZE>(fragmentStream, stream, fragmentLength + stream.GetPosition());
+		// copy the fragment where it belongs in the message
+		std::memcpy(fragmentBuffer + sizeof(uint32_t) + fragmentLength, data + dataStart, fragmentSize);
+		fragmentLength += fragmentSize;
 
-		if (fragmentLength == FRAGMENT_SIZE) {
-			return false;
+		if (fragmentSize == FRAGMENT_SIZE) {
+			return nullptr;
 		}
 
-		// seek to preallocate
-		stream.Seek(fragmentStream.GetLength());
-		// reset position to create a message
-		stream.Seek(0);
+		// write the server header in the room left before the message
+		FixedDataMessageStream headerStream(fragmentBuffer, sizeof(uint32_t));
+		writePacketServerHeader(headerStream, sequenceNum);
+
+		// the message is read from the fragment buffer, past the header
+		fragmentStream = FixedDataMessageStream(fragmentBuffer, sizeof(fragmentBuffer), sizeof(uint32_t) + this->fragmentLength);
+		fragmentStream.Seek(sizeof(uint32_t));
+		messageStream = &fragmentStream;
 
-		// write all necessary stuff
-		writePacketServerHeader(stream, sequenceNum);
-
-		// save the initial position
-		const size_t savedPos = stream.GetPosition();
-		// set the fragment to the beginning and copy it to the message stream
-		fragmentStream.Seek(0);
-		StreamHelpers::Copy<FRAGMENT_SIZE>(stream, fragmentStream, fragmentStream.GetLength());
-		// return to the beginning of the message
-		stream.Seek(savedPos);
-		// now get rid of the fragment buffer
+		// the buffer is reused for the next message
 		clearFragment();
+
+		getMetrics()->messageReassembled();
 	}
-	else {
+	else
+	{
+		stream.Write(data, len);
 		stream.Seek(msgRead.GetPosition());
+		messageStream = &stream;
+	}
+
+	if (sequenceNum > incomingSequence + 1) {
+		getMetrics()->packetsDropped(sequenceNum - incomingSequence - 1);
 	}
 
 	if (sequenceNum != -1) incomingSequence = sequenceNum;
 
-	return true;
+	return messageStream;
 }
 
 bool Network::Netchan::transmit(const NetAddr& to, IMessageStream& stream)
@@ -197,6 +226,7 @@ bool Network::Netchan::transmit(const NetAddr& to, IMessageStream& stream)
 
 		// send the packet now
 		getSocket()->send(to, newStream.getStorage(), newStream.GetLength());
+		getMetrics()->packetSent(newStream.GetLength());
 
 		++outgoingSequence;
 	}
@@ -235,6 +265,8 @@ void Netchan::transmitNextFragment(const NetAddr& to, IMessageStream& stream, fr
 
 	const uint8_t* sendBuf = outputPacket.getStorage();
 	getSocket()->send(to, sendBuf, outputPacket.GetLength());
+	getMetrics()->packetSent(outputPacket.GetLength());
+	getMetrics()->fragmentSent();
 
 	unsentFragmentStart += fragmentLength;
 
@@ -266,8 +298,8 @@ void Netchan::writePacketServerHeader(IMessageStream& stream, uint32_t sequenceN
 
 void Netchan::clearFragment()
 {
-	// free memory if it's above the max message size
-	fragmentStream.clear(fragmentStream.GetLength() >= MAX_MSGLEN);
+	// the buffer is kept, only the length is reset
+	fragmentLength = 0;
 }
 
 void MOHPC::Network::Netchan::writePacketHeader(IMessageStream& stream, bool fragmented)
@@ -320,7 +352,7 @@ Network::ConnectionlessChan::ConnectionlessChan(const IUdpSocketPtr& existingSoc
 	: INetchan(existingSocket)
 {}
 
-bool Network::ConnectionlessChan::receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& sequenceNum)
+IMessageStream* Network::ConnectionlessChan::receive(NetAddrPtr& from, IMessageStream& stream, uint32_t& sequenceNum)
 {
 	MSG msg(stream, msgMode_e::Reading);
 
@@ -329,18 +361,20 @@ bool Network::ConnectionlessChan::receive(NetAddrPtr& from, IMessageStream& stre
 
 	sequenceNum = msg.ReadInteger();
 
+	getMetrics()->packetReceived(stream.GetLength());
+
 	// Should be -1 for connectionless packets
 	//assert(sequenceNum == -1);
 
 	const netsrc_e dirByte = (netsrc_e)msg.ReadByte();
 
 	if (dirByte != netsrc_e::Client) {
-		return false;
+		return nullptr;
 	}
 
 	// Seek after header
 	stream.Seek(5);
-	return true;
+	return &stream;
 }
 
 bool Network::ConnectionlessChan::transmit(const NetAddr& to, IMessageStream& stream)
@@ -352,5 +386,6 @@ bool Network::ConnectionlessChan::transmit(const NetAddr& to, IMessageStream& st
 	stream.Read(msgBuf, len);
 
 	getSocket()->send(to, msgBuf, len);
+	getMetrics()->packetSent(len);
 	return true;
 }
@@ -6,6 +6,7 @@
 #include <MOHPC/Log.h>
 #include <MOHPC/Utilities/TokenParser.h>
 
+#include <algorithm>
 #include <bitset>
 
 using namespace MOHPC;
@@ -13,6 +14,9 @@ using namespace Network;
 
 #define MOHPC_LOG_NAMESPACE "cgame" 
 
+// extra space around entities bounds, larger than the collision epsilon
+static constexpr float SOLID_BOUNDS_EPSILON = 1.f;
+
 const char* effectsModel[] =
 {
 "models/fx/barrel_oil_leak_big.tik",
@@ -145,6 +149,9 @@ CGameModuleBase::CGameModuleBase(const ClientImports& inImports)
 	, latestSnapshotNum(0)
 	, latestCommandSequence(0)
 	, numSolidEntities(0)
+	, numSolidBounds(0)
+	, solidBoundsMaxWidth(0.f)
+	, solidBoundsWorld(nullptr)
 {
 	traceFunction = stubTrace;
 	pointContentsFunction = stubPointContents;
@@ -274,7 +281,8 @@ void CGameModuleBase::processSnapshots()
 	uintptr_t n = getImports().getCurrentSnapshotNumber();
 	if (n != latestSnapshotNum)
 	{
-		assert(n < latestSnapshotNum);
+		// snapshot numbers only go forward
+		assert(n > latestSnapshotNum);
 		latestSnapshotNum = n;
 	}
 
@@ -413,8 +421,6 @@ void CGameModuleBase::setInitialSnapshot(SnapshotInfo* newSnap)
 {
 	this->snap = newSnap;
 
-	// sort out solid entities
-	buildSolidList();
 	// execute all commands at once that was received in this snap
 	executeNewServerCommands(this->snap->serverCommandSequence, false);
 
@@ -432,6 +438,9 @@ void CGameModuleBase::setInitialSnapshot(SnapshotInfo* newSnap)
 		// This is the first snapshot, notify about each entities
 		handlers().entityAddedHandler.broadcast(entInfo);
 	}
+
+	// sort out solid entities, now that their states are valid
+	buildSolidList();
 }
 
 void CGameModuleBase::transitionSnapshot(bool differentServer)
@@ -515,6 +524,9 @@ void CGameModuleBase::transitionSnapshot(bool differentServer)
 		entInfo.snapshotTime = this->snap->serverTime;
 	}
 
+	// entities have moved
+	invalidateSolidBounds();
+
 	this->nextSnap = nullptr;
 
 	playerState_t* ops = &oldSnap.ps;
@@ -699,10 +711,36 @@ void CGameModuleBase::setPointContentsFunction(PointContentsFunction&& inPointCo
 
 void CGameModuleBase::clipMoveToEntities(CollisionWorld& cm, const Vector& start, const Vector& mins, const Vector& maxs, const Vector& end, uint16_t skipNumber, uint32_t mask, bool cylinder, trace_t& tr)
 {
+	if (solidBoundsWorld != &cm)
+	{
+		// brush models bounds depend on the collision world
+		buildSolidBounds(cm);
+	}
+
+	// bounds of the whole move
+	Vector moveMins, moveMaxs;
+	for (size_t i = 0; i < 3; ++i)
+	{
+		if (start[i] < end[i])
+		{
+			moveMins[i] = start[i] + mins[i];
+			moveMaxs[i] = end[i] + maxs[i];
+		}
+		else
+		{
+			moveMins[i] = end[i] + mins[i];
+			moveMaxs[i] = start[i] + maxs[i];
+		}
+	}
+
+	// only keep entities that the move can touch
+	uintptr_t touchList[MAX_ENTITIES_IN_SNAPSHOT];
+	const size_t numTouch = querySolidBounds(moveMins, moveMaxs, touchList);
+
 	// iterate through entities and test their collision
-	for (size_t i = 0; i < numSolidEntities; i++)
+	for (size_t i = 0; i < numTouch; i++)
 	{
-		const EntityInfo* cent = solidEntities[i];
+		const EntityInfo* cent = solidEntities[touchList[i]];
 		const entityState_t* ent = &cent->currentState;
 
 		if (ent->number == skipNumber) {
@@ -877,8 +915,9 @@ bool CGameModuleBase::replayAllCommands()
 	Pmove& pmove = getMove();
 	pmove_t& pm = pmove.get();
 	pm.ps = &predictedPlayerState;
-	pm.pointcontents = pointContentsFunction;
-	pm.trace = traceFunction;
+	// refer to the functions rather than copying them on each prediction
+	pm.pointcontents = std::ref(pointContentsFunction);
+	pm.trace = std::ref(traceFunction);
 
 	if (pm.ps->pm_type == pmType_e::Dead) {
 		pm.tracemask = ContentFlags::MASK_PLAYERSOLID & ~ContentFlags::MASK_DYNAMICBODY;
@@ -949,6 +988,12 @@ bool CGameModuleBase::tryReplayCommand(Pmove& pmove, const playerState_t& oldPla
 			predictedError = Vector();
 			thisFrameTeleport = false;
 		}
+		else if ((oldPlayerState.origin - predictedPlayerState.origin).lengthSquared() > 0.1f * 0.1f)
+		{
+			// the previous prediction at the same command time
+			// doesn't match what the server has computed
+			getImports().getMetrics().predictionErrors.add();
+		}
 
 		// FIXME: Should it have some sort of predicted error?
 	}
@@ -1342,6 +1387,7 @@ void CGameModuleBase::buildSolidList()
 {
 	numSolidEntities = 0;
 	numTriggerEntities = 0;
+	invalidateSolidBounds();
 
 	SnapshotInfo* snap;
 
@@ -1372,6 +1418,96 @@ void CGameModuleBase::buildSolidList()
 	}
 }
 
+void CGameModuleBase::invalidateSolidBounds()
+{
+	// bounds will be rebuilt on the next trace
+	solidBoundsWorld = nullptr;
+}
+
+void CGameModuleBase::buildSolidBounds(CollisionWorld& cm)
+{
+	numSolidBounds = 0;
+	solidBoundsMaxWidth = 0.f;
+
+	for (size_t i = 0; i < numSolidEntities; ++i)
+	{
+		const entityState_t* ent = &solidEntities[i]->currentState;
+		solidBounds_t& bounds = solidBounds[numSolidBounds];
+
+		if (ent->solid == SOLID_BMODEL)
+		{
+			const clipHandle_t cmodel = cm.inlineModel(ent->modelindex);
+			if (!cmodel)
+			{
+				// not traced at all
+				continue;
+			}
+
+			cm.CM_ModelBounds(cmodel, bounds.mins, bounds.maxs);
+
+			const Vector& angles = ent->netangles;
+			if (angles[0] || angles[1] || angles[2])
+			{
+				// rotated model, use the enclosing sphere instead
+				Vector corner;
+				for (size_t j = 0; j < 3; ++j) {
+					corner[j] = std::max(fabsf(bounds.mins[j]), fabsf(bounds.maxs[j]));
+				}
+
+				const float radius = corner.length();
+				bounds.mins = Vector(-radius, -radius, -radius);
+				bounds.maxs = Vector(radius, radius, radius);
+			}
+		}
+		else
+		{
+			// encoded bbox
+			IntegerToBoundingBox(ent->solid, bounds.mins, bounds.maxs);
+		}
+
+		const Vector epsilon(SOLID_BOUNDS_EPSILON, SOLID_BOUNDS_EPSILON, SOLID_BOUNDS_EPSILON);
+		bounds.mins = ent->netorigin + bounds.mins - epsilon;
+		bounds.maxs = ent->netorigin + bounds.maxs + epsilon;
+		bounds.solidNum = i;
+
+		solidBoundsMaxWidth = std::max(solidBoundsMaxWidth, bounds.maxs[0] - bounds.mins[0]);
+		numSolidBounds++;
+	}
+
+	// sort along the x axis so queries only sweep a small range
+	std::sort(solidBounds, solidBounds + numSolidBounds, [](const solidBounds_t& a, const solidBounds_t& b) {
+		return a.mins[0] < b.mins[0];
+	});
+
+	solidBoundsWorld = &cm;
+}
+
+size_t CGameModuleBase::querySolidBounds(const Vector& mins, const Vector& maxs, uintptr_t* list) const
+{
+	const solidBounds_t* const endBounds = solidBounds + numSolidBounds;
+
+	// no entity can overlap if it starts further than the widest entity
+	const float startX = mins[0] - solidBoundsMaxWidth;
+	const solidBounds_t* it = std::lower_bound(solidBounds, endBounds, startX, [](const solidBounds_t& bounds, float x) {
+		return bounds.mins[0] < x;
+	});
+
+	size_t count = 0;
+	for (; it != endBounds && it->mins[0] <= maxs[0]; ++it)
+	{
+		if (it->maxs[0] >= mins[0]
+			&& it->mins[1] <= maxs[1] && it->maxs[1] >= mins[1]
+			&& it->mins[2] <= maxs[2] && it->maxs[2] >= mins[2])
+		{
+			list[count++] = it->solidNum;
+		}
+	}
+
+	// keep the same order as the solid list so results are identical to testing all entities
+	std::sort(list, list + count);
+	return count;
+}
+
 void CGameModuleBase::SCmd_Print(TokenParser& args)
 {
 	const char* text = args.GetString(true, false);
@@ -1963,10 +2099,10 @@ void CGameModule6::normalizePlayerState(playerState_t& ps)
 
 	// Convert AA PlayerMove flags to SH/BT flags
 	newPmFlags |= pmFlags & PMF_DUCKED;
-	for (size_t i = 2; i < 32; ++i)
+	for (size_t i = 2; i < 30; ++i)
 	{
-		if (pmFlags & (1 << (i + 2))) {
-			newPmFlags |= (1 << i);
+		if (pmFlags & (1u << (i + 2))) {
+			newPmFlags |= (1u << i);
 		}
 	}
 
@@ -13,6 +13,7 @@
 #include <fstream>
 #include <chrono>
 #include <cstring>
+#include <algorithm>
 
 using namespace MOHPC;
 using namespace MOHPC::Network;
@@ -95,14 +96,13 @@ outPacket_t::outPacket_t()
 }
 
 gameState_t::gameState_t()
-	: stringOffsets{ 0 }
-	, stringData{ 0 }
-	, dataCount(1)
-{}
+{
+	clear();
+}
 
 const char* gameState_t::getConfigString(csNum_t num) const
 {
-	if (num > MAX_CONFIGSTRINGS) {
+	if (num >= MAX_CONFIGSTRINGS) {
 		return nullptr;
 	}
 
@@ -116,46 +116,104 @@ const char* gameState_t::getConfigStringChecked(csNum_t num) const
 
 void gameState_t::setConfigString(csNum_t num, const char* configString, size_t len)
 {
-	const size_t newSz = dataCount + len;
-	if (num > MAX_CONFIGSTRINGS) {
+	if (num >= MAX_CONFIGSTRINGS) {
 		throw ClientError::MaxConfigStringException("gameState_t::setConfigString", num);
 	}
 
-	// going to  
-	// backup the game state
-	gameState_t oldGs = *this;
+	const size_t size = len + 1;
+	if (size <= stringCapacities[num])
+	{
+		// fits in the space of the previous string
+		char* dest = stringData + stringOffsets[num];
+		std::memmove(dest, configString, len);
+		dest[len] = 0;
+		return;
+	}
 
-	// leave the first 0 for empty/uninitialized strings
-	dataCount = 1;
+	if (!len)
+	{
+		// empty strings all point to the first null character
+		stringOffsets[num] = 0;
+		return;
+	}
 
-	// shrink the game state
-	for (size_t i = 0; i < MAX_CONFIGSTRINGS; i++)
+	// the previous space of the string is reclaimed on compaction
+	stringOffsets[num] = 0;
+	stringCapacities[num] = 0;
+
+	std::string copy;
+	if (dataCount + size > MAX_GAMESTATE_CHARS)
 	{
-		const char* dup;
+		if (configString >= stringData && configString < stringData + MAX_GAMESTATE_CHARS)
+		{
+			// the string is moved by compaction
+			copy.assign(configString, len);
+			configString = copy.c_str();
+		}
 
-		if (i == num) {
-			dup = configString;
+		compact();
+
+		if (dataCount + size > MAX_GAMESTATE_CHARS) {
+			throw ClientError::MaxGameStateCharsException(dataCount + len);
 		}
-		else {
-			dup = oldGs.stringData + oldGs.stringOffsets[i];
+	}
+
+	append(num, configString, len);
+}
+
+void gameState_t::append(csNum_t num, const char* configString, size_t len)
+{
+	stringOffsets[num] = (uint16_t)dataCount;
+	stringCapacities[num] = (uint16_t)(len + 1);
+	std::memcpy(stringData + dataCount, configString, len);
+	stringData[dataCount + len] = 0;
+	dataCount += len + 1;
+}
+
+void gameState_t::clear()
+{
+	// leave the first 0 for empty/uninitialized strings
+	stringData[0] = 0;
+	dataCount = 1;
+	std::memset(stringOffsets, 0, sizeof(stringOffsets));
+	std::memset(stringCapacities, 0, sizeof(stringCapacities));
+}
+
+void gameState_t::compact()
+{
+	csNum_t strings[MAX_CONFIGSTRINGS];
+	size_t numStrings = 0;
+
+	for (csNum_t i = 0; i < MAX_CONFIGSTRINGS; ++i)
+	{
+		if (!stringCapacities[i]) {
+			continue;
 		}
 
-		if (!dup[0])
+		if (!stringData[stringOffsets[i]])
 		{
-			// leave with the default empty string
+			// the space is not kept for empty strings
+			stringOffsets[i] = 0;
+			stringCapacities[i] = 0;
 			continue;
 		}
 
-		len = strlen(dup);
+		strings[numStrings++] = i;
+	}
 
-		if (len + dataCount >= MAX_GAMESTATE_CHARS) {
-			throw ClientError::MaxGameStateCharsException(newSz);
-		}
+	// strings are moved in buffer order so they are never overwritten before being moved
+	std::sort(strings, strings + numStrings, [this](csNum_t a, csNum_t b) { return stringOffsets[a] < stringOffsets[b]; });
+
+	dataCount = 1;
+	for (size_t i = 0; i < numStrings; ++i)
+	{
+		const csNum_t num = strings[i];
+		const size_t size = strlen(stringData + stringOffsets[num]) + 1;
 
-		// the string is correct, append it to the gameState string buffer
-		stringOffsets[i] = dataCount;
-		std::memcpy(stringData + dataCount, dup, len + 1);
-		dataCount += len + 1;
+		std::memmove(stringData + dataCount, stringData + stringOffsets[num], size);
+		stringOffsets[num] = (uint16_t)dataCount;
+		stringCapacities[num] = (uint16_t)size;
+		dataCount += size;
 	}
 }
 
@@ -180,6 +238,8 @@ MOHPC_OBJECT_DEFINITION(ClientGameConnection);
 ClientGameConnection::ClientGameConnection(const NetworkManagerPtr& inNetworkManager, const INetchanPtr& inNetchan, const NetAddrPtr& inAdr, uint32_t challengeResponse, const protocolType_c& protoType, const ClientInfoPtr& cInfo)
 	: ITickableNetwork(inNetworkManager)
 	, netchan(inNetchan)	
+	, channelMetrics(inNetchan->getMetrics())
+	, protocol(protoType)
 	, adr(inAdr)
 	, realTimeStart(0)
 	, serverStartTime(0)
@@ -207,6 +267,9 @@ ClientGameConnection::ClientGameConnection(const NetworkManagerPtr& inNetworkMan
 	, serverCmdStrings{ 0 }
 	, userInfo(cInfo)
 {
+	// add the traffic of this connection to the total
+	channelMetrics->setParent(inNetworkManager->getTotalMetrics());
+
 	ClientImports imports;
 	fillClientImports(imports);
 
@@ -296,6 +359,8 @@ void ClientGameConnection::tick(uint64_t deltaTime, uint64_t currentTime)
 
 	size_t count = 0;
 
+	MemoryTagScope tagScope(memoryTag_e::Network);
+
 	IUdpSocket* socket = getNetchan()->getRawSocket();
 	// Loop until there is no valid data
 	// or the max number of processed packets has reached the limit
@@ -308,10 +373,12 @@ void ClientGameConnection::tick(uint64_t deltaTime, uint64_t currentTime)
 		uint32_t sequenceNum;
 		NetAddrPtr from;
 
-		if(getNetchan()->receive(from, stream, sequenceNum))
+		// a reassembled message is read in place from the channel
+		IMessageStream* messageStream = getNetchan()->receive(from, stream, sequenceNum);
+		if(messageStream)
 		{
 			// Prepare for reading
-			MSG msg(stream, msgMode_e::Reading);
+			MSG msg(*messageStream, msgMode_e::Reading);
 			if(sequenceNum != -1)
 			{
 				// received connection packet
@@ -347,6 +414,9 @@ void ClientGameConnection::tick(uint64_t deltaTime, uint64_t currentTime)
 
 		MOHPC_LOG(Error, "ClientGameModule exception: %s", e.what().c_str());
 	}
+
+	// configstrings from the gamestate and from server commands of this tick
+	flushConfigStringChanges();
 }
 
 void ClientGameConnection::setTimeout(size_t inTimeoutTime)
@@ -385,6 +455,7 @@ void ClientGameConnection::receive(const NetAddrPtr& from, MSG& msg, uint64_t cu
 
 	// Needs to be reset as the stream has been decoded
 	msg.Reset();
+	const size_t startBits = msg.GetSerializedBits();
 	// Serialize again to read the proper number of bits
 	msg.ReadInteger();
 
@@ -407,6 +478,10 @@ void ClientGameConnection::receive(const NetAddrPtr& from, MSG& msg, uint64_t cu
 	{
 		MOHPC_LOG(Error, "Tried to read past end of server message (length %d)", stream.GetLength());
 	}
+
+	// everything after the sequence number is compressed
+	metrics.compressedBytesIn.add(stream.GetLength() - sizeof(uint32_t));
+	metrics.uncompressedBytesIn.add((msg.GetSerializedBits() - startBits + 7) / 8);
 }
 
 void ClientGameConnection::receiveConnectionLess(const NetAddrPtr& from, MSG& msg)
@@ -525,11 +600,13 @@ void ClientGameConnection::parseGameState(MSG& msg)
 {
 	MOHPC_LOG(Verbose, "Received gamestate");
 
+	metrics.gameStates.add();
+
 	MsgTypesHelper msgHelper(msg);
 
 	serverCommandSequence = msg.ReadInteger();
 
-	gameState.dataCount = 1;
+	gameState.clear();
 	for (;;)
 	{
 		const svc_ops_e cmd = msg.ReadByteEnum<svc_ops_e>();
@@ -543,7 +620,7 @@ void ClientGameConnection::parseGameState(MSG& msg)
 		{
 			const csNum_t stringNum = msg.ReadUShort();
 
-			if (stringNum > MAX_CONFIGSTRINGS) {
+			if (stringNum >= MAX_CONFIGSTRINGS) {
 				throw ClientError::MaxConfigStringException("gameStateParsing", stringNum);
 			}
 
@@ -599,6 +676,9 @@ void ClientGameConnection::parseGameState(MSG& msg)
 
 void ClientGameConnection::parseSnapshot(MSG& msg, uint64_t currentTime)
 {
+	using namespace std::chrono;
+	const steady_clock::time_point parseStart = steady_clock::now();
+
 	ClientSnapshot newSnap;
 	newSnap.serverCommandNum = serverCommandSequence;
 
@@ -640,12 +720,45 @@ void ClientGameConnection::parseSnapshot(MSG& msg, uint64_t currentTime)
 	setNewSnap(newSnap);
 	calculatePing(currentTime);
 
+	metrics.snapshots.add();
+	metrics.ping.record(currentSnap.ping);
+
 	// read and unpack radar info on SH/BT
 	readNonPVSClient(currentSnap.ps.getRadarInfo());
 
+	publishSnapshot();
+
+	// the time spent in handlers is not part of parsing
+	metrics.snapshotParseTime.record(duration_cast<microseconds>(steady_clock::now() - parseStart).count());
+
 	getHandlerList().snapshotReceivedHandler.broadcast(currentSnap);
 }
 
+void ClientGameConnection::publishSnapshot()
+{
+	if (!snapshotPublisher.isEnabled()) {
+		return;
+	}
+
+	SnapshotInfo* snap = snapshotPublisher.beginPublish();
+	if (!snap)
+	{
+		// readers are holding every slot
+		return;
+	}
+
+	if (!getSnapshot(currentSnap.messageNum, *snap))
+	{
+		snapshotPublisher.cancelPublish();
+		return;
+	}
+
+	// the ping is calculated after the snap is backed up
+	snap->ping = currentSnap.ping;
+
+	snapshotPublisher.endPublish(currentSnap.messageNum);
+}
+
 void ClientGameConnection::parsePacketEntities(MSG& msg, const ClientSnapshot* oldFrame, ClientSnapshot* newFrame)
 {
 	newFrame->parseEntitiesNum = parseEntitiesNum;
@@ -1179,6 +1292,9 @@ void ClientGameConnection::writePacket(uint64_t currentTime)
 	// flush out pending data
 	msg.Flush();
 
+	metrics.compressedBytesOut.add(stream.GetLength());
+	metrics.uncompressedBytesOut.add((msg.GetSerializedBits() + 7) / 8);
+
 	static constexpr size_t encodeStart = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint32_t);
 
 	stream.Seek(encodeStart, IMessageStream::SeekPos::Begin);
@@ -1572,6 +1688,16 @@ const gameState_t& ClientGameConnection::getGameState() const
 	return gameState;
 }
 
+const ClientMetrics& ClientGameConnection::getMetrics() const
+{
+	return metrics;
+}
+
+const ChannelMetricsPtr& ClientGameConnection::getChannelMetrics() const
+{
+	return channelMetrics;
+}
+
 ReadOnlyInfo ClientGameConnection::getServerSystemInfo() const
 {
 	return gameState.getConfigString(CS_SYSTEMINFO);
@@ -1670,6 +1796,11 @@ bool ClientGameConnection::getSnapshot(uintptr_t snapshotNum, SnapshotInfo& outS
 	return true;
 }
 
+SnapshotPublisher& ClientGameConnection::getSnapshotPublisher()
+{
+	return snapshotPublisher;
+}
+
 uint64_t ClientGameConnection::getServerStartTime() const
 {
 	return serverStartTime;
@@ -1695,6 +1826,16 @@ uint32_t ClientGameConnection::getClientNum() const
 	return clientNum;
 }
 
+const protocolType_c& ClientGameConnection::getProtocol() const
+{
+	return protocol;
+}
+
+uint32_t ClientGameConnection::getChallenge() const
+{
+	return encoder->getChallenge();
+}
+
 bool ClientGameConnection::getUserCmd(uintptr_t cmdNum, usercmd_t& outCmd) const
 {
 	// the usercmd has been overwritten in the wrapping
@@ -1832,6 +1973,19 @@ void ClientGameConnection::notifyConfigStringChange(csNum_t num, const char* new
 
 	// notify about the change
 	handlerList.configStringHandler.broadcast(num, newString);
+
+	// batched until the end of the tick
+	changedConfigStrings.set(num);
+}
+
+void ClientGameConnection::flushConfigStringChanges()
+{
+	if (changedConfigStrings.none()) {
+		return;
+	}
+
+	handlerList.configStringsChangedHandler.broadcast(changedConfigStrings, gameState);
+	changedConfigStrings.reset();
 }
 
 void ClientGameConnection::wipeChannel()
@@ -2091,6 +2245,7 @@ void ClientGameConnection::fillClientImports(ClientImports& imports)
 	imports.readStringMessage			= std::bind(&ClientGameConnection::readStringMessage, this, _1);
 	imports.addReliableCommand			= std::bind(&ClientGameConnection::addReliableCommand, this, _1);
 	imports.getUserInfo					= std::bind(static_cast<const ClientInfoPtr&(ClientGameConnection::*)()>(&ClientGameConnection::getUserInfo), this);
+	imports.getMetrics					= [this]() -> ClientMetrics& { return metrics; };
 }
 
 MOHPC_OBJECT_DEFINITION(ClientInfo);
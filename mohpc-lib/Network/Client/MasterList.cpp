@@ -55,6 +55,20 @@ void Network::ServerList::fetch(FoundServerCallback&& callback, MasterServerDone
 	sendRequest(makeShared<Request_FetchServers>(getManager(), gameType, std::move(callback), std::move(doneCallback)));
 }
 
+void Network::ServerList::fetchAddresses(FoundServerAddressesCallback&& callback, MasterServerDone&& doneCallback)
+{
+	sendRequest(makeShared<Request_FetchServers>(getManager(), gameType, std::move(callback), std::move(doneCallback)));
+}
+
+IServerPtr Network::ServerList::createServer(const serverAddress_t& address) const
+{
+	NetAddr4Ptr adr = makeShared<NetAddr4>();
+	memcpy(adr->ip, address.ip, sizeof(adr->ip));
+	adr->port = address.port;
+
+	return makeShared<GSServer>(getManager(), adr);
+}
+
 void Network::ServerList::tick(uint64_t deltaTime, uint64_t currentTime)
 {
 	handler.handle();
@@ -228,7 +242,6 @@ Network::ServerList::Request_FetchServers::Request_FetchServers(const NetworkMan
 	, game(gameName[(uint8_t)inGameType])
 	, callback(std::move(inCallback))
 	, doneCallback(std::move(inDoneCallback))
-	, pendingLen(0)
 {
 	if (!callback)
 	{
@@ -239,6 +252,22 @@ Network::ServerList::Request_FetchServers::Request_FetchServers(const NetworkMan
 	}
 }
 
+Network::ServerList::Request_FetchServers::Request_FetchServers(const NetworkManagerPtr& inNetworkManager, gameListType_e inGameType, FoundServerAddressesCallback&& inCallback, MasterServerDone&& inDoneCallback)
+	: networkManager(inNetworkManager)
+	, key(gameKeys[(uint8_t)inGameType])
+	, game(gameName[(uint8_t)inGameType])
+	, addressesCallback(std::move(inCallback))
+	, doneCallback(std::move(inDoneCallback))
+{
+	if (!addressesCallback)
+	{
+		using namespace std::placeholders;
+		callback = std::bind(&Request_FetchServers::nullCallback, this, _1);
+
+		MOHPC_LOG(Warning, "No callback was given for fetching server addresses! Fallback to a null callback");
+	}
+}
+
 void Network::ServerList::Request_FetchServers::generateInfo(Info& info)
 {
 	info.SetValueForKey("list", "cmp");
@@ -248,46 +277,49 @@ void Network::ServerList::Request_FetchServers::generateInfo(Info& info)
 
 SharedPtr<IRequestBase> Network::ServerList::Request_FetchServers::process(RequestData& data)
 {
-	char dataStr[512 + sizeof(pendingData)];
-
-	memcpy(dataStr, pendingData, pendingLen);
-
-	const size_t len = data.stream.GetLength();
-	data.stream.Read(dataStr + pendingLen, len - pendingLen);
+	uint8_t buffer[512];
 
 	//EncryptionLevel2 enc;
-	//enc.decode(key, (unsigned char*)dataStr + pendingLen, len - pendingLen);
+	//enc.decode(key, buffer, len);
 
-	const size_t totalLen = len + pendingLen;
-	pendingLen = totalLen % 6;
-	const size_t maxlen = len - pendingLen;
+	// decode everything that was received at once, the list is sent in many pieces
+	addresses.clear();
 
-	const char* p = dataStr;
-	const char* endbuf = dataStr + maxlen;
-	while (p < endbuf)
+	size_t len = data.stream.GetLength();
+	while (len && !decoder.isFinished())
 	{
-		if (!strncmp(p, "\\final\\", 7))
-		{
-			// finished processing
-			if (doneCallback) doneCallback();
-			return nullptr;
+		const size_t readLen = len < sizeof(buffer) ? len : sizeof(buffer);
+		data.stream.Read(buffer, readLen);
+		decoder.decode(buffer, readLen, addresses);
+		len -= readLen;
+	}
+
+	if (addressesCallback)
+	{
+		if (addresses.size()) {
+			addressesCallback(addresses.data(), addresses.size());
 		}
+	}
+	else
+	{
+		for (const serverAddress_t& address : addresses)
+		{
+			// the master server only return IPv4 entries
+			NetAddr4Ptr adr = makeShared<NetAddr4>();
+			memcpy(adr->ip, address.ip, sizeof(adr->ip));
+			adr->port = address.port;
 
-		const uint8_t ip[4] = { (uint8_t)*p++, (uint8_t)*p++, (uint8_t)*p++, (uint8_t)*p++ };
-		const uint16_t port = rotl(*(uint16_t*)p, 8);
-		p += sizeof(port);
-
-		// the master server only return IPv4 entries
-		// for now, only use netadr4_t
-		NetAddr4Ptr adr = makeShared<NetAddr4>();
-		memcpy(adr->ip, ip, sizeof(adr->ip));
-		adr->port = port;
-	
-		IServerPtr ptr = makeShared<GSServer>(networkManager, adr);
-		callback(ptr);
+			IServerPtr ptr = makeShared<GSServer>(networkManager, adr);
+			callback(ptr);
+		}
 	}
 
-	memcpy(pendingData, p, pendingLen);
+	if (decoder.isFinished())
+	{
+		// finished processing
+		if (doneCallback) doneCallback();
+		return nullptr;
+	}
 
 	return shared_from_this();
 }
@@ -0,0 +1,104 @@
+#include <MOHPC/Network/Client/MasterListDecoder.h>
+
+#include <string.h>
+
+using namespace MOHPC;
+using namespace Network;
+
+static const char finalMarker[] = "\\final\\";
+static constexpr size_t FINAL_SIZE = sizeof(finalMarker) - 1;
+
+static_assert(FINAL_SIZE <= MasterListDecoder::RECORD_SIZE + 1, "The pending data must be able to hold the end marker");
+
+MasterListDecoder::MasterListDecoder()
+	: pendingLen(0)
+	, finished(false)
+{
+}
+
+bool MasterListDecoder::decode(const uint8_t* data, size_t size, std::vector<serverAddress_t>& addresses)
+{
+	if (finished) {
+		return true;
+	}
+
+	if (pendingLen)
+	{
+		// complete the record that was cut at the end of the previous piece
+		const size_t needed = FINAL_SIZE - pendingLen < size ? FINAL_SIZE - pendingLen : size;
+		memcpy(pendingData + pendingLen, data, needed);
+
+		const size_t consumed = decodeRecords(pendingData, pendingLen + needed, addresses);
+		if (!consumed)
+		{
+			// still not enough
+			pendingLen += needed;
+			return finished;
+		}
+
+		data += consumed - pendingLen;
+		size -= consumed - pendingLen;
+		pendingLen = 0;
+
+		if (finished) {
+			return true;
+		}
+	}
+
+	addresses.reserve(addresses.size() + size / RECORD_SIZE);
+
+	const size_t consumed = decodeRecords(data, size, addresses);
+	if (!finished)
+	{
+		pendingLen = size - consumed;
+		memcpy(pendingData, data + consumed, pendingLen);
+	}
+
+	return finished;
+}
+
+size_t MasterListDecoder::decodeRecords(const uint8_t* data, size_t size, std::vector<serverAddress_t>& addresses)
+{
+	const uint8_t* p = data;
+	const uint8_t* end = data + size;
+
+	while ((size_t)(end - p) >= RECORD_SIZE)
+	{
+		if (*p == finalMarker[0])
+		{
+			// a valid address can start with the same byte
+			if ((size_t)(end - p) < FINAL_SIZE) {
+				break;
+			}
+
+			if (!memcmp(p, finalMarker, FINAL_SIZE))
+			{
+				finished = true;
+				return p - data + FINAL_SIZE;
+			}
+		}
+
+		serverAddress_t address;
+		address.ip[0] = p[0];
+		address.ip[1] = p[1];
+		address.ip[2] = p[2];
+		address.ip[3] = p[3];
+		address.port = (uint16_t)((p[4] << 8) | p[5]);
+		addresses.push_back(address);
+
+		p += RECORD_SIZE;
+	}
+
+	return p - data;
+}
+
+bool MasterListDecoder::isFinished() const
+{
+	return finished;
+}
+
+void MasterListDecoder::reset()
+{
+	pendingLen = 0;
+	finished = false;
+}
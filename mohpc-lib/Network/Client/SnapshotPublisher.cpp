@@ -0,0 +1,235 @@
+#include <MOHPC/Network/Client/SnapshotPublisher.h>
+
+#include <cassert>
+
+using namespace MOHPC;
+using namespace Network;
+
+// set in the reference count while the network thread writes the slot
+static constexpr uint32_t WRITING_FLAG = 0x80000000;
+// the latest value holds the slot number in its lowest bits
+static constexpr uint64_t SLOT_BITS = 4;
+static constexpr uint64_t SLOT_MASK = (1 << SLOT_BITS) - 1;
+
+static_assert(SnapshotPublisher::NUM_SLOTS <= SLOT_MASK + 1, "Too many slots for the latest value");
+
+struct SnapshotPublisher::slot_t
+{
+	// number of readers, or WRITING_FLAG
+	std::atomic<uint32_t> refCount;
+	std::atomic<uint64_t> publication;
+	uint32_t messageNum;
+	SnapshotInfo snap;
+
+public:
+	slot_t()
+		: refCount(0)
+		, publication(0)
+		, messageNum(0)
+	{}
+};
+
+PublishedSnapshotRef::PublishedSnapshotRef()
+	: publisher(nullptr)
+	, slotNum(0)
+{
+}
+
+PublishedSnapshotRef::PublishedSnapshotRef(const SnapshotPublisher* inPublisher, size_t inSlotNum)
+	: publisher(inPublisher)
+	, slotNum(inSlotNum)
+{
+}
+
+PublishedSnapshotRef::PublishedSnapshotRef(PublishedSnapshotRef&& other)
+	: publisher(other.publisher)
+	, slotNum(other.slotNum)
+{
+	other.publisher = nullptr;
+}
+
+PublishedSnapshotRef& PublishedSnapshotRef::operator=(PublishedSnapshotRef&& other)
+{
+	if (this != &other)
+	{
+		reset();
+
+		publisher = other.publisher;
+		slotNum = other.slotNum;
+		other.publisher = nullptr;
+	}
+
+	return *this;
+}
+
+PublishedSnapshotRef::~PublishedSnapshotRef()
+{
+	reset();
+}
+
+void PublishedSnapshotRef::reset()
+{
+	if (publisher)
+	{
+		publisher->release(slotNum);
+		publisher = nullptr;
+	}
+}
+
+const SnapshotInfo* PublishedSnapshotRef::get() const
+{
+	return publisher ? &publisher->slots[slotNum].snap : nullptr;
+}
+
+const SnapshotInfo* PublishedSnapshotRef::operator->() const
+{
+	return get();
+}
+
+const SnapshotInfo& PublishedSnapshotRef::operator*() const
+{
+	return *get();
+}
+
+PublishedSnapshotRef::operator bool() const
+{
+	return publisher != nullptr;
+}
+
+uint32_t PublishedSnapshotRef::getMessageNum() const
+{
+	return publisher ? publisher->slots[slotNum].messageNum : 0;
+}
+
+uint64_t PublishedSnapshotRef::getPublication() const
+{
+	return publisher ? publisher->slots[slotNum].publication.load(std::memory_order_relaxed) : 0;
+}
+
+SnapshotPublisher::SnapshotPublisher()
+	: latest(0)
+	, numPublished(0)
+	, numSkipped(0)
+	, writingSlot(NUM_SLOTS)
+	, nextSlot(0)
+{
+}
+
+SnapshotPublisher::~SnapshotPublisher()
+{
+}
+
+void SnapshotPublisher::enable()
+{
+	if (!slots) {
+		slots = std::unique_ptr<slot_t[]>(new slot_t[NUM_SLOTS]);
+	}
+}
+
+bool SnapshotPublisher::isEnabled() const
+{
+	return slots != nullptr;
+}
+
+SnapshotInfo* SnapshotPublisher::beginPublish()
+{
+	assert(writingSlot == NUM_SLOTS);
+
+	if (!slots) {
+		return nullptr;
+	}
+
+	const uint64_t latestValue = latest.load(std::memory_order_relaxed);
+
+	for (size_t i = 0; i < NUM_SLOTS; ++i)
+	{
+		const size_t slotNum = (nextSlot + i) % NUM_SLOTS;
+		if (latestValue && slotNum == (latestValue & SLOT_MASK))
+		{
+			// readers must always find the latest one intact
+			continue;
+		}
+
+		// a slot can only be taken if nobody is reading it
+		uint32_t expected = 0;
+		if (slots[slotNum].refCount.compare_exchange_strong(expected, WRITING_FLAG, std::memory_order_acquire))
+		{
+			writingSlot = slotNum;
+			nextSlot = slotNum + 1;
+			return &slots[slotNum].snap;
+		}
+	}
+
+	numSkipped.fetch_add(1, std::memory_order_relaxed);
+	return nullptr;
+}
+
+void SnapshotPublisher::endPublish(uint32_t messageNum)
+{
+	assert(writingSlot < NUM_SLOTS);
+
+	slot_t& slot = slots[writingSlot];
+	const uint64_t publication = numPublished.load(std::memory_order_relaxed) + 1;
+
+	slot.messageNum = messageNum;
+	slot.publication.store(publication, std::memory_order_relaxed);
+	// readers that see the flag cleared also see the content
+	slot.refCount.fetch_sub(WRITING_FLAG, std::memory_order_release);
+
+	latest.store((publication << SLOT_BITS) | writingSlot, std::memory_order_release);
+	numPublished.store(publication, std::memory_order_relaxed);
+
+	writingSlot = NUM_SLOTS;
+}
+
+void SnapshotPublisher::cancelPublish()
+{
+	assert(writingSlot < NUM_SLOTS);
+
+	slots[writingSlot].refCount.fetch_sub(WRITING_FLAG, std::memory_order_release);
+	writingSlot = NUM_SLOTS;
+}
+
+PublishedSnapshotRef SnapshotPublisher::acquireLatest() const
+{
+	if (!slots) {
+		return PublishedSnapshotRef();
+	}
+
+	for (;;)
+	{
+		const uint64_t latestValue = latest.load(std::memory_order_acquire);
+		if (!latestValue)
+		{
+			// nothing published yet
+			return PublishedSnapshotRef();
+		}
+
+		const size_t slotNum = latestValue & SLOT_MASK;
+		slot_t& slot = slots[slotNum];
+
+		const uint32_t previousCount = slot.refCount.fetch_add(1, std::memory_order_acquire);
+		if (!(previousCount & WRITING_FLAG) && slot.publication.load(std::memory_order_relaxed) == (latestValue >> SLOT_BITS)) {
+			return PublishedSnapshotRef(this, slotNum);
+		}
+
+		// the slot was reused after it was loaded, try again with the new latest one
+		slot.refCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+uint64_t SnapshotPublisher::getNumPublished() const
+{
+	return numPublished.load(std::memory_order_relaxed);
+}
+
+uint64_t SnapshotPublisher::getNumSkipped() const
+{
+	return numSkipped.load(std::memory_order_relaxed);
+}
+
+void SnapshotPublisher::release(size_t slotNum) const
+{
+	// the network thread that takes the slot next must see the reads done
+	slots[slotNum].refCount.fetch_sub(1, std::memory_order_release);
+}
@@ -140,3 +140,8 @@ uint32_t Encoding::getSecretKey() const
 {
 	return secretKey;
 }
+
+uint32_t Encoding::getChallenge() const
+{
+	return challenge;
+}
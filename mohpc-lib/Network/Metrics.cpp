@@ -0,0 +1,181 @@
+#include <MOHPC/Network/Metrics.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace MOHPC;
+using namespace Network;
+
+MetricHistogram::MetricHistogram()
+{
+	reset();
+}
+
+size_t MetricHistogram::getBucketNum(uint64_t value)
+{
+	if (!value) {
+		return 0;
+	}
+
+	// number of bits needed to represent the value
+#if defined(__GNUC__) || defined(__clang__)
+	const size_t numBits = 64 - __builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	const size_t numBits = index + 1;
+#else
+	size_t numBits = 0;
+	for (; value; value >>= 1) {
+		++numBits;
+	}
+#endif
+
+	return numBits < NUM_BUCKETS ? numBits : NUM_BUCKETS - 1;
+}
+
+uint64_t MetricHistogram::getBucketLimit(size_t bucketNum)
+{
+	if (bucketNum >= NUM_BUCKETS - 1) {
+		return UINT64_MAX;
+	}
+
+	return (uint64_t(1) << bucketNum) - 1;
+}
+
+void MetricHistogram::record(uint64_t value)
+{
+	buckets[getBucketNum(value)].fetch_add(1, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(value, std::memory_order_relaxed);
+
+	uint64_t currentMax = max.load(std::memory_order_relaxed);
+	while (value > currentMax && !max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed));
+}
+
+uint64_t MetricHistogram::getCount() const
+{
+	return count.load(std::memory_order_relaxed);
+}
+
+uint64_t MetricHistogram::getSum() const
+{
+	return sum.load(std::memory_order_relaxed);
+}
+
+uint64_t MetricHistogram::getMax() const
+{
+	return max.load(std::memory_order_relaxed);
+}
+
+uint64_t MetricHistogram::getBucketCount(size_t bucketNum) const
+{
+	return buckets[bucketNum].load(std::memory_order_relaxed);
+}
+
+uint64_t MetricHistogram::getPercentile(double percentile) const
+{
+	// the total is taken from the buckets, the count may be updated in the meantime
+	uint64_t bucketCounts[NUM_BUCKETS];
+	uint64_t total = 0;
+	for (size_t i = 0; i < NUM_BUCKETS; ++i)
+	{
+		bucketCounts[i] = getBucketCount(i);
+		total += bucketCounts[i];
+	}
+
+	if (!total) {
+		return 0;
+	}
+
+	uint64_t rank = (uint64_t)(total * percentile / 100.0 + 0.5);
+	if (rank < 1) rank = 1;
+
+	const uint64_t maxValue = getMax();
+
+	uint64_t cumulated = 0;
+	for (size_t i = 0; i < NUM_BUCKETS; ++i)
+	{
+		cumulated += bucketCounts[i];
+		if (cumulated >= rank)
+		{
+			const uint64_t limit = getBucketLimit(i);
+			// no value above the highest recorded one
+			return limit < maxValue ? limit : maxValue;
+		}
+	}
+
+	return maxValue;
+}
+
+void MetricHistogram::reset()
+{
+	for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+		buckets[i].store(0, std::memory_order_relaxed);
+	}
+
+	count.store(0, std::memory_order_relaxed);
+	sum.store(0, std::memory_order_relaxed);
+	max.store(0, std::memory_order_relaxed);
+}
+
+MOHPC_OBJECT_DEFINITION(ChannelMetrics);
+
+ChannelMetrics::ChannelMetrics()
+{
+}
+
+ChannelMetrics::ChannelMetrics(const ChannelMetricsPtr& inParent)
+	: parent(inParent)
+{
+}
+
+void ChannelMetrics::setParent(const ChannelMetricsPtr& newParent)
+{
+	parent = newParent;
+}
+
+void ChannelMetrics::packetReceived(size_t size)
+{
+	packetsIn.add();
+	bytesIn.add(size);
+	if (parent) parent->packetReceived(size);
+}
+
+void ChannelMetrics::packetSent(size_t size)
+{
+	packetsOut.add();
+	bytesOut.add(size);
+	if (parent) parent->packetSent(size);
+}
+
+void ChannelMetrics::packetsDropped(size_t numPackets)
+{
+	droppedPackets.add(numPackets);
+	if (parent) parent->packetsDropped(numPackets);
+}
+
+void ChannelMetrics::packetOutOfOrder()
+{
+	outOfOrderPackets.add();
+	if (parent) parent->packetOutOfOrder();
+}
+
+void ChannelMetrics::fragmentReceived()
+{
+	fragmentsIn.add();
+	if (parent) parent->fragmentReceived();
+}
+
+void ChannelMetrics::fragmentSent()
+{
+	fragmentsOut.add();
+	if (parent) parent->fragmentSent();
+}
+
+void ChannelMetrics::messageReassembled()
+{
+	reassembledMessages.add();
+	if (parent) parent->messageReassembled();
+}
@@ -742,6 +742,9 @@ void MOHPC::SerializablePlayerState::LoadDelta(MSG& msg, const ISerializableMess
 
 	// Serialize the number of changes
 	const uint8_t lc = msg.ReadByte();
+	if (lc > numFields) {
+		throw BadEntityFieldCountException(lc);
+	}
 
 	size_t i;
 	const netField_t* field;
@@ -781,7 +784,7 @@ void MOHPC::SerializablePlayerState::LoadDelta(MSG& msg, const ISerializableMess
 	if (fromPS)
 	{
 		// assign unchanged fields accordingly
-		for (i = lc, field = &playerStateFields[lc]; i < numFields; i++, field++)
+		for (i = lc, field = playerStateFields + lc; i < numFields; i++, field++)
 		{
 			const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->offset);
 			uint8_t* toF = (uint8_t*)((uint8_t*)GetState() + field->offset);
@@ -944,7 +947,7 @@ void MOHPC::SerializablePlayerState_ver15::LoadDelta(MSG& msg, const ISerializab
 	if (fromPS)
 	{
 		// assign unchanged fields accordingly
-		for (i = lc, field = &playerStateFields_ver15[lc]; i < numFields; i++, field++)
+		for (i = lc, field = playerStateFields_ver15 + lc; i < numFields; i++, field++)
 		{
 			const uint8_t* fromF = (const uint8_t*)((const uint8_t*)fromPS + field->offset);
 			uint8_t* toF = (uint8_t*)((uint8_t*)GetState() + field->offset);
@@ -1067,7 +1070,7 @@ void MOHPC::SerializableEntityState::SaveDelta(MSG& msg, const ISerializableMess
 
 	if (!hasDelta)
 	{
-		state = *(entityState_t*)from;
+		state = *fromEnt;
 		return;
 	}
 
@@ -1137,7 +1140,8 @@ void MOHPC::SerializableEntityState::LoadDelta(MSG& msg, const ISerializableMess
 {
 	MsgTypesHelper msgHelper(msg);
 
-	entityState_t* fromEnt = ((SerializableEntityState*)from)->GetState();
+	static entityState_t nullstate;
+	entityState_t* fromEnt = from ? ((SerializableEntityState*)from)->GetState() : &nullstate;
 
 	const bool removed = msg.ReadBool();
 	if (removed)
@@ -1549,7 +1553,8 @@ void MOHPC::EntityField::WriteNumberEntityField(MSG& msg, intptr_t bits, const v
 	}
 	else
 	{
-		const bool hasValue = memcmp(toF, "", size);
+		static const uint8_t zeroValue[sizeof(uint32_t)] = { 0 };
+		const bool hasValue = memcmp(toF, zeroValue, size);
 		msg.WriteBool(hasValue);
 
 		if (hasValue)
@@ -0,0 +1,303 @@
+#include <MOHPC/Network/Server/CaptureGenerator.h>
+#include <MOHPC/Network/Server/ServerHost.h>
+#include <MOHPC/Network/Channel.h>
+#include <MOHPC/Network/Configstring.h>
+#include <MOHPC/Network/InfoTypes.h>
+#include <MOHPC/Network/SerializableTypes.h>
+#include <MOHPC/Misc/MSG/Codec.h>
+#include <MOHPC/Misc/MSG/MSG.h>
+#include <MOHPC/Misc/MSG/Stream.h>
+#include <MOHPC/Math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace MOHPC;
+using namespace MOHPC::Network;
+
+// entities after the clients
+static constexpr entityNum_t firstEntityNum = MAX_CLIENTS;
+static constexpr size_t maxEntities = ENTITYNUM_NONE - firstEntityNum;
+static constexpr size_t numModels = 16;
+static constexpr uint32_t serverStartTime = 10000;
+
+static const char* modelNames[numModels] =
+{
+	"models/player/allied_airborne.tik", "models/player/allied_manon.tik", "models/player/allied_pilot.tik",
+	"models/player/allied_sas.tik", "models/player/american_army.tik", "models/player/american_ranger.tik",
+	"models/player/german_afrika_officer.tik", "models/player/german_afrika_private.tik", "models/player/german_elite_officer.tik",
+	"models/player/german_elite_sentry.tik", "models/player/german_kradshutzen.tik", "models/player/german_panzer_grenadier.tik",
+	"models/player/german_panzer_obershutze.tik", "models/player/german_panzer_shutze.tik", "models/player/german_panzer_tankcommander.tik",
+	"models/player/german_scientist.tik"
+};
+
+static entityState_t getNullEntityState()
+{
+	// same as the state the client parses baselines from
+	entityState_t nullState;
+	nullState.alpha = 1.0f;
+	nullState.scale = 1.0f;
+	nullState.parent = ENTITYNUM_NONE;
+	nullState.tag_num = -1;
+	nullState.constantLight = -1;
+	nullState.renderfx = 16;
+	for (size_t i = 0; i < entityState_t::NUM_BONE_CONTROLLERS; ++i) {
+		nullState.bone_tag[i] = -1;
+	}
+
+	return nullState;
+}
+
+static void writeConfigString(MSG& msg, csNum_t num, const char* value)
+{
+	msg.WriteByte((uint8_t)svc_ops_e::Configstring);
+	msg.WriteUShort(num);
+	msg.WriteString(value);
+}
+
+static void addMessage(PacketCapture& capture, uint64_t captureTime, const uint8_t* message, size_t len, uint32_t sequenceNum)
+{
+	if (len < FRAGMENT_SIZE)
+	{
+		capture.addPacket(captureTime, captureDirection_e::Received, message, len);
+		return;
+	}
+
+	// split big messages the same way the channel does, the sequence number is not part of the fragments
+	const uint8_t* data = message + sizeof(uint32_t);
+	const size_t dataLen = len - sizeof(uint32_t);
+
+	fragment_t fragmentStart = 0;
+	fragmentLen_t fragmentLength;
+	// a message that is a multiple of the fragment size ends with an empty fragment
+	do
+	{
+		fragmentLength = (fragmentLen_t)std::min<size_t>(dataLen - fragmentStart, FRAGMENT_SIZE);
+
+		uint8_t fragment[PACKET_HEADER + FRAGMENT_SIZE];
+		FixedDataMessageStream stream(fragment, sizeof(fragment));
+		MSG msg(stream, msgMode_e::Writing);
+		msg.SetCodec(MessageCodecs::OOB);
+		msg.WriteUInteger(sequenceNum | FRAGMENT_BIT);
+		msg.WriteUInteger(fragmentStart);
+		msg.WriteUShort(fragmentLength);
+		msg.Flush();
+		stream.Write(data + fragmentStart, fragmentLength);
+
+		capture.addPacket(captureTime, captureDirection_e::Received, fragment, stream.GetPosition());
+		fragmentStart += fragmentLength;
+	} while (fragmentLength == FRAGMENT_SIZE);
+}
+
+static void moveEntity(entityState_t& state, size_t entityIndex, uint32_t serverTime)
+{
+	// each entity runs in its own circle
+	const float angle = (float)(serverTime % 36000) / 100.f + entityIndex * 7.f;
+	const float radians = angle * 3.14159265f / 180.f;
+	const float radius = 64.f + (entityIndex % 32) * 32.f;
+
+	state.netorigin = Vector(cosf(radians) * radius, sinf(radians) * radius, (float)(entityIndex % 8) * 16.f);
+	state.origin = state.netorigin;
+	state.netangles = Vector(0.f, fmodf(angle + 90.f, 360.f), 0.f);
+	state.angles = state.netangles;
+	state.frameInfo[0].time = (serverTime % 1000) / 1000.f;
+}
+
+CaptureGenerator::CaptureGenerator(uint32_t inChallenge)
+	: challenge(inChallenge)
+	, frameTime(50)
+	, numEntities(64)
+	, solidEntities(false)
+{
+}
+
+void CaptureGenerator::setNumEntities(size_t newNumEntities)
+{
+	numEntities = newNumEntities < maxEntities ? newNumEntities : maxEntities;
+}
+
+void CaptureGenerator::setFrameTime(uint32_t newFrameTime)
+{
+	frameTime = newFrameTime;
+}
+
+void CaptureGenerator::setSolidEntities(bool newSolidEntities)
+{
+	solidEntities = newSolidEntities;
+}
+
+void CaptureGenerator::addServerCommand(size_t snapNum, const char* command)
+{
+	serverCommands.push_back(serverCommand_t{ snapNum, command });
+}
+
+void CaptureGenerator::generate(PacketCapture& capture, size_t numSnapshots)
+{
+	capture.setProtocol(protocolType_c(serverType_e::none, protocolVersion_e::ver111));
+	capture.setChallenge(challenge);
+
+	// the client data holds the encoding and the sequence, nothing is sent through it
+	const ClientDataPtr client = ClientData::create(nullptr, nullptr, 0, challenge, nullptr);
+
+	const entityState_t nullState = getNullEntityState();
+	std::vector<entityState_t> baselines(numEntities, nullState);
+	for (size_t i = 0; i < numEntities; ++i)
+	{
+		entityState_t& baseline = baselines[i];
+		baseline.number = (entityNum_t)(firstEntityNum + i);
+		baseline.eType = entityType_e::modelanim;
+		baseline.modelindex = (uint16_t)(1 + i % numModels);
+		if (solidEntities)
+		{
+			// players standing or crouching
+			Vector mins(-15.f, -15.f, 0.f);
+			Vector maxs(15.f, 15.f, i % 2 ? 54.f : 96.f);
+			baseline.solid = BoundingBoxToInteger(mins, maxs);
+		}
+		moveEntity(baseline, i, serverStartTime);
+	}
+
+	uint8_t transmission[MAX_UDP_DATA_SIZE];
+	uint64_t captureTime = 0;
+
+	// the gamestate
+	{
+		const uint32_t sequenceNum = client->newSequence();
+
+		FixedDataMessageStream stream(transmission, sizeof(transmission));
+		MSG msg(stream, msgMode_e::Writing);
+		msg.SetCodec(MessageCodecs::OOB);
+		msg.WriteUInteger(sequenceNum);
+
+		msg.SetCodec(MessageCodecs::Bit);
+		// reliable acknowledge
+		msg.WriteUInteger(0);
+
+		msg.WriteByte((uint8_t)svc_ops_e::Gamestate);
+		// server command sequence
+		msg.WriteUInteger(0);
+
+		writeConfigString(msg, CS_SERVERINFO, "\\mapname\\dm/mohdm6\\g_gametype\\2\\sv_fps\\20\\version\\Medal of Honor Allied Assault 1.11 win-x86 Mar  5 2002\\protocol\\8");
+		writeConfigString(msg, CS_SYSTEMINFO, "\\sv_serverid\\1\\sv_pure\\0");
+		for (size_t i = 0; i < numModels; ++i) {
+			writeConfigString(msg, (csNum_t)(CS_MODELS + 1 + i), modelNames[i]);
+		}
+
+		MsgTypesHelper msgHelper(msg);
+		for (size_t i = 0; i < numEntities; ++i)
+		{
+			const entityNum_t num = baselines[i].number;
+			entityState_t from = nullState;
+
+			msg.WriteByte((uint8_t)svc_ops_e::Baseline);
+			msgHelper.WriteEntityNum(num);
+
+			SerializableEntityState fromSerialize(from, num);
+			SerializableEntityState toSerialize(baselines[i], num);
+			msg.WriteDeltaClass(&fromSerialize, &toSerialize);
+		}
+
+		msg.WriteByte((uint8_t)svc_ops_e::Eof);
+		// client number
+		msg.WriteUInteger(0);
+		// checksum feed
+		msg.WriteUInteger(0);
+
+		// end of sv messages
+		msg.WriteByte((uint8_t)svc_ops_e::Eof);
+		msg.Flush();
+
+		const size_t len = stream.GetPosition();
+		client->encodeMessage(transmission, len, sequenceNum);
+		addMessage(capture, captureTime, transmission, len, sequenceNum);
+	}
+
+	playerState_t oldPlayerState;
+	playerState_t playerState;
+	std::vector<entityState_t> oldEntities(baselines);
+	std::vector<entityState_t> entities(baselines);
+
+	uint32_t serverCommandSequence = 0;
+
+	for (size_t snapNum = 0; snapNum < numSnapshots; ++snapNum)
+	{
+		const uint32_t serverTime = serverStartTime + (uint32_t)snapNum * frameTime;
+		captureTime = (uint64_t)(snapNum + 1) * frameTime * 1000;
+
+		// the player walks in a circle
+		const float angle = (float)(snapNum % 360);
+		const float radians = angle * 3.14159265f / 180.f;
+		playerState.commandTime = serverTime;
+		playerState.origin = Vector(cosf(radians) * 512.f, sinf(radians) * 512.f, 0.f);
+		playerState.velocity = Vector(-sinf(radians) * 250.f, cosf(radians) * 250.f, 0.f);
+		playerState.viewangles = Vector(0.f, fmodf(angle + 90.f, 360.f), 0.f);
+
+		for (size_t i = 0; i < numEntities; ++i) {
+			moveEntity(entities[i], i, serverTime);
+		}
+
+		const uint32_t sequenceNum = client->newSequence();
+
+		FixedDataMessageStream stream(transmission, sizeof(transmission));
+		MSG msg(stream, msgMode_e::Writing);
+		msg.SetCodec(MessageCodecs::OOB);
+		msg.WriteUInteger(sequenceNum);
+
+		msg.SetCodec(MessageCodecs::Bit);
+		// reliable acknowledge
+		msg.WriteUInteger(0);
+
+		for (const serverCommand_t& serverCommand : serverCommands)
+		{
+			if (serverCommand.snapNum == snapNum)
+			{
+				msg.WriteByte((uint8_t)svc_ops_e::ServerCommand);
+				msg.WriteUInteger(++serverCommandSequence);
+				msg.WriteString(serverCommand.command.c_str());
+			}
+		}
+
+		msg.WriteByte((uint8_t)svc_ops_e::Snapshot);
+		msg.WriteUInteger(serverTime);
+		// server time residual
+		msg.WriteByte(0);
+		// the first snapshot is uncompressed, others are delta from the previous message
+		msg.WriteByte(snapNum ? 1 : 0);
+		// snap flags
+		msg.WriteByte(0);
+		// area mask
+		msg.WriteByte(0);
+
+		playerState_t nullPlayerState;
+		SerializablePlayerState fromPlayerState(snapNum ? oldPlayerState : nullPlayerState);
+		SerializablePlayerState toPlayerState(playerState);
+		msg.WriteDeltaClass(&fromPlayerState, &toPlayerState);
+
+		MsgTypesHelper msgHelper(msg);
+		for (size_t i = 0; i < numEntities; ++i)
+		{
+			const entityNum_t num = entities[i].number;
+			msgHelper.WriteEntityNum(num);
+
+			// delta from the baseline when the client has no previous snapshot
+			SerializableEntityState fromSerialize(snapNum ? oldEntities[i] : baselines[i], num);
+			SerializableEntityState toSerialize(entities[i], num);
+			msg.WriteDeltaClass(&fromSerialize, &toSerialize);
+		}
+		msgHelper.WriteEntityNum(ENTITYNUM_NONE);
+
+		// no sound
+		msg.WriteBool(false);
+
+		msg.WriteByte((uint8_t)svc_ops_e::Eof);
+		msg.Flush();
+
+		const size_t len = stream.GetPosition();
+		client->encodeMessage(transmission, len, sequenceNum);
+		addMessage(capture, captureTime, transmission, len, sequenceNum);
+
+		oldPlayerState = playerState;
+		oldEntities = entities;
+	}
+}
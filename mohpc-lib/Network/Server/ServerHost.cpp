@@ -44,8 +44,9 @@ const NetAddr& Challenge::getSourceAddress() const
 
 MOHPC_OBJECT_DEFINITION(ClientData);
 
-ClientData::ClientData(const IUdpSocketPtr& inSocket, const NetAddrPtr& from, uint16_t inQport, uint32_t inChallenge)
+ClientData::ClientData(const IUdpSocketPtr& inSocket, const NetAddrPtr& from, uint16_t inQport, uint32_t inChallenge, const ChannelMetricsPtr& serverMetrics)
 	: socket(inSocket)
+	, metrics(ChannelMetrics::create(serverMetrics))
 	, source(from)
 	, challengeNum(inChallenge)
 	, sequenceNum(0)
@@ -70,6 +71,11 @@ const NetAddr& ClientData::getAddress() const
 	return *source;
 }
 
+const ChannelMetricsPtr& ClientData::getMetrics() const
+{
+	return metrics;
+}
+
 uint16_t ClientData::getQPort() const
 {
 	return qport;
@@ -85,23 +91,37 @@ uint32_t ClientData::newSequence()
 	return ++sequenceNum;
 }
 
+void ClientData::encodeMessage(uint8_t* data, size_t len, uint32_t messageSequence)
+{
+	// the sequence number and the acknowledge are not encoded
+	FixedDataMessageStream encodedStream(data, len);
+	encodedStream.Seek(8, IMessageStream::SeekPos::Begin);
+
+	encoding->setMessageAcknowledge(0);
+	encoding->setReliableAcknowledge(0);
+	encoding->setSecretKey(messageSequence);
+	encoding->encode(encodedStream, encodedStream);
+}
+
 MOHPC_OBJECT_DEFINITION(ServerHost);
 
 ServerHost::ServerHost(const NetworkManagerPtr& networkManager)
 	: ITickableNetwork(networkManager)
+	, metrics(ChannelMetrics::create(networkManager->getTotalMetrics()))
 {
 	NetAddr4 bindAddress;
 	bindAddress.port = 12203;
 
 	serverSocket = ISocketFactory::get()->createUdp(&bindAddress);
 	conChan = ConnectionlessChan::create(serverSocket);
+	conChan->getMetrics()->setParent(metrics);
 
 	serverId = rand();
 }
 
 ClientData& ServerHost::createClient(const NetAddrPtr& from, uint16_t qport, uint32_t challengeNum)
 {
-	ClientDataPtr data = ClientData::create(serverSocket, from, qport, challengeNum);
+	ClientDataPtr data = ClientData::create(serverSocket, from, qport, challengeNum, metrics);
 	clientList.AddObject(data);
 
 	return *data;
@@ -163,6 +183,11 @@ void ServerHost::tick(uint64_t deltaTime, uint64_t currentTime)
 	sendStateToClients();
 }
 
+const ChannelMetricsPtr& ServerHost::getMetrics() const
+{
+	return metrics;
+}
+
 void ServerHost::connectionLessReply(const NetAddr& target, const char* reply)
 {
 	uint8_t transmission[MAX_UDP_DATA_SIZE];
@@ -196,6 +221,8 @@ void ServerHost::processRequests()
 
 	if (sequenceNum == -1)
 	{
+		metrics->packetReceived(len);
+
 		// connectionless command
 		const netsrc_e dirByte = (netsrc_e)msg.ReadByte();
 		if (dirByte != netsrc_e::Server) {
@@ -279,6 +306,8 @@ void ServerHost::processRequests()
 		ClientData* client = findClient(*from, qport);
 		if (!client)
 		{
+			metrics->packetReceived(len);
+
 			// Not connected
 			uint8_t transmission[MAX_UDP_DATA_SIZE];
 			FixedDataMessageStream clientStream(transmission, MAX_UDP_DATA_SIZE);
@@ -294,6 +323,19 @@ void ServerHost::processRequests()
 			return;
 		}
 
+		const ChannelMetricsPtr& clientMetrics = client->getMetrics();
+		clientMetrics->packetReceived(len);
+
+		if (client->numCommands)
+		{
+			if (sequenceNum <= client->clientSequence) {
+				clientMetrics->packetOutOfOrder();
+			}
+			else if (sequenceNum > client->clientSequence + 1) {
+				clientMetrics->packetsDropped(sequenceNum - client->clientSequence - 1);
+			}
+		}
+
 		client->numCommands++;
 		client->clientSequence = sequenceNum;
 		processClient(*client, sequenceNum, stream, msg);
@@ -339,8 +381,6 @@ void ServerHost::sendClientMessage(ClientData& client)
 
 void ServerHost::sendGameStateToClient(ClientData& client)
 {
-	Encoding& encoding = client.getEncoding();
-
 	const uint32_t sequenceNum = client.newSequence();
 
 	uint8_t transmission[MAX_UDP_DATA_SIZE];
@@ -380,16 +420,8 @@ void ServerHost::sendGameStateToClient(ClientData& client)
 	clientMessage.Flush();
 
 	const size_t len = clientStream.GetPosition();
-
-	FixedDataMessageStream encodedStream(transmission, len);
-	encodedStream.Seek(8, IMessageStream::SeekPos::Begin);
-
-	encoding.setMessageAcknowledge(0);
-	encoding.setReliableAcknowledge(0);
-	encoding.setSecretKey(sequenceNum);
-	encoding.encode(encodedStream, encodedStream);
-
-	encodedStream.Seek(0, IMessageStream::SeekPos::Begin);
+	client.encodeMessage(transmission, len, sequenceNum);
 
 	serverSocket->send(client.getAddress(), transmission, len);
+	client.getMetrics()->packetSent(len);
 }
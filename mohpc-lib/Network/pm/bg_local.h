@@ -22,7 +22,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 //
 // bg_local.h -- local definitions for the bg (both games) files
 
+#pragma once
+
 #include <MOHPC/Math.h>
+#include <MOHPC/Collision/Collision.h>
+#include <MOHPC/Network/pm/bg_public.h>
 
 namespace MOHPC
 {
@@ -37,20 +41,54 @@ namespace MOHPC
 	static constexpr unsigned int PELVIS_TAG	= 3;
 	static constexpr unsigned int MOUTH_TAG		= 4;
 
-	// movement parameters
-	extern	float	pm_stopspeed;
-	extern	float	pm_duckScale;
-	extern	float	pm_swimScale;
-	extern	float	pm_wadeScale;
+	/**
+	 * Collision used by Pmove::move(), through the callbacks set in pmove_t.
+	 */
+	class pmoveCallbacks_t
+	{
+	public:
+		pmoveCallbacks_t(const pmove_t& inPm)
+			: pm(inPm)
+		{}
 
-	extern	float	pm_accelerate;
-	extern	float	pm_airaccelerate;
-	extern	float	pm_wateraccelerate;
-	extern	float	pm_flyaccelerate;
+		void trace(trace_t* results, const Vector& start, const Vector& mins, const Vector& maxs, const Vector& end, uintptr_t passEntityNum, uintptr_t contentMask, bool capsule, bool traceDeep)
+		{
+			pm.trace(results, start, mins, maxs, end, passEntityNum, contentMask, capsule, traceDeep);
+		}
 
-	extern	float	pm_friction;
-	extern	float	pm_waterfriction;
-	extern	float	pm_flightfriction;
-}
+		uint32_t pointContents(const Vector& point, uintptr_t passEntityNum)
+		{
+			return pm.pointcontents(point, passEntityNum);
+		}
+
+	private:
+		const pmove_t& pm;
+	};
 
+	/**
+	 * Collision used by Pmove::move(CollisionWorld&), calls go straight to the world so they can be inlined.
+	 * Entities are not clipped against.
+	 */
+	class pmoveWorld_t
+	{
+	public:
+		pmoveWorld_t(CollisionWorld& inCm)
+			: cm(inCm)
+		{}
 
+		void trace(trace_t* results, const Vector& start, const Vector& mins, const Vector& maxs, const Vector& end, uintptr_t passEntityNum, uintptr_t contentMask, bool capsule, bool traceDeep)
+		{
+			cm.CM_BoxTrace(results, start, end, mins, maxs, 0, (uint32_t)contentMask, capsule);
+			// same as the client game trace without entities
+			results->entityNum = results->fraction != 1.f || results->startsolid ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+		}
+
+		uint32_t pointContents(const Vector& point, uintptr_t passEntityNum)
+		{
+			return cm.CM_PointContents(point, 0);
+		}
+
+	private:
+		CollisionWorld& cm;
+	};
+}
@@ -447,7 +447,7 @@ void Pmove::PM_CheckTerminalVelocity()
 			pm.ps->velocity, OVERCLIP );
 	}
 
-	PM_StepSlideMove( true );
+	PM_StepSlideMove( collision, true );
 }
 */
 
@@ -472,275 +472,6 @@ void Pmove::PM_GetMove
 	*pfRight = pm.cmd.rightmove * pm_strafespeed;
 }
 
-/*
-===================
-PM_AirMove
-
-===================
-*/
-void Pmove::PM_AirMove( void )
-{
-	Vector		wishvel;
-	float		   fmove;
-	float       smove;
-	Vector		wishdir;
-	float		   wishspeed;
-	float		   scale;
-	usercmd_t	cmd;
-
-	PM_GetMove( &fmove, &smove );
-
-	pm.ps->pm_time = 0;
-
-	cmd = pm.cmd;
-	scale = PM_CmdScale( &cmd );
-
-	wishvel[ 0 ] = pml.flat_forward[ 0 ] * fmove - pml.flat_left[ 0 ] * smove;
-	wishvel[ 1 ] = pml.flat_forward[ 1 ] * fmove - pml.flat_left[ 1 ] * smove;
-	wishvel[ 2 ] = 0;
-
-	VecCopy( wishvel, wishdir );
-	wishspeed = VectorNormalize( wishdir );
-	wishspeed *= scale;
-
-	// not on ground, so little effect on velocity
-	PM_Accelerate( wishdir, wishspeed, pm_airaccelerate );
-
-	// we may have a ground plane that is very steep, even
-	// though we don't have a groundentity
-	// slide along the steep plane
-	if( pml.groundPlane )
-	{
-		PM_ClipVelocity( pm.ps->velocity, pml.groundTrace.plane.normal, pm.ps->velocity, OVERCLIP );
-	}
-
-	PM_StepSlideMove( true );
-
-	PM_CheckTerminalVelocity();
-}
-
-static Vector min4x4 = { -8, 0, 0 };
-static Vector max4x4 = { 4, 4, 8 };
-static Vector base_rightfoot_pos = { -5.25301f, -3.10885f, 0 };
-static Vector base_leftfoot_pos = { -0.123711f, 10.4893f, 0 };
-
-bool Pmove::PM_FeetOnGround(const Vector& pos)
-{
-	Vector start;
-	Vector end;
-	trace_t trace;
-
-	VecCopy(pos, start);
-	VecCopy(pos, end);
-	// Some fixes not present in Quake3/OpenMOHAA
-	end[2] -= 16.1f;
-
-	pm.trace( &trace, start, min4x4, max4x4, end, pm.ps->clientNum, pm.tracemask, true, false );
-
-	return trace.fraction != 1.0f;
-}
-
-bool Pmove::PM_FindBestFallPos(const Vector& pos, Vector& bestdir)
-{ 
-	trace_t trace;
-	Vector ang;
-	Vector dir;
-	Vector start;
-	Vector end;
-	Vector move;
-	int i;
-	bool set;
-	float radius;
-
-	VectorClear( bestdir );
-
-	set = false;
-
-	radius = pm.maxs[ 0 ] - pm.mins[ 0 ] + 1.0f;
-
-	VecCopy( pos, start );
-	start[ 2 ] -= 16.1f;
-
-	VecSet( ang, 0, pm.ps->viewangles[ 1 ], 0 );
-	for( i = 0; i < 16; i++, ang[ 1 ] += 22.5f )
-	{
-		AngleVectorsLeft( ang, dir, NULL, NULL );
-		VectorMA( pos, radius, dir, move );
-
-		pm.trace( &trace, pos, pm.mins, pm.maxs, move, pm.ps->clientNum, pm.tracemask, true, false );
-
-		VecCopy( trace.endpos, end );
-		end[ 2 ] = start[ 2 ];
-
-		pm.trace( &trace, trace.endpos, pm.mins, pm.maxs, end, pm.ps->clientNum, pm.tracemask, true, false );
-		if( trace.fraction == 1.0f )
-		{
-			VecCopy( trace.endpos, end );
-			pm.trace( &trace, end, pm.mins, pm.maxs, start, pm.ps->clientNum, pm.tracemask, true, false );
-
-			if( trace.fraction < 1.0f )
-			{
-				VecAdd( bestdir, trace.plane.normal, bestdir );
-				set = true;
-			}
-		}
-	}
-
-	if( !set || !VectorNormalize( bestdir ) )
-	{
-		return false;
-	}
-
-	return true;
-}
-
-void Pmove::PM_CheckFeet(const Vector& vWishdir)
-{
-	Vector		temp;
-	trace_t		trace;
-
-	if( pm.stepped )
-	{
-		pm.ps->feetfalling = 0;
-		return;
-	}
-
-	if( !pm.ps->walking )
-	{
-		return;
-	}
-
-	VectorMA( pm.ps->origin, 0.2f, pm.ps->velocity, temp );
-	temp[ 2 ] = pm.ps->origin[ 2 ] + 2;
-	if( PM_FeetOnGround( pm.ps->origin ) || PM_FeetOnGround( temp ) )
-	{
-		pm.ps->feetfalling = 0;
-		return;
-	}
-
-	if( pm.ps->feetfalling > 0 )
-	{
-		pm.ps->feetfalling--;
-	}
-
-	if( !pm.ps->feetfalling )
-	{
-		if( !PM_FindBestFallPos( pm.ps->origin, pm.ps->falldir ) ) {
-			return;
-		}
-
-		pm.ps->feetfalling = 5;
-	}
-
-	VectorMA( pm.ps->origin, 15.0f * pml.frametime, pm.ps->falldir, temp );
-
-	pm.trace( &trace, pm.ps->origin, pm.mins, pm.maxs, temp, pm.ps->clientNum, pm.tracemask, true, false );
-	if( trace.fraction == 0 )
-	{
-		pm.ps->feetfalling = 0;
-		return;
-	}
-
-	if( ( vWishdir[ 0 ] == 0.0f && vWishdir[ 1 ] == 0.0f ) ||
-		DotProduct( vWishdir, pm.ps->falldir ) > 0.0f )
-	{
-		pm.ps->walking = false;
-		VecCopy( trace.endpos, pm.ps->origin );
-	}
-}
-
-/*
-===================
-PM_WalkMove
-
-===================
-*/
-void Pmove::PM_WalkMove( void ) {
-	int			i;
-	Vector		wishvel;
-	float		fmove, smove;
-	Vector		wishdir;
-	float		wishspeed;
-	float		scale;
-	usercmd_t	cmd;
-	float		accelerate;
-
-	PM_Friction();
-
-	PM_GetMove( &fmove, &smove );
-
-	cmd = pm.cmd;
-	scale = PM_CmdScale( &cmd );
-
-	if( ( pm.cmd.buttons.flags & BUTTON_RUN ) && fmove && !smove )
-	{
-		pm.ps->pm_time += pml.msec;
-	}
-	else
-	{
-		pm.ps->pm_time = 0;
-	}
-
-	// project the forward and right directions onto the ground plane
-	PM_ClipVelocity( pml.flat_forward, pml.groundTrace.plane.normal, pml.flat_forward, OVERCLIP );
-	PM_ClipVelocity( pml.flat_left, pml.groundTrace.plane.normal, pml.flat_left, OVERCLIP );
-	//
-	VectorNormalize( pml.flat_forward );
-	VectorNormalize( pml.flat_left );
-
-	for( i = 0; i < 3; i++ )
-	{
-		wishvel[ i ] = pml.flat_forward[ i ] * fmove - pml.flat_left[ i ] * smove;
-	}
-
-	VecCopy( wishvel, wishdir );
-	wishspeed = VectorNormalize( wishdir );
-	wishspeed *= scale;
-
-	// clamp the speed lower if wading or walking on the bottom
-	if( pm.waterlevel )
-	{
-		float	waterScale;
-
-		if( pm.waterlevel == 1.0f )
-		{
-			waterScale = 0.80f;
-		}
-		else
-		{
-			waterScale = 0.5f;
-		}
-
-		if( wishspeed > pm.ps->speed * waterScale ) {
-			wishspeed = pm.ps->speed * waterScale;
-		}
-	}
-
-	if( pml.groundTrace.surfaceFlags & SURF_SLICK ) {
-		accelerate = pm_airaccelerate;
-	} else {
-		accelerate = pm_accelerate;
-	}
-
-	PM_Accelerate( wishdir, wishspeed, accelerate );
-
-	if( pml.groundTrace.surfaceFlags & SURF_SLICK ) {
-		pm.ps->velocity[ 2 ] -= pm.ps->gravity * pml.frametime;
-	}
-
-	// slide along the ground plane
-	PM_ClipVelocity( pm.ps->velocity, pml.groundTrace.plane.normal,
-		pm.ps->velocity, OVERCLIP );
-
-	// don't do anything if standing still
-	if( pm.ps->velocity[ 0 ] || pm.ps->velocity[ 1 ] )
-	{
-		PM_StepSlideMove( true );
-	}
-
-	PM_CheckFeet( wishdir );
-}
-
 /*
 ==============
 PM_DeadMove
@@ -937,201 +668,6 @@ void PM_CheckStuck(void) {
 }
 */
 
-/*
-=============
-PM_CorrectAllSolid
-=============
-*/
-// Some code has not been fixed in OpenMOHAA
-int Pmove::PM_CorrectAllSolid()
-{
-	int			i, j, k;
-	Vector		point, point2;
-	trace_t		trace, trace2;
-
-	if ( pm.debugLevel ) {
-		//Com_Printf("%i:allsolid\n", c_pmove);
-	}
-
-	// jitter around
-	for (i = -1; i <= 1; i++) {
-		for (j = -1; j <= 1; j++) {
-			for (k = -1; k <= 1; k++) {
-				VecCopy(pm.ps->origin, point);
-				point[0] += (float) i;
-				point[1] += (float) j;
-				point[2] += (float) k;
-				pm.trace( &trace, point, pm.mins, pm.maxs, point, pm.ps->clientNum, pm.tracemask, true, false );
-				if ( !trace.allsolid && !trace.startsolid ) {
-					pm.ps->origin[0] = point[0];
-					pm.ps->origin[1] = point[1];
-					pm.ps->origin[2] = point[2];
-					point2 = point;
-					point2[2] -= 0.25f;
-
-					pm.trace( &trace2, point, pm.mins, pm.maxs, point2, pm.ps->clientNum, pm.tracemask, true, false );
-					pml.groundTrace = trace2;
-					pm.ps->groundTrace = trace2;
-					return true;
-				}
-			}
-		}
-	}
-
-	//pm.ps->groundEntityNum = ENTITYNUM_NONE;
-	//pml.groundPlane = false;
-	//pml.walking = false;
-
-	return false;
-}
-
-/*
-=============
-PM_GroundTrace
-=============
-*/
-void Pmove::PM_GroundTrace( void ) {
-	Vector		point;
-	trace_t		trace;
-
-	point[ 0 ] = pm.ps->origin[ 0 ];
-	point[ 1 ] = pm.ps->origin[ 1 ];
-	point[ 2 ] = pm.ps->origin[ 2 ] - 0.25f;
-
-	pm.trace( &trace, pm.ps->origin, pm.mins, pm.maxs, point, pm.ps->clientNum, pm.tracemask, true, false );
-
-	pml.groundTrace = trace;
-	pm.ps->groundTrace = trace;
-
-	// do something corrective if the trace starts in a solid...
-	if ( trace.allsolid || trace.startsolid )
-	{
-		if( !PM_CorrectAllSolid() ) {
-			trace.fraction = 1.0f;
-		}
-	}
-
-	// if the trace didn't hit anything, we are in free fall
-	if ( trace.fraction == 1.0 )
-	{
-		pm.ps->groundEntityNum = ENTITYNUM_NONE;
-		pml.groundPlane = false;
-		pml.walking = false;
-
-		pm.ps->walking = pml.walking;
-		pm.ps->groundPlane = pml.groundPlane;
-		return;
-	}
-
-	// check if getting thrown off the ground
-	if( pm.ps->velocity[ 2 ] > 0.0f && DotProduct( pm.ps->velocity, trace.plane.normal ) > 150.0f )
-	{
-		if ( pm.debugLevel ) {
-			//Com_Printf("%i:kickoff\n", c_pmove);
-		}
-
-		pm.ps->groundEntityNum = ENTITYNUM_NONE;
-		pml.groundPlane = false;
-		pml.walking = false;
-
-		pm.ps->walking = pml.walking;
-		pm.ps->groundPlane = pml.groundPlane;
-		return;
-	}
-
-	// slopes that are too steep will not be considered onground
-	if( trace.plane.normal[ 2 ] < MIN_WALK_NORMAL )
-	{
-		Vector oldvel;
-		float d;
-
-		if ( pm.debugLevel ) {
-			//Com_Printf("%i:steep\n", c_pmove);
-		}
-
-		VecCopy( pm.ps->velocity, oldvel );
-		VecSet( pm.ps->velocity, 0, 0, -1.0f / pml.frametime );
-		PM_SlideMove( false );
-
-		d = VectorLength( pm.ps->velocity );
-		VecCopy( oldvel, pm.ps->velocity );
-
-		if( d > ( 0.1f / pml.frametime ) )
-		{
-			pm.ps->groundEntityNum = ENTITYNUM_NONE;
-			pml.groundPlane = true;
-			pml.walking = false;
-
-			pm.ps->walking = pml.walking;
-			pm.ps->groundPlane = pml.groundPlane;
-			return;
-		}
-	}
-
-	pml.groundPlane = true;
-	pml.walking = true;
-
-	if ( pm.ps->groundEntityNum == ENTITYNUM_NONE )
-	{
-		// just hit the ground
-		if ( pm.debugLevel ) {
-			//Com_Printf( "%i:Land\n", c_pmove );
-		}
-
-		PM_CrashLand();
-	}
-
-	pm.ps->groundEntityNum = trace.entityNum;
-
-	PM_AddTouchEnt( trace.entityNum );
-
-	pm.ps->walking = pml.walking;
-	pm.ps->groundPlane = pml.groundPlane;
-}
-
-
-/*
-=============
-PM_SetWaterLevel	FIXME: avoid this twice?  certainly if not moving
-=============
-*/
-void Pmove::PM_SetWaterLevel( void ) {
-	Vector		point;
-	int			cont;
-	int			sample1;
-	int			sample2;
-
-	//
-	// get waterlevel, accounting for ducking
-	//
-	pm.waterlevel = 0;
-	pm.watertype = 0;
-
-	point[0] = pm.ps->origin[0];
-	point[1] = pm.ps->origin[1];
-	point[2] = pm.ps->origin[2] + MINS_Z + 1;
-	cont = pm.pointcontents( point, pm.ps->clientNum );
-
-	if ( cont & MASK_WATER ) {
-		sample2 = pm.ps->viewheight - MINS_Z;
-		sample1 = sample2 / 2;
-
-		pm.watertype = cont;
-		pm.waterlevel = 1;
-		point[2] = pm.ps->origin[2] + MINS_Z + sample1;
-		cont = pm.pointcontents (point, pm.ps->clientNum );
-		if ( cont & MASK_WATER ) {
-			pm.waterlevel = 2;
-			point[2] = pm.ps->origin[2] + MINS_Z + sample2;
-			cont = pm.pointcontents (point, pm.ps->clientNum );
-			if ( cont & MASK_WATER ){
-				pm.waterlevel = 3;
-			}
-		}
-	}
-
-}
-
 /*
 ==============
 PM_CheckDuck
@@ -1370,231 +906,15 @@ void Pmove::PM_UpdateViewAngles(playerState_t* ps, const usercmd_t* cmd)
 	}
 }
 
-
-/*
-================
-PmoveSingle
-
-================
-*/
-
-void Pmove::moveSingle()
-{
-	Vector tempVec;
-	bool walking;
-
-	// this counter lets us debug movement problems with a journal
-	// by setting a conditional breakpoint fot the previous frame
-	c_pmove++;
-
-	// clear results
-	pm.numtouch = 0;
-	pm.watertype = 0;
-	pm.waterlevel = 0;
-
-	if( pm.ps->stats[(size_t)playerstat_e::STAT_HEALTH] <= 0 ) {
-		pm.tracemask &= ~( CONTENTS_BODY | CONTENTS_NOBOTCLIP );	// corpses can fly through bodies
-	}
-
-	if( pm.ps->pm_type == pmType_e::ClimbWall )
-	{
-		pm.ps->fLeanAngle = 0.0f;
-		pm.cmd.buttons.flags &= ~( BUTTON_LEANLEFT | BUTTON_LEANRIGHT );
-	}
-
-	// clear all pmove local vars
-	memset( &pml, 0, sizeof( pml ) );
-
-	// determine the time
-	pml.msec = pm.cmd.serverTime - pm.ps->commandTime;
-	if ( pml.msec < 1 ) {
-		pml.msec = 1;
-	} else if ( pml.msec > 200 ) {
-		pml.msec = 200;
-	}
-
-	pm.ps->commandTime = pm.cmd.serverTime;
-
-	// save old org in case we get stuck
-	VecCopy( pm.ps->origin, pml.previous_origin );
-
-	// save old velocity for crashlanding
-	VecCopy( pm.ps->velocity, pml.previous_velocity );
-
-	pml.frametime = float(pml.msec * 0.001);
-
-	if ((pm.cmd.buttons.flags & (BUTTON_LEANLEFT | BUTTON_LEANRIGHT) &&
-		(pm.cmd.buttons.flags & (BUTTON_LEANLEFT | BUTTON_LEANRIGHT)) != (BUTTON_LEANLEFT | BUTTON_LEANRIGHT))
-		&& canLean(pm.cmd))
-	{
-		if( pm.cmd.buttons.flags & BUTTON_LEANLEFT )
-		{
-			if( pm.ps->fLeanAngle <= -40.0f )
-			{
-				pm.ps->fLeanAngle = -40.0f;
-			}
-			else
-			{
-				float fAngle = pml.frametime * ( -40.0f - pm.ps->fLeanAngle );
-				float fLeanAngle = pml.frametime * -4.0f;
-
-				if( fAngle * 10.0f <= fLeanAngle ) {
-					fLeanAngle = fAngle * 10.0f;
-				}
-
-				pm.ps->fLeanAngle += fLeanAngle;
-			}
-		}
-		else
-		{
-			if( pm.ps->fLeanAngle >= 40.0f )
-			{
-				pm.ps->fLeanAngle = 40.0f;
-			}
-			else
-			{
-				float fAngle = 40.0f - pm.ps->fLeanAngle;
-				float fLeanAngle = pml.frametime * 4.0f;
-				float fMult = pml.frametime * fAngle;
-
-				if( fLeanAngle <= fMult * 10.0f )
-				{
-					fLeanAngle = fMult * 10.0f;
-				}
-				else
-				{
-					fLeanAngle = fMult;
-				}
-
-				pm.ps->fLeanAngle += fLeanAngle;
-			}
-		}
-	}
-	else if( pm.ps->fLeanAngle )
-	{
-		float fAngle = pm.ps->fLeanAngle * pml.frametime * 15.0f;
-
-		if( pm.ps->fLeanAngle <= 0.0f )
-		{
-			float fLeanAngle = -4.0f * pml.frametime;
-
-			if( fAngle <= fLeanAngle )
-			{
-				fLeanAngle = fAngle;
-			}
-
-			pm.ps->fLeanAngle -= fLeanAngle;
-		}
-		else
-		{
-			float fLeanAngle = pml.frametime * 4.0f;
-
-			if( fLeanAngle <= fAngle ) {
-				fLeanAngle = fAngle;
-			}
-
-			pm.ps->fLeanAngle -= fLeanAngle;
-		}
-	}
-
-	if (shouldClearLean()) {
-		pm.ps->fLeanAngle = 0.f;
-	}
-
-	// update the viewangles
-	PM_UpdateViewAngles( pm.ps, &pm.cmd );
-
-	AngleVectorsLeft( pm.ps->viewangles, pml.forward, pml.left, pml.up );
-	VectorClear( tempVec );
-	tempVec[ YAW ] = pm.ps->viewangles[ YAW ];
-	AngleVectorsLeft( tempVec, pml.flat_forward, pml.flat_left, pml.flat_up );
-
-	if (pm.ps->pm_type >= pmType_e::Dead)
-	{
-		pm.cmd.forwardmove = 0;
-		pm.cmd.rightmove = 0;
-		pm.cmd.upmove = 0;
-		pm.ps->fLeanAngle = 0.0f;
-	}
-
-	if (pm.ps->pm_type == pmType_e::Noclip)
-	{
-		PM_NoclipMove();
-		PM_DropTimers();
-		return;
-	}
-
-	if ((pm.ps->pm_flags & PMF_NO_MOVE) || (pm.ps->pm_flags & PMF_FROZEN))
-	{
-		PM_CheckDuck();
-		return;
-	}
-
-	// set watertype, and waterlevel
-	PM_SetWaterLevel();
-	pml.previous_waterlevel = pm.waterlevel;
-
-	// set mins, maxs, and viewheight
-	PM_CheckDuck();
-
-	// set groundentity
-	PM_GroundTrace();
-
-	if ( pm.ps->pm_type == pmType_e::Dead ) {
-		PM_DeadMove();
-	}
-
-	PM_DropTimers();
-
-	if ( pml.walking ) {
-		// walking on ground
-		PM_WalkMove();
-	} else {
-		// airborne
-		PM_AirMove();
-	}
-
-	walking = pml.walking;
-
-	// set groundentity, watertype, and waterlevel
-	PM_GroundTrace();
-	PM_SetWaterLevel();
-
-	// don't fall down stairs or do really short falls
-	if( !pml.walking && ( walking || ( ( pml.previous_velocity[ 2 ] >= 0 ) && ( pm.ps->velocity[ 2 ] <= 0 ) ) ) )
-	{
-		Vector   point;
-		trace_t  trace;
-
-		point[ 0 ] = pm.ps->origin[ 0 ];
-		point[ 1 ] = pm.ps->origin[ 1 ];
-		point[ 2 ] = pm.ps->origin[ 2 ] - STEPSIZE;
-
-		pm.trace( &trace, pm.ps->origin, pm.mins, pm.maxs, point, pm.ps->clientNum, pm.tracemask, true, false );
-		if( ( trace.fraction < 1.0f ) && ( !trace.allsolid ) )
-		{
-			VecCopy( trace.endpos, pm.ps->origin );
-
-			// allow client to smooth out the step
-			pm.stepped = true;
-
-			// requantify the player's position
-			PM_GroundTrace();
-			PM_SetWaterLevel();
-		}
-	}
-
-	// entering / leaving water splashes
-	PM_WaterEvents();
-}
-
 void Pmove::move_GroundTrace()
 {
+	pmoveCallbacks_t callbacks(pm);
+
 	memset( &pml, 0, sizeof( pml ) );
 	pml.msec = 1;
 	pml.frametime = 0.001f;
 	PM_CheckDuck();
-	PM_GroundTrace();
+	PM_GroundTrace(callbacks);
 }
 
 /*
@@ -1606,39 +926,39 @@ Can be called by either the server or the client
 */
 void Pmove::move()
 {
-	unsigned int finalTime = pm.cmd.serverTime;
+	pmoveCallbacks_t callbacks(pm);
+	move(callbacks);
+}
 
-	if (finalTime < pm.ps->commandTime)
-	{
-		// should not happen
-		return;
-	}
+void Pmove::move(CollisionWorld& cm)
+{
+	pmoveWorld_t world(cm);
+	move(world);
+}
 
-	if (finalTime > pm.ps->commandTime + 1000) {
-		pm.ps->commandTime = finalTime - 1000;
-	}
+void Pmove::moveBatch(CollisionWorld& cm, pmoveBatch_t* moves, size_t numMoves)
+{
+	pmoveWorld_t world(cm);
 
-	// chop the move up if it is too long, to prevent framerate
-	// dependent behavior
-	while (pm.ps->commandTime != finalTime) {
-		int		msec;
+	for (size_t i = 0; i < numMoves; ++i)
+	{
+		pmoveBatch_t& batch = moves[i];
 
-		msec = finalTime - pm.ps->commandTime;
+		pm.ps = batch.ps;
+		pm.cmd = batch.cmd;
+		pm.tracemask = batch.tracemask;
+		pm.moveresult = MOVERESULT_NONE;
+		pm.stepped = false;
+		pm.pmoveEvent = EV_NONE;
 
-		if (pm.pmove_fixed)
-		{
-			if (msec > pm.pmove_msec) {
-				msec = pm.pmove_msec;
-			}
-		}
-		else if (msec > 66) {
-			msec = 66;
-		}
+		move(world);
 
-		pm.cmd.serverTime = pm.ps->commandTime + msec;
-		moveSingle();
+		batch.moveresult = pm.moveresult;
+		batch.stepped = pm.stepped;
+		batch.pmoveEvent = pm.pmoveEvent;
 	}
 }
+
 void Pmove::moveAdjustViewAngleSettings_OnLadder(Vector& vViewAngles, Vector& vAngles, playerState_t *pPlayerState, entityState_t *pEntState)
 {
 	float fDelta;
@@ -6,6 +6,13 @@ using namespace MOHPC;
 
 const str& AbstractScript::Filename()
 {
+	if (!m_Filename)
+	{
+		// loaded from memory without a name
+		static const str noFilename;
+		return noFilename;
+	}
+
 	return GetScriptManager()->GetString(m_Filename);
 }
 
@@ -19,8 +19,8 @@
 
 namespace MOHPC
 {
-extern int prev_yylex;
-ScriptCompiler* Compiler = nullptr;
+extern thread_local int prev_yylex;
+thread_local ScriptCompiler* Compiler = nullptr;
 
 int yyerror(const char *msg)
 {
@@ -92,6 +92,7 @@ void ScriptCompiler::AbsorbPrevOpcode()
 	m_iVarStackOffset -= PrevVarStackOffset();
 
 	code_pos -= OpcodeLength( PrevOpcode() );
+	RemoveRelocations( code_pos );
 
 	if( !prev_opcode_pos ) {
 		prev_opcode_pos = 100;
@@ -105,6 +106,24 @@ void ScriptCompiler::ClearPrevOpcode()
 	prev_opcodes[ prev_opcode_pos ].opcode = OP_PREVIOUS;
 }
 
+void ScriptCompiler::FuseWithPrevOpcode( int opcode )
+{
+	int prev = PrevOpcode();
+	int superOpcode = SuperOpcode( prev, opcode );
+
+	if( superOpcode == prev ) {
+		return;
+	}
+
+	// only the first opcode is replaced, so the operands, the jump offsets
+	// and the labels pointing to the second opcode stay valid
+	unsigned char *prev_pos = code_pos - OpcodeLength( prev );
+
+	if( prev_pos >= code_ptr && *prev_pos == prev ) {
+		*prev_pos = superOpcode;
+	}
+}
+
 void ScriptCompiler::AddBreakJumpLocation( unsigned char *pos )
 {
 	if( iBreakJumpLocCount < BREAK_JUMP_LOCATION_COUNT )
@@ -265,9 +284,6 @@ void ScriptCompiler::EmitAssignmentStatement( sval_t lhs, uint32_t sourcePos )
 {
 	uintptr_t eventnum;
 	sval_t listener_val;
-	char *name = lhs.node[ 2 ].stringValue;
-	str name2 = name;
-	name2.tolower();
 
 	if( lhs.node[ 0 ].type != sval_field )
 	{
@@ -285,6 +301,11 @@ void ScriptCompiler::EmitAssignmentStatement( sval_t lhs, uint32_t sourcePos )
 		}
 	}
 
+	// only a field has a name
+	char *name = lhs.node[ 2 ].stringValue;
+	str name2 = name;
+	name2.tolower();
+
 	ScriptManagerPtr Director = GetScriptManager();
 
 	const_str index = Director->AddString( name );
@@ -308,8 +329,7 @@ void ScriptCompiler::EmitAssignmentStatement( sval_t lhs, uint32_t sourcePos )
 		EmitOpcode( OP_LOAD_GAME_VAR + listener_val.node[ 1 ].byteValue, sourcePos );
 	}
 
-	*reinterpret_cast<uint32_t *>( code_pos ) = index;
-	code_pos += sizeof(uint32_t);
+	EmitStringOperand( index );
 }
 
 void ScriptCompiler::EmitBoolJumpFalse( uint32_t sourcePos )
@@ -455,14 +475,12 @@ void ScriptCompiler::EmitConstArrayOpcode( int iCount )
 	}
 	else
 	{
-		SetOpcodeVarStackOffset( OP_LOAD_CONST_ARRAY1, 1 - iCount );
-		EmitOpcode( OP_LOAD_CONST_ARRAY1, -1 );
+		EmitOpcode( OP_LOAD_CONST_ARRAY1, 1 - iCount, -1 );
 
 		*code_pos++ = iCount;
 	}*/
 
-	SetOpcodeVarStackOffset( OP_LOAD_CONST_ARRAY1, 1 - iCount );
-	EmitOpcode( OP_LOAD_CONST_ARRAY1, -1 );
+	EmitOpcode( OP_LOAD_CONST_ARRAY1, 1 - iCount, -1 );
 
 	*reinterpret_cast< short * >( code_pos ) = iCount;
 	code_pos += sizeof( short );
@@ -561,7 +579,6 @@ void ScriptCompiler::EmitField( sval_t listener_val, sval_t field_val, uint32_t
 {
 	uintptr_t eventnum = 0;
 	uint32_t index = -1;
-	uint32_t prev_index;
 
 	if( field_val.node[ 0 ].stringValue )
 	{
@@ -580,28 +597,32 @@ void ScriptCompiler::EmitField( sval_t listener_val, sval_t field_val, uint32_t
 		}
 	}
 
-	prev_index = *reinterpret_cast< uint32_t * >( code_pos - sizeof( uint32_t ) );
-
 	if( listener_val.node[ 0 ].type != sval_store_method || ( eventnum && BuiltinReadVariable( sourcePos, listener_val.node[ 1 ].byteValue , eventnum ) ) )
 	{
 		EmitValue( listener_val );
 		EmitOpcode( OP_STORE_FIELD, sourcePos );
-
-		*reinterpret_cast< uint32_t * >( code_pos ) = index;
 	}
-	else if( PrevOpcode() != ( OP_LOAD_GAME_VAR + listener_val.node[ 1 ].byteValue ) || prev_index != index )
+	// the operand is only read when the previous opcode has one, it may be the start of the code
+	else if( PrevOpcode() != ( OP_LOAD_GAME_VAR + listener_val.node[ 1 ].byteValue ) || *reinterpret_cast< uint32_t * >( code_pos - sizeof( uint32_t ) ) != index )
 	{
 		EmitOpcode( OP_STORE_GAME_VAR + listener_val.node[ 1 ].byteValue, sourcePos );
-
-		*reinterpret_cast< uint32_t * >( code_pos ) = index;
 	}
 	else
 	{
+		// the operand of the absorbed opcode is the same index
 		AbsorbPrevOpcode();
 		EmitOpcode( OP_LOAD_STORE_GAME_VAR + listener_val.node[ 1 ].byteValue, sourcePos );
 	}
 
-	code_pos += sizeof( uint32_t );
+	if( index != (uint32_t)-1 )
+	{
+		EmitStringOperand( index );
+	}
+	else
+	{
+		*reinterpret_cast< uint32_t * >( code_pos ) = index;
+		code_pos += sizeof( uint32_t );
+	}
 }
 
 void ScriptCompiler::EmitFloat( float value, uint32_t sourcePos )
@@ -661,8 +682,7 @@ void ScriptCompiler::EmitFunction( int iParamCount, sval_t val, uint32_t sourceP
 		p++;
 	}
 
-	SetOpcodeVarStackOffset( OP_FUNC, -iParamCount );
-	EmitOpcode( OP_FUNC, sourcePos );
+	EmitOpcode( OP_FUNC, -iParamCount, sourcePos );
 
 	ScriptManagerPtr Director = GetScriptManager();
 
@@ -671,18 +691,15 @@ void ScriptCompiler::EmitFunction( int iParamCount, sval_t val, uint32_t sourceP
 		label = val.stringValue;
 
 		*code_pos++ = false;
-		*reinterpret_cast<uint32_t *>(code_pos) = Director->AddString(label);
+		EmitStringOperand(Director->AddString(label));
 	}
 	else
 	{
 		*code_pos++ = true;
-		*reinterpret_cast<uint32_t *>(code_pos) = Director->AddString(filename);
-		code_pos += sizeof(uint32_t);
-		*reinterpret_cast<uint32_t *>(code_pos) = Director->AddString(label);
+		EmitStringOperand(Director->AddString(filename));
+		EmitStringOperand(Director->AddString(label));
 	}
 
-	code_pos += sizeof( uint32_t );
-
 	*code_pos++ = iParamCount;
 }
 
@@ -911,8 +928,7 @@ void ScriptCompiler::EmitMethodExpression( int iParamCount, uintptr_t eventnum,
 {
 	if( iParamCount > 5 )
 	{
-		SetOpcodeVarStackOffset( OP_EXEC_METHOD_COUNT1, -iParamCount );
-		EmitOpcode( OP_EXEC_METHOD_COUNT1, sourcePos );
+		EmitOpcode( OP_EXEC_METHOD_COUNT1, -iParamCount, sourcePos );
 
 		*code_pos++ = iParamCount;
 	}
@@ -921,8 +937,7 @@ void ScriptCompiler::EmitMethodExpression( int iParamCount, uintptr_t eventnum,
 		EmitOpcode( OP_EXEC_METHOD0 + iParamCount, sourcePos );
 	}
 
-	*reinterpret_cast<uint32_t *>( code_pos ) = (uint32_t)eventnum;
-	code_pos += sizeof( uint32_t );
+	EmitEventOperand( eventnum, scriptRelocationType_e::ReturnEvent );
 }
 
 void ScriptCompiler::EmitNil( uint32_t sourcePos )
@@ -975,9 +990,13 @@ int ScriptCompiler::EmitNot( uint32_t sourcePos )
 }
 
 void ScriptCompiler::EmitOpcode( int opcode, uint32_t sourcePos )
+{
+	EmitOpcode( opcode, OpcodeVarStackOffset( opcode ), sourcePos );
+}
+
+void ScriptCompiler::EmitOpcode( int opcode, int iVarStackOffset, uint32_t sourcePos )
 {
 	int IsExternal;
-	int iVarStackOffset;
 
 	if( code_pos == NULL )
 	{
@@ -997,7 +1016,6 @@ void ScriptCompiler::EmitOpcode( int opcode, uint32_t sourcePos )
 	}
 
 	IsExternal = IsExternalOpcode( opcode );
-	iVarStackOffset = OpcodeVarStackOffset( opcode );
 
 	if( IsExternal )
 	{
@@ -1034,6 +1052,8 @@ void ScriptCompiler::EmitOpcode( int opcode, uint32_t sourcePos )
 	}
 	*/
 
+	FuseWithPrevOpcode( opcode );
+
 	prev_opcode_pos = ( prev_opcode_pos + 1 ) % 100;
 	prev_opcodes[ prev_opcode_pos ].opcode = opcode;
 	prev_opcodes[ prev_opcode_pos ].VarStackOffset = iVarStackOffset;
@@ -1064,8 +1084,7 @@ void ScriptCompiler::EmitParameter( sval_t lhs, uint32_t sourcePos )
 		EmitOpcode( OP_STORE_PARAM, sourcePos );
 		EmitOpcode( OP_LOAD_GAME_VAR + listener_val.node[ 1 ].byteValue, sourcePos );
 
-		*reinterpret_cast< uint32_t * >( code_pos ) = index;
-		code_pos += sizeof( uint32_t );
+		EmitStringOperand( index );
 	}
 }
 
@@ -1115,8 +1134,7 @@ void ScriptCompiler::EmitRef( sval_t val, uint32_t sourcePos )
 	EmitValue( val.node[ 1 ] );
 	EmitOpcode( OP_STORE_FIELD_REF, sourcePos );
 
-	*reinterpret_cast< uint32_t * >( code_pos ) = index;
-	code_pos += sizeof( uint32_t );
+	EmitStringOperand( index );
 }
 
 void ScriptCompiler::EmitStatementList( sval_t val )
@@ -1129,6 +1147,22 @@ void ScriptCompiler::EmitStatementList( sval_t val )
 	}
 }
 
+void ScriptCompiler::EmitStringOperand( uint32_t index )
+{
+	AddRelocation( code_pos, scriptRelocationType_e::String );
+
+	*reinterpret_cast< uint32_t * >( code_pos ) = index;
+	code_pos += sizeof( uint32_t );
+}
+
+void ScriptCompiler::EmitEventOperand( uintptr_t eventnum, scriptRelocationType_e type )
+{
+	AddRelocation( code_pos, type );
+
+	*reinterpret_cast< uint32_t * >( code_pos ) = ( uint32_t )eventnum;
+	code_pos += sizeof( uint32_t );
+}
+
 void ScriptCompiler::EmitString( str value, uint32_t sourcePos )
 {
 	ScriptManagerPtr Director = GetScriptManager();
@@ -1143,8 +1177,7 @@ void ScriptCompiler::EmitString( str value, uint32_t sourcePos )
 
 	EmitOpcode( OP_STORE_STRING, sourcePos );
 
-	*reinterpret_cast< uint32_t * >( code_pos ) = index;
-	code_pos += sizeof( uint32_t );
+	EmitStringOperand( index );
 }
 
 void ScriptCompiler::EmitSwitch( sval_t val, uint32_t sourcePos )
@@ -1158,6 +1191,7 @@ void ScriptCompiler::EmitSwitch( sval_t val, uint32_t sourcePos )
 
 	EmitOpcode( OP_SWITCH, sourcePos );
 
+	AddRelocation( code_pos, scriptRelocationType_e::SwitchState );
 	*reinterpret_cast<StateScript **>(code_pos) = stateScript;
 	code_pos += sizeof(StateScript *);
 
@@ -1279,16 +1313,14 @@ __emit:
 			EmitFunction( iParamCount, val.node[ 1 ], val.node[ 3 ].sourcePosValue );
 			EmitOpcode( OP_LOAD_LOCAL_VAR, val.node[ 3 ].sourcePosValue );
 
-			*reinterpret_cast< uint32_t * >( code_pos ) = GetScriptManager()->AddString( "" );
-			code_pos += sizeof( uint32_t );
+			EmitStringOperand( GetScriptManager()->AddString( "" ) );
 		}
 		else
 		{
 			int iParamCount = EmitParameterList(val.node[2]);
 			if( iParamCount > 5 )
 			{
-				SetOpcodeVarStackOffset( OP_EXEC_CMD_COUNT1, -iParamCount );
-				EmitOpcode( OP_EXEC_CMD_COUNT1, val.node[ 3 ].sourcePosValue );
+				EmitOpcode( OP_EXEC_CMD_COUNT1, -iParamCount, val.node[ 3 ].sourcePosValue );
 
 				*code_pos++ = iParamCount;
 			}
@@ -1297,8 +1329,7 @@ __emit:
 				EmitOpcode( OP_EXEC_CMD0 + iParamCount, val.node[ 3 ].sourcePosValue );
 			}
 
-			*reinterpret_cast<uint32_t *>(code_pos) = (uint32_t)eventnum;
-			code_pos += sizeof( uint32_t );
+			EmitEventOperand( eventnum, scriptRelocationType_e::NormalEvent );
 		}
 		break;
 	}
@@ -1319,8 +1350,9 @@ __emit:
 		}
 		else
 		{
-			int iParamCount = EmitParameterList(val.node[2]);
+			// the VM expects the listener below the parameters
 			EmitOpcode(OP_STORE_LOCAL, val.node[3].sourcePosValue);
+			int iParamCount = EmitParameterList(val.node[2]);
 			EmitMethodExpression( iParamCount, eventnum, val.node[ 3 ].sourcePosValue );
 		}
 		break;
@@ -1342,8 +1374,7 @@ __emit:
 			EmitFunction( iParamCount, val.node[ 2 ], val.node[ 4 ].sourcePosValue );
 			EmitOpcode( OP_LOAD_LOCAL_VAR, val.node[ 3 ].sourcePosValue );
 
-			*reinterpret_cast< uint32_t * >( code_pos ) = GetScriptManager()->AddString( "" );
-			code_pos += sizeof( uint32_t );
+			EmitStringOperand( GetScriptManager()->AddString( "" ) );
 		}
 		else
 		{
@@ -1352,8 +1383,7 @@ __emit:
 			int iParamCount = EmitParameterList(val.node[3]);
 			if( iParamCount > 5 )
 			{
-				SetOpcodeVarStackOffset( OP_EXEC_CMD_METHOD_COUNT1, -iParamCount - 1 );
-				EmitOpcode( OP_EXEC_CMD_METHOD_COUNT1, val.node[ 4 ].sourcePosValue );
+				EmitOpcode( OP_EXEC_CMD_METHOD_COUNT1, -iParamCount - 1, val.node[ 4 ].sourcePosValue );
 
 				*code_pos++ = iParamCount;
 			}
@@ -1362,8 +1392,7 @@ __emit:
 				EmitOpcode( OP_EXEC_CMD_METHOD0 + iParamCount, val.node[ 4 ].sourcePosValue );
 			}
 
-			*reinterpret_cast<uint32_t*>(code_pos) = (uint32_t)eventnum;
-			code_pos += sizeof( uint32_t );
+			EmitEventOperand( eventnum, scriptRelocationType_e::NormalEvent );
 		}
 		break;
 	}
@@ -1384,8 +1413,9 @@ __emit:
 		}
 		else
 		{
-			int iParamCount = EmitParameterList(val.node[3]);
+			// the VM expects the listener below the parameters
 			EmitValue(val.node[1]);
+			int iParamCount = EmitParameterList(val.node[3]);
 			EmitMethodExpression( iParamCount, eventnum, val.node[ 4 ].sourcePosValue );
 		}
 		break;
@@ -1750,6 +1780,27 @@ void ScriptCompiler::ProcessContinueJumpLocations( int iStartContinueJumpLocCoun
 	}
 }
 
+void ScriptCompiler::AddRelocation( unsigned char *pos, scriptRelocationType_e type )
+{
+	script_relocation_t reloc;
+	reloc.offset = ( uint32_t )( pos - code_ptr );
+	reloc.type = type;
+
+	script->m_Relocations.AddObject( reloc );
+}
+
+void ScriptCompiler::RemoveRelocations( unsigned char *pos )
+{
+	const uint32_t offset = ( uint32_t )( pos - code_ptr );
+	Container< script_relocation_t >& relocations = script->m_Relocations;
+
+	// relocations are recorded in code order
+	while( relocations.NumObjects() && relocations[ relocations.NumObjects() - 1 ].offset >= offset )
+	{
+		relocations.RemoveObjectAt( relocations.NumObjects() );
+	}
+}
+
 unsigned char *ScriptCompiler::GetPosition()
 {
 	return code_pos;
@@ -1810,6 +1861,7 @@ size_t ScriptCompiler::Parse( GameScript *gameScript, char *sourceBuffer )
 			// an error occured
 
 			yylex_destroy();
+			parsetree_freeall();
 
 			if( !parsedata.exc.yytext )
 			{
@@ -1829,6 +1881,8 @@ size_t ScriptCompiler::Parse( GameScript *gameScript, char *sourceBuffer )
 	catch( ScriptException& exc )
 	{
 		exc;
+		yylex_destroy();
+		parsetree_freeall();
 		return 0;
 	}
 
@@ -1852,6 +1906,7 @@ size_t ScriptCompiler::Compile( GameScript *gameScript, unsigned char *progBuffe
 	prog_ptr = progBuffer;
 
 	gameScript->m_ProgToSource = new con_set < unsigned char *, sourceinfo_t >;
+	gameScript->m_Relocations.ClearObjectList();
 
 	compileSuccess = true;
 
@@ -1962,43 +2017,66 @@ void ScriptCompiler::CompileAssemble( const char *filename, const char *outputfi
 		return;
 	}
 
-	/*
-	arc.Create( outputfile );
+	const uint64_t sourceHash = GameScript::GetSourceHash( gameScript->m_SourceBuffer, gameScript->m_SourceLength );
+	SaveCompiledScript( gameScript, outputfile, sourceHash );
+}
 
-	if( !arc.NoErrors() )
+bool ScriptCompiler::GetCompiledScript( GameScript *scr, const char *filename, uint64_t sourceHash )
+{
+	FILE *file = fopen( filename, "rb" );
+	if( !file )
 	{
-		//glbs.DPrintf( "Error saving to file '%s'\n", filename );
-		return;
+		return false;
 	}
 
-	gameScript->m_bPrecompiled = true;
-	gameScript->Archive( arc );
+	fseek( file, 0, SEEK_END );
+	const long fileLength = ftell( file );
+	fseek( file, 0, SEEK_SET );
 
-	// dump the compiled script to file
-	arc.Close();
-	*/
-}
+	if( fileLength <= 0 )
+	{
+		fclose( file );
+		return false;
+	}
 
-bool ScriptCompiler::GetCompiledScript( GameScript *scr )
-{
-	/*
-	Archiver arc;
+	uint8_t *buffer = new uint8_t[ fileLength ];
+	const size_t numRead = fread( buffer, 1, fileLength, file );
+	fclose( file );
 
-	arc.SetSilent( true );
-	arc.Read( scr->Filename(), false );
+	bool success = false;
+	if( numRead == ( size_t )fileLength )
+	{
+		success = scr->LoadCompiled( buffer, numRead, sourceHash );
+	}
 
-	if( !arc.NoErrors() )
+	delete[] buffer;
+
+	return success;
+}
+
+bool ScriptCompiler::SaveCompiledScript( GameScript *scr, const char *filename, uint64_t sourceHash )
+{
+	Container< uint8_t > data;
+	if( !scr->SaveCompiled( sourceHash, data ) )
 	{
 		return false;
 	}
 
-	arc.SetSilent( false );
+	FILE *file = fopen( filename, "wb" );
+	if( !file )
+	{
+		return false;
+	}
 
-	scr->Archive( arc );
+	const size_t written = fwrite( data.Data(), 1, data.NumObjects(), file );
+	fclose( file );
 
-	arc.Close();
+	if( written != data.NumObjects() )
+	{
+		// don't leave a truncated script behind
+		remove( filename );
+		return false;
+	}
 
 	return true;
-	*/
-	return false;
 }
@@ -593,6 +593,7 @@ Event::Event()
 	fromScript = false;
 	eventnum = 0;
 	dataSize = 0;
+	maxDataSize = 0;
 	data = nullptr;
 }
 
@@ -601,9 +602,43 @@ Event::Event(uintptr_t eventnum)
 	fromScript = false;
 	this->eventnum = eventnum;
 	dataSize = 0;
+	maxDataSize = 0;
 	data = nullptr;
 }
 
+Event::Event(const Event& other)
+	: ScriptClass(other)
+{
+	fromScript = other.fromScript;
+	eventnum = other.eventnum;
+	dataSize = 0;
+	maxDataSize = 0;
+	data = nullptr;
+#ifdef _DEBUG
+	name = other.name;
+#endif
+
+	CopyArgs(other);
+}
+
+Event& Event::operator=(const Event& other)
+{
+	if (this != &other)
+	{
+		Clear();
+
+		fromScript = other.fromScript;
+		eventnum = other.eventnum;
+#ifdef _DEBUG
+		name = other.name;
+#endif
+
+		CopyArgs(other);
+	}
+
+	return *this;
+}
+
 Event::Event(const char *command, unsigned int flags, const char *formatspec, const char *argument_names, const char *documentation, uint8_t type)
 {
 	EventDef* e = new EventDef;
@@ -622,6 +657,7 @@ Event::Event(const char *command, unsigned int flags, const char *formatspec, co
 
 	fromScript = false;
 	dataSize = 0;
+	maxDataSize = 0;
 	data = NULL;
 	eventnum = 0;
 }
@@ -719,10 +755,71 @@ void Event::Clear(void)
 {
 	if (data)
 	{
-		delete[] data;
+		FreeArgs();
 
 		data = NULL;
 		dataSize = 0;
+		maxDataSize = 0;
+	}
+}
+
+void Event::ReserveArgs(uint16_t count)
+{
+	if (count <= maxDataSize) {
+		return;
+	}
+
+	if (!data && count <= INLINE_ARGS)
+	{
+		data = inlineData;
+		maxDataSize = INLINE_ARGS;
+		return;
+	}
+
+	// the data may have been assigned directly without a capacity
+	if (count < dataSize) {
+		count = dataSize;
+	}
+
+	ScriptVariable *newData = new ScriptVariable[count];
+	for (uint16_t i = 0; i < dataSize; i++) {
+		newData[i] = data[i];
+	}
+
+	if (data) {
+		FreeArgs();
+	}
+
+	data = newData;
+	maxDataSize = count;
+}
+
+void Event::CopyArgs(const Event& other)
+{
+	if (!other.dataSize) {
+		return;
+	}
+
+	ReserveArgs(other.dataSize);
+
+	for (uint16_t i = 0; i < other.dataSize; i++) {
+		data[i] = other.data[i];
+	}
+
+	dataSize = other.dataSize;
+}
+
+void Event::FreeArgs()
+{
+	if (data == inlineData)
+	{
+		// keep the storage, only release what the values hold
+		for (uint16_t i = 0; i < INLINE_ARGS; i++) {
+			inlineData[i].Clear();
+		}
+	}
+	else {
+		delete[] data;
 	}
 }
 
@@ -797,25 +894,11 @@ ScriptVariable&	Event::GetValue(uintptr_t pos)
 
 ScriptVariable&	Event::GetValue()
 {
-	ScriptVariable *tmp = data;
-
-	AssetManagerPtr AM = GetAssetManager();
-
-	data = new ScriptVariable[dataSize + 1];
-
-	if (tmp != NULL)
-	{
-		for (int i = 0; i < dataSize; i++)
-		{
-			data[i] = tmp[i];
-		}
-
-		delete[] tmp;
+	if (dataSize >= maxDataSize) {
+		ReserveArgs(dataSize < INLINE_ARGS ? INLINE_ARGS : dataSize * 2);
 	}
 
-	dataSize++;
-
-	return data[dataSize - 1];
+	return data[dataSize++];
 }
 
 Vector Event::GetVector(uintptr_t pos)
@@ -3,7 +3,13 @@
 #include <MOHPC/Script/Compiler.h>
 #include <MOHPC/Script/ScriptVariable.h>
 #include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Managers/EventManager.h>
 #include <MOHPC/Managers/ScriptManager.h>
+#include <MOHPC/Misc/crc32.h>
+#include <MOHPC/Version.h>
+
+#include <map>
+#include <type_traits>
 
 using namespace MOHPC;
 
@@ -421,6 +427,13 @@ void GameScript::Close(void)
 
 	m_CatchBlocks.FreeObjectList();
 
+	for (intptr_t i = m_SwitchStates.NumObjects(); i > 0; i--)
+	{
+		delete m_SwitchStates.ObjectAt(i);
+	}
+
+	m_SwitchStates.FreeObjectList();
+
 	if (m_ProgToSource)
 	{
 		delete m_ProgToSource;
@@ -439,15 +452,18 @@ void GameScript::Close(void)
 		m_SourceBuffer = NULL;
 	}
 
+	m_Relocations.FreeObjectList();
+
 	m_ProgLength = 0;
 	m_SourceLength = 0;
 	m_bPrecompiled = false;
 }
 
-void GameScript::Load(const void *sourceBuffer, size_t sourceLength)
+void GameScript::SetSource(const void *sourceBuffer, size_t sourceLength)
 {
-	size_t nodeLength;
-	char *m_PreprocessedBuffer;
+	if (m_SourceBuffer) {
+		free(m_SourceBuffer);
+	}
 
 	m_SourceBuffer = (char *)malloc(sourceLength + 1);
 	m_SourceLength = sourceLength;
@@ -455,13 +471,28 @@ void GameScript::Load(const void *sourceBuffer, size_t sourceLength)
 	m_SourceBuffer[sourceLength] = 0;
 
 	memcpy(m_SourceBuffer, sourceBuffer, sourceLength);
+}
+
+void GameScript::Load(const void *sourceBuffer, size_t sourceLength)
+{
+	MemoryTagScope tagScope(memoryTag_e::Script);
+
+	size_t nodeLength;
+	char *m_PreprocessedBuffer;
 
-	ScriptCompiler* Compiler = new ScriptCompiler();
-	Compiler->Reset();
+	SetSource(sourceBuffer, sourceLength);
 
-	m_PreprocessedBuffer = Compiler->Preprocess(m_SourceBuffer);
-	nodeLength = Compiler->Parse(this, m_PreprocessedBuffer);
-	Compiler->Preclean(m_PreprocessedBuffer);
+	// each script has its own compiler, so that scripts can be compiled from multiple threads
+	ScriptCompiler Compiler;
+	Compiler.InitAssetManager(this);
+	Compiler.Reset();
+
+	// labels are added by name
+	m_State->InitAssetManager(this);
+
+	m_PreprocessedBuffer = Compiler.Preprocess(m_SourceBuffer);
+	nodeLength = Compiler.Parse(this, m_PreprocessedBuffer);
+	Compiler.Preclean(m_PreprocessedBuffer);
 
 	if (!nodeLength)
 	{
@@ -470,7 +501,7 @@ void GameScript::Load(const void *sourceBuffer, size_t sourceLength)
 	}
 
 	m_ProgBuffer = (unsigned char *)malloc(nodeLength);
-	m_ProgLength = Compiler->Compile(this, m_ProgBuffer);
+	m_ProgLength = Compiler.Compile(this, m_ProgBuffer);
 
 	if (!m_ProgLength)
 	{
@@ -478,9 +509,697 @@ void GameScript::Load(const void *sourceBuffer, size_t sourceLength)
 		return Close();
 	}
 
-	requiredStackSize = Compiler->m_iInternalMaxVarStackOffset + 9 * Compiler->m_iMaxExternalVarStackOffset + 1;
+	requiredStackSize = Compiler.m_iInternalMaxVarStackOffset + 9 * Compiler.m_iMaxExternalVarStackOffset + 1;
+
+	successCompile = true;
+}
+
+static constexpr char COMPILED_SCRIPT_IDENT[4] = { 'S', 'C', 'R', 'C' };
+
+namespace MOHPC
+{
+	struct compiledScriptHeader_t
+	{
+		char ident[4];
+		uint32_t version;
+		// version of the library that compiled the script, opcodes may differ between versions
+		uint32_t engineVersion[4];
+		// size of pointers, switch operands are stored with their native size
+		uint32_t pointerSize;
+		// crc32 of everything after the header
+		uint32_t dataCrc;
+		uint64_t sourceHash;
+		uint64_t dataLength;
+	};
+
+	struct compiledLabel_t
+	{
+		uint32_t name;
+		uint32_t offset;
+		bool isPrivate;
+	};
+
+	struct compiledStateScript_t
+	{
+		Container<compiledLabel_t> labels;
+	};
+
+	struct compiledRelocation_t
+	{
+		script_relocation_t reloc;
+		uint32_t index;
+	};
+
+	struct compiledCatchBlock_t
+	{
+		uint32_t tryStart;
+		uint32_t tryEnd;
+		compiledStateScript_t state;
+	};
+
+	struct compiledSourceInfo_t
+	{
+		uint32_t offset;
+		sourceinfo_t info;
+	};
+
+	/**
+	 * Write a compiled script into a growing buffer.
+	 */
+	class compiledScriptWriter
+	{
+	private:
+		Container<uint8_t>& data;
+		size_t pos;
+
+	public:
+		compiledScriptWriter(Container<uint8_t>& dataRef)
+			: data(dataRef)
+			, pos(0)
+		{
+		}
+
+		void write(const void* value, size_t size)
+		{
+			if (pos + size > data.NumObjects()) {
+				data.SetNumObjectsUninitialized(data.NumObjects() * 2 + size);
+			}
+
+			memcpy(data.Data() + pos, value, size);
+			pos += size;
+		}
+
+		/** Trim the buffer to what has been written. */
+		void finish()
+		{
+			data.SetNumObjectsUninitialized(pos);
+		}
+
+		template<typename T>
+		compiledScriptWriter& operator<<(T value)
+		{
+			static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be written directly");
+			write(&value, sizeof(value));
+			return *this;
+		}
+
+		compiledScriptWriter& operator<<(const str& value)
+		{
+			const uint32_t len = (uint32_t)value.length();
+			*this << len;
+			write(value.c_str(), len);
+			return *this;
+		}
+	};
+
+	/**
+	 * Read a compiled script, without going past the end of the buffer.
+	 */
+	class compiledScriptReader
+	{
+	private:
+		const uint8_t* data;
+		size_t dataSize;
+		size_t dataPos;
+		bool overflowed;
+
+	public:
+		compiledScriptReader(const uint8_t* inData, size_t inDataSize)
+			: data(inData)
+			, dataSize(inDataSize)
+			, dataPos(0)
+			, overflowed(false)
+		{
+		}
+
+		const uint8_t* read(size_t size)
+		{
+			if (size > dataSize - dataPos)
+			{
+				dataPos = dataSize;
+				overflowed = true;
+				return nullptr;
+			}
+
+			const uint8_t* value = data + dataPos;
+			dataPos += size;
+			return value;
+		}
+
+		bool hasOverflowed() const
+		{
+			return overflowed;
+		}
+
+		bool isFullyRead() const
+		{
+			return dataPos == dataSize;
+		}
+
+		template<typename T>
+		compiledScriptReader& operator>>(T& value)
+		{
+			static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be read directly");
+			const uint8_t* p = read(sizeof(value));
+			if (p) memcpy(&value, p, sizeof(value));
+			else value = T();
+			return *this;
+		}
+
+		compiledScriptReader& operator>>(str& value)
+		{
+			uint32_t len = 0;
+			*this >> len;
+
+			const uint8_t* p = read(len);
+			// an empty string can be the last thing in the buffer, str() would read its first character
+			value = p && len ? str((const char*)p, len) : str();
+			return *this;
+		}
+
+		/** Read an element count, failing if there can't be that many elements left. */
+		uint32_t readCount(size_t minElementSize)
+		{
+			uint32_t count = 0;
+			*this >> count;
+
+			if (count > (dataSize - dataPos) / minElementSize)
+			{
+				dataPos = dataSize;
+				overflowed = true;
+				return 0;
+			}
+
+			return count;
+		}
+	};
+}
+
+static uint32_t GetRelocationSize(scriptRelocationType_e type)
+{
+	return type == scriptRelocationType_e::SwitchState ? sizeof(StateScript*) : sizeof(uint32_t);
+}
+
+/*
+====================
+SaveStateScript
+
+Labels are written in the order they were added, so that the first label stays the default one.
+====================
+*/
+static void SaveStateScript(compiledScriptWriter& ar, const Container<script_label_t*>& labels, const unsigned char* progBuffer, std::map<const_str, uint32_t>& stringIndexes, Container<const_str>& strings)
+{
+	ar << (uint32_t)labels.NumObjects();
+
+	for (size_t i = 0; i < labels.NumObjects(); ++i)
+	{
+		const script_label_t* label = labels[i];
+
+		const auto it = stringIndexes.find(label->key);
+		uint32_t nameIndex;
+		if (it == stringIndexes.end())
+		{
+			nameIndex = (uint32_t)strings.NumObjects();
+			stringIndexes[label->key] = nameIndex;
+			strings.AddObject(label->key);
+		}
+		else {
+			nameIndex = it->second;
+		}
+
+		ar << nameIndex;
+		ar << (uint32_t)(label->codepos - progBuffer);
+		ar << (uint8_t)label->isprivate;
+	}
+}
+
+static void ReadStateScript(compiledScriptReader& ar, compiledStateScript_t& state)
+{
+	const uint32_t numLabels = ar.readCount(sizeof(uint32_t) * 2 + 1);
+	state.labels.SetNumObjects(numLabels);
+
+	for (size_t i = 0; i < numLabels; ++i)
+	{
+		compiledLabel_t& label = state.labels[i];
+
+		uint8_t isPrivate = 0;
+		ar >> label.name >> label.offset >> isPrivate;
+		label.isPrivate = isPrivate != 0;
+	}
+}
+
+static bool ValidateStateScript(const compiledStateScript_t& state, size_t numStrings, size_t progLength)
+{
+	for (size_t i = 0; i < state.labels.NumObjects(); ++i)
+	{
+		const compiledLabel_t& label = state.labels[i];
+		if (label.name >= numStrings || label.offset > progLength) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void LoadStateScript(StateScript* stateScript, const compiledStateScript_t& state, unsigned char* progBuffer, const Container<const_str>& strings)
+{
+	for (size_t i = 0; i < state.labels.NumObjects(); ++i)
+	{
+		const compiledLabel_t& label = state.labels[i];
+		stateScript->AddLabel(strings[label.name], progBuffer + label.offset, label.isPrivate);
+	}
+}
+
+uint64_t GameScript::GetSourceHash(const void *sourceBuffer, size_t sourceLength)
+{
+	// include the length to make collisions less likely
+	return ((uint64_t)sourceLength << 32) | crc32_hash(sourceBuffer, sourceLength, 0);
+}
+
+bool GameScript::SaveCompiled(uint64_t sourceHash, Container<uint8_t>& out)
+{
+	if (!successCompile || !m_ProgBuffer) {
+		return false;
+	}
+
+	ScriptManagerPtr Director = GetScriptManager();
+	EventManagerPtr eventManager = GetEventManager();
+
+	// strings are stored once, operands and labels refer to them by index
+	std::map<const_str, uint32_t> stringIndexes;
+	Container<const_str> strings;
+	Container<str> eventNames;
+
+	Container<compiledRelocation_t> relocations;
+	Container<StateScript*> switchStates;
+	relocations.Resize(m_Relocations.NumObjects());
+
+	for (size_t i = 0; i < m_Relocations.NumObjects(); ++i)
+	{
+		const script_relocation_t& reloc = m_Relocations[i];
+		if (reloc.offset + GetRelocationSize(reloc.type) > m_ProgLength) {
+			return false;
+		}
+
+		const unsigned char* operand = m_ProgBuffer + reloc.offset;
+
+		compiledRelocation_t compiledReloc;
+		compiledReloc.reloc = reloc;
+
+		switch (reloc.type)
+		{
+		case scriptRelocationType_e::String:
+		{
+			const_str value;
+			memcpy(&value, operand, sizeof(value));
+
+			const auto it = stringIndexes.find(value);
+			if (it == stringIndexes.end())
+			{
+				compiledReloc.index = (uint32_t)strings.NumObjects();
+				stringIndexes[value] = compiledReloc.index;
+				strings.AddObject(value);
+			}
+			else {
+				compiledReloc.index = it->second;
+			}
+			break;
+		}
+		case scriptRelocationType_e::NormalEvent:
+		case scriptRelocationType_e::ReturnEvent:
+		{
+			uint32_t eventnum;
+			memcpy(&eventnum, operand, sizeof(eventnum));
+
+			// events are looked up again by name, their number depends on registration order
+			compiledReloc.index = (uint32_t)eventNames.NumObjects();
+			eventNames.AddObject(eventManager->GetEventName(eventnum));
+			break;
+		}
+		case scriptRelocationType_e::SwitchState:
+		{
+			StateScript* stateScript;
+			memcpy(&stateScript, operand, sizeof(stateScript));
+
+			compiledReloc.index = (uint32_t)switchStates.NumObjects();
+			switchStates.AddObject(stateScript);
+			break;
+		}
+		default:
+			return false;
+		}
+
+		relocations.AddObject(compiledReloc);
+	}
+
+	compiledScriptHeader_t header;
+	memset(&header, 0, sizeof(header));
+
+	out.FreeObjectList();
+	compiledScriptWriter ar(out);
+	ar.write(&header, sizeof(header));
+
+	ar << (uint32_t)m_ProgLength;
+	ar << (uint32_t)requiredStackSize;
+
+	// the program, with the process-specific operands cleared so the output only depends on the source
+	const size_t progStart = sizeof(header) + sizeof(uint32_t) * 2;
+	ar.write(m_ProgBuffer, m_ProgLength);
+	for (size_t i = 0; i < relocations.NumObjects(); ++i)
+	{
+		const script_relocation_t& reloc = relocations[i].reloc;
+		memset(out.Data() + progStart + reloc.offset, 0, GetRelocationSize(reloc.type));
+	}
+
+	ar << (uint32_t)relocations.NumObjects();
+	for (size_t i = 0; i < relocations.NumObjects(); ++i)
+	{
+		ar << relocations[i].reloc.offset;
+		ar << (uint8_t)relocations[i].reloc.type;
+		ar << relocations[i].index;
+	}
+
+	ar << (uint32_t)eventNames.NumObjects();
+	for (size_t i = 0; i < eventNames.NumObjects(); ++i) {
+		ar << eventNames[i];
+	}
+
+	SaveStateScript(ar, m_State->reverse_label_list, m_ProgBuffer, stringIndexes, strings);
+
+	ar << (uint32_t)switchStates.NumObjects();
+	for (size_t i = 0; i < switchStates.NumObjects(); ++i) {
+		SaveStateScript(ar, switchStates[i]->reverse_label_list, m_ProgBuffer, stringIndexes, strings);
+	}
+
+	ar << (uint32_t)m_CatchBlocks.NumObjects();
+	for (size_t i = 0; i < m_CatchBlocks.NumObjects(); ++i)
+	{
+		const CatchBlock* catchBlock = m_CatchBlocks[i];
+		ar << (uint32_t)(catchBlock->m_TryStartCodePos - m_ProgBuffer);
+		ar << (uint32_t)(catchBlock->m_TryEndCodePos - m_ProgBuffer);
+		SaveStateScript(ar, catchBlock->m_StateScript.reverse_label_list, m_ProgBuffer, stringIndexes, strings);
+	}
+
+	// source positions, so that errors are reported the same way as a freshly compiled script
+	Container<compiledSourceInfo_t> sourceInfos;
+	if (m_ProgToSource)
+	{
+		con_set_enum<unsigned char*, sourceinfo_t> en = *m_ProgToSource;
+		Entry<unsigned char*, sourceinfo_t>* e;
+
+		for (e = en.NextElement(); e != NULL; e = en.NextElement())
+		{
+			// entries of absorbed opcodes can be past the end
+			if (e->key >= m_ProgBuffer && e->key <= m_ProgBuffer + m_ProgLength)
+			{
+				compiledSourceInfo_t info;
+				info.offset = (uint32_t)(e->key - m_ProgBuffer);
+				info.info = e->value;
+				sourceInfos.AddObject(info);
+			}
+		}
+
+		// entries come in the hash order of their address, sort them so the output only depends on the source
+		sourceInfos.Sort([](const void* elem1, const void* elem2) -> int
+		{
+			const uint32_t offset1 = ((const compiledSourceInfo_t*)elem1)->offset;
+			const uint32_t offset2 = ((const compiledSourceInfo_t*)elem2)->offset;
+			return offset1 < offset2 ? -1 : offset1 > offset2 ? 1 : 0;
+		});
+	}
+
+	ar << (uint32_t)sourceInfos.NumObjects();
+	for (size_t i = 0; i < sourceInfos.NumObjects(); ++i)
+	{
+		const compiledSourceInfo_t& info = sourceInfos[i];
+		ar << info.offset;
+		ar << info.info.sourcePos;
+		ar << info.info.column;
+		ar << info.info.line;
+	}
+
+	// the string table is written last as labels add to it
+	ar << (uint32_t)strings.NumObjects();
+	for (size_t i = 0; i < strings.NumObjects(); ++i) {
+		ar << Director->GetString(strings[i]);
+	}
+
+	ar.finish();
+
+	const uint8_t* scriptData = out.Data() + sizeof(header);
+	const size_t scriptLength = out.NumObjects() - sizeof(header);
+
+	memcpy(header.ident, COMPILED_SCRIPT_IDENT, sizeof(header.ident));
+	header.version = COMPILED_VERSION;
+	header.engineVersion[0] = VERSION_MAJOR;
+	header.engineVersion[1] = VERSION_MINOR;
+	header.engineVersion[2] = VERSION_PATCH;
+	header.engineVersion[3] = VERSION_BUILD;
+	header.pointerSize = sizeof(uintptr_t);
+	header.dataCrc = crc32_hash(scriptData, scriptLength, 0);
+	header.sourceHash = sourceHash;
+	header.dataLength = scriptLength;
+	memcpy(out.Data(), &header, sizeof(header));
+
+	return true;
+}
+
+bool GameScript::LoadCompiled(const uint8_t *data, size_t length, uint64_t sourceHash)
+{
+	if (m_ProgBuffer || length < sizeof(compiledScriptHeader_t)) {
+		return false;
+	}
+
+	compiledScriptHeader_t header;
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header.ident, COMPILED_SCRIPT_IDENT, sizeof(header.ident))
+		|| header.version != COMPILED_VERSION
+		|| header.engineVersion[0] != VERSION_MAJOR
+		|| header.engineVersion[1] != VERSION_MINOR
+		|| header.engineVersion[2] != VERSION_PATCH
+		|| header.engineVersion[3] != VERSION_BUILD
+		|| header.pointerSize != sizeof(uintptr_t))
+	{
+		return false;
+	}
+
+	if (header.sourceHash != sourceHash || header.dataLength != length - sizeof(header)) {
+		return false;
+	}
+
+	const uint8_t* scriptData = data + sizeof(header);
+	if (crc32_hash(scriptData, (size_t)header.dataLength, 0) != header.dataCrc) {
+		return false;
+	}
+
+	//
+	// read and validate everything before touching the script
+	//
+	compiledScriptReader ar(scriptData, (size_t)header.dataLength);
+
+	uint32_t progLength = 0;
+	uint32_t stackSize = 0;
+	ar >> progLength >> stackSize;
+
+	const uint8_t* progData = ar.read(progLength);
+
+	const uint32_t numRelocations = ar.readCount(sizeof(uint32_t) * 2 + 1);
+	Container<compiledRelocation_t> relocations;
+	relocations.SetNumObjects(numRelocations);
+	for (size_t i = 0; i < numRelocations; ++i)
+	{
+		compiledRelocation_t& reloc = relocations[i];
+
+		uint8_t type = 0;
+		ar >> reloc.reloc.offset >> type >> reloc.index;
+		reloc.reloc.type = (scriptRelocationType_e)type;
+	}
+
+	const uint32_t numEvents = ar.readCount(sizeof(uint32_t));
+	Container<str> eventNames;
+	eventNames.SetNumObjects(numEvents);
+	for (size_t i = 0; i < numEvents; ++i) {
+		ar >> eventNames[i];
+	}
+
+	compiledStateScript_t mainState;
+	ReadStateScript(ar, mainState);
+
+	const uint32_t numSwitchStates = ar.readCount(sizeof(uint32_t));
+	Container<compiledStateScript_t> switchStates;
+	switchStates.SetNumObjects(numSwitchStates);
+	for (size_t i = 0; i < numSwitchStates; ++i) {
+		ReadStateScript(ar, switchStates[i]);
+	}
+
+	const uint32_t numCatchBlocks = ar.readCount(sizeof(uint32_t) * 3);
+	Container<compiledCatchBlock_t> catchBlocks;
+	catchBlocks.SetNumObjects(numCatchBlocks);
+	for (size_t i = 0; i < numCatchBlocks; ++i)
+	{
+		compiledCatchBlock_t& catchBlock = catchBlocks[i];
+		ar >> catchBlock.tryStart >> catchBlock.tryEnd;
+		ReadStateScript(ar, catchBlock.state);
+	}
+
+	const uint32_t numSourceInfos = ar.readCount(sizeof(uint32_t) * 4);
+	Container<compiledSourceInfo_t> sourceInfos;
+	sourceInfos.SetNumObjects(numSourceInfos);
+	for (size_t i = 0; i < numSourceInfos; ++i)
+	{
+		compiledSourceInfo_t& info = sourceInfos[i];
+		ar >> info.offset >> info.info.sourcePos >> info.info.column >> info.info.line;
+	}
+
+	const uint32_t numStrings = ar.readCount(sizeof(uint32_t));
+	Container<str> strings;
+	strings.SetNumObjects(numStrings);
+	for (size_t i = 0; i < numStrings; ++i) {
+		ar >> strings[i];
+	}
+
+	if (ar.hasOverflowed() || !ar.isFullyRead() || !progData) {
+		return false;
+	}
+
+	for (size_t i = 0; i < numRelocations; ++i)
+	{
+		const compiledRelocation_t& reloc = relocations[i];
+
+		size_t numTargets;
+		switch (reloc.reloc.type)
+		{
+		case scriptRelocationType_e::String:
+			numTargets = numStrings;
+			break;
+		case scriptRelocationType_e::NormalEvent:
+		case scriptRelocationType_e::ReturnEvent:
+			numTargets = numEvents;
+			break;
+		case scriptRelocationType_e::SwitchState:
+			numTargets = numSwitchStates;
+			break;
+		default:
+			return false;
+		}
+
+		if (reloc.index >= numTargets || reloc.reloc.offset + GetRelocationSize(reloc.reloc.type) > progLength) {
+			return false;
+		}
+	}
+
+	if (!ValidateStateScript(mainState, numStrings, progLength)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < numSwitchStates; ++i)
+	{
+		if (!ValidateStateScript(switchStates[i], numStrings, progLength)) {
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < numCatchBlocks; ++i)
+	{
+		const compiledCatchBlock_t& catchBlock = catchBlocks[i];
+		if (catchBlock.tryStart > progLength || catchBlock.tryEnd > progLength || !ValidateStateScript(catchBlock.state, numStrings, progLength)) {
+			return false;
+		}
+	}
+
+	// resolve events by name, the script must be recompiled if any of them is gone
+	EventManagerPtr eventManager = GetEventManager();
+	Container<uint32_t> eventNums;
+	eventNums.SetNumObjects(numEvents);
+	for (size_t i = 0; i < numRelocations; ++i)
+	{
+		const compiledRelocation_t& reloc = relocations[i];
+		if (reloc.reloc.type == scriptRelocationType_e::NormalEvent) {
+			eventNums[reloc.index] = (uint32_t)eventManager->FindNormalEventNum(eventNames[reloc.index]);
+		}
+		else if (reloc.reloc.type == scriptRelocationType_e::ReturnEvent) {
+			eventNums[reloc.index] = (uint32_t)eventManager->FindReturnEventNum(eventNames[reloc.index]);
+		}
+		else {
+			continue;
+		}
+
+		if (!eventNums[reloc.index]) {
+			return false;
+		}
+	}
+
+	//
+	// everything is valid, build the script
+	//
+	ScriptManagerPtr Director = GetScriptManager();
+
+	Container<const_str> constStrings;
+	constStrings.SetNumObjects(numStrings);
+	for (size_t i = 0; i < numStrings; ++i) {
+		constStrings[i] = Director->AddString(strings[i]);
+	}
+
+	m_ProgBuffer = (unsigned char *)malloc(progLength);
+	m_ProgLength = progLength;
+	memcpy(m_ProgBuffer, progData, progLength);
+
+	Container<StateScript*> switchStateScripts;
+	switchStateScripts.SetNumObjects(numSwitchStates);
+	for (size_t i = 0; i < numSwitchStates; ++i)
+	{
+		switchStateScripts[i] = CreateSwitchStateScript();
+		LoadStateScript(switchStateScripts[i], switchStates[i], m_ProgBuffer, constStrings);
+	}
+
+	m_Relocations.FreeObjectList();
+	m_Relocations.Resize(numRelocations);
+
+	for (size_t i = 0; i < numRelocations; ++i)
+	{
+		const compiledRelocation_t& reloc = relocations[i];
+		unsigned char* operand = m_ProgBuffer + reloc.reloc.offset;
 
+		switch (reloc.reloc.type)
+		{
+		case scriptRelocationType_e::String:
+			memcpy(operand, &constStrings[reloc.index], sizeof(uint32_t));
+			break;
+		case scriptRelocationType_e::NormalEvent:
+		case scriptRelocationType_e::ReturnEvent:
+			memcpy(operand, &eventNums[reloc.index], sizeof(uint32_t));
+			break;
+		case scriptRelocationType_e::SwitchState:
+			memcpy(operand, &switchStateScripts[reloc.index], sizeof(StateScript*));
+			break;
+		}
+
+		m_Relocations.AddObject(reloc.reloc);
+	}
+
+	LoadStateScript(m_State, mainState, m_ProgBuffer, constStrings);
+
+	for (size_t i = 0; i < numCatchBlocks; ++i)
+	{
+		const compiledCatchBlock_t& catchBlock = catchBlocks[i];
+
+		StateScript* stateScript = CreateCatchStateScript(m_ProgBuffer + catchBlock.tryStart, m_ProgBuffer + catchBlock.tryEnd);
+		LoadStateScript(stateScript, catchBlock.state, m_ProgBuffer, constStrings);
+	}
+
+	if (numSourceInfos)
+	{
+		m_ProgToSource = new con_set<unsigned char *, sourceinfo_t>;
+		for (size_t i = 0; i < numSourceInfos; ++i) {
+			m_ProgToSource->addKeyValue(m_ProgBuffer + sourceInfos[i].offset) = sourceInfos[i].info;
+		}
+	}
+
+	requiredStackSize = stackSize;
 	successCompile = true;
+
+	return true;
 }
 
 bool GameScript::GetCodePos(unsigned char *codePos, str& filename, uintptr_t& pos)
@@ -538,6 +1257,7 @@ StateScript *GameScript::CreateCatchStateScript(unsigned char *try_begin_code_po
 {
 	CatchBlock *catchBlock = new CatchBlock;
 
+	catchBlock->m_StateScript.InitAssetManager(this);
 	catchBlock->m_TryStartCodePos = try_begin_code_pos;
 	catchBlock->m_TryEndCodePos = try_end_code_pos;
 
@@ -548,7 +1268,12 @@ StateScript *GameScript::CreateCatchStateScript(unsigned char *try_begin_code_po
 
 StateScript *GameScript::CreateSwitchStateScript(void)
 {
-	return new StateScript();
+	StateScript* stateScript = new StateScript();
+	stateScript->InitAssetManager(this);
+
+	m_SwitchStates.AddObject(stateScript);
+
+	return stateScript;
 }
 
 StateScript *GameScript::GetCatchStateScript(unsigned char *in, unsigned char *&out)
@@ -311,6 +311,8 @@ void Entry< const_str, ConList >::Archive(Archiver& arc)
 
 Listener::Listener()
 {
+	m_pendingEvents = NULL;
+
 	m_EndList = NULL;
 
 	m_NotifyList = NULL;
@@ -414,18 +416,16 @@ void Listener::CancelEventsOfType(Event *ev)
 
 	EventManagerPtr eventManager = GetEventManager();
 
-	node = eventManager->EventQueue.next;
-
 	eventnum = ev->eventnum;
-	while (node != &eventManager->EventQueue)
+	for (node = m_pendingEvents; node; node = next)
 	{
 		next = node->next;
-		if ((node->GetSourceObject() == this) && (node->event->eventnum == eventnum))
+		if (node->event->eventnum == eventnum)
 		{
-			LL_Remove(node, next, prev);
-			delete node;
+			delete node->event;
+			eventManager->RemoveEventNode(node);
+			eventManager->FreeEventNode(node);
 		}
-		node = next;
 	}
 }
 
@@ -441,39 +441,34 @@ void Listener::CancelFlaggedEvents(int flags)
 
 	EventManagerPtr eventManager = GetEventManager();
 
-	node = eventManager->EventQueue.next;
-
-	while (node != &eventManager->EventQueue)
+	for (node = m_pendingEvents; node; node = next)
 	{
 		next = node->next;
-		if ((node->GetSourceObject() == this) && (node->flags & flags))
+		if (node->flags & flags)
 		{
-			LL_Remove(node, next, prev);
-			delete node;
+			delete node->event;
+			eventManager->RemoveEventNode(node);
+			eventManager->FreeEventNode(node);
 		}
-		node = next;
 	}
 }
 
 void Listener::CancelPendingEvents(void)
 {
 	EventQueueNode *node;
-	EventQueueNode *next;
+
+	if (!m_pendingEvents) {
+		return;
+	}
 
 	EventManagerPtr eventManager = GetEventManager();
 	if (eventManager)
 	{
-		node = eventManager->EventQueue.next;
-
-		while (node != &eventManager->EventQueue)
+		while ((node = m_pendingEvents) != NULL)
 		{
-			next = node->next;
-			if (node->GetSourceObject() == this)
-			{
-				LL_Remove(node, next, prev);
-				delete node;
-			}
-			node = next;
+			delete node->event;
+			eventManager->RemoveEventNode(node);
+			eventManager->FreeEventNode(node);
 		}
 	}
 }
@@ -483,20 +478,14 @@ bool Listener::EventPending(Event &ev)
 	EventQueueNode *event;
 	uintptr_t eventnum;
 
-	EventManagerPtr eventManager = GetEventManager();
-
-	event = eventManager->EventQueue.next;
-
 	eventnum = ev.eventnum;
 
-	while (event != &eventManager->EventQueue)
+	for (event = m_pendingEvents; event; event = event->next)
 	{
-		if ((event->GetSourceObject() == this) && (event->event->eventnum))
+		if (event->event->eventnum == eventnum)
 		{
 			return true;
 		}
-
-		event = event->next;
 	}
 
 	return false;
@@ -505,7 +494,6 @@ bool Listener::EventPending(Event &ev)
 EventQueueNode *Listener::PostEventInternal(Event *ev, float delay, int flags)
 {
 	EventQueueNode *node;
-	EventQueueNode *i;
 	float time;
 
 	if (!classinfo()->responseLookup[ev->eventnum])
@@ -525,17 +513,11 @@ EventQueueNode *Listener::PostEventInternal(Event *ev, float delay, int flags)
 		return NULL;
 	}
 
-	node = new EventQueueNode;
-
 	EventManagerPtr eventManager = GetEventManager();
 
-	i = eventManager->EventQueue.next;
-	time = GetGameManager()->GetLevel()->GetTimeSeconds() + (delay + 0.0005f);
+	node = eventManager->AllocateEventNode();
 
-	while (i != &eventManager->EventQueue && time > i->time)
-	{
-		i = i->next;
-	}
+	time = GetGameManager()->GetLevel()->GetTimeSeconds() + (delay + 0.0005f);
 
 	node->time = time;
 	node->event = ev;
@@ -546,7 +528,7 @@ EventQueueNode *Listener::PostEventInternal(Event *ev, float delay, int flags)
 	node->name = ev->name;
 #endif
 
-	LL_Add(i, node, next, prev);
+	eventManager->InsertEventNode(node);
 
 	return node;
 }
@@ -566,66 +548,46 @@ void Listener::PostEvent(const Event &ev, float delay, int flags)
 bool Listener::PostponeAllEvents(float time)
 {
 	EventQueueNode *event;
-	EventQueueNode *node;
-	
-	EventManagerPtr eventManager = GetEventManager();
+	EventQueueNode *first = NULL;
 
-	event = eventManager->EventQueue.next;
-	while (event != &eventManager->EventQueue)
+	// only the first event in the queue is postponed
+	for (event = m_pendingEvents; event; event = event->next)
 	{
-		if (event->GetSourceObject() == this)
-		{
-			event->time += time + 0.0005f;
-
-			node = event->next;
-			while ((node != &eventManager->EventQueue) && (event->time >= node->time))
-			{
-				node = node->next;
-			}
-
-			LL_Remove(event, next, prev);
-			LL_Add(node, event, next, prev);
-
-			return true;
+		if (!first || EventManager::EventFiresBefore(event, first)) {
+			first = event;
 		}
-		event = event->next;
 	}
 
-	return false;
+	if (!first) {
+		return false;
+	}
+
+	GetEventManager()->RescheduleEventNode(first, first->time + time + 0.0005f);
+	return true;
 }
 
-bool Listener::PostponeEvent(Event &ev, float time)
+bool Listener::PostponeEvent(Event& ev, float time)
 {
 	EventQueueNode *event;
-	EventQueueNode *node;
+	EventQueueNode *first = NULL;
 	uintptr_t eventnum;
 
 	eventnum = ev.eventnum;
 
-	EventManagerPtr eventManager = GetEventManager();
-
-	event = eventManager->EventQueue.next;
-	while (event != &eventManager->EventQueue)
+	// only the first event of this type in the queue is postponed
+	for (event = m_pendingEvents; event; event = event->next)
 	{
-		if ((event->GetSourceObject() == this) && (event->event->eventnum == eventnum))
-		{
-			event->time += time + 0.0005f;
-
-			node = event->next;
-			while ((node != &eventManager->EventQueue) && (event->time >= node->time))
-			{
-				node = node->next;
-			}
-
-			LL_Remove(event, next, prev);
-			LL_Add(node, event, next, prev);
-
-			return true;
+		if (event->event->eventnum == eventnum && (!first || EventManager::EventFiresBefore(event, first))) {
+			first = event;
 		}
-		event = event->next;
 	}
 
-	return false;
+	if (!first) {
+		return false;
+	}
+
+	GetEventManager()->RescheduleEventNode(first, first->time + time + 0.0005f);
+	return true;
 }
 
 bool Listener::ProcessEvent(Event *ev)
@@ -658,6 +620,8 @@ bool Listener::ProcessEvent(Event *ev)
 
 	response = responses->response;
 
+	ScriptVariableContext variableContext(this);
+
 	try
 	{
 		if (response)
@@ -715,6 +679,8 @@ ScriptVariable Listener::ProcessEventReturn(Event *ev)
 
 	size_t previousArgs = ev->NumArgs();
 
+	ScriptVariableContext variableContext(this);
+
 	if (response)
 	{
 		(this->*response)(ev);
@@ -770,6 +736,8 @@ bool Listener::ProcessScriptEvent(Event &ev)
 
 	response = responses->response;
 
+	ScriptVariableContext variableContext(this);
+
 	if (response)
 	{
 		(this->*response)(&ev);
@@ -791,6 +759,7 @@ void Listener::ProcessContainerEvent(const Container< Event * >& conev)
 bool Listener::ProcessPendingEvents(void)
 {
 	EventQueueNode *event;
+	EventQueueNode *first;
 	bool processedEvents;
 	float t;
 
@@ -800,41 +769,30 @@ bool Listener::ProcessPendingEvents(void)
 
 	EventManagerPtr eventManager = GetEventManager();
 
-	event = eventManager->EventQueue.next;
-	while (event != &eventManager->EventQueue)
+	for (;;)
 	{
-		Listener *obj;
-
-		assert(event);
-
-		obj = event->GetSourceObject();
-
-		if (event->time > t)
+		// process the events of this listener in queue order
+		first = NULL;
+		for (event = m_pendingEvents; event; event = event->next)
 		{
-			break;
+			if (event->time <= t && (!first || EventManager::EventFiresBefore(event, first))) {
+				first = event;
+			}
 		}
 
-		if (obj != this)
-		{
-			// traverse normally
-			event = event->next;
+		if (!first) {
+			break;
 		}
-		else
-		{
-			// the event is removed from its list and temporarily added to the active list
-			LL_Remove(event, next, prev);
-
-			// ProcessEvent will dispose of this event when it is done
-			obj->ProcessEvent(event->event);
 
-			// free up the node
-			delete event;
+		// the event is removed from the queue, the node can be reused right away
+		Event* ev = first->event;
+		eventManager->RemoveEventNode(first);
+		eventManager->FreeEventNode(first);
 
-			// start over, since can't guarantee that we didn't process any previous or following events
-			event = eventManager->EventQueue.next;
+		// ProcessEvent will dispose of this event when it is done
+		ProcessEvent(ev);
 
-			processedEvents = true;
-		}
+		processedEvents = true;
 	}
 
 	return processedEvents;
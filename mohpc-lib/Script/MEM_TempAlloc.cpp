@@ -14,6 +14,9 @@ void *MEM_TempAlloc::Alloc( size_t len )
 	unsigned char *prev_block = m_CurrentMemoryBlock;
 	unsigned char *result;
 
+	// strings and parse tree nodes are allocated one after another, keep nodes aligned
+	len = ( len + alignof( void * ) - 1 ) & ~( alignof( void * ) - 1 );
+
 	if( m_CurrentMemoryBlock && m_CurrentMemoryPos + len <= 65536 )
 	{
 		result = m_CurrentMemoryBlock + m_CurrentMemoryPos + sizeof( unsigned char * );
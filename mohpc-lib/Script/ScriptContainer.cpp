@@ -20,6 +20,8 @@ ScriptContainer::ScriptContainer(GameScript *gameScript, Listener *self)
 	m_Script = gameScript;
 	m_Threads = NULL;
 
+	InitAssetManager(gameScript->GetAssetManager());
+
 	ScriptManagerPtr Director = GetScriptManager();
 	LL_SafeAddFirst(Director->ContainerHead, this, Next, Prev);
 }
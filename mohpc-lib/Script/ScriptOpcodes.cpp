@@ -144,8 +144,20 @@ static opcode_t OpcodeInfo[] =
 
 		{ "OPCODE_END",								1,				-1,			0 },
 		{ "OPCODE_RETURN",							1,				-1,			0 },
+
+		// the length is the one of the first opcode, the stack offset is the one of the whole pair
+		{ "OPCODE_BIN_EQUALITY_VAR_JUMP_FALSE4",	1,				-2,			0 },
+		{ "OPCODE_BIN_INEQUALITY_VAR_JUMP_FALSE4",	1,				-2,			0 },
+		{ "OPCODE_BIN_LESS_THAN_VAR_JUMP_FALSE4",	1,				-2,			0 },
+		{ "OPCODE_BIN_GREATER_THAN_VAR_JUMP_FALSE4",	1,			-2,			0 },
+		{ "OPCODE_BIN_LESS_THAN_OR_EQUAL_VAR_JUMP_FALSE4",	1,		-2,			0 },
+		{ "OPCODE_BIN_GREATER_THAN_OR_EQUAL_VAR_JUMP_FALSE4",	1,	-2,			0 },
+		{ "OPCODE_STORE_INT1_BIN_PLUS",				1 + sizeof( char ),				0,			0 },
+		{ "OPCODE_STORE_INT1_BIN_MINUS",			1 + sizeof( char ),				0,			0 },
 };
 
+static_assert(sizeof(OpcodeInfo) / sizeof(OpcodeInfo[0]) == OP_MAX, "OpcodeInfo must have one entry per opcode");
+
 static const char *aszVarGroupNames[] =
 {
 	"game",
@@ -184,4 +196,55 @@ bool IsExternalOpcode(int opcode)
 {
 	return OpcodeInfo[opcode].isexternal ? true : false;
 }
+
+/*
+====================
+SuperOpcode
+
+Returns the superinstruction executing opcode followed by nextOpcode,
+or opcode if there is none.
+
+The pairs were picked from what the compiler emits, not from a profile:
+every if/while/for with a comparison compiles to the comparison followed
+by OP_VAR_JUMP_FALSE4 (the boolean cast is absorbed by the jump),
+and adding or subtracting a small constant (local.i += 2, local.i - 1)
+loads it with OP_STORE_INT1 right before OP_BIN_PLUS/OP_BIN_MINUS.
+Both are found in most script loops.
+====================
+*/
+int SuperOpcode(int opcode, int nextOpcode)
+{
+	switch (nextOpcode)
+	{
+	case OP_VAR_JUMP_FALSE4:
+		switch (opcode)
+		{
+		case OP_BIN_EQUALITY:
+			return OP_BIN_EQUALITY_VAR_JUMP_FALSE4;
+		case OP_BIN_INEQUALITY:
+			return OP_BIN_INEQUALITY_VAR_JUMP_FALSE4;
+		case OP_BIN_LESS_THAN:
+			return OP_BIN_LESS_THAN_VAR_JUMP_FALSE4;
+		case OP_BIN_GREATER_THAN:
+			return OP_BIN_GREATER_THAN_VAR_JUMP_FALSE4;
+		case OP_BIN_LESS_THAN_OR_EQUAL:
+			return OP_BIN_LESS_THAN_OR_EQUAL_VAR_JUMP_FALSE4;
+		case OP_BIN_GREATER_THAN_OR_EQUAL:
+			return OP_BIN_GREATER_THAN_OR_EQUAL_VAR_JUMP_FALSE4;
+		}
+		break;
+	case OP_BIN_PLUS:
+		if (opcode == OP_STORE_INT1) {
+			return OP_STORE_INT1_BIN_PLUS;
+		}
+		break;
+	case OP_BIN_MINUS:
+		if (opcode == OP_STORE_INT1) {
+			return OP_STORE_INT1_BIN_MINUS;
+		}
+		break;
+	}
+
+	return opcode;
+}
 };
\ No newline at end of file
@@ -1106,6 +1106,8 @@ ScriptThread::ScriptThread()
 
 ScriptThread::ScriptThread(ScriptContainer *scriptClass, unsigned char *pCodePos)
 {
+	InitAssetManager(scriptClass->GetAssetManager());
+
 	m_ScriptVM = new ScriptVM(scriptClass, pCodePos, this);
 	m_ScriptVM->m_ThreadState = THREAD_RUNNING;
 }
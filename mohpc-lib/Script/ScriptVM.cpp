@@ -28,6 +28,8 @@ ScriptVM::ScriptVM(ScriptContainer *scriptClass, unsigned char *pCodePos, Script
 	m_Thread = thread;
 	m_ScriptContainer = scriptClass;
 
+	InitAssetManager(scriptClass->GetAssetManager());
+
 	m_Stack = NULL;
 
 	m_PrevCodePos = NULL;
@@ -165,13 +167,9 @@ void ScriptVM::executeCommand(Listener *listener, uint16_t iParamCount, int even
 		var = pTop + 1;
 	}
 
-	AssetManagerPtr AM = GetAssetManager();
-
+	// commands rarely have more arguments than the event can store inline
+	ev.ReserveArgs(iParamCount);
 	ev.dataSize = iParamCount;
-	if (iParamCount)
-	{
-		ev.data = new ScriptVariable[ev.dataSize];
-	}
 
 	ev.fromScript = true;
 
@@ -446,6 +444,37 @@ void ScriptVM::End()
 	LeaveFunction();
 }
 
+/*
+ * When the compiler supports computed gotos, each opcode handler jumps
+ * straight to the handler of the next opcode through a table of labels,
+ * instead of going back to the top of the loop and through the switch.
+ * The loop is only resumed when the thread state changes, when the stack
+ * needs to be checked or on backward jumps, so the loop protection still applies.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(MOHPC_VM_NO_DIRECT_THREADING)
+#define MOHPC_VM_DIRECT_THREADED
+#endif
+
+#ifdef MOHPC_VM_DIRECT_THREADED
+#define VM_CASE(op) case op: vm_##op
+#define VM_DEFAULT default: vm_default
+#define VM_LABEL(op) &&vm_##op
+#define VM_DISPATCH() goto *(*opcode < OP_MAX ? dispatchTable[*opcode] : &&vm_default)
+#define VM_CAN_DISPATCH() (state == STATE_RUNNING && (m_bMarkStack || (pTop >= localStack && pTop < localStack + localStackSize)))
+#define VM_NEXT \
+	{ \
+		if (!VM_CAN_DISPATCH()) break; \
+		m_PrevCodePos = m_CodePos; \
+		eventCalled = false; \
+		opcode = m_CodePos++; \
+		VM_DISPATCH(); \
+	}
+#else
+#define VM_CASE(op) case op
+#define VM_DEFAULT default
+#define VM_NEXT break
+#endif
+
 void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 {
 	unsigned char *opcode;
@@ -467,11 +496,144 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 
 	ev.InitAssetManager(this);
 
+	// variables on the stack resolve strings with the managers of this VM
+	ScriptVariableContext variableContext(this);
+
 	static str str_null = "";
 	str& value = str_null;
 
 	ConSimple *targetList;
 
+#ifdef MOHPC_VM_DIRECT_THREADED
+	// must follow the order of opcode_e
+	static const void* const dispatchTable[] =
+	{
+		VM_LABEL(OP_DONE),
+		VM_LABEL(OP_BOOL_JUMP_FALSE4),
+		VM_LABEL(OP_BOOL_JUMP_TRUE4),
+		VM_LABEL(OP_VAR_JUMP_FALSE4),
+		VM_LABEL(OP_VAR_JUMP_TRUE4),
+		VM_LABEL(OP_BOOL_LOGICAL_AND),
+		VM_LABEL(OP_BOOL_LOGICAL_OR),
+		VM_LABEL(OP_VAR_LOGICAL_AND),
+		VM_LABEL(OP_VAR_LOGICAL_OR),
+		&&vm_default, // OP_BOOL_TO_VAR
+		VM_LABEL(OP_JUMP4),
+		VM_LABEL(OP_JUMP_BACK4),
+		VM_LABEL(OP_STORE_INT0),
+		VM_LABEL(OP_STORE_INT1),
+		VM_LABEL(OP_STORE_INT2),
+		VM_LABEL(OP_STORE_INT3),
+		VM_LABEL(OP_STORE_INT4),
+		VM_LABEL(OP_BOOL_STORE_FALSE),
+		VM_LABEL(OP_BOOL_STORE_TRUE),
+		VM_LABEL(OP_STORE_STRING),
+		VM_LABEL(OP_STORE_FLOAT),
+		VM_LABEL(OP_STORE_VECTOR),
+		VM_LABEL(OP_CALC_VECTOR),
+		VM_LABEL(OP_STORE_NULL),
+		VM_LABEL(OP_STORE_NIL),
+		VM_LABEL(OP_EXEC_CMD0),
+		VM_LABEL(OP_EXEC_CMD1),
+		VM_LABEL(OP_EXEC_CMD2),
+		VM_LABEL(OP_EXEC_CMD3),
+		VM_LABEL(OP_EXEC_CMD4),
+		VM_LABEL(OP_EXEC_CMD5),
+		VM_LABEL(OP_EXEC_CMD_COUNT1),
+		VM_LABEL(OP_EXEC_CMD_METHOD0),
+		VM_LABEL(OP_EXEC_CMD_METHOD1),
+		VM_LABEL(OP_EXEC_CMD_METHOD2),
+		VM_LABEL(OP_EXEC_CMD_METHOD3),
+		VM_LABEL(OP_EXEC_CMD_METHOD4),
+		VM_LABEL(OP_EXEC_CMD_METHOD5),
+		VM_LABEL(OP_EXEC_CMD_METHOD_COUNT1),
+		VM_LABEL(OP_EXEC_METHOD0),
+		VM_LABEL(OP_EXEC_METHOD1),
+		VM_LABEL(OP_EXEC_METHOD2),
+		VM_LABEL(OP_EXEC_METHOD3),
+		VM_LABEL(OP_EXEC_METHOD4),
+		VM_LABEL(OP_EXEC_METHOD5),
+		VM_LABEL(OP_EXEC_METHOD_COUNT1),
+		VM_LABEL(OP_LOAD_GAME_VAR),
+		VM_LABEL(OP_LOAD_LEVEL_VAR),
+		VM_LABEL(OP_LOAD_LOCAL_VAR),
+		VM_LABEL(OP_LOAD_PARM_VAR),
+		VM_LABEL(OP_LOAD_SELF_VAR),
+		VM_LABEL(OP_LOAD_GROUP_VAR),
+		VM_LABEL(OP_LOAD_OWNER_VAR),
+		VM_LABEL(OP_LOAD_FIELD_VAR),
+		VM_LABEL(OP_LOAD_ARRAY_VAR),
+		VM_LABEL(OP_LOAD_CONST_ARRAY1),
+		VM_LABEL(OP_STORE_FIELD_REF),
+		VM_LABEL(OP_STORE_ARRAY_REF),
+		VM_LABEL(OP_MARK_STACK_POS),
+		VM_LABEL(OP_STORE_PARAM),
+		VM_LABEL(OP_RESTORE_STACK_POS),
+		VM_LABEL(OP_LOAD_STORE_GAME_VAR),
+		VM_LABEL(OP_LOAD_STORE_LEVEL_VAR),
+		VM_LABEL(OP_LOAD_STORE_LOCAL_VAR),
+		VM_LABEL(OP_LOAD_STORE_PARM_VAR),
+		VM_LABEL(OP_LOAD_STORE_SELF_VAR),
+		VM_LABEL(OP_LOAD_STORE_GROUP_VAR),
+		VM_LABEL(OP_LOAD_STORE_OWNER_VAR),
+		VM_LABEL(OP_STORE_GAME_VAR),
+		VM_LABEL(OP_STORE_LEVEL_VAR),
+		VM_LABEL(OP_STORE_LOCAL_VAR),
+		VM_LABEL(OP_STORE_PARM_VAR),
+		VM_LABEL(OP_STORE_SELF_VAR),
+		VM_LABEL(OP_STORE_GROUP_VAR),
+		VM_LABEL(OP_STORE_OWNER_VAR),
+		VM_LABEL(OP_STORE_FIELD),
+		VM_LABEL(OP_STORE_ARRAY),
+		VM_LABEL(OP_STORE_GAME),
+		VM_LABEL(OP_STORE_LEVEL),
+		VM_LABEL(OP_STORE_LOCAL),
+		VM_LABEL(OP_STORE_PARM),
+		VM_LABEL(OP_STORE_SELF),
+		VM_LABEL(OP_STORE_GROUP),
+		VM_LABEL(OP_STORE_OWNER),
+		VM_LABEL(OP_BIN_BITWISE_AND),
+		VM_LABEL(OP_BIN_BITWISE_OR),
+		VM_LABEL(OP_BIN_BITWISE_EXCL_OR),
+		VM_LABEL(OP_BIN_EQUALITY),
+		VM_LABEL(OP_BIN_INEQUALITY),
+		VM_LABEL(OP_BIN_LESS_THAN),
+		VM_LABEL(OP_BIN_GREATER_THAN),
+		VM_LABEL(OP_BIN_LESS_THAN_OR_EQUAL),
+		VM_LABEL(OP_BIN_GREATER_THAN_OR_EQUAL),
+		VM_LABEL(OP_BIN_PLUS),
+		VM_LABEL(OP_BIN_MINUS),
+		VM_LABEL(OP_BIN_MULTIPLY),
+		VM_LABEL(OP_BIN_DIVIDE),
+		VM_LABEL(OP_BIN_PERCENTAGE),
+		VM_LABEL(OP_UN_MINUS),
+		VM_LABEL(OP_UN_COMPLEMENT),
+		VM_LABEL(OP_UN_TARGETNAME),
+		VM_LABEL(OP_BOOL_UN_NOT),
+		VM_LABEL(OP_VAR_UN_NOT),
+		VM_LABEL(OP_UN_CAST_BOOLEAN),
+		VM_LABEL(OP_UN_INC),
+		VM_LABEL(OP_UN_DEC),
+		VM_LABEL(OP_UN_SIZE),
+		VM_LABEL(OP_SWITCH),
+		VM_LABEL(OP_FUNC),
+		VM_LABEL(OP_NOP),
+		VM_LABEL(OP_BIN_SHIFT_LEFT),
+		VM_LABEL(OP_BIN_SHIFT_RIGHT),
+		&&vm_default, // OP_END
+		&&vm_default, // OP_RETURN
+		VM_LABEL(OP_BIN_EQUALITY_VAR_JUMP_FALSE4),
+		VM_LABEL(OP_BIN_INEQUALITY_VAR_JUMP_FALSE4),
+		VM_LABEL(OP_BIN_LESS_THAN_VAR_JUMP_FALSE4),
+		VM_LABEL(OP_BIN_GREATER_THAN_VAR_JUMP_FALSE4),
+		VM_LABEL(OP_BIN_LESS_THAN_OR_EQUAL_VAR_JUMP_FALSE4),
+		VM_LABEL(OP_BIN_GREATER_THAN_OR_EQUAL_VAR_JUMP_FALSE4),
+		VM_LABEL(OP_STORE_INT1_BIN_PLUS),
+		VM_LABEL(OP_STORE_INT1_BIN_MINUS),
+	};
+	static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == OP_MAX, "the dispatch table must have one entry per opcode");
+#endif
+
 	if (label != "")
 	{
 		// Throw if label is not found
@@ -580,149 +742,153 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 			eventCalled = false;
 
 			opcode = m_CodePos++;
+#ifdef MOHPC_VM_DIRECT_THREADED
+			VM_DISPATCH();
+#endif
 			switch (*opcode)
 			{
-			case OP_BIN_BITWISE_AND:
+			VM_CASE(OP_BIN_BITWISE_AND):
 				a = pTop--;
 				b = pTop;
 
 				*b &= *a;
-				break;
+				VM_NEXT;
 
-			case OP_BIN_BITWISE_OR:
+			VM_CASE(OP_BIN_BITWISE_OR):
 				a = pTop--;
 				b = pTop;
 
 				*b |= *a;
-				break;
+				VM_NEXT;
 
-			case OP_BIN_BITWISE_EXCL_OR:
+			VM_CASE(OP_BIN_BITWISE_EXCL_OR):
 				a = pTop--;
 				b = pTop;
 
 				*b ^= *a;
-				break;
+				VM_NEXT;
 
-			case OP_BIN_EQUALITY:
+			VM_CASE(OP_BIN_EQUALITY):
 				a = pTop--;
 				b = pTop;
 
 				b->setIntValue(*b == *a);
-				break;
+				VM_NEXT;
 
-			case OP_BIN_INEQUALITY:
+			VM_CASE(OP_BIN_INEQUALITY):
 				a = pTop--;
 				b = pTop;
 
 				b->setIntValue(*b != *a);
-				break;
+				VM_NEXT;
 
-			case OP_BIN_GREATER_THAN:
+			VM_CASE(OP_BIN_GREATER_THAN):
 				a = pTop--;
 				b = pTop;
 
 				b->greaterthan(*a);
-				break;
+				VM_NEXT;
 
-			case OP_BIN_GREATER_THAN_OR_EQUAL:
+			VM_CASE(OP_BIN_GREATER_THAN_OR_EQUAL):
 				a = pTop--;
 				b = pTop;
 
 				b->greaterthanorequal(*a);
-				break;
+				VM_NEXT;
 
-			case OP_BIN_LESS_THAN:
+			VM_CASE(OP_BIN_LESS_THAN):
 				a = pTop--;
 				b = pTop;
 
 				b->lessthan(*a);
-				break;
+				VM_NEXT;
 
-			case OP_BIN_LESS_THAN_OR_EQUAL:
+			VM_CASE(OP_BIN_LESS_THAN_OR_EQUAL):
 				a = pTop--;
 				b = pTop;
 
 				b->lessthanorequal(*a);
-				break;
+				VM_NEXT;
 
-			case OP_BIN_PLUS:
+			VM_CASE(OP_BIN_PLUS):
 				a = pTop--;
 				b = pTop;
 
 				*b += *a;
-				break;
+				VM_NEXT;
 
-			case OP_BIN_MINUS:
+			VM_CASE(OP_BIN_MINUS):
 				a = pTop--;
 				b = pTop;
 
 				*b -= *a;
-				break;
+				VM_NEXT;
 
-			case OP_BIN_MULTIPLY:
+			VM_CASE(OP_BIN_MULTIPLY):
 				a = pTop--;
 				b = pTop;
 
 				*b *= *a;
-				break;
+				VM_NEXT;
 
-			case OP_BIN_DIVIDE:
+			VM_CASE(OP_BIN_DIVIDE):
 				a = pTop--;
 				b = pTop;
 
 				*b /= *a;
-				break;
+				VM_NEXT;
 
-			case OP_BIN_PERCENTAGE:
+			VM_CASE(OP_BIN_PERCENTAGE):
 				a = pTop--;
 				b = pTop;
 
 				*b %= *a;
-				break;
+				VM_NEXT;
 
-			case OP_BIN_SHIFT_LEFT:
+			VM_CASE(OP_BIN_SHIFT_LEFT):
 				a = pTop--;
 				b = pTop;
 
 				*b <<= *a;
-				break;
+				VM_NEXT;
 
-			case OP_BIN_SHIFT_RIGHT:
+			VM_CASE(OP_BIN_SHIFT_RIGHT):
 				a = pTop--;
 				b = pTop;
 
 				*b >>= *a;
-				break;
+				VM_NEXT;
 
-			case OP_BOOL_JUMP_FALSE4:
+			VM_CASE(OP_BOOL_JUMP_FALSE4):
 				jumpBool(*reinterpret_cast<unsigned int *>(m_CodePos) + sizeof(unsigned int), !pTop->m_data.intValue);
 
 				pTop--;
 
-				break;
+				VM_NEXT;
 
-			case OP_BOOL_JUMP_TRUE4:
+			VM_CASE(OP_BOOL_JUMP_TRUE4):
 				jumpBool(*reinterpret_cast<unsigned int *>(m_CodePos) + sizeof(unsigned int), pTop->m_data.intValue ? true : false);
 
 				pTop--;
 
-				break;
+				VM_NEXT;
 
-			case OP_VAR_JUMP_FALSE4:
+			VM_CASE(OP_VAR_JUMP_FALSE4):
+			__varJumpFalse4:
 				jumpBool(*reinterpret_cast<unsigned int *>(m_CodePos) + sizeof(unsigned int), !pTop->booleanValue());
 
 				pTop--;
 
-				break;
+				VM_NEXT;
 
-			case OP_VAR_JUMP_TRUE4:
+			VM_CASE(OP_VAR_JUMP_TRUE4):
 				jumpBool(*reinterpret_cast<unsigned int *>(m_CodePos) + sizeof(unsigned int), pTop->booleanValue());
 
 				pTop--;
 
-				break;
+				VM_NEXT;
 
-			case OP_BOOL_LOGICAL_AND:
+			VM_CASE(OP_BOOL_LOGICAL_AND):
 				if (pTop->m_data.intValue)
 				{
 					pTop--;
@@ -733,9 +899,9 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 					m_CodePos += *reinterpret_cast<unsigned int *>(m_CodePos) + sizeof(unsigned int);
 				}
 
-				break;
+				VM_NEXT;
 
-			case OP_BOOL_LOGICAL_OR:
+			VM_CASE(OP_BOOL_LOGICAL_OR):
 				if (!pTop->m_data.intValue)
 				{
 					pTop--;
@@ -746,9 +912,9 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 					m_CodePos += *reinterpret_cast<unsigned int *>(m_CodePos) + sizeof(unsigned int);
 				}
 
-				break;
+				VM_NEXT;
 
-			case OP_VAR_LOGICAL_AND:
+			VM_CASE(OP_VAR_LOGICAL_AND):
 				if (pTop->booleanValue())
 				{
 					pTop--;
@@ -759,9 +925,9 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 					pTop->SetFalse();
 					m_CodePos += *reinterpret_cast<unsigned int *>(m_CodePos) + sizeof(unsigned int);
 				}
-				break;
+				VM_NEXT;
 
-			case OP_VAR_LOGICAL_OR:
+			VM_CASE(OP_VAR_LOGICAL_OR):
 				if (!pTop->booleanValue())
 				{
 					pTop--;
@@ -772,55 +938,55 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 					pTop->SetTrue();
 					m_CodePos += *reinterpret_cast<unsigned int *>(m_CodePos) + sizeof(unsigned int);
 				}
-				break;
+				VM_NEXT;
 
-			case OP_BOOL_STORE_FALSE:
+			VM_CASE(OP_BOOL_STORE_FALSE):
 				pTop++;
 				pTop->SetFalse();
-				break;
+				VM_NEXT;
 
-			case OP_BOOL_STORE_TRUE:
+			VM_CASE(OP_BOOL_STORE_TRUE):
 				pTop++;
 				pTop->SetTrue();
-				break;
+				VM_NEXT;
 
-			case OP_BOOL_UN_NOT:
+			VM_CASE(OP_BOOL_UN_NOT):
 				pTop->m_data.intValue = (pTop->m_data.intValue == 0);
-				break;
+				VM_NEXT;
 
-			case OP_CALC_VECTOR:
+			VM_CASE(OP_CALC_VECTOR):
 				c = pTop--;
 				b = pTop--;
 				a = pTop;
 
 				pTop->setVectorValue(Vector(a->floatValue(), b->floatValue(), c->floatValue()));
-				break;
+				VM_NEXT;
 
-			case OP_EXEC_CMD0:
+			VM_CASE(OP_EXEC_CMD0):
 				iParamCount = 0;
 				goto __execCmd;
 
-			case OP_EXEC_CMD1:
+			VM_CASE(OP_EXEC_CMD1):
 				iParamCount = 1;
 				goto __execCmd;
 
-			case OP_EXEC_CMD2:
+			VM_CASE(OP_EXEC_CMD2):
 				iParamCount = 2;
 				goto __execCmd;
 
-			case OP_EXEC_CMD3:
+			VM_CASE(OP_EXEC_CMD3):
 				iParamCount = 3;
 				goto __execCmd;
 
-			case OP_EXEC_CMD4:
+			VM_CASE(OP_EXEC_CMD4):
 				iParamCount = 4;
 				goto __execCmd;
 
-			case OP_EXEC_CMD5:
+			VM_CASE(OP_EXEC_CMD5):
 				iParamCount = 5;
 				goto __execCmd;
 
-			case OP_EXEC_CMD_COUNT1:
+			VM_CASE(OP_EXEC_CMD_COUNT1):
 				iParamCount = *m_CodePos++;
 
 			__execCmd:
@@ -839,29 +1005,29 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 					throw exc;
 				}
 
-				break;
+				VM_NEXT;
 
-			case OP_EXEC_CMD_METHOD0:
+			VM_CASE(OP_EXEC_CMD_METHOD0):
 				iParamCount = 0;
 				goto __execCmdMethod;
 
-			case OP_EXEC_CMD_METHOD1:
+			VM_CASE(OP_EXEC_CMD_METHOD1):
 				iParamCount = 1;
 				goto __execCmdMethod;
 
-			case OP_EXEC_CMD_METHOD2:
+			VM_CASE(OP_EXEC_CMD_METHOD2):
 				iParamCount = 2;
 				goto __execCmdMethod;
 
-			case OP_EXEC_CMD_METHOD3:
+			VM_CASE(OP_EXEC_CMD_METHOD3):
 				iParamCount = 3;
 				goto __execCmdMethod;
 
-			case OP_EXEC_CMD_METHOD4:
+			VM_CASE(OP_EXEC_CMD_METHOD4):
 				iParamCount = 4;
 				goto __execCmdMethod;
 
-			case OP_EXEC_CMD_METHOD5:
+			VM_CASE(OP_EXEC_CMD_METHOD5):
 				iParamCount = 5;
 				goto __execCmdMethod;
 
@@ -869,7 +1035,7 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 				m_CodePos--;
 				goto __execCmdMethodInternal;
 
-			case OP_EXEC_CMD_METHOD_COUNT1:
+			VM_CASE(OP_EXEC_CMD_METHOD_COUNT1):
 				iParamCount = *m_CodePos;
 
 			__execCmdMethodInternal:
@@ -909,36 +1075,36 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 
 				m_CodePos += sizeof(uint8_t) + sizeof(unsigned int);
 
-				break;
+				VM_NEXT;
 
-			case OP_EXEC_METHOD0:
+			VM_CASE(OP_EXEC_METHOD0):
 				iParamCount = 0;
 				goto __execMethod;
 
-			case OP_EXEC_METHOD1:
+			VM_CASE(OP_EXEC_METHOD1):
 				iParamCount = 1;
 				goto __execMethod;
 
-			case OP_EXEC_METHOD2:
+			VM_CASE(OP_EXEC_METHOD2):
 				iParamCount = 2;
 				goto __execMethod;
 
-			case OP_EXEC_METHOD3:
+			VM_CASE(OP_EXEC_METHOD3):
 				iParamCount = 3;
 				goto __execMethod;
 
-			case OP_EXEC_METHOD4:
+			VM_CASE(OP_EXEC_METHOD4):
 				iParamCount = 4;
 				goto __execMethod;
 
-			case OP_EXEC_METHOD5:
+			VM_CASE(OP_EXEC_METHOD5):
 				iParamCount = 5;
 
 			__execMethod:
 				m_CodePos--;
 				goto __execMethodInternal;
 
-			case OP_EXEC_METHOD_COUNT1:
+			VM_CASE(OP_EXEC_METHOD_COUNT1):
 				iParamCount = *m_CodePos;
 
 			__execMethodInternal:
@@ -968,9 +1134,9 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 
 				m_CodePos += sizeof(uint8_t) + sizeof(unsigned int);
 
-				break;
+				VM_NEXT;
 
-			case OP_FUNC:
+			VM_CASE(OP_FUNC):
 				ev.Clear();
 
 				if (!*m_CodePos++)
@@ -1068,23 +1234,24 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 				}
 				break;
 
-			case OP_JUMP4:
+			VM_CASE(OP_JUMP4):
 				m_CodePos += *reinterpret_cast<int *>(m_CodePos) + sizeof(unsigned int);
-				break;
+				VM_NEXT;
 
-			case OP_JUMP_BACK4:
+			VM_CASE(OP_JUMP_BACK4):
 				m_CodePos -= *reinterpret_cast<int *>(m_CodePos);
+				// go back to the loop for the loop protection
 				break;
 
-			case OP_LOAD_ARRAY_VAR:
+			VM_CASE(OP_LOAD_ARRAY_VAR):
 				a = pTop--;
 				b = pTop--;
 				c = pTop--;
 
 				b->setArrayAt(*a, *c);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_FIELD_VAR:
+			VM_CASE(OP_LOAD_FIELD_VAR):
 				a = pTop--;
 
 				try
@@ -1113,33 +1280,33 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 					throw exc;
 				}
 
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_CONST_ARRAY1:
+			VM_CASE(OP_LOAD_CONST_ARRAY1):
 				index = *reinterpret_cast<short *>(m_CodePos);
 				m_CodePos += sizeof(short);
 
 				pTop -= index - 1;
 				pTop->setConstArrayValue(pTop, index);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_GAME_VAR:
+			VM_CASE(OP_LOAD_GAME_VAR):
 				loadTop(gameManager->GetGame());
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_GROUP_VAR:
+			VM_CASE(OP_LOAD_GROUP_VAR):
 				loadTop(m_ScriptContainer);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_LEVEL_VAR:
+			VM_CASE(OP_LOAD_LEVEL_VAR):
 				loadTop(level);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_LOCAL_VAR:
+			VM_CASE(OP_LOAD_LOCAL_VAR):
 				loadTop(m_Thread);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_OWNER_VAR:
+			VM_CASE(OP_LOAD_OWNER_VAR):
 				if (!m_ScriptContainer->m_Self)
 				{
 					pTop--;
@@ -1155,13 +1322,13 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 				}
 
 				loadTop(m_ScriptContainer->m_Self->GetScriptOwner());
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_PARM_VAR:
+			VM_CASE(OP_LOAD_PARM_VAR):
 				loadTop(Director->GetParm());
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_SELF_VAR:
+			VM_CASE(OP_LOAD_SELF_VAR):
 				if (!m_ScriptContainer->m_Self)
 				{
 					pTop--;
@@ -1170,25 +1337,25 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 				}
 
 				loadTop(m_ScriptContainer->m_Self);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_STORE_GAME_VAR:
+			VM_CASE(OP_LOAD_STORE_GAME_VAR):
 				loadTop(gameManager->GetGame(), true);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_STORE_GROUP_VAR:
+			VM_CASE(OP_LOAD_STORE_GROUP_VAR):
 				loadTop(m_ScriptContainer, true);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_STORE_LEVEL_VAR:
+			VM_CASE(OP_LOAD_STORE_LEVEL_VAR):
 				loadTop(level, true);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_STORE_LOCAL_VAR:
+			VM_CASE(OP_LOAD_STORE_LOCAL_VAR):
 				loadTop(m_Thread, true);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_STORE_OWNER_VAR:
+			VM_CASE(OP_LOAD_STORE_OWNER_VAR):
 				if (!m_ScriptContainer->m_Self)
 				{
 					m_CodePos += sizeof(unsigned int);
@@ -1202,27 +1369,27 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 				}
 
 				loadTop(m_ScriptContainer->m_Self->GetScriptOwner(), true);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_STORE_PARM_VAR:
+			VM_CASE(OP_LOAD_STORE_PARM_VAR):
 				loadTop(Director->GetParm(), true);
-				break;
+				VM_NEXT;
 
-			case OP_LOAD_STORE_SELF_VAR:
+			VM_CASE(OP_LOAD_STORE_SELF_VAR):
 				if (!m_ScriptContainer->m_Self)
 				{
 					ScriptError("self is NULL");
 				}
 
 				loadTop(m_ScriptContainer->m_Self, true);
-				break;
+				VM_NEXT;
 
-			case OP_MARK_STACK_POS:
+			VM_CASE(OP_MARK_STACK_POS):
 				m_StackPos = pTop;
 				m_bMarkStack = true;
-				break;
+				VM_NEXT;
 
-			case OP_STORE_PARAM:
+			VM_CASE(OP_STORE_PARAM):
 				if (fastEvent->dataSize)
 				{
 					pTop = fastEvent->data++;
@@ -1233,25 +1400,25 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 					pTop = m_StackPos + 1;
 					pTop->Clear();
 				}
-				break;
+				VM_NEXT;
 
-			case OP_RESTORE_STACK_POS:
+			VM_CASE(OP_RESTORE_STACK_POS):
 				pTop = m_StackPos;
 				m_bMarkStack = false;
-				break;
+				VM_NEXT;
 
-			case OP_STORE_ARRAY:
+			VM_CASE(OP_STORE_ARRAY):
 				pTop--;
 				pTop->evalArrayAt(*(pTop + 1));
-				break;
+				VM_NEXT;
 
-			case OP_STORE_ARRAY_REF:
+			VM_CASE(OP_STORE_ARRAY_REF):
 				pTop--;
 				pTop->setArrayRefValue(*(pTop + 1));
-				break;
+				VM_NEXT;
 
-			case OP_STORE_FIELD_REF:
-			case OP_STORE_FIELD:
+			VM_CASE(OP_STORE_FIELD_REF):
+			VM_CASE(OP_STORE_FIELD):
 				try
 				{
 					value = Director->GetString(*reinterpret_cast<int *>(m_CodePos));
@@ -1286,68 +1453,68 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 
 					throw exc;
 				}
-				break;
+				VM_NEXT;
 
-			case OP_STORE_FLOAT:
+			VM_CASE(OP_STORE_FLOAT):
 				pTop++;
 				pTop->setFloatValue(*reinterpret_cast<float *>(m_CodePos));
 
 				m_CodePos += sizeof(float);
 
-				break;
+				VM_NEXT;
 
-			case OP_STORE_INT0:
+			VM_CASE(OP_STORE_INT0):
 				pTop++;
 				pTop->setIntValue(0);
 
-				break;
+				VM_NEXT;
 
-			case OP_STORE_INT1:
+			VM_CASE(OP_STORE_INT1):
 				pTop++;
 				pTop->setIntValue(*m_CodePos++);
 
-				break;
+				VM_NEXT;
 
-			case OP_STORE_INT2:
+			VM_CASE(OP_STORE_INT2):
 				pTop++;
 				pTop->setIntValue(*reinterpret_cast<short *>(m_CodePos));
 
 				m_CodePos += sizeof(short);
 
-				break;
+				VM_NEXT;
 
-			case OP_STORE_INT3:
+			VM_CASE(OP_STORE_INT3):
 				pTop++;
 				pTop->setIntValue(*reinterpret_cast<short3 *>(m_CodePos));
 
 				m_CodePos += sizeof(short3);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_INT4:
+			VM_CASE(OP_STORE_INT4):
 				pTop++;
 				pTop->setIntValue(*reinterpret_cast<int *>(m_CodePos));
 
 				m_CodePos += sizeof(int);
 
-				break;
+				VM_NEXT;
 
-			case OP_STORE_GAME_VAR:
+			VM_CASE(OP_STORE_GAME_VAR):
 				storeTop(gameManager->GetGame());
-				break;
+				VM_NEXT;
 
-			case OP_STORE_GROUP_VAR:
+			VM_CASE(OP_STORE_GROUP_VAR):
 				storeTop(m_ScriptContainer);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_LEVEL_VAR:
+			VM_CASE(OP_STORE_LEVEL_VAR):
 				storeTop(level);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_LOCAL_VAR:
+			VM_CASE(OP_STORE_LOCAL_VAR):
 				storeTop(m_Thread);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_OWNER_VAR:
+			VM_CASE(OP_STORE_OWNER_VAR):
 				if (!m_ScriptContainer->m_Self)
 				{
 					pTop++;
@@ -1363,13 +1530,13 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 				}
 
 				storeTop(m_ScriptContainer->m_Self->GetScriptOwner());
-				break;
+				VM_NEXT;
 
-			case OP_STORE_PARM_VAR:
+			VM_CASE(OP_STORE_PARM_VAR):
 				storeTop(Director->GetParm());
-				break;
+				VM_NEXT;
 
-			case OP_STORE_SELF_VAR:
+			VM_CASE(OP_STORE_SELF_VAR):
 				if (!m_ScriptContainer->m_Self)
 				{
 					pTop++;
@@ -1378,29 +1545,29 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 				}
 
 				storeTop(m_ScriptContainer->m_Self);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_GAME:
+			VM_CASE(OP_STORE_GAME):
 				pTop++;
 				pTop->setListenerValue(gameManager->GetGame());
-				break;
+				VM_NEXT;
 
-			case OP_STORE_GROUP:
+			VM_CASE(OP_STORE_GROUP):
 				pTop++;
 				pTop->setListenerValue(m_ScriptContainer);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_LEVEL:
+			VM_CASE(OP_STORE_LEVEL):
 				pTop++;
 				pTop->setListenerValue(level);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_LOCAL:
+			VM_CASE(OP_STORE_LOCAL):
 				pTop++;
 				pTop->setListenerValue(m_Thread);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_OWNER:
+			VM_CASE(OP_STORE_OWNER):
 				pTop++;
 
 				if (!m_ScriptContainer->m_Self)
@@ -1410,89 +1577,89 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 				}
 
 				pTop->setListenerValue(m_ScriptContainer->m_Self->GetScriptOwner());
-				break;
+				VM_NEXT;
 
-			case OP_STORE_PARM:
+			VM_CASE(OP_STORE_PARM):
 				pTop++;
 				pTop->setListenerValue(Director->GetParm());
-				break;
+				VM_NEXT;
 
-			case OP_STORE_SELF:
+			VM_CASE(OP_STORE_SELF):
 				pTop++;
 				pTop->setListenerValue(m_ScriptContainer->m_Self);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_NIL:
+			VM_CASE(OP_STORE_NIL):
 				pTop++;
 				pTop->Clear();
-				break;
+				VM_NEXT;
 
-			case OP_STORE_NULL:
+			VM_CASE(OP_STORE_NULL):
 				pTop++;
 				pTop->setListenerValue(NULL);
-				break;
+				VM_NEXT;
 
-			case OP_STORE_STRING:
+			VM_CASE(OP_STORE_STRING):
 				pTop++;
 				pTop->setConstStringValue(*reinterpret_cast<unsigned int *>(m_CodePos));
 
 				m_CodePos += sizeof(unsigned int);
 
-				break;
+				VM_NEXT;
 
-			case OP_STORE_VECTOR:
+			VM_CASE(OP_STORE_VECTOR):
 				pTop++;
 				pTop->setVectorValue(*reinterpret_cast<Vector *>(m_CodePos));
 
 				m_CodePos += sizeof(Vector);
 
-				break;
+				VM_NEXT;
 
-			case OP_SWITCH:
+			VM_CASE(OP_SWITCH):
 				if (!Switch(*reinterpret_cast<StateScript **>(m_CodePos), *pTop))
 				{
 					m_CodePos += sizeof(unsigned int);
 				}
 
 				pTop--;
-				break;
+				VM_NEXT;
 
-			case OP_UN_CAST_BOOLEAN:
+			VM_CASE(OP_UN_CAST_BOOLEAN):
 				pTop->CastBoolean();
-				break;
+				VM_NEXT;
 
-			case OP_UN_COMPLEMENT:
+			VM_CASE(OP_UN_COMPLEMENT):
 				pTop->complement();
-				break;
+				VM_NEXT;
 
-			case OP_UN_MINUS:
+			VM_CASE(OP_UN_MINUS):
 				pTop->minus();
-				break;
+				VM_NEXT;
 
-			case OP_UN_DEC:
+			VM_CASE(OP_UN_DEC):
 				(*pTop)--;
-				break;
+				VM_NEXT;
 
-			case OP_UN_INC:
+			VM_CASE(OP_UN_INC):
 				(*pTop)++;
-				break;
+				VM_NEXT;
 
-			case OP_UN_SIZE:
+			VM_CASE(OP_UN_SIZE):
 				pTop->setIntValue((int)pTop->size());
-				break;
+				VM_NEXT;
 
-			case OP_UN_TARGETNAME:
+			VM_CASE(OP_UN_TARGETNAME):
 				targetList = gameManager->GetWorld()->GetExistingTargetList(pTop->constStringValue());
 
 				if (!targetList)
 				{
 					pTop->setListenerValue(NULL);
 
-					if (*m_CodePos >= OP_BIN_EQUALITY && *m_CodePos <= OP_BIN_GREATER_THAN_OR_EQUAL || *m_CodePos >= OP_BOOL_UN_NOT && *m_CodePos <= OP_UN_CAST_BOOLEAN) {
+					if (*m_CodePos >= OP_BIN_EQUALITY && *m_CodePos <= OP_BIN_GREATER_THAN_OR_EQUAL || *m_CodePos >= OP_BOOL_UN_NOT && *m_CodePos <= OP_UN_CAST_BOOLEAN || *m_CodePos >= OP_BIN_EQUALITY_VAR_JUMP_FALSE4 && *m_CodePos <= OP_BIN_GREATER_THAN_OR_EQUAL_VAR_JUMP_FALSE4) {
 						ScriptError("Targetname '%s' does not exist.", pTop->stringValue().c_str());
 					}
 
-					break;
+					VM_NEXT;
 				}
 
 				if (targetList->NumObjects() == 1)
@@ -1509,27 +1676,100 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 
 					pTop->setListenerValue(NULL);
 
-					if (*m_CodePos >= OP_BIN_EQUALITY && *m_CodePos <= OP_BIN_GREATER_THAN_OR_EQUAL || *m_CodePos >= OP_BOOL_UN_NOT && *m_CodePos <= OP_UN_CAST_BOOLEAN) {
+					if (*m_CodePos >= OP_BIN_EQUALITY && *m_CodePos <= OP_BIN_GREATER_THAN_OR_EQUAL || *m_CodePos >= OP_BOOL_UN_NOT && *m_CodePos <= OP_UN_CAST_BOOLEAN || *m_CodePos >= OP_BIN_EQUALITY_VAR_JUMP_FALSE4 && *m_CodePos <= OP_BIN_GREATER_THAN_OR_EQUAL_VAR_JUMP_FALSE4) {
 						ScriptError("Targetname '%s' does not exist.", value.c_str());
 					}
 
-					break;
+					VM_NEXT;
 				}
 
-				break;
+				VM_NEXT;
 
-			case OP_VAR_UN_NOT:
+			VM_CASE(OP_VAR_UN_NOT):
 				pTop->setIntValue(pTop->booleanValue());
-				break;
+				VM_NEXT;
 
-			case OP_DONE:
+			VM_CASE(OP_DONE):
 				End();
-				break;
+				VM_NEXT;
 
-			case OP_NOP:
-				break;
+			VM_CASE(OP_NOP):
+				VM_NEXT;
+
+			//
+			// superinstructions, the second opcode of the pair is skipped and executed inline
+			//
+			VM_CASE(OP_BIN_EQUALITY_VAR_JUMP_FALSE4):
+				a = pTop--;
+				b = pTop;
+
+				b->setIntValue(*b == *a);
+				m_CodePos++;
+				goto __varJumpFalse4;
+
+			VM_CASE(OP_BIN_INEQUALITY_VAR_JUMP_FALSE4):
+				a = pTop--;
+				b = pTop;
+
+				b->setIntValue(*b != *a);
+				m_CodePos++;
+				goto __varJumpFalse4;
 
-			default:
+			VM_CASE(OP_BIN_LESS_THAN_VAR_JUMP_FALSE4):
+				a = pTop--;
+				b = pTop;
+
+				b->lessthan(*a);
+				m_CodePos++;
+				goto __varJumpFalse4;
+
+			VM_CASE(OP_BIN_GREATER_THAN_VAR_JUMP_FALSE4):
+				a = pTop--;
+				b = pTop;
+
+				b->greaterthan(*a);
+				m_CodePos++;
+				goto __varJumpFalse4;
+
+			VM_CASE(OP_BIN_LESS_THAN_OR_EQUAL_VAR_JUMP_FALSE4):
+				a = pTop--;
+				b = pTop;
+
+				b->lessthanorequal(*a);
+				m_CodePos++;
+				goto __varJumpFalse4;
+
+			VM_CASE(OP_BIN_GREATER_THAN_OR_EQUAL_VAR_JUMP_FALSE4):
+				a = pTop--;
+				b = pTop;
+
+				b->greaterthanorequal(*a);
+				m_CodePos++;
+				goto __varJumpFalse4;
+
+			VM_CASE(OP_STORE_INT1_BIN_PLUS):
+				pTop++;
+				pTop->setIntValue(*m_CodePos++);
+				m_CodePos++;
+
+				a = pTop--;
+				b = pTop;
+
+				*b += *a;
+				VM_NEXT;
+
+			VM_CASE(OP_STORE_INT1_BIN_MINUS):
+				pTop++;
+				pTop->setIntValue(*m_CodePos++);
+				m_CodePos++;
+
+				a = pTop--;
+				b = pTop;
+
+				*b -= *a;
+				VM_NEXT;
+
+			VM_DEFAULT:
 				if (*opcode < OP_MAX)
 				{
 					//glbs.DPrintf("unknown opcode %d ('%s')\n", *opcode, OpcodeName(*opcode));
@@ -1564,6 +1804,13 @@ void ScriptVM::Execute(ScriptVariable *data, int dataSize, str label)
 	}
 }
 
+#undef VM_CASE
+#undef VM_DEFAULT
+#undef VM_NEXT
+#undef VM_LABEL
+#undef VM_DISPATCH
+#undef VM_CAN_DISPATCH
+
 void ScriptVM::HandleScriptException(ScriptException& exc)
 {
 	if (m_ScriptContainer)
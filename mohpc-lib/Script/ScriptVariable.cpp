@@ -12,6 +12,26 @@
 
 using namespace MOHPC;
 
+static_assert(sizeof(ScriptVariable) <= 16, "ScriptVariable must stay a compact value");
+
+static thread_local const BaseScriptClass* currentOwner = nullptr;
+
+ScriptVariableContext::ScriptVariableContext(const BaseScriptClass* owner)
+{
+	previousOwner = currentOwner;
+	currentOwner = owner;
+}
+
+ScriptVariableContext::~ScriptVariableContext()
+{
+	currentOwner = previousOwner;
+}
+
+const BaseScriptClass* ScriptVariableContext::GetOwner()
+{
+	return currentOwner;
+}
+
 template<>
 intptr_t MOHPC::HashCode< ScriptVariable >(const ScriptVariable& key)
 {
@@ -253,7 +273,6 @@ ScriptVariable::ScriptVariable()
 }
 
 ScriptVariable::ScriptVariable(const ScriptVariable& variable)
-	: BaseScriptClass(variable)
 {
 	type = 0;
 	m_data.pointerValue = NULL;
@@ -266,6 +285,28 @@ ScriptVariable::~ScriptVariable()
 	ClearInternal();
 }
 
+GameManagerPtr ScriptVariable::GetGameManager()
+{
+	const BaseScriptClass* owner = ScriptVariableContext::GetOwner();
+	if (!owner)
+	{
+		ScriptError("No script is running to resolve the variable");
+	}
+
+	return owner->GetGameManager();
+}
+
+ScriptManagerPtr ScriptVariable::GetScriptManager()
+{
+	const BaseScriptClass* owner = ScriptVariableContext::GetOwner();
+	if (!owner)
+	{
+		ScriptError("No script is running to resolve the variable");
+	}
+
+	return owner->GetScriptManager();
+}
+
 void ScriptVariable::Archive(Archiver& arc)
 {
 	/*
@@ -5,9 +5,9 @@
 
 namespace MOHPC
 {
-MEM_TempAlloc parsetree_allocator;
+thread_local MEM_TempAlloc parsetree_allocator;
 
-yyparsedata parsedata;
+thread_local yyparsedata parsedata;
 sval_u node_none = { 0 };
 
 char *str_replace( char *orig, const char *rep, const char *with )
@@ -136,6 +136,12 @@ sval_u append_node( sval_u val1, sval_u val2 )
 {
 	sval_u *node;
 
+	if( val1.node == &node_none )
+	{
+		// the list only had newlines so far
+		return linked_list_end( val2 );
+	}
+
 	node = ( sval_u * )parsetree_malloc( sizeof( sval_u ) * 2 );
 
 	node[ 1 ].node = nullptr;
@@ -229,9 +229,9 @@ typedef struct yy_buffer_state *YY_BUFFER_STATE;
 typedef size_t yy_size_t;
 #endif
 
-extern int yyleng;
+extern thread_local int yyleng;
 
-extern FILE *yyin, *yyout;
+extern thread_local FILE *yyin, *yyout;
 
 #define EOB_ACT_CONTINUE_SCAN 0
 #define EOB_ACT_END_OF_FILE 1
@@ -340,9 +340,9 @@ struct yy_buffer_state
 #endif /* !YY_STRUCT_YY_BUFFER_STATE */
 
 /* Stack of input buffers. */
-static size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
-static size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
-static YY_BUFFER_STATE * yy_buffer_stack = NULL; /**< Stack as an array. */
+static thread_local size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
+static thread_local size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
+static thread_local YY_BUFFER_STATE * yy_buffer_stack = NULL; /**< Stack as an array. */
 
 /* We provide macros for accessing buffer states in case in the
  * future we want to put the buffer states in a more general
@@ -359,19 +359,19 @@ static YY_BUFFER_STATE * yy_buffer_stack = NULL; /**< Stack as an array. */
 #define YY_CURRENT_BUFFER_LVALUE (yy_buffer_stack)[(yy_buffer_stack_top)]
 
 /* yy_hold_char holds the character lost when yytext is formed. */
-static char yy_hold_char;
-static int yy_n_chars;		/* number of characters read into yy_ch_buf */
-int yyleng;
+static thread_local char yy_hold_char;
+static thread_local int yy_n_chars;		/* number of characters read into yy_ch_buf */
+thread_local int yyleng;
 
 /* Points to current character in buffer. */
-static char *yy_c_buf_p = NULL;
-static int yy_init = 0;		/* whether we need to initialize */
-static int yy_start = 0;	/* start state number */
+static thread_local char *yy_c_buf_p = NULL;
+static thread_local int yy_init = 0;		/* whether we need to initialize */
+static thread_local int yy_start = 0;	/* start state number */
 
 /* Flag which is used to allow yywrap()'s to do buffer switches
  * instead of setting up a fresh yyin.  A bit of a hack ...
  */
-static int yy_did_buffer_switch_on_eof;
+static thread_local int yy_did_buffer_switch_on_eof;
 
 void yyrestart ( FILE *input_file  );
 void yy_switch_to_buffer ( YY_BUFFER_STATE new_buffer  );
@@ -421,14 +421,14 @@ void yyfree ( void *  );
 #define YY_SKIP_YYWRAP
 typedef flex_uint8_t YY_CHAR;
 
-FILE *yyin = NULL, *yyout = NULL;
+thread_local FILE *yyin = NULL, *yyout = NULL;
 
 typedef int yy_state_type;
 
-extern int yylineno;
-int yylineno = 1;
+extern thread_local int yylineno;
+thread_local int yylineno = 1;
 
-extern char *yytext;
+extern thread_local char *yytext;
 #ifdef yytext_ptr
 #undef yytext_ptr
 #endif
@@ -835,9 +835,9 @@ static const flex_int32_t yy_rule_can_match_eol[93] =
 extern int yy_flex_debug;
 int yy_flex_debug = 0;
 
-static yy_state_type *yy_state_buf=0, *yy_state_ptr=0;
-static char *yy_full_match;
-static int yy_lp;
+static thread_local yy_state_type *yy_state_buf=0, *yy_state_ptr=0;
+static thread_local char *yy_full_match;
+static thread_local int yy_lp;
 #define REJECT \
 { \
 *yy_cp = (yy_hold_char); /* undo effects of setting up yytext */ \
@@ -849,13 +849,14 @@ goto find_rule; \
 #define yymore() yymore_used_but_not_detected
 #define YY_MORE_ADJ 0
 #define YY_RESTORE_YY_MORE_OFFSET
-char *yytext;
+thread_local char *yytext;
 #line 1 "..\\..\\..\\code\\globalcpp\\parser\\yyLexer.l"
 #line 2 "..\\..\\..\\code\\globalcpp\\parser\\yyLexer.l"
 
 };
 
 #include <MOHPC/Script/Compiler.h>
+#include <MOHPC/Script/ScriptException.h>
 #include "yyParser.h"
 
 #include <stdio.h>
@@ -866,7 +867,7 @@ namespace MOHPC
 void fprintf2( FILE *f, const char *format, ... )
 {
 	va_list va;
-	static char buffer[ 4200 ];
+	static thread_local char buffer[ 4200 ];
 
 	va_start( va, format );
 	vsprintf( buffer, format, va );
@@ -877,9 +878,9 @@ void fprintf2( FILE *f, const char *format, ... )
 
 #define fprintf fprintf2
 
-int prev_yylex = 0;
+thread_local int prev_yylex = 0;
 
-extern yyparsedata parsedata;
+extern thread_local yyparsedata parsedata;
 
 #define YYLLOCSET { yylval.s.sourcePos = parsedata.pos - yyleng; }
 #define YYLEX(n) { prev_yylex = n; return n; }
@@ -890,7 +891,8 @@ extern yyparsedata parsedata;
 void yylexerror( const char *msg )
 {
 	//glbs.Printf( "%s\n%s", msg, yytext );
-	assert( 0 );
+	// caught by the compiler, which discards the script
+	throw ScriptException( str( msg ) + ( yytext ? yytext : "" ) );
 }
 
 static void TextEscapeValue( char *str, size_t len )
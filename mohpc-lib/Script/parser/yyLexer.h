@@ -204,9 +204,9 @@ namespace MOHPC
 	typedef size_t yy_size_t;
 #endif
 
-	extern int yyleng;
+	extern thread_local int yyleng;
 
-	extern FILE *yyin, *yyout;
+	extern thread_local FILE *yyin, *yyout;
 
 #ifndef YY_STRUCT_YY_BUFFER_STATE
 #define YY_STRUCT_YY_BUFFER_STATE
@@ -280,9 +280,9 @@ namespace MOHPC
 #define yywrap() (/*CONSTCOND*/1)
 #define YY_SKIP_YYWRAP
 
-	extern int yylineno;
+	extern thread_local int yylineno;
 
-	extern char *yytext;
+	extern thread_local char *yytext;
 #ifdef yytext_ptr
 #undef yytext_ptr
 #endif
@@ -73,9 +73,9 @@ namespace MOHPC
 {
 int yyerror( const char *msg );
 
-extern int prev_yylex;
+extern thread_local int prev_yylex;
 
-extern yyparsedata parsedata;
+extern thread_local yyparsedata parsedata;
 
 #define YYLLOC node_pos( parsedata.pos - yyleng )
 
@@ -211,7 +211,7 @@ typedef union YYSTYPE
 # define YYSTYPE_IS_DECLARED 1
 #endif
 
-extern YYSTYPE yylval;
+extern thread_local YYSTYPE yylval;
 
 #ifdef YYPARSE_PARAM
 #if defined __STDC__ || defined __cplusplus
@@ -1571,7 +1571,7 @@ yydestruct (yymsg, yytype, yyvaluep)
 
 
 /* The lookahead symbol.  */
-int yychar;
+thread_local int yychar;
 
 
 #ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
@@ -1583,10 +1583,10 @@ int yychar;
 #endif
 
 /* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval YY_INITIAL_VALUE(yyval_default);
+thread_local YYSTYPE yylval YY_INITIAL_VALUE(yyval_default);
 
 /* Number of syntax errors so far.  */
-int yynerrs;
+thread_local int yynerrs;
 
 
 /*----------.
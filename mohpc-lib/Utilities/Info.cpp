@@ -1,177 +1,376 @@
 #include <MOHPC/Utilities/Info.h>
 #include <algorithm>
+#include <stdlib.h>
 
 using namespace MOHPC;
 
+/** Case-insensitive FNV-1a hash of a key. */
+static size_t HashKey(const char* key, size_t keyLen)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < keyLen; ++i)
+	{
+		char c = key[i];
+		if (c >= 'A' && c <= 'Z') {
+			c += 'a' - 'A';
+		}
+
+		hash = (hash ^ (uint8_t)c) * 16777619u;
+	}
+
+	return hash;
+}
+
+/** Return a power of two that keeps the table at most half full. */
+static size_t GetNumSlots(size_t numKeys)
+{
+	size_t numSlots = 8;
+	while (numSlots < numKeys * 2) {
+		numSlots *= 2;
+	}
+
+	return numSlots;
+}
+
+/**
+ * Return the position of the key in the table, or the empty position where it would be inserted.
+ * keyAt(index, key, keyLen) returns the key of an index.
+ */
+template<typename KeyAt>
+static size_t FindSlot(const std::vector<uint32_t>& slots, const char* key, size_t keyLen, KeyAt&& keyAt)
+{
+	const size_t mask = slots.size() - 1;
+	for (size_t pos = HashKey(key, keyLen) & mask;; pos = (pos + 1) & mask)
+	{
+		const uint32_t slot = slots[pos];
+		if (!slot) {
+			return pos;
+		}
+
+		const char* slotKey;
+		size_t slotKeyLen;
+		keyAt(slot - 1, slotKey, slotKeyLen);
+
+		if (slotKeyLen == keyLen && !str::icmpn(slotKey, key, keyLen)) {
+			return pos;
+		}
+	}
+}
+
+template<typename KeyAt>
+static void BuildSlots(std::vector<uint32_t>& slots, size_t numKeys, KeyAt&& keyAt)
+{
+	slots.assign(GetNumSlots(numKeys), 0);
+
+	for (size_t i = 0; i < numKeys; ++i)
+	{
+		const char* key;
+		size_t keyLen;
+		keyAt(i, key, keyLen);
+
+		const size_t pos = FindSlot(slots, key, keyLen, keyAt);
+		// only the first of duplicate keys is found
+		if (!slots[pos]) {
+			slots[pos] = (uint32_t)(i + 1);
+		}
+	}
+}
+
+/** Convert a value that is not null-terminated. */
+template<typename T>
+static T NumberValue(const char* value, size_t valueLen, T (*convert)(const char*))
+{
+	char buffer[32];
+	if (valueLen >= sizeof(buffer)) {
+		valueLen = sizeof(buffer) - 1;
+	}
+
+	memcpy(buffer, value, valueLen);
+	buffer[valueLen] = 0;
+	return convert(buffer);
+}
+
+static int ConvertInt(const char* value)
+{
+	return atoi(value);
+}
+
+static long long ConvertLong(const char* value)
+{
+	return atoll(value);
+}
+
+InfoIndex::InfoIndex()
+{
+}
+
+InfoIndex::InfoIndex(const char* text, size_t size)
+{
+	parse(text, size);
+}
+
+void InfoIndex::parse(const char* text, size_t size)
+{
+	keyValues.clear();
+
+	const char* p = text;
+	const char* end = text + size;
+
+	while (p < end && *p)
+	{
+		if (*p == '\\') ++p;
+
+		InfoKeyValue keyValue;
+		keyValue.key = p;
+		while (p < end && *p && *p != '\\') ++p;
+		keyValue.keyLen = p - keyValue.key;
+
+		if (p < end && *p == '\\') ++p;
+
+		keyValue.value = p;
+		while (p < end && *p && *p != '\\') ++p;
+		keyValue.valueLen = p - keyValue.value;
+
+		keyValues.push_back(keyValue);
+	}
+
+	BuildSlots(slots, keyValues.size(), [this](size_t index, const char*& key, size_t& keyLen)
+	{
+		key = keyValues[index].key;
+		keyLen = keyValues[index].keyLen;
+	});
+}
+
+const InfoKeyValue* InfoIndex::find(const char* key) const
+{
+	return find(key, strlen(key));
+}
+
+const InfoKeyValue* InfoIndex::find(const char* key, size_t keyLen) const
+{
+	if (keyValues.empty()) {
+		return nullptr;
+	}
+
+	const size_t pos = FindSlot(slots, key, keyLen, [this](size_t index, const char*& slotKey, size_t& slotKeyLen)
+	{
+		slotKey = keyValues[index].key;
+		slotKeyLen = keyValues[index].keyLen;
+	});
+
+	return slots[pos] ? &keyValues[slots[pos] - 1] : nullptr;
+}
+
+size_t InfoIndex::getNumKeys() const
+{
+	return keyValues.size();
+}
+
+const InfoKeyValue& InfoIndex::getKeyValue(size_t index) const
+{
+	return keyValues[index];
+}
+
 Info::Info()
-	: keyBuffer(nullptr)
-	, size(0)
-	, alloced(0)
+	: modified(false)
 {
 }
 
+Info::Info(const char* existingBuffer)
+	: modified(true)
+{
+	const InfoIndex index(existingBuffer, strlen(existingBuffer));
+
+	entries.reserve(index.getNumKeys());
+	for (size_t i = 0; i < index.getNumKeys(); ++i)
+	{
+		const InfoKeyValue& keyValue = index.getKeyValue(i);
+		// keep the first of duplicate keys, like lookups do
+		if (index.find(keyValue.key, keyValue.keyLen) == &keyValue) {
+			entries.push_back({ str(keyValue.key, keyValue.keyLen), str(keyValue.value, keyValue.valueLen) });
+		}
+	}
+
+	rebuildSlots();
+}
+
 Info::Info(Info&& info)
+	: modified(false)
 {
 	*this = std::move(info);
 }
 
 Info::~Info()
 {
-	if (keyBuffer) delete[] keyBuffer;
 }
 
 Info& Info::operator=(Info&& info)
 {
-	// move values out
-	keyBuffer = info.keyBuffer;
-	size = info.size;
-	alloced = info.alloced;
+	entries = std::move(info.entries);
+	slots = std::move(info.slots);
+	keyBuffer = std::move(info.keyBuffer);
+	modified = info.modified;
 
 	// empty out the older instance
-	info.keyBuffer = nullptr;
-	info.size = info.alloced = 0;
+	info.entries.clear();
+	info.slots.clear();
+	info.keyBuffer.clear();
+	info.modified = false;
 
 	return *this;
 }
 
+void Info::rebuildSlots()
+{
+	BuildSlots(slots, entries.size(), [this](size_t index, const char*& key, size_t& keyLen)
+	{
+		key = entries[index].key.c_str();
+		keyLen = entries[index].key.length();
+	});
+}
+
 void Info::SetValueForKey(const char* key, const char* value)
 {
-	if (!key || !*key) {
+	if (!key || !*key || strchr(key, '\\')) {
 		return;
 	}
 
-	// remove existing key
-	RemoveKey(key);
-
-	// append at the end
 	const size_t keyLen = strlen(key);
-	const size_t valueLen = strlen(value);
-	const size_t sizeNoNul = (size ? size - 1 : 0);
-	const size_t newsz = sizeNoNul + 1 + keyLen + 1 + valueLen + 1;
+	modified = true;
 
-	if (newsz > alloced)
+	if (!slots.empty())
 	{
-		// allocate a new buffer
-		char* newBuf = new char[newsz];
-
-		alloced = newsz;
+		const size_t pos = FindSlot(slots, key, keyLen, [this](size_t index, const char*& slotKey, size_t& slotKeyLen)
+		{
+			slotKey = entries[index].key.c_str();
+			slotKeyLen = entries[index].key.length();
+		});
 
-		if (keyBuffer)
+		if (slots[pos])
 		{
-			// copy without the null-terminated character
-			memcpy(newBuf, keyBuffer, size - 1);
-			delete[] keyBuffer;
+			// replace the existing value
+			entries[slots[pos] - 1].value = value;
+			return;
 		}
-
-		keyBuffer = newBuf;
 	}
 
-	char* pbuf = keyBuffer + sizeNoNul;
-	// copy the key
-	*(pbuf++) = '\\';
-	memcpy(pbuf, key, keyLen);
-	pbuf += keyLen;
+	entries.push_back({ str(key, keyLen), str(value) });
 
-	// copy the value
-	*(pbuf++) = '\\';
-	memcpy(pbuf, value, valueLen + 1);
+	if (entries.size() * 2 > slots.size()) {
+		rebuildSlots();
+	}
+	else
+	{
+		const size_t pos = FindSlot(slots, key, keyLen, [this](size_t index, const char*& slotKey, size_t& slotKeyLen)
+		{
+			slotKey = entries[index].key.c_str();
+			slotKeyLen = entries[index].key.length();
+		});
 
-	size = newsz;
+		slots[pos] = (uint32_t)entries.size();
+	}
 }
 
 void Info::RemoveKey(const char* key)
 {
-	if (!keyBuffer) {
+	if (slots.empty() || strchr(key, '\\')) {
 		return;
 	}
 
-	if (strchr(key, '\\')) {
-		return;
-	}
-
-	char* pkey = keyBuffer;
-
-	while(*pkey)
+	const size_t pos = FindSlot(slots, key, strlen(key), [this](size_t index, const char*& slotKey, size_t& slotKeyLen)
 	{
-		char* startKey = pkey;
-		if (*pkey == '\\') pkey++;
+		slotKey = entries[index].key.c_str();
+		slotKeyLen = entries[index].key.length();
+	});
 
-		char* endKey = pkey;
-		while (*endKey && *endKey != '\\') ++endKey;
-
-		char* startValue = endKey + 1;
-		char* endValue = startValue;
-
-		while (*endValue && *endValue != '\\') ++endValue;
-
-		if (!str::cmpn(pkey, key, endKey - pkey))
-		{
-			const size_t len = endValue - startKey;
-			memmove(startKey, endValue, keyBuffer + size - endValue);
-			size -= len;
-
-			break;
-		}
-
-		pkey = endValue;
+	if (slots[pos])
+	{
+		entries.erase(entries.begin() + (slots[pos] - 1));
+		// indexes after the removed entry have moved
+		rebuildSlots();
+		modified = true;
 	}
 }
 
 str Info::ValueForKey(const char* key) const
 {
-	char* pkey = keyBuffer;
+	if (slots.empty()) {
+		return str();
+	}
 
-	while (*pkey)
+	const size_t pos = FindSlot(slots, key, strlen(key), [this](size_t index, const char*& slotKey, size_t& slotKeyLen)
 	{
-		char* startKey = pkey;
-		if (*pkey == '\\') pkey++;
-
-		char* endKey = pkey;
-		while (*endKey && *endKey != '\\') ++endKey;
+		slotKey = entries[index].key.c_str();
+		slotKeyLen = entries[index].key.length();
+	});
 
-		char* startValue = endKey + 1;
-		char* endValue = startValue;
-
-		while (*endValue && *endValue != '\\') ++endValue;
-
-		if (!str::cmpn(pkey, key, endKey - pkey))
-		{
-			return str(
-				startValue,
-				0,
-				endValue - startValue
-			);
-		}
-
-		pkey = endValue;
-	}
-
-	return str();
+	return slots[pos] ? entries[slots[pos] - 1].value : str();
 }
 
 uint32_t Info::IntValueForKey(const char* key) const
 {
-	return atoi(ValueForKey("key"));
+	return atoi(ValueForKey(key));
 }
 
 uint64_t Info::LongValueForKey(const char* key) const
 {
-	return atoll(ValueForKey("key"));
+	return atoll(ValueForKey(key));
+}
+
+void Info::serialize() const
+{
+	size_t length = 0;
+	for (const entry_t& entry : entries) {
+		length += 1 + entry.key.length() + 1 + entry.value.length();
+	}
+
+	keyBuffer.clear();
+
+	if (!entries.empty())
+	{
+		keyBuffer.reserve(length + 1);
+
+		for (const entry_t& entry : entries)
+		{
+			keyBuffer.push_back('\\');
+			keyBuffer.insert(keyBuffer.end(), entry.key.c_str(), entry.key.c_str() + entry.key.length());
+			keyBuffer.push_back('\\');
+			keyBuffer.insert(keyBuffer.end(), entry.value.c_str(), entry.value.c_str() + entry.value.length());
+		}
+
+		keyBuffer.push_back(0);
+	}
+
+	modified = false;
 }
 
 const char* Info::GetString() const
 {
-	return keyBuffer;
+	if (modified) {
+		serialize();
+	}
+
+	return !keyBuffer.empty() ? keyBuffer.data() : nullptr;
 }
 
 size_t Info::GetInfoLength() const
 {
-	return size;
+	if (modified) {
+		serialize();
+	}
+
+	return keyBuffer.size();
 }
 
 InfoIterator Info::createConstIterator() const
 {
-	return InfoIterator(keyBuffer, size);
+	const char* buffer = GetString();
+	if (!buffer) {
+		// nothing to iterate
+		return InfoIterator("", 0);
+	}
+
+	return InfoIterator(buffer, GetInfoLength());
 }
 
 ReadOnlyInfo::ReadOnlyInfo(const char* existingBuffer, size_t len)
@@ -183,12 +382,15 @@ ReadOnlyInfo::ReadOnlyInfo(const char* existingBuffer, size_t len)
 	else {
 		size = len;
 	}
+
+	index.parse(keyBuffer, size);
 }
 
 ReadOnlyInfo::ReadOnlyInfo(ReadOnlyInfo&& other) noexcept
+	: keyBuffer(other.keyBuffer)
+	, size(other.size)
+	, index(std::move(other.index))
 {
-	keyBuffer = other.keyBuffer;
-	size = other.size;
 }
 
 ReadOnlyInfo::ReadOnlyInfo()
@@ -201,21 +403,19 @@ ReadOnlyInfo& ReadOnlyInfo::operator=(ReadOnlyInfo&& other) noexcept
 {
 	keyBuffer = other.keyBuffer;
 	size = other.size;
+	index = std::move(other.index);
 	return *this;
 }
 
 str ReadOnlyInfo::ValueForKey(const char* key) const
 {
-	size_t keyLen;
-	const char* foundKey = ValueForKey(key, keyLen);
+	size_t valueLen;
+	const char* value = ValueForKey(key, valueLen);
 
-	if(keyLen)
+	if(valueLen)
 	{
-		return str(
-			foundKey,
-			0,
-			keyLen
-		);
+		// the value is not null-terminated
+		return str(value, valueLen);
 	}
 
 	return str();
@@ -223,44 +423,29 @@ str ReadOnlyInfo::ValueForKey(const char* key) const
 
 const char* ReadOnlyInfo::ValueForKey(const char* key, size_t& outLen) const
 {
-	const char* pkey = keyBuffer;
-	const char* endBuf = keyBuffer + size;
-
-	outLen = 0;
-
-	while (pkey < endBuf)
+	const InfoKeyValue* keyValue = index.find(key);
+	if (!keyValue)
 	{
-		const char* startKey = pkey;
-		if (*pkey == '\\') pkey++;
-
-		const char* endKey = pkey;
-		while (endKey < endBuf && *endKey != '\\') ++endKey;
-
-		const char* startValue = endKey + 1;
-		const char* endValue = startValue;
-
-		while (endValue < endBuf && *endValue != '\\') ++endValue;
-
-		if (!str::cmpn(pkey, key, endKey - pkey))
-		{
-			outLen = endValue - startValue;
-			return startValue;
-		}
-
-		pkey = endValue;
+		outLen = 0;
+		return "";
 	}
 
-	return str();
+	outLen = keyValue->valueLen;
+	return keyValue->value;
 }
 
 uint32_t ReadOnlyInfo::IntValueForKey(const char* key) const
 {
-	return atoi(ValueForKey(key));
+	size_t valueLen;
+	const char* value = ValueForKey(key, valueLen);
+	return NumberValue(value, valueLen, &ConvertInt);
 }
 
 uint64_t ReadOnlyInfo::LongValueForKey(const char* key) const
 {
-	return atoll(ValueForKey(key));
+	size_t valueLen;
+	const char* value = ValueForKey(key, valueLen);
+	return NumberValue(value, valueLen, &ConvertLong);
 }
 
 const char* ReadOnlyInfo::GetString() const
@@ -273,6 +458,11 @@ size_t ReadOnlyInfo::GetInfoLength() const
 	return size;
 }
 
+const InfoIndex& ReadOnlyInfo::GetIndex() const
+{
+	return index;
+}
+
 InfoIterator ReadOnlyInfo::createConstIterator() const
 {
 	return InfoIterator(keyBuffer, size);
@@ -362,8 +552,8 @@ void InfoIterator::parseInfo()
 
 void InfoIterator::deleteTmps()
 {
-	if (tmpKey) delete tmpKey;
-	if (tmpValue) delete tmpValue;
+	if (tmpKey) delete[] tmpKey;
+	if (tmpValue) delete[] tmpValue;
 }
 
 bool InfoIterator::isLast() const
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MOHPC
+{
+	/**
+	 * Call func(i) for every i in [0, count), spread over the available cores.
+	 * The calling thread takes part in the work, items are picked in ascending order by whichever thread is free.
+	 * func must only write to data that belongs to item i, so that the result doesn't depend on scheduling.
+	 * The first exception thrown by func is rethrown once every thread has finished.
+	 *
+	 * @param	count			Number of items.
+	 * @param	minPerThread	Minimum number of items for each thread, so that small loops stay on the calling thread.
+	 */
+	template<typename Func>
+	void ParallelFor(size_t count, Func&& func, size_t minPerThread = 1)
+	{
+		size_t numThreads = std::thread::hardware_concurrency();
+		if (minPerThread && numThreads > count / minPerThread) {
+			numThreads = count / minPerThread;
+		}
+
+		if (numThreads <= 1)
+		{
+			for (size_t i = 0; i < count; ++i) {
+				func(i);
+			}
+			return;
+		}
+
+		std::atomic<size_t> nextItem(0);
+		std::exception_ptr exception;
+		std::mutex exceptionMutex;
+
+		auto worker = [&]()
+		{
+			try
+			{
+				for (size_t i = nextItem++; i < count; i = nextItem++) {
+					func(i);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(exceptionMutex);
+				if (!exception) {
+					exception = std::current_exception();
+				}
+
+				// stop the other threads early
+				nextItem = count;
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads - 1);
+		for (size_t i = 1; i < numThreads; ++i) {
+			threads.emplace_back(worker);
+		}
+
+		worker();
+
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+}
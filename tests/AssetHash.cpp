@@ -0,0 +1,121 @@
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Formats/BSP.h>
+#include <MOHPC/Misc/crc32.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_assethash"
+
+class CAssetHashTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Asset hashing";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testCRC32();
+		benchmarkCRC32();
+		benchmarkLoad(AM);
+	}
+
+private:
+	static uint32_t referenceCRC32(const uint8_t* p, size_t size, uint32_t crc)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			crc ^= p[i];
+			for (size_t bit = 0; bit < 8; ++bit) {
+				crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+			}
+		}
+
+		return crc;
+	}
+
+	void testCRC32()
+	{
+		// standard check value, with the usual inversions done by the caller
+		const char check[] = "123456789";
+		assert(~crc32_hash(check, 9, -1) == 0xCBF43926);
+
+		std::mt19937 rng(1234);
+		std::vector<uint8_t> buffer(16384);
+		for (uint8_t& b : buffer) {
+			b = (uint8_t)rng();
+		}
+
+		// every alignment, and lengths around the sizes of the wide paths
+		for (size_t offset = 0; offset < 16; ++offset)
+		{
+			for (size_t length = 0; length < 300; ++length)
+			{
+				const uint32_t base = rng();
+				assert(crc32_hash(buffer.data() + offset, length, (int)base) == referenceCRC32(buffer.data() + offset, length, base));
+			}
+		}
+
+		// calls can be chained
+		uint32_t crc = crc32_hash(buffer.data(), 1001, 0);
+		crc = crc32_hash(buffer.data() + 1001, buffer.size() - 1001, (int)crc);
+		assert(crc == referenceCRC32(buffer.data(), buffer.size(), 0));
+	}
+
+	void benchmarkCRC32()
+	{
+		static constexpr size_t bufferSize = 32 * 1024 * 1024;
+
+		std::vector<uint8_t> buffer(bufferSize, 0xA5);
+
+		const auto start = std::chrono::system_clock().now();
+		const uint32_t crc = crc32_hash(buffer.data(), buffer.size(), 0);
+		const auto end = std::chrono::system_clock().now();
+
+		const long long duration = (long long)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+		MOHPC_LOG(Log, "crc32 of %zu MiB in %lld us (%08x)", bufferSize / (1024 * 1024), duration, crc);
+	}
+
+	void benchmarkLoad(const MOHPC::AssetManagerPtr& AM)
+	{
+		using namespace MOHPC;
+
+		static constexpr char mapName[] = "/maps/dm/mohdm6.bsp";
+
+		const bool wasHashing = AM->IsAssetHashingEnabled();
+
+		long long durations[2];
+		for (size_t i = 0; i < 2; ++i)
+		{
+			AM->SetAssetHashing(i != 0);
+
+			// the asset is released at the end of each pass, so it's loaded again
+			const auto start = std::chrono::system_clock().now();
+			BSPPtr level = AM->LoadAsset<BSP>(mapName);
+			const auto end = std::chrono::system_clock().now();
+
+			if (!level)
+			{
+				MOHPC_LOG(Warning, "could not load %s", mapName);
+				AM->SetAssetHashing(wasHashing);
+				return;
+			}
+
+			uint8_t hash[20];
+			assert(level->HashGetHash(hash) == (i != 0));
+
+			durations[i] = (long long)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+		}
+
+		AM->SetAssetHashing(wasHashing);
+
+		MOHPC_LOG(Log, "%s loaded in %lld ms without hashing, %lld ms with hashing", mapName, durations[0], durations[1]);
+	}
+};
+static CAssetHashTest unitTest;
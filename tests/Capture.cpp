@@ -0,0 +1,518 @@
+#include <MOHPC/Collision/Collision.h>
+#include <MOHPC/Managers/NetworkManager.h>
+#include <MOHPC/Managers/ShaderManager.h>
+#include <MOHPC/Network/Capture.h>
+#include <MOHPC/Network/Channel.h>
+#include <MOHPC/Network/Configstring.h>
+#include <MOHPC/Network/Client/CGModule.h>
+#include <MOHPC/Network/Client/ClientGame.h>
+#include <MOHPC/Network/Client/UserInfo.h>
+#include <MOHPC/Network/Server/CaptureGenerator.h>
+#include <MOHPC/Misc/MSG/Stream.h>
+#include <MOHPC/Math.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_capture"
+
+class CCaptureTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Packet capture";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testSaveLoad();
+		testRecord();
+		testReplay();
+		testFragmentedReplay();
+		testConfigStringChanges();
+		testSolidBroadphase();
+		benchmarkReplay();
+	}
+
+private:
+	static constexpr uint32_t challenge = 0x1234abcd;
+
+	static MOHPC::Network::PacketCapturePtr createCapture()
+	{
+		using namespace MOHPC::Network;
+
+		const PacketCapturePtr capture = PacketCapture::create(protocolType_c(serverType_e::none, protocolVersion_e::ver111), challenge);
+		capture->addPacket(0, captureDirection_e::Received, "gamestate", 9);
+		capture->addPacket(1000, captureDirection_e::Sent, "usercmd", 7);
+		capture->addPacket(50000, captureDirection_e::Received, "snapshot", 8);
+		capture->addPacket(100000, captureDirection_e::Received, "", 0);
+
+		return capture;
+	}
+
+	void testSaveLoad()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		const PacketCapturePtr capture = createCapture();
+
+		DynamicDataMessageStream stream;
+		capture->save(stream);
+		stream.Seek(0);
+
+		const PacketCapturePtr loaded = PacketCapture::create();
+		loaded->load(stream);
+
+		assert(loaded->getProtocol().getProtocolVersion() == protocolVersion_e::ver111);
+		assert(loaded->getChallenge() == challenge);
+		assert(loaded->getNumPackets() == capture->getNumPackets());
+		for (size_t i = 0; i < capture->getNumPackets(); ++i)
+		{
+			const CapturedPacket& packet = loaded->getPacket(i);
+			assert(packet.getTime() == capture->getPacket(i).getTime());
+			assert(packet.getDirection() == capture->getPacket(i).getDirection());
+			assert(packet.getSize() == capture->getPacket(i).getSize());
+			assert(!memcmp(loaded->getPacketData(i), capture->getPacketData(i), packet.getSize()));
+		}
+
+		// cut in the middle of the last datagram
+		FixedDataMessageStream truncated(stream.getStorage(), stream.GetLength() - 4);
+		bool thrown = false;
+		try {
+			loaded->load(truncated);
+		}
+		catch (CaptureError::TruncatedException&) {
+			thrown = true;
+		}
+		assert(thrown);
+
+		char notCapture[] = "\xff\xff\xff\xff" "disconnect";
+		FixedDataMessageStream badHeader(notCapture, sizeof(notCapture));
+		thrown = false;
+		try {
+			loaded->load(badHeader);
+		}
+		catch (CaptureError::BadHeaderException&) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+
+	void testRecord()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		const PacketCapturePtr capture = createCapture();
+
+		NetAddr4Ptr adr = NetAddr4::create();
+		adr->setIp(127, 0, 0, 1);
+		adr->setPort(12203);
+
+		// record the replay of the capture
+		const PacketCapturePtr recorded = PacketCapture::create();
+		const IUdpSocketPtr socket = CaptureSocket::create(ReplaySocket::create(capture, adr, replayMode_e::AsFastAsPossible), recorded);
+
+		uint8_t buf[64];
+		size_t numReceived = 0;
+		while (socket->dataAvailable())
+		{
+			NetAddrPtr from;
+			const size_t len = socket->receive(buf, sizeof(buf), from);
+			assert(len == capture->getPacket(numReceived ? numReceived + 1 : 0).getSize());
+			assert(from.get() == adr.get());
+			++numReceived;
+
+			socket->send(*adr, "ack", 3);
+		}
+
+		assert(numReceived == 3);
+		assert(recorded->getNumPackets() == 6);
+		assert(recorded->getPacket(0).getDirection() == captureDirection_e::Received);
+		assert(recorded->getPacket(1).getDirection() == captureDirection_e::Sent);
+		assert(!memcmp(recorded->getPacketData(2), "snapshot", 8));
+		assert(recorded->getPacket(1).getTime() >= recorded->getPacket(0).getTime());
+	}
+
+	void testReplay()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numSnapshots = 100;
+		static constexpr size_t numEntities = 32;
+
+		const PacketCapturePtr capture = PacketCapture::create();
+		CaptureGenerator generator(challenge);
+		generator.setNumEntities(numEntities);
+		generator.generate(*capture, numSnapshots);
+		assert(capture->getNumPackets() == numSnapshots + 1);
+
+		// through a file
+		DynamicDataMessageStream stream;
+		capture->save(stream);
+		stream.Seek(0);
+
+		const PacketCapturePtr loaded = PacketCapture::create();
+		loaded->load(stream);
+
+		const NetworkManagerPtr manager = makeShared<NetworkManager>();
+
+		NetAddr4Ptr adr = NetAddr4::create();
+		adr->setIp(127, 0, 0, 1);
+		adr->setPort(12203);
+
+		const ReplaySocketPtr socket = ReplaySocket::create(loaded, adr, replayMode_e::AsFastAsPossible);
+		const ClientGameConnectionPtr connection = ClientGameConnection::create(
+			manager,
+			makeShared<Netchan>(socket, 1),
+			adr,
+			loaded->getChallenge(),
+			loaded->getProtocol(),
+			ClientInfo::create()
+		);
+		connection->initTime(getCurrentTime());
+
+		while (!socket->isFinished()) {
+			manager->processTicks();
+		}
+
+		const ClientMetrics& metrics = connection->getMetrics();
+		assert(metrics.gameStates.get() == 1);
+		assert(metrics.snapshots.get() == numSnapshots);
+		assert(!strcmp(connection->getGameState().getConfigString(CS_MODELS + 1), "models/player/allied_airborne.tik"));
+
+		std::unique_ptr<SnapshotInfo> snap(new SnapshotInfo);
+		assert(connection->getSnapshot(connection->getCurrentSnapshotNumber(), *snap));
+		assert(snap->getServerTime() == 10000 + (numSnapshots - 1) * 50);
+		assert(snap->getPlayerState().commandTime == snap->getServerTime());
+		assert(snap->getNumEntities() == numEntities);
+		assert(snap->getEntityStateByNumber(MAX_CLIENTS + numEntities - 1));
+
+		// the traffic can still be read once the channel is gone
+		connection->disconnect();
+		assert(connection->getChannelMetrics()->packetsIn.get() == loaded->getNumPackets());
+	}
+
+	void testFragmentedReplay()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numSnapshots = 10;
+		// enough baselines for the gamestate and the first snapshot to be fragmented
+		static constexpr size_t numEntities = 256;
+
+		const PacketCapturePtr capture = PacketCapture::create();
+		CaptureGenerator generator(challenge);
+		generator.setNumEntities(numEntities);
+		generator.generate(*capture, numSnapshots);
+		assert(capture->getNumPackets() > numSnapshots + 1);
+
+		const NetworkManagerPtr manager = makeShared<NetworkManager>();
+		NetAddr4Ptr adr = NetAddr4::create();
+
+		const ReplaySocketPtr socket = ReplaySocket::create(capture, adr, replayMode_e::AsFastAsPossible);
+		const SharedPtr<Netchan> netchan = makeShared<Netchan>(socket, 1);
+		const ClientGameConnectionPtr connection = ClientGameConnection::create(
+			manager,
+			netchan,
+			adr,
+			capture->getChallenge(),
+			capture->getProtocol(),
+			ClientInfo::create()
+		);
+		connection->initTime(getCurrentTime());
+
+		while (!socket->isFinished()) {
+			manager->processTicks();
+		}
+
+		assert(netchan->getMetrics()->reassembledMessages.get() >= 2);
+		assert(netchan->getMetrics()->fragmentsIn.get() == capture->getNumPackets() - numSnapshots - 1 + netchan->getMetrics()->reassembledMessages.get());
+
+		const ClientMetrics& metrics = connection->getMetrics();
+		assert(metrics.gameStates.get() == 1);
+		assert(metrics.snapshots.get() == numSnapshots);
+
+		std::unique_ptr<SnapshotInfo> snap(new SnapshotInfo);
+		assert(connection->getSnapshot(connection->getCurrentSnapshotNumber(), *snap));
+		assert(snap->getNumEntities() == numEntities);
+	}
+
+	void testConfigStringChanges()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numSnapshots = 20;
+
+		const PacketCapturePtr capture = PacketCapture::create();
+		CaptureGenerator generator(challenge);
+		generator.setNumEntities(8);
+		// several configstrings changed in the same tick
+		generator.addServerCommand(10, "cs 49 \"models/weapons/colt45.tik\"");
+		generator.addServerCommand(10, "cs 50 \"models/weapons/m1_garand.tik\"");
+		generator.addServerCommand(10, "cs 49 \"models/weapons/thompsonsmg.tik\"");
+		generator.generate(*capture, numSnapshots);
+
+		const NetworkManagerPtr manager = makeShared<NetworkManager>();
+		NetAddr4Ptr adr = NetAddr4::create();
+
+		const ReplaySocketPtr socket = ReplaySocket::create(capture, adr, replayMode_e::RealTime);
+		const ClientGameConnectionPtr connection = ClientGameConnection::create(
+			manager,
+			makeShared<Netchan>(socket, 1),
+			adr,
+			capture->getChallenge(),
+			capture->getProtocol(),
+			ClientInfo::create()
+		);
+		connection->initTime(getCurrentTime());
+
+		std::vector<configStringChanges_t> notified;
+		connection->getHandlerList().configStringsChangedHandler.add([&notified](const configStringChanges_t& changed, const gameState_t& gameState)
+		{
+			// the values are already set when notified
+			for (size_t i = 0; i < changed.size(); ++i) {
+				assert(!changed.test(i) || *gameState.getConfigString((csNum_t)i));
+			}
+
+			notified.push_back(changed);
+		});
+
+		// server commands are executed when the cgame reaches their snapshot, so the time must elapse
+		const auto startTime = std::chrono::steady_clock::now();
+		while ((!socket->isFinished() || notified.size() < 2) && std::chrono::steady_clock::now() - startTime < std::chrono::seconds(5))
+		{
+			manager->processTicks();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		// once for the gamestate and once for the server commands, nothing in between
+		assert(notified.size() == 2);
+
+		configStringChanges_t expected;
+		expected.set(CS_SERVERINFO);
+		expected.set(CS_SYSTEMINFO);
+		for (csNum_t i = 1; i <= 16; ++i) {
+			expected.set(CS_MODELS + i);
+		}
+		assert(notified[0] == expected);
+
+		expected.reset();
+		expected.set(CS_MODELS + 17);
+		expected.set(CS_MODELS + 18);
+		assert(notified[1] == expected);
+		assert(!strcmp(connection->getGameState().getConfigString(CS_MODELS + 17), "models/weapons/thompsonsmg.tik"));
+		assert(!strcmp(connection->getGameState().getConfigString(CS_MODELS + 18), "models/weapons/m1_garand.tik"));
+	}
+
+	void testSolidBroadphase()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numSnapshots = 20;
+		static constexpr size_t numQueries = 500;
+
+		const PacketCapturePtr capture = PacketCapture::create();
+		CaptureGenerator generator(challenge);
+		generator.setNumEntities(64);
+		generator.setSolidEntities(true);
+		generator.generate(*capture, numSnapshots);
+
+		const NetworkManagerPtr manager = makeShared<NetworkManager>();
+		NetAddr4Ptr adr = NetAddr4::create();
+
+		const ReplaySocketPtr socket = ReplaySocket::create(capture, adr, replayMode_e::AsFastAsPossible);
+		const ClientGameConnectionPtr connection = ClientGameConnection::create(
+			manager,
+			makeShared<Netchan>(socket, 1),
+			adr,
+			capture->getChallenge(),
+			capture->getProtocol(),
+			ClientInfo::create()
+		);
+		// one datagram per frame
+		connection->getSettings().setMaxTickPackets(1);
+		// the timeout is checked against the clock
+		connection->setTimeout(0);
+
+		// entities only move when the cgame time elapses, it is advanced by the frames below
+		uint64_t currentTime = 1000000;
+		connection->initTime(currentTime);
+
+		// entities have no brush model, the world is never traced
+		const CollisionWorldPtr cm = CollisionWorld::create();
+		const CollisionWorldPtr boxHull = CollisionWorld::create();
+		boxHull->CM_InitBoxHull();
+
+		srand(0);
+
+		size_t numChecked = 0;
+		size_t numHits = 0;
+		uint32_t lastServerTime = 0;
+		// a fixed number of frames as long as the server frames, enough to go through the whole capture
+		for (size_t frame = 0; frame < numSnapshots * 2; ++frame)
+		{
+			currentTime += 50;
+			connection->tick(50, currentTime);
+
+			CGameModuleBase* cgame = connection->getCGModule();
+			const SnapshotInfo* snap = cgame ? cgame->getCurrentSnapshot() : nullptr;
+			if (!snap || snap->getServerTime() == lastServerTime) {
+				continue;
+			}
+
+			// entities moved, the bounds must be rebuilt
+			lastServerTime = snap->getServerTime();
+
+			for (size_t i = 0; i < numQueries; ++i)
+			{
+				const Vector start((float)(rand() % 2400 - 1200), (float)(rand() % 2400 - 1200), (float)(rand() % 320 - 64));
+				// some traces don't move at all
+				const Vector end = i % 8 ? start + Vector((float)(rand() % 1024 - 512), (float)(rand() % 1024 - 512), (float)(rand() % 256 - 128)) : start;
+				const float size = (float)(rand() % 33);
+				const Vector mins(-size, -size, -size);
+				const Vector maxs(size, size, size);
+
+				trace_t expected = missedTrace(end);
+				clipMoveLinear(*cgame, *snap, *boxHull, start, mins, maxs, end, ENTITYNUM_NONE, expected);
+
+				trace_t results = missedTrace(end);
+				cgame->clipMoveToEntities(*cm, start, mins, maxs, end, ENTITYNUM_NONE, ContentFlags::MASK_PLAYERSOLID, false, results);
+				assertSameTrace(results, expected);
+
+				if (expected.entityNum != ENTITYNUM_NONE)
+				{
+					// the entity behind the one that was hit must be found the same
+					const uint16_t skipNumber = expected.entityNum;
+					expected = missedTrace(end);
+					clipMoveLinear(*cgame, *snap, *boxHull, start, mins, maxs, end, skipNumber, expected);
+
+					trace_t skipResults = missedTrace(end);
+					cgame->clipMoveToEntities(*cm, start, mins, maxs, end, skipNumber, ContentFlags::MASK_PLAYERSOLID, false, skipResults);
+					assertSameTrace(skipResults, expected);
+					++numHits;
+				}
+			}
+
+			++numChecked;
+		}
+
+		// every snapshot after the first one was checked, with traces hitting entities
+		assert(numChecked == numSnapshots - 1);
+		assert(numHits);
+	}
+
+	/** Test all solid entities of the snapshot, like the cgame did before using bounds. */
+	static void clipMoveLinear(MOHPC::Network::CGameModuleBase& cgame, const MOHPC::Network::SnapshotInfo& snap, MOHPC::CollisionWorld& boxHull, const MOHPC::Vector& start, const MOHPC::Vector& mins, const MOHPC::Vector& maxs, const MOHPC::Vector& end, uint16_t skipNumber, MOHPC::trace_t& tr)
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		for (size_t i = 0; i < snap.getNumEntities(); ++i)
+		{
+			const entityState_t* ent = &cgame.getEntity(snap.getEntityState((entityNum_t)i).number)->getCurrentState();
+			if (!ent->solid || ent->number == skipNumber) {
+				continue;
+			}
+
+			Vector bmins, bmaxs;
+			IntegerToBoundingBox(ent->solid, bmins, bmaxs);
+			const clipHandle_t cmodel = boxHull.CM_TempBoxModel(bmins, bmaxs, ContentFlags::CONTENTS_BODY);
+
+			trace_t trace;
+			boxHull.CM_TransformedBoxTrace(&trace, start, end, mins, maxs, cmodel, ContentFlags::MASK_PLAYERSOLID, ent->netorigin, vec3_origin, false);
+
+			if (trace.allsolid || trace.fraction < tr.fraction) {
+				trace.entityNum = ent->number;
+				tr = trace;
+			}
+			else if (trace.startsolid) {
+				tr.startsolid = true;
+			}
+		}
+	}
+
+	/** Result of a trace that didn't hit the world. */
+	static MOHPC::trace_t missedTrace(const MOHPC::Vector& end)
+	{
+		MOHPC::trace_t tr;
+		tr.fraction = 1.f;
+		tr.endpos = end;
+		tr.entityNum = MOHPC::ENTITYNUM_NONE;
+		return tr;
+	}
+
+	static void assertSameTrace(const MOHPC::trace_t& results, const MOHPC::trace_t& expected)
+	{
+		assert(results.entityNum == expected.entityNum);
+		assert(results.fraction == expected.fraction);
+		assert(results.allsolid == expected.allsolid);
+		assert(results.startsolid == expected.startsolid);
+		if (expected.entityNum != MOHPC::ENTITYNUM_NONE)
+		{
+			assert(results.endpos == expected.endpos);
+			assert(results.plane.normal == expected.plane.normal);
+			assert(results.plane.dist == expected.plane.dist);
+			assert(results.contents == expected.contents);
+		}
+	}
+
+	void benchmarkReplay()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numSnapshots = 2000;
+		static constexpr size_t numEntities = 256;
+
+		const PacketCapturePtr capture = PacketCapture::create();
+		CaptureGenerator generator(challenge);
+		generator.setNumEntities(numEntities);
+		generator.generate(*capture, numSnapshots);
+
+		const NetworkManagerPtr manager = makeShared<NetworkManager>();
+		NetAddr4Ptr adr = NetAddr4::create();
+
+		const ReplaySocketPtr socket = ReplaySocket::create(capture, adr, replayMode_e::AsFastAsPossible);
+		const ClientGameConnectionPtr connection = ClientGameConnection::create(
+			manager,
+			makeShared<Netchan>(socket, 1),
+			adr,
+			capture->getChallenge(),
+			capture->getProtocol(),
+			ClientInfo::create()
+		);
+		connection->initTime(getCurrentTime());
+
+		auto start = std::chrono::system_clock().now();
+		while (!socket->isFinished()) {
+			manager->processTicks();
+		}
+		auto end = std::chrono::system_clock().now();
+
+		const ClientMetrics& metrics = connection->getMetrics();
+		assert(metrics.snapshots.get() == numSnapshots);
+
+		MOHPC_LOG(Log, "%zu snapshots of %zu entities replayed in %lf time (parse time: median %llu us, p99 %llu us)",
+			numSnapshots,
+			numEntities,
+			std::chrono::duration<double>(end - start).count(),
+			(unsigned long long)metrics.snapshotParseTime.getPercentile(50),
+			(unsigned long long)metrics.snapshotParseTime.getPercentile(99)
+		);
+	}
+};
+static CCaptureTest unitTest;
@@ -0,0 +1,120 @@
+#include <MOHPC/Common/con_timer.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_contimer"
+
+class CConTimerTest : public IUnitTest
+{
+private:
+	class TimedObject : public MOHPC::Class
+	{
+	};
+
+public:
+	virtual const char* name() override
+	{
+		return "Timer list";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testOrder();
+		benchmarkDrain();
+	}
+
+private:
+	void testOrder()
+	{
+		using namespace MOHPC;
+
+		TimedObject objects[5];
+
+		con_timer timer;
+		timer.AddElement(&objects[0], 3.f);
+		timer.AddElement(&objects[1], 1.f);
+		timer.AddElement(&objects[2], 2.f);
+		// same time as objects[1], must come after it
+		timer.AddElement(&objects[3], 1.f);
+		timer.AddElement(&objects[4], 5.f);
+		assert(timer.NumElements() == 5);
+
+		// moved, not added twice
+		timer.AddElement(&objects[4], 0.5f);
+		assert(timer.NumElements() == 5);
+
+		timer.RemoveElement(&objects[2]);
+		assert(timer.NumElements() == 4);
+
+		// nothing is due before the time is set
+		float time;
+		assert(!timer.GetNextElement(time));
+
+		timer.SetTime(2.f);
+		assert(timer.GetNextElement(time) == &objects[4] && time == 0.5f);
+		assert(timer.GetNextElement(time) == &objects[1] && time == 1.f);
+		assert(timer.GetNextElement(time) == &objects[3] && time == 1.f);
+		assert(!timer.GetNextElement(time));
+
+		timer.SetTime(3.f);
+		assert(timer.GetNextElement(time) == &objects[0] && time == 3.f);
+		assert(timer.NumElements() == 0);
+	}
+
+	void benchmarkDrain()
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t numElements = 20000;
+
+		// like threads waiting in a map
+		std::vector<TimedObject> objects(numElements);
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> delays(0.f, 60.f);
+
+		con_timer timer;
+
+		const auto addStart = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numElements; ++i) {
+			timer.AddElement(&objects[i], delays(rng));
+		}
+		const auto addEnd = std::chrono::system_clock().now();
+
+		// a quarter of them are killed while waiting
+		for (size_t i = 0; i < numElements; i += 4) {
+			timer.RemoveElement(&objects[i]);
+		}
+		assert(timer.NumElements() == numElements - numElements / 4);
+
+		timer.SetTime(60.f);
+
+		size_t numDrained = 0;
+		float lastTime = 0.f;
+		float time;
+
+		const auto drainStart = std::chrono::system_clock().now();
+		while (timer.GetNextElement(time))
+		{
+			assert(time >= lastTime);
+			lastTime = time;
+			++numDrained;
+		}
+		const auto drainEnd = std::chrono::system_clock().now();
+
+		assert(numDrained == numElements - numElements / 4);
+
+		MOHPC_LOG(
+			Log,
+			"%zu elements: added in %lld us, drained in %lld us",
+			numElements,
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(addEnd - addStart).count(),
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(drainEnd - drainStart).count()
+		);
+	}
+};
+static CConTimerTest unitTest;
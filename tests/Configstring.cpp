@@ -0,0 +1,146 @@
+#include <MOHPC/Network/Client/ClientGame.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string.h>
+
+#define MOHPC_LOG_NAMESPACE "test_configstring"
+
+class CConfigstringTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Configstring";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testSlots();
+		testChurn();
+		benchmarkChurn();
+	}
+
+private:
+	static void setString(MOHPC::Network::gameState_t& gameState, MOHPC::Network::csNum_t num, const std::string& value)
+	{
+		gameState.setConfigString(num, value.c_str(), value.length());
+	}
+
+	void testSlots()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		std::unique_ptr<gameState_t> gameState(new gameState_t);
+		assert(!strcmp(gameState->getConfigString(0), ""));
+		assert(!gameState->getConfigString(MAX_CONFIGSTRINGS));
+
+		setString(*gameState, 10, "models/player/allied_airborne.tik");
+		const char* previous = gameState->getConfigString(10);
+		assert(!strcmp(previous, "models/player/allied_airborne.tik"));
+
+		// replaced in place
+		setString(*gameState, 10, "models/player/german.tik");
+		assert(gameState->getConfigString(10) == previous);
+		assert(!strcmp(gameState->getConfigString(10), "models/player/german.tik"));
+
+		// too long for the slot
+		setString(*gameState, 10, "models/player/allied_airborne_captain.tik");
+		assert(!strcmp(gameState->getConfigString(10), "models/player/allied_airborne_captain.tik"));
+
+		setString(*gameState, 10, "");
+		assert(!strcmp(gameState->getConfigString(10), ""));
+
+		bool thrown = false;
+		try {
+			setString(*gameState, MAX_CONFIGSTRINGS, "out");
+		}
+		catch (ClientError::MaxConfigStringException&) {
+			thrown = true;
+		}
+		assert(thrown);
+
+		// a configstring set from another one
+		setString(*gameState, 20, "sound/weapons/fire/Kar98Fire.wav");
+		const char* other = gameState->getConfigString(20);
+		gameState->setConfigString(21, other, strlen(other));
+		assert(!strcmp(gameState->getConfigString(21), other));
+
+		gameState->clear();
+		assert(!strcmp(gameState->getConfigString(20), ""));
+		assert(!strcmp(gameState->getConfigString(21), ""));
+	}
+
+	void testChurn()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numStrings = 1000;
+
+		std::unique_ptr<gameState_t> gameState(new gameState_t);
+		std::unique_ptr<std::string[]> expected(new std::string[numStrings]);
+
+		// strings growing one by one, the buffer must be compacted many times
+		for (size_t i = 0; i < 20000; ++i)
+		{
+			const csNum_t num = (csNum_t)((i * 7) % numStrings);
+			expected[num] = std::string((i / numStrings) % 30, 'a' + (char)(num % 26));
+			setString(*gameState, num, expected[num]);
+		}
+
+		for (csNum_t i = 0; i < numStrings; ++i) {
+			assert(expected[i] == gameState->getConfigString(i));
+		}
+
+		// more than the buffer can hold
+		bool thrown = false;
+		try
+		{
+			const std::string longString(1000, 'x');
+			for (csNum_t i = 0; i < numStrings; ++i) {
+				setString(*gameState, i, longString);
+			}
+		}
+		catch (ClientError::MaxGameStateCharsException&) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+
+	void benchmarkChurn()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numUpdates = 1000000;
+
+		std::unique_ptr<gameState_t> gameState(new gameState_t);
+
+		// a full gamestate
+		for (csNum_t i = 0; i < MAX_CONFIGSTRINGS; ++i) {
+			setString(*gameState, i, str::printf("cs%u", i).c_str());
+		}
+
+		// scripts updating a few strings with values of varying length
+		char value[64];
+		auto start = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numUpdates; ++i)
+		{
+			const size_t len = snprintf(value, sizeof(value), "%zu %zu", i, i * i);
+			gameState->setConfigString((csNum_t)(1500 + i % 64), value, len);
+		}
+		auto end = std::chrono::system_clock().now();
+
+		MOHPC_LOG(Log, "%zu configstring updates in %lf time",
+			numUpdates,
+			std::chrono::duration<double>(end - start).count()
+		);
+	}
+};
+static CConfigstringTest unitTest;
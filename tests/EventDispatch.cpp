@@ -0,0 +1,158 @@
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Managers/EventManager.h>
+#include <MOHPC/Managers/GameManager.h>
+#include <MOHPC/Managers/ScriptManager.h>
+#include <MOHPC/Script/GameScript.h>
+#include <MOHPC/Script/ScriptThread.h>
+#include <MOHPC/Script/Event.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <string>
+
+#define MOHPC_LOG_NAMESPACE "test_eventdispatch"
+
+class CEventDispatchTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Event dispatch";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		using namespace MOHPC;
+
+		testArguments();
+		benchmarkScript(AM);
+
+		static constexpr size_t numIterations = 500000;
+
+		EventManagerPtr eventManager = AM->GetManager<EventManager>();
+		// abs returns a value
+		const uintptr_t absNum = eventManager->FindReturnEventNum("abs");
+		assert(absNum);
+
+		ScriptThread* thread = new ScriptThread();
+		thread->InitAssetManager(AM);
+
+		// what the VM does for a command: an event on the stack, arguments copied in, return value read back
+		float sum = 0.f;
+		const auto stackStart = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numIterations; ++i)
+		{
+			Event ev(absNum);
+			ev.ReserveArgs(1);
+			ev.AddFloat(-(float)(i & 7));
+			thread->ProcessScriptEvent(ev);
+			sum += ev.GetValue(ev.NumArgs()).floatValue();
+		}
+		const auto stackEnd = std::chrono::system_clock().now();
+
+		// same event, allocated from the event manager for every call
+		float heapSum = 0.f;
+		const auto heapStart = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numIterations; ++i)
+		{
+			Event* ev = eventManager->NewEvent(absNum);
+			ev->AddFloat(-(float)(i & 7));
+			heapSum += thread->ProcessEventReturn(ev).floatValue();
+		}
+		const auto heapEnd = std::chrono::system_clock().now();
+
+		assert(sum == heapSum);
+		assert(sum > 0.f);
+
+		delete thread;
+
+		MOHPC_LOG(
+			Log,
+			"%zu calls: %lld us with inline arguments, %lld us with allocated events",
+			numIterations,
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(stackEnd - stackStart).count(),
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(heapEnd - heapStart).count()
+		);
+	}
+
+private:
+	void benchmarkScript(const MOHPC::AssetManagerPtr& AM)
+	{
+		using namespace MOHPC;
+
+		static constexpr int numIterations = 200000;
+
+		// a native command called from a tight script loop
+		const std::string source =
+			"main:\n"
+			"local.sum = 0\n"
+			"local.i = 0\n"
+			"while (local.i < " + std::to_string(numIterations) + ")\n"
+			"{\n"
+			"local.sum = local.sum + (abs (local.i % 8 - 7))\n"
+			"local.i = local.i + 1\n"
+			"}\n"
+			"game.dispatch_sum = local.sum\n"
+			"end\n";
+
+		GameScript* scr = new GameScript();
+		scr->InitAssetManager(AM);
+		scr->Load(source.c_str(), source.length());
+		assert(scr->successCompile);
+
+		ScriptManagerPtr Director = AM->GetManager<ScriptManager>();
+
+		const auto start = std::chrono::system_clock().now();
+		Director->ExecuteThread(scr, "main");
+		const auto end = std::chrono::system_clock().now();
+
+		int expected = 0;
+		for (int i = 0; i < numIterations; ++i) {
+			expected += 7 - i % 8;
+		}
+
+		ScriptVariableList* vars = AM->GetManager<GameManager>()->GetGame()->Vars();
+		assert(vars->GetVariable(Director->AddString("dispatch_sum"))->intValue() == expected);
+
+		// the script has no file name, it was deleted with its thread
+
+		MOHPC_LOG(
+			Log,
+			"%d script calls in %lld us",
+			numIterations,
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+		);
+	}
+
+	void testArguments()
+	{
+		using namespace MOHPC;
+
+		// grow past the inline storage and make sure nothing is lost
+		Event ev;
+		for (int i = 0; i < Event::INLINE_ARGS * 3; ++i) {
+			ev.AddInteger(i);
+		}
+
+		assert(ev.NumArgs() == Event::INLINE_ARGS * 3);
+
+		Event copy = ev;
+		ev.Clear();
+		assert(ev.NumArgs() == 0);
+
+		for (int i = 0; i < Event::INLINE_ARGS * 3; ++i) {
+			assert(copy.GetInteger(i + 1) == i);
+		}
+
+		// small copies stay inline
+		Event small;
+		small.AddInteger(5);
+		Event smallCopy(small);
+		small.Clear();
+		assert(smallCopy.NumArgs() == 1);
+		assert(smallCopy.GetInteger(1) == 5);
+	}
+};
+static CEventDispatchTest unitTest;
@@ -0,0 +1,246 @@
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Managers/EventManager.h>
+#include <MOHPC/Managers/GameManager.h>
+#include <MOHPC/Script/Listener.h>
+#include <MOHPC/Script/Level.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_eventqueue"
+
+using namespace MOHPC;
+
+Event EV_EventQueueRecorder_Fire
+(
+	"eventqueue_fire",
+	EV_DEFAULT,
+	"i",
+	"id",
+	"Records the order of the event.",
+	EV_NORMAL
+);
+
+/**
+ * Listener recording the order its events fire in.
+ */
+class EventQueueRecorder : public Listener
+{
+public:
+	CLASS_PROTOTYPE(EventQueueRecorder);
+
+	std::vector<int>* firedOrder = nullptr;
+	// event that posts other events when it fires
+	int chainId = -1;
+	int chainedIds[2] = { 0 };
+	float chainedDelays[2] = { 0.f };
+
+	void Fire(Event* ev)
+	{
+		const int id = ev->GetInteger(1);
+		firedOrder->push_back(id);
+
+		if (id == chainId)
+		{
+			for (size_t i = 0; i < 2; ++i)
+			{
+				Event* chained = new Event(EV_EventQueueRecorder_Fire);
+				chained->AddInteger(chainedIds[i]);
+				PostEvent(chained, chainedDelays[i]);
+			}
+		}
+	}
+};
+
+CLASS_DECLARATION(Listener, EventQueueRecorder, NULL)
+{
+	{ &EV_EventQueueRecorder_Fire, &EventQueueRecorder::Fire },
+	{ NULL, NULL }
+};
+
+class CEventQueueTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Event queue";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t numListeners = 1000;
+		static constexpr size_t numEvents = 100000;
+
+		EventManagerPtr eventManager = AM->GetManager<EventManager>();
+		const size_t numPendingBefore = eventManager->NumPendingEvents();
+
+		std::vector<Listener*> listeners;
+		listeners.reserve(numListeners);
+		for (size_t i = 0; i < numListeners; ++i)
+		{
+			Listener* l = new Listener();
+			l->InitAssetManager(AM);
+			listeners.push_back(l);
+		}
+
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> delays(0.f, 600.f);
+
+		// post events far in the future, so they're never processed
+		const auto postStart = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numEvents; ++i) {
+			listeners[i % numListeners]->PostEvent(EV_Remove, delays(rng) + 3600.f);
+		}
+		const auto postEnd = std::chrono::system_clock().now();
+
+		assert(eventManager->NumPendingEvents() == numPendingBefore + numEvents);
+		for (size_t i = 0; i < numListeners; ++i) {
+			assert(listeners[i]->EventPending(EV_Remove));
+		}
+
+		// cancel half of the listeners by type, the other half all at once
+		const auto cancelStart = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numListeners; ++i)
+		{
+			if (i & 1) {
+				listeners[i]->CancelEventsOfType(EV_Remove);
+			}
+			else {
+				listeners[i]->CancelPendingEvents();
+			}
+		}
+		const auto cancelEnd = std::chrono::system_clock().now();
+
+		assert(eventManager->NumPendingEvents() == numPendingBefore);
+		for (size_t i = 0; i < numListeners; ++i) {
+			assert(!listeners[i]->EventPending(EV_Remove));
+		}
+
+		// deleting listeners with pending events must remove them from the queue
+		for (size_t i = 0; i < numEvents; ++i) {
+			listeners[i % numListeners]->PostEvent(EV_Remove, delays(rng) + 3600.f);
+		}
+
+		for (size_t i = 0; i < numListeners; ++i) {
+			delete listeners[i];
+		}
+
+		assert(eventManager->NumPendingEvents() == numPendingBefore);
+
+		testOrder(AM);
+
+		MOHPC_LOG(
+			Log,
+			"%zu events: posted in %lld us, cancelled in %lld us",
+			numEvents,
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(postEnd - postStart).count(),
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(cancelEnd - cancelStart).count()
+		);
+	}
+
+private:
+	struct expectedEvent_t
+	{
+		int id;
+		// level time the event fires at, in milliseconds
+		int fireTime;
+	};
+
+	void testOrder(const MOHPC::AssetManagerPtr& AM)
+	{
+		using namespace MOHPC;
+
+		static constexpr int numRecorders = 10;
+		static constexpr int numEvents = 1000;
+
+		EventManagerPtr eventManager = AM->GetManager<EventManager>();
+		Level* level = AM->GetManager<GameManager>()->GetLevel();
+		level->setTime(0);
+
+		const size_t numPendingBefore = eventManager->NumPendingEvents();
+
+		std::vector<int> firedOrder;
+		std::vector<EventQueueRecorder*> recorders;
+		for (int i = 0; i < numRecorders; ++i)
+		{
+			EventQueueRecorder* recorder = new EventQueueRecorder();
+			recorder->InitAssetManager(AM);
+			recorder->firedOrder = &firedOrder;
+			recorders.push_back(recorder);
+		}
+
+		// only 10 different delays, so most events fire at the same time as others
+		std::mt19937 rng(1234);
+		std::vector<expectedEvent_t> expected;
+		for (int i = 0; i < numEvents; ++i)
+		{
+			const int delay = 100 * (1 + (int)(rng() % 10));
+
+			Event* ev = new Event(EV_EventQueueRecorder_Fire);
+			ev->AddInteger(i);
+			recorders[i % numRecorders]->PostEvent(ev, delay / 1000.f);
+			expected.push_back({ i, delay });
+		}
+
+		// the first event firing at 200ms posts two events, when processed at 500ms
+		EventQueueRecorder* chainRecorder = nullptr;
+		for (const expectedEvent_t& event : expected)
+		{
+			if (event.fireTime == 200)
+			{
+				chainRecorder = recorders[event.id % numRecorders];
+				chainRecorder->chainId = event.id;
+				break;
+			}
+		}
+		assert(chainRecorder);
+
+		chainRecorder->chainedIds[0] = numEvents;
+		chainRecorder->chainedDelays[0] = 0.25f;
+		chainRecorder->chainedIds[1] = numEvents + 1;
+		chainRecorder->chainedDelays[1] = 2.f;
+		expected.push_back({ numEvents, 750 });
+		expected.push_back({ numEvents + 1, 2500 });
+
+		// sorted by time, events of the same time in the order they were posted
+		std::stable_sort(expected.begin(), expected.end(), [](const expectedEvent_t& a, const expectedEvent_t& b)
+		{
+			return a.fireTime < b.fireTime;
+		});
+
+		const int processTimes[] = { 500, 1100, 3000 };
+		for (const int processTime : processTimes)
+		{
+			level->setTime(processTime);
+			eventManager->ProcessPendingEvents();
+
+			// events posted while processing wait for their time
+			size_t numExpected = 0;
+			while (numExpected < expected.size() && expected[numExpected].fireTime < processTime) {
+				++numExpected;
+			}
+
+			assert(firedOrder.size() == numExpected);
+			for (size_t i = 0; i < numExpected; ++i) {
+				assert(firedOrder[i] == expected[i].id);
+			}
+		}
+
+		assert(firedOrder.size() == expected.size());
+		assert(eventManager->NumPendingEvents() == numPendingBefore);
+
+		for (EventQueueRecorder* recorder : recorders) {
+			delete recorder;
+		}
+
+		level->setTime(0);
+	}
+};
+static CEventQueueTest unitTest;
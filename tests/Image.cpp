@@ -0,0 +1,472 @@
+#include <MOHPC/Formats/Image.h>
+#include <MOHPC/Formats/DXT.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_image"
+
+class CImageTest : public IUnitTest
+{
+public:
+	virtual unsigned int priority() override
+	{
+		return 1;
+	}
+
+	virtual const char* name() override
+	{
+		return "Image";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testDXT1();
+		testDXT1Transparent();
+		testDXT3();
+		testDXT5();
+		testDecodeImage();
+		testDownsample();
+		testTGA();
+		testJPEG();
+		benchmarkTGA();
+
+		MOHPC_LOG(Log, "DXT decoding and mipmap filtering match the reference blocks");
+	}
+
+private:
+	static bool comparePixel(const uint8_t* pixels, size_t pixelNum, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+	{
+		const uint8_t* p = pixels + pixelNum * 4;
+		return p[0] == r && p[1] == g && p[2] == b && p[3] == a;
+	}
+
+	void testDXT1()
+	{
+		using namespace MOHPC;
+
+		// white and black endpoints, each row uses the 4 colors in order
+		const uint8_t block[8] = { 0xFF, 0xFF, 0x00, 0x00, 0xE4, 0xE4, 0xE4, 0xE4 };
+
+		uint8_t pixels[16 * 4];
+		DXT::DecodeBlock(DXT::Format::DXT1, block, pixels, 4 * 4);
+
+		for (size_t y = 0; y < 4; ++y)
+		{
+			assert(comparePixel(pixels, y * 4 + 0, 255, 255, 255, 255));
+			assert(comparePixel(pixels, y * 4 + 1, 0, 0, 0, 255));
+			assert(comparePixel(pixels, y * 4 + 2, 170, 170, 170, 255));
+			assert(comparePixel(pixels, y * 4 + 3, 85, 85, 85, 255));
+		}
+	}
+
+	void testDXT1Transparent()
+	{
+		using namespace MOHPC;
+
+		// c0 <= c1 selects the 3 colors + transparent black mode
+		const uint8_t block[8] = { 0x00, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4 };
+
+		uint8_t pixels[16 * 4];
+		DXT::DecodeBlock(DXT::Format::DXT1, block, pixels, 4 * 4);
+
+		for (size_t y = 0; y < 4; ++y)
+		{
+			assert(comparePixel(pixels, y * 4 + 0, 0, 0, 0, 255));
+			assert(comparePixel(pixels, y * 4 + 1, 255, 0, 0, 255));
+			assert(comparePixel(pixels, y * 4 + 2, 128, 0, 0, 255));
+			assert(comparePixel(pixels, y * 4 + 3, 0, 0, 0, 0));
+		}
+	}
+
+	void testDXT3()
+	{
+		using namespace MOHPC;
+
+		// explicit alpha going from 0 to 15, over a blue color block
+		const uint8_t block[16] =
+		{
+			0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE,
+			0x1F, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00
+		};
+
+		uint8_t pixels[16 * 4];
+		DXT::DecodeBlock(DXT::Format::DXT3, block, pixels, 4 * 4);
+
+		for (size_t i = 0; i < 16; ++i) {
+			assert(comparePixel(pixels, i, 0, 0, 255, (uint8_t)(i * 17)));
+		}
+	}
+
+	void testDXT5()
+	{
+		using namespace MOHPC;
+
+		// 8 alphas mode, every index used twice, over a green color block
+		{
+			const uint8_t block[16] =
+			{
+				224, 0, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA,
+				0xE0, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+			};
+			const uint8_t expected[8] = { 224, 0, 192, 160, 128, 96, 64, 32 };
+
+			uint8_t pixels[16 * 4];
+			DXT::DecodeBlock(DXT::Format::DXT5, block, pixels, 4 * 4);
+
+			for (size_t i = 0; i < 16; ++i) {
+				assert(comparePixel(pixels, i, 0, 255, 0, expected[i % 8]));
+			}
+		}
+
+		// 6 alphas mode with explicit 0 and 255
+		{
+			const uint8_t block[16] =
+			{
+				0, 250, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA,
+				0xE0, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+			};
+			const uint8_t expected[8] = { 0, 250, 50, 100, 150, 200, 0, 255 };
+
+			uint8_t pixels[16 * 4];
+			DXT::DecodeBlock(DXT::Format::DXT5, block, pixels, 4 * 4);
+
+			for (size_t i = 0; i < 16; ++i) {
+				assert(comparePixel(pixels, i, 0, 255, 0, expected[i % 8]));
+			}
+		}
+	}
+
+	void testDecodeImage()
+	{
+		using namespace MOHPC;
+
+		// 6x5 image, made of 2x2 blocks that are clipped on the right and bottom
+		const uint32_t width = 6;
+		const uint32_t height = 5;
+		assert(DXT::GetImageSize(DXT::Format::DXT1, width, height) == 4 * 8);
+
+		const uint8_t block[8] = { 0xFF, 0xFF, 0x00, 0x00, 0xE4, 0xE4, 0xE4, 0xE4 };
+		uint8_t blocks[4 * 8];
+		for (size_t i = 0; i < 4; ++i) {
+			memcpy(blocks + i * 8, block, sizeof(block));
+		}
+
+		// guard bytes after the image must stay untouched
+		uint8_t pixels[width * height * 4 + 4];
+		memset(pixels, 0xCD, sizeof(pixels));
+		DXT::DecodeImage(DXT::Format::DXT1, blocks, width, height, pixels);
+
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			assert(comparePixel(pixels, y * width + 0, 255, 255, 255, 255));
+			assert(comparePixel(pixels, y * width + 3, 85, 85, 85, 255));
+			assert(comparePixel(pixels, y * width + 4, 255, 255, 255, 255));
+			assert(comparePixel(pixels, y * width + 5, 0, 0, 0, 255));
+		}
+
+		assert(pixels[width * height * 4] == 0xCD);
+	}
+
+	void testDownsample()
+	{
+		using namespace MOHPC;
+
+		// 2x2 RGBA to 1x1
+		{
+			const uint8_t in[2 * 2 * 4] =
+			{
+				0, 10, 100, 255,	4, 20, 200, 255,
+				8, 30, 0, 0,		12, 40, 100, 0
+			};
+
+			uint8_t out[4];
+			Image::DownsampleBox(in, 2, 2, 4, out);
+			assert(out[0] == 6 && out[1] == 25 && out[2] == 100 && out[3] == 128);
+		}
+
+		// 4x1 RGB to 2x1, the single row is used twice
+		{
+			const uint8_t in[4 * 3] =
+			{
+				0, 0, 0,	255, 255, 255,	10, 20, 30,		30, 40, 50
+			};
+
+			uint8_t out[2 * 3];
+			Image::DownsampleBox(in, 4, 1, 3, out);
+			assert(out[0] == 128 && out[1] == 128 && out[2] == 128);
+			assert(out[3] == 20 && out[4] == 30 && out[5] == 40);
+		}
+	}
+
+	struct testTGA_t
+	{
+		std::vector<uint8_t> file;
+		// RGBA8, rows from top to bottom
+		std::vector<uint8_t> expected;
+	};
+
+	/**
+	 * Encode a TGA file with pixels repeated 3 times in file order, so that runs span across rows.
+	 * Run-length encoding uses a run packet for each repeated pixel and raw packets for the rest.
+	 */
+	static testTGA_t makeTGA(uint32_t width, uint32_t height, uint8_t pixelSize, bool rle, bool topDown)
+	{
+		const size_t bytesPerPixel = pixelSize / 8;
+		const size_t numPixels = (size_t)width * height;
+
+		testTGA_t tga;
+		tga.file.resize(18, 0);
+		tga.file[2] = rle ? 10 : (pixelSize == 8 ? 3 : 2);
+		tga.file[12] = (uint8_t)(width & 0xFF);
+		tga.file[13] = (uint8_t)(width >> 8);
+		tga.file[14] = (uint8_t)(height & 0xFF);
+		tga.file[15] = (uint8_t)(height >> 8);
+		tga.file[16] = pixelSize;
+		tga.file[17] = topDown ? 0x20 : 0;
+
+		// an image comment is skipped
+		tga.file[0] = 3;
+		tga.file.insert(tga.file.end(), { 'a', 'b', 'c' });
+
+		tga.expected.resize(numPixels * 4);
+
+		std::vector<uint8_t> pixels;
+		for (size_t i = 0; i < numPixels; ++i)
+		{
+			const size_t color = i / 3;
+			const uint8_t r = (uint8_t)(color * 7);
+			const uint8_t g = (uint8_t)(color * 13 + 1);
+			const uint8_t b = (uint8_t)(color ^ 0x5A);
+			const uint8_t a = (uint8_t)(color * 3 + 64);
+
+			const size_t row = i / width;
+			const size_t y = topDown ? row : height - row - 1;
+			uint8_t* out = tga.expected.data() + (y * width + i % width) * 4;
+
+			if (pixelSize == 8)
+			{
+				pixels.push_back(r);
+				out[0] = out[1] = out[2] = r;
+				out[3] = 255;
+			}
+			else
+			{
+				pixels.insert(pixels.end(), { b, g, r });
+				if (pixelSize == 32) {
+					pixels.push_back(a);
+				}
+
+				out[0] = r;
+				out[1] = g;
+				out[2] = b;
+				out[3] = pixelSize == 32 ? a : 255;
+			}
+		}
+
+		if (!rle)
+		{
+			tga.file.insert(tga.file.end(), pixels.begin(), pixels.end());
+			return tga;
+		}
+
+		for (size_t i = 0; i < numPixels; i += 3)
+		{
+			const size_t count = numPixels - i < 3 ? numPixels - i : 3;
+			const uint8_t* pixel = pixels.data() + i * bytesPerPixel;
+
+			if (i % 2)
+			{
+				tga.file.push_back((uint8_t)(0x80 | (count - 1)));
+				tga.file.insert(tga.file.end(), pixel, pixel + bytesPerPixel);
+			}
+			else
+			{
+				tga.file.push_back((uint8_t)(count - 1));
+				tga.file.insert(tga.file.end(), pixel, pixel + count * bytesPerPixel);
+			}
+		}
+
+		return tga;
+	}
+
+	void testTGA()
+	{
+		using namespace MOHPC;
+
+		const uint8_t pixelSizes[] = { 8, 24, 32 };
+		for (uint8_t pixelSize : pixelSizes)
+		{
+			for (int flags = 0; flags < 4; ++flags)
+			{
+				const bool rle = (flags & 1) != 0;
+				const bool topDown = (flags & 2) != 0;
+				if (rle && pixelSize == 8) {
+					continue;
+				}
+
+				// odd sizes leave pixels for the generic conversion
+				const uint32_t width = 37;
+				const uint32_t height = 5;
+				const testTGA_t tga = makeTGA(width, height, pixelSize, rle, topDown);
+
+				uint32_t decodedWidth, decodedHeight;
+				assert(Image::DecodeHeader(ImageFileFormat::TGA, tga.file.data(), 18 + 3, decodedWidth, decodedHeight));
+				assert(decodedWidth == width && decodedHeight == height);
+
+				std::vector<uint8_t> pixels(width * height * 4);
+				assert(Image::DecodeRGBA(ImageFileFormat::TGA, tga.file.data(), tga.file.size(), pixels.data(), pixels.size()));
+				assert(pixels == tga.expected);
+
+				// too small
+				assert(!Image::DecodeRGBA(ImageFileFormat::TGA, tga.file.data(), tga.file.size(), pixels.data(), pixels.size() - 1));
+				// truncated
+				assert(!Image::DecodeRGBA(ImageFileFormat::TGA, tga.file.data(), tga.file.size() - 1, pixels.data(), pixels.size()));
+			}
+		}
+
+		assert(Image::GetFileFormat("textures/test.TGA") == ImageFileFormat::TGA);
+		assert(Image::GetFileFormat("textures/test.jpg") == ImageFileFormat::JPEG);
+		assert(Image::GetFileFormat("textures/test.dds") == ImageFileFormat::Unknown);
+	}
+
+	/**
+	 * JPEG files made of flat 8x8 blocks at the highest quality, without chroma subsampling,
+	 * so each block decodes to a single color with any IDCT.
+	 * The block colors come from decoding the whole image with libjpeg, one row at a time.
+	 */
+	void testJPEG()
+	{
+		using namespace MOHPC;
+
+		// 16x40 RGB, 2x5 blocks
+		static const uint8_t rgbFile[] =
+		{
+			0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+			0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xC0,
+			0x00, 0x11, 0x08, 0x00, 0x28, 0x00, 0x10, 0x03, 0x01, 0x11, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+			0x01, 0xFF, 0xC4, 0x00, 0x16, 0x00, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x09, 0x0A, 0xFF, 0xC4, 0x00, 0x14, 0x10, 0x01, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF,
+			0xC4, 0x00, 0x18, 0x01, 0x01, 0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x0A, 0x0B, 0x09, 0xFF, 0xC4, 0x00, 0x14, 0x11, 0x01, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF,
+			0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00, 0x33, 0xAC, 0x10,
+			0xE1, 0xF9, 0x80, 0xCF, 0xFD, 0x28, 0x16, 0xA0, 0x18, 0xF7, 0x5A, 0xA1, 0x76, 0x05, 0xA8, 0x00,
+			0xFD, 0xD5, 0x86, 0x7F, 0xE6, 0x03, 0x3F, 0xF4, 0xA0, 0x5A, 0x80, 0x63, 0xDD, 0x6A, 0x85, 0xD8,
+			0x16, 0xA0, 0x1F, 0xFF, 0xD9,
+		};
+		static const uint8_t rgbBlocks[] =
+		{
+			30, 127, 224, 83, 180, 21, 136, 233, 74, 190, 30, 128, 243, 83, 181, 39, 136, 233, 92, 189, 30, 145, 242, 83, 199, 39, 137, 252, 92, 190
+		};
+
+		// 8x40 grayscale, 1x5 blocks
+		static const uint8_t grayFile[] =
+		{
+			0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+			0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xC0, 0x00, 0x0B, 0x08, 0x00, 0x28,
+			0x00, 0x08, 0x01, 0x01, 0x11, 0x00, 0xFF, 0xC4, 0x00, 0x15, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x0A, 0xFF, 0xC4, 0x00,
+			0x14, 0x10, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00, 0x8E, 0xF3, 0x50,
+			0x6A, 0x0D, 0x41, 0xA8, 0x7F, 0xFF, 0xD9,
+		};
+		static const uint8_t grayBlocks[] =
+		{
+			30, 83, 136, 189, 242
+		};
+
+		struct testJPEG_t
+		{
+			const uint8_t* file;
+			size_t fileSize;
+			const uint8_t* blocks;
+			size_t numComponents;
+			uint32_t width;
+			uint32_t height;
+		};
+
+		// 40 rows are read in strips of 16, 16 and 8 rows
+		const testJPEG_t jpegs[] =
+		{
+			{ rgbFile, sizeof(rgbFile), rgbBlocks, 3, 16, 40 },
+			{ grayFile, sizeof(grayFile), grayBlocks, 1, 8, 40 }
+		};
+
+		for (const testJPEG_t& jpeg : jpegs)
+		{
+			uint32_t decodedWidth, decodedHeight;
+			assert(Image::DecodeHeader(ImageFileFormat::JPEG, jpeg.file, jpeg.fileSize, decodedWidth, decodedHeight));
+			assert(decodedWidth == jpeg.width && decodedHeight == jpeg.height);
+
+			std::vector<uint8_t> pixels(jpeg.width * jpeg.height * 4);
+			assert(Image::DecodeRGBA(ImageFileFormat::JPEG, jpeg.file, jpeg.fileSize, pixels.data(), pixels.size()));
+
+			const size_t blocksPerRow = jpeg.width / 8;
+			for (size_t y = 0; y < jpeg.height; ++y)
+			{
+				for (size_t x = 0; x < jpeg.width; ++x)
+				{
+					const uint8_t* block = jpeg.blocks + ((y / 8) * blocksPerRow + x / 8) * jpeg.numComponents;
+					const uint8_t r = block[0];
+					const uint8_t g = jpeg.numComponents == 3 ? block[1] : block[0];
+					const uint8_t b = jpeg.numComponents == 3 ? block[2] : block[0];
+					assert(comparePixel(pixels.data(), y * jpeg.width + x, r, g, b, 255));
+				}
+			}
+		}
+	}
+
+	void benchmarkTGA()
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t numImages = 64;
+		const testTGA_t tga = makeTGA(512, 512, 24, false, false);
+		const testTGA_t tgaRLE = makeTGA(512, 512, 32, true, false);
+
+		// the buffer is reused for every image
+		std::vector<uint8_t> pixels;
+		uint32_t width, height;
+
+		auto start = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numImages; ++i) {
+			Image::DecodeRGBA(ImageFileFormat::TGA, tga.file.data(), tga.file.size(), pixels, width, height);
+		}
+		auto end = std::chrono::system_clock().now();
+		assert(pixels == tga.expected);
+
+		const double duration = std::chrono::duration<double>(end - start).count();
+
+		start = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numImages; ++i) {
+			Image::DecodeRGBA(ImageFileFormat::TGA, tgaRLE.file.data(), tgaRLE.file.size(), pixels, width, height);
+		}
+		end = std::chrono::system_clock().now();
+		assert(pixels == tgaRLE.expected);
+
+		MOHPC_LOG(Log, "%zu 512x512 TGA decoded in %lf time (24-bit), %lf time (32-bit RLE)",
+			numImages,
+			duration,
+			std::chrono::duration<double>(end - start).count()
+		);
+	}
+};
+static CImageTest unitTest;
@@ -0,0 +1,211 @@
+#include <MOHPC/Utilities/Info.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <string.h>
+
+#define MOHPC_LOG_NAMESPACE "test_info"
+
+class CInfoTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Infostring";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testReadOnly();
+		testModify();
+		testIterate();
+		benchmarkServerInfo();
+	}
+
+private:
+	// serverinfo as sent by a server in the status reply
+	static constexpr const char serverInfo[] =
+		"\\sv_maxclients\\32\\sv_hostname\\Allied Assault Test Server\\mapname\\obj/obj_team2"
+		"\\g_gametype\\4\\g_gametypestring\\Objective-Match\\fraglimit\\0\\timelimit\\20"
+		"\\sv_maxRate\\25000\\sv_floodProtect\\1\\sv_allowDownload\\0\\sv_fps\\20\\dmflags\\0"
+		"\\protocol\\8\\version\\Medal of Honor Allied Assault 1.11 win-x86 Mar  5 2002"
+		"\\gamename\\mohaa\\sv_keywords\\mohaa\\g_obj_alliedtext1\\Destroy the Flak 88"
+		"\\g_obj_alliedtext2\\Destroy the radar\\g_obj_alliedtext3\\\\g_obj_axistext1\\Defend the Flak 88"
+		"\\g_obj_axistext2\\Defend the radar\\g_obj_axistext3\\\\g_scoreboardpic\\objdm2"
+		"\\g_allowjointime\\30\\g_teamdamage\\1\\g_inactivekick\\900\\g_inactivespectate\\60"
+		"\\g_needpass\\0\\g_healthdrop\\1\\sv_minPing\\0\\sv_maxPing\\300\\sv_pure\\0\\roundlimit\\0";
+
+	// keys in a different case than the infostring, as queried by callers
+	static constexpr const char* keys[] =
+	{
+		"sv_maxclients", "sv_hostname", "mapname", "g_gametype", "g_gametypestring", "fraglimit", "timelimit",
+		"sv_maxrate", "sv_floodprotect", "sv_allowdownload", "sv_fps", "dmflags", "protocol", "version",
+		"gamename", "sv_keywords", "g_obj_alliedtext1", "g_obj_alliedtext2", "g_obj_alliedtext3", "g_obj_axistext1",
+		"g_obj_axistext2", "g_obj_axistext3", "g_scoreboardpic", "g_allowjointime", "g_teamdamage", "g_inactivekick",
+		"g_inactivespectate", "g_needpass", "g_healthdrop", "sv_minping", "sv_maxping", "sv_pure", "roundlimit"
+	};
+
+	void testReadOnly()
+	{
+		using namespace MOHPC;
+
+		ReadOnlyInfo info(serverInfo);
+		assert(info.GetIndex().getNumKeys() == sizeof(keys) / sizeof(keys[0]));
+
+		assert(info.IntValueForKey("sv_maxclients") == 32);
+		assert(info.IntValueForKey("SV_FPS") == 20);
+		assert(info.ValueForKey("mapname") == "obj/obj_team2");
+		assert(info.ValueForKey("roundlimit") == "0");
+		assert(info.ValueForKey("g_obj_alliedtext3") == "");
+
+		// keys only match as a whole
+		assert(info.ValueForKey("sv") == "");
+		assert(info.ValueForKey("sv_fps_") == "");
+
+		size_t len;
+		const char* value = info.ValueForKey("gamename", len);
+		assert(len == 5 && !strncmp(value, "mohaa", len));
+
+		// the size limits the infostring, no null character needed
+		ReadOnlyInfo truncated(serverInfo, strlen("\\sv_maxclients\\32\\sv_hostname\\Allied"));
+		assert(truncated.IntValueForKey("sv_maxclients") == 32);
+		assert(truncated.ValueForKey("sv_hostname") == "Allied");
+		assert(truncated.ValueForKey("mapname") == "");
+
+		// first of duplicate keys
+		ReadOnlyInfo duplicate("\\name\\first\\NAME\\second");
+		assert(duplicate.ValueForKey("name") == "first");
+	}
+
+	void testModify()
+	{
+		using namespace MOHPC;
+
+		Info info;
+		assert(!info.GetString());
+
+		info.SetValueForKey("rate", "25000");
+		info.SetValueForKey("snaps", "20");
+		info.SetValueForKey("name", "player");
+		assert(!strcmp(info.GetString(), "\\rate\\25000\\snaps\\20\\name\\player"));
+		assert(info.GetInfoLength() == strlen(info.GetString()) + 1);
+
+		// keys keep their place
+		info.SetValueForKey("SNAPS", "40");
+		assert(!strcmp(info.GetString(), "\\rate\\25000\\snaps\\40\\name\\player"));
+		assert(info.IntValueForKey("snaps") == 40);
+
+		info.RemoveKey("rate");
+		assert(!strcmp(info.GetString(), "\\snaps\\40\\name\\player"));
+		assert(info.ValueForKey("rate") == "");
+		assert(info.ValueForKey("name") == "player");
+
+		// invalid keys
+		info.SetValueForKey("a\\b", "c");
+		info.SetValueForKey("", "c");
+		assert(!strcmp(info.GetString(), "\\snaps\\40\\name\\player"));
+
+		// enough keys to grow the table
+		for (size_t i = 0; i < 100; ++i) {
+			info.SetValueForKey(str::printf("key%zu", i), str::printf("%zu", i));
+		}
+
+		for (size_t i = 0; i < 100; ++i) {
+			assert(info.IntValueForKey(str::printf("KEY%zu", i)) == i);
+		}
+
+		Info parsed(serverInfo);
+		assert(!strcmp(parsed.GetString(), serverInfo));
+		assert(parsed.ValueForKey("version") == "Medal of Honor Allied Assault 1.11 win-x86 Mar  5 2002");
+
+		Info moved(std::move(parsed));
+		assert(!strcmp(moved.GetString(), serverInfo));
+		assert(!parsed.GetString());
+	}
+
+	void testIterate()
+	{
+		using namespace MOHPC;
+
+		Info info;
+		assert(!info.createConstIterator());
+
+		info.SetValueForKey("rate", "25000");
+		info.SetValueForKey("snaps", "20");
+		info.SetValueForKey("name", "player");
+		info.RemoveKey("snaps");
+
+		static const char* expected[][2] = { { "rate", "25000" }, { "name", "player" } };
+
+		// keys are iterated in the order of the infostring
+		size_t numKeys = 0;
+		for (InfoIterator it = info.createConstIterator(); it; ++it)
+		{
+			assert(numKeys < 2);
+			assert(!strcmp(it.key(), expected[numKeys][0]));
+			assert(!strcmp(it.value(), expected[numKeys][1]));
+			++numKeys;
+		}
+		assert(numKeys == 2);
+
+		ReadOnlyInfo readOnly(serverInfo);
+		numKeys = 0;
+		for (InfoIterator it = readOnly.createConstIterator(); it; ++it)
+		{
+			// the reference keys are not in the same case
+			assert(!str::icmp(it.key(), keys[numKeys]));
+			++numKeys;
+		}
+		assert(numKeys == sizeof(keys) / sizeof(keys[0]));
+	}
+
+	void benchmarkServerInfo()
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t numReplies = 20000;
+		const size_t numKeys = sizeof(keys) / sizeof(keys[0]);
+
+		// every key of each reply is queried, as when listing servers
+		size_t total = 0;
+		auto start = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numReplies; ++i)
+		{
+			ReadOnlyInfo info(serverInfo);
+			for (size_t j = 0; j < numKeys; ++j)
+			{
+				size_t len;
+				info.ValueForKey(keys[j], len);
+				total += len;
+			}
+		}
+		auto end = std::chrono::system_clock().now();
+
+		assert(total);
+		const double readDuration = std::chrono::duration<double>(end - start).count();
+
+		// userinfo updates
+		start = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numReplies; ++i)
+		{
+			Info info;
+			for (size_t j = 0; j < numKeys; ++j) {
+				info.SetValueForKey(keys[j], "value");
+			}
+
+			info.SetValueForKey("sv_fps", "30");
+			total += info.GetInfoLength();
+		}
+		end = std::chrono::system_clock().now();
+
+		MOHPC_LOG(Log, "%zu serverinfo of %zu keys: all keys read in %lf time, written in %lf time",
+			numReplies,
+			numKeys,
+			readDuration,
+			std::chrono::duration<double>(end - start).count()
+		);
+	}
+};
+static CInfoTest unitTest;
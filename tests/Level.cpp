@@ -1,13 +1,19 @@
 #include <MOHPC/Formats/BSP.h>
 #include <MOHPC/Formats/DCL.h>
 #include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Managers/FileManager.h>
 #include <MOHPC/Managers/ShaderManager.h>
 #include <MOHPC/Collision/Collision.h>
+#include <MOHPC/Collision/CollisionCache.h>
+#include <MOHPC/Log.h>
 #include "UnitTest.h"
 
+#include <chrono>
 #include <map>
 #include <vector>
 
+#define MOHPC_LOG_NAMESPACE "test_bsp"
+
 class Archive
 {
 public:
@@ -210,10 +216,10 @@ public:
 		if(Asset)
 		{
 			traceTest(Asset);
+			treeBenchmark(Asset);
+			cacheTest(Asset);
+			parallelBuildTest(AM, Asset);
 			leafTesting(Asset);
-
-			MOHPC::BSPData::TerrainCollide collision;
-			Asset->GenerateTerrainCollide(Asset->GetTerrainPatch(0), collision);
 		}
 	}
 
@@ -260,6 +266,209 @@ public:
 		cm->CM_BoxTrace(&results, start, end, Vector(), Vector(), 0, ContentFlags::MASK_PLAYERSOLID, true);
 	}
 
+	void treeBenchmark(MOHPC::BSPPtr Asset)
+	{
+		using namespace MOHPC;
+		CollisionWorldPtr cm = CollisionWorld::create();
+		Asset->FillCollisionWorld(*cm);
+
+		std::vector<treeQuery_t> flatResults, nodesResults;
+		const double flatTime = runTreeQueries(*cm, flatResults);
+		cm->clearFlatTree();
+		const double nodesTime = runTreeQueries(*cm, nodesResults);
+		cm->flattenTree();
+
+		MOHPC_LOG(Log, "tree queries: %lf time with nodes, %lf time with compact nodes", nodesTime, flatTime);
+
+		// both traversals must give the same results
+		assert(flatResults.size() == nodesResults.size());
+		for (size_t i = 0; i < flatResults.size(); ++i)
+		{
+			const treeQuery_t& flat = flatResults[i];
+			const treeQuery_t& nodes = nodesResults[i];
+			assert(flat.pointContents == nodes.pointContents);
+			assert(flat.trace.fraction == nodes.trace.fraction);
+			assert(flat.trace.endpos == nodes.trace.endpos);
+			assert(flat.trace.plane.normal == nodes.trace.plane.normal);
+			assert(flat.trace.plane.dist == nodes.trace.plane.dist);
+			assert(flat.trace.contents == nodes.trace.contents);
+			assert(flat.trace.surfaceFlags == nodes.trace.surfaceFlags);
+			assert(flat.trace.allsolid == nodes.trace.allsolid);
+			assert(flat.trace.startsolid == nodes.trace.startsolid);
+		}
+	}
+
+	void cacheTest(MOHPC::BSPPtr Asset)
+	{
+		using namespace MOHPC;
+
+		// keep images in memory only
+		CollisionWorldCachePtr cache = CollisionWorldCache::create(nullptr);
+
+		// reference world, built from the BSP without the cache
+		auto start = std::chrono::system_clock().now();
+		CollisionWorldPtr cm = CollisionWorld::create();
+		Asset->FillCollisionWorld(*cm);
+		auto built = std::chrono::system_clock().now();
+
+		// builds the image, that the second world is loaded from
+		cache->getImage(*Asset);
+		auto imageBuilt = std::chrono::system_clock().now();
+		CollisionWorldPtr cachedCm = CollisionWorld::create();
+		cache->fillCollisionWorld(*Asset, *cachedCm);
+		auto end = std::chrono::system_clock().now();
+
+		MOHPC_LOG(Log, "collision world: %lf time to build, %lf time from image",
+			std::chrono::duration<double>(built - start).count(),
+			std::chrono::duration<double>(end - imageBuilt).count()
+		);
+
+		const CollisionWorldImagePtr image = cache->getImage(*Asset);
+		assert(image->getKey() == Asset->GetContentHash());
+		// kept in memory
+		assert(cache->getImage(*Asset) == image);
+
+		// worlds filled from the same image share the geometry
+		CollisionWorldPtr sharedCm = CollisionWorld::create();
+		cache->fillCollisionWorld(*Asset, *sharedCm);
+		assert(sharedCm->getPlane(0) == cachedCm->getPlane(0));
+
+		// a stale image must be rejected
+		const char* imagePath = "collision_test.cmwi";
+		image->writeFile(imagePath);
+		assert(CollisionWorldImage::fromFile(imagePath, image->getKey()));
+		assert(!CollisionWorldImage::fromFile(imagePath, image->getKey() + 1));
+		remove(imagePath);
+
+		srand(0);
+		for (size_t i = 0; i < 1000; ++i)
+		{
+			const Vector point((float)(rand() % 8192 - 4096), (float)(rand() % 8192 - 4096), (float)(rand() % 2048 - 1024));
+			const Vector endPoint = point + Vector((float)(rand() % 512 - 256), (float)(rand() % 512 - 256), (float)(rand() % 512 - 256));
+
+			trace_t results, cachedResults;
+			cm->CM_BoxTrace(&results, point, endPoint, Vector(-15, -15, 0), Vector(15, 15, 96), 0, ContentFlags::MASK_PLAYERSOLID, true);
+			cachedCm->CM_BoxTrace(&cachedResults, point, endPoint, Vector(-15, -15, 0), Vector(15, 15, 96), 0, ContentFlags::MASK_PLAYERSOLID, true);
+			assert(results.fraction == cachedResults.fraction);
+			assert(results.allsolid == cachedResults.allsolid);
+			assert(results.startsolid == cachedResults.startsolid);
+			assert(results.endpos == cachedResults.endpos);
+			assert(results.plane.normal == cachedResults.plane.normal);
+			assert(results.plane.dist == cachedResults.plane.dist);
+			assert(results.contents == cachedResults.contents);
+		}
+	}
+
+	void parallelBuildTest(const MOHPC::AssetManagerPtr& AM, MOHPC::BSPPtr Asset)
+	{
+		using namespace MOHPC;
+
+		auto start = std::chrono::system_clock().now();
+		CollisionWorldPtr cm = CollisionWorld::create();
+		Asset->FillCollisionWorld(*cm);
+		auto end = std::chrono::system_clock().now();
+
+		MOHPC_LOG(Log, "collision world: %lf time to fill with %zu terrain patches",
+			std::chrono::duration<double>(end - start).count(),
+			Asset->GetNumTerrainPatches()
+		);
+
+		// terrain generated on all cores must match the serial generation
+		assert(cm->getNumTerrains() == Asset->GetNumTerrainPatches());
+		for (size_t i = 0; i < Asset->GetNumTerrainPatches(); ++i)
+		{
+			BSPData::TerrainCollide collision;
+			Asset->GenerateTerrainCollide(Asset->GetTerrainPatch(i), collision);
+
+			const terrainCollide_t& tc = cm->getTerrain(i)->tc;
+			assert(tc.vBounds[0] == collision.vBounds[0]);
+			assert(tc.vBounds[1] == collision.vBounds[1]);
+			assert(!memcmp(tc.squares, collision.squares, sizeof(tc.squares)));
+		}
+
+		// patches are generated on all cores when loading, so a second load of the same file must give the same collision
+		FileManager* FM = AM->GetFileManager();
+		const char* copyName = "/maps/parallel_copy.bsp";
+		{
+			FilePtr file = FM->OpenFile(Asset->GetFilename().c_str());
+			assert(file);
+
+			void* buf;
+			const std::streamsize length = file->ReadBuffer(&buf);
+			FM->AddMemoryFile(copyName, buf, (size_t)length);
+		}
+
+		BSPPtr copy = AM->LoadAsset<BSP>(copyName);
+		assert(copy);
+
+		CollisionWorldPtr copyCm = CollisionWorld::create();
+		copy->FillCollisionWorld(*copyCm);
+
+		assert(copyCm->getNumPatches() == cm->getNumPatches());
+		for (size_t i = 0; i < cm->getNumPatches(); ++i)
+		{
+			const patchCollide_t& pc = cm->getPatch(i)->pc;
+			const patchCollide_t& expected = copyCm->getPatch(i)->pc;
+			assert(pc.bounds[0] == expected.bounds[0]);
+			assert(pc.bounds[1] == expected.bounds[1]);
+			assert(pc.numPlanes == expected.numPlanes);
+			assert(pc.numFacets == expected.numFacets);
+
+			for (size_t j = 0; j < pc.numPlanes; ++j)
+			{
+				assert(!memcmp(pc.planes[j].plane, expected.planes[j].plane, sizeof(pc.planes[j].plane)));
+				assert(pc.planes[j].signbits == expected.planes[j].signbits);
+			}
+
+			for (size_t j = 0; j < pc.numFacets; ++j)
+			{
+				const facet_t& facet = pc.facets[j];
+				const facet_t& expectedFacet = expected.facets[j];
+				assert(facet.surfacePlane == expectedFacet.surfacePlane);
+				assert(facet.numBorders == expectedFacet.numBorders);
+				assert(!memcmp(facet.borderPlanes, expectedFacet.borderPlanes, sizeof(facet.borderPlanes)));
+				assert(!memcmp(facet.borderInward, expectedFacet.borderInward, sizeof(facet.borderInward)));
+				assert(!memcmp(facet.borderNoAdjust, expectedFacet.borderNoAdjust, sizeof(facet.borderNoAdjust)));
+			}
+		}
+
+		FM->RemoveMemoryFile(copyName);
+	}
+
+	struct treeQuery_t
+	{
+		int pointContents;
+		// only traced every 4 queries
+		MOHPC::trace_t trace;
+	};
+
+	double runTreeQueries(MOHPC::CollisionWorld& cm, std::vector<treeQuery_t>& results)
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t numQueries = 200000;
+
+		// always the same queries
+		srand(0);
+		results.resize(numQueries);
+
+		auto start = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numQueries; ++i)
+		{
+			const Vector point((float)(rand() % 8192 - 4096), (float)(rand() % 8192 - 4096), (float)(rand() % 2048 - 1024));
+			results[i].pointContents = cm.CM_PointContents(point, 0);
+
+			if (!(i % 4))
+			{
+				const Vector end = point + Vector((float)(rand() % 512 - 256), (float)(rand() % 512 - 256), (float)(rand() % 512 - 256));
+				cm.CM_BoxTrace(&results[i].trace, point, end, Vector(-15, -15, 0), Vector(15, 15, 96), 0, ContentFlags::MASK_PLAYERSOLID, true);
+			}
+		}
+		auto end = std::chrono::system_clock().now();
+
+		return std::chrono::duration<double>(end - start).count();
+	}
+
 	void leafTesting(MOHPC::BSPPtr Asset)
 	{
 		uintptr_t leafNum = Asset->PointLeafNum(MOHPC::Vector(0, 0, 0));
@@ -0,0 +1,255 @@
+#include <MOHPC/Network/Client/MasterList.h>
+#include <MOHPC/Network/Client/MasterListDecoder.h>
+#include <MOHPC/Network/Socket.h>
+#include <MOHPC/Managers/NetworkManager.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <string.h>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_masterlist"
+
+/** Master server connection that replies with prepared data. */
+class FakeMasterSocket : public MOHPC::Network::ITcpSocket
+{
+public:
+	std::deque<std::vector<uint8_t>> replies;
+
+public:
+	size_t send(const void* buf, size_t bufsize) override
+	{
+		return bufsize;
+	}
+
+	size_t receive(void* buf, size_t maxsize) override
+	{
+		if (replies.empty()) {
+			return 0;
+		}
+
+		std::vector<uint8_t>& reply = replies.front();
+		const size_t len = reply.size() < maxsize ? reply.size() : maxsize;
+		memcpy(buf, reply.data(), len);
+		reply.erase(reply.begin(), reply.begin() + len);
+		if (reply.empty()) {
+			replies.pop_front();
+		}
+
+		return len;
+	}
+
+	bool wait(size_t timeout) override
+	{
+		return !replies.empty();
+	}
+
+	bool dataAvailable() override
+	{
+		return !replies.empty();
+	}
+};
+
+class FakeMasterSocketFactory : public MOHPC::Network::ISocketFactory
+{
+public:
+	MOHPC::SharedPtr<FakeMasterSocket> master;
+
+public:
+	MOHPC::Network::IUdpSocketPtr createUdp(const MOHPC::Network::NetAddr4* bindAddress) override
+	{
+		return nullptr;
+	}
+
+	MOHPC::Network::IUdpSocketPtr createUdp6(const MOHPC::Network::NetAddr6* bindAddress) override
+	{
+		return nullptr;
+	}
+
+	MOHPC::Network::ITcpSocketPtr createTcp(const MOHPC::Network::NetAddr4& address) override
+	{
+		return master;
+	}
+
+	MOHPC::Network::ITcpSocketPtr createTcp6(const MOHPC::Network::NetAddr6& address) override
+	{
+		return nullptr;
+	}
+
+	MOHPC::Network::ITcpServerSocketPtr createTcpListener() override
+	{
+		return nullptr;
+	}
+
+	MOHPC::Network::NetAddr4 getHost(const char* domain) override
+	{
+		return MOHPC::Network::NetAddr4();
+	}
+};
+
+class CMasterListTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Master server list";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testPieces();
+		testEmptyCallback();
+		benchmarkDecode();
+	}
+
+private:
+	/** Build a reply like the one sent by the master server. */
+	static std::vector<uint8_t> makeReply(size_t numServers, std::vector<MOHPC::Network::serverAddress_t>& expected)
+	{
+		using namespace MOHPC::Network;
+
+		std::mt19937 rng(1234);
+
+		std::vector<uint8_t> reply;
+		reply.reserve(numServers * MasterListDecoder::RECORD_SIZE + 7);
+		expected.resize(numServers);
+
+		for (size_t i = 0; i < numServers; ++i)
+		{
+			serverAddress_t& address = expected[i];
+			for (size_t j = 0; j < 4; ++j) {
+				address.ip[j] = (uint8_t)rng();
+			}
+
+			// addresses starting like the end marker must not end the list
+			if (!(i % 16)) {
+				address.ip[0] = '\\';
+			}
+
+			address.port = (uint16_t)(12203 + i % 16);
+
+			reply.insert(reply.end(), address.ip, address.ip + 4);
+			reply.push_back((uint8_t)(address.port >> 8));
+			reply.push_back((uint8_t)(address.port & 0xFF));
+		}
+
+		const char final[] = "\\final\\";
+		reply.insert(reply.end(), final, final + 7);
+
+		return reply;
+	}
+
+	static bool sameAddresses(const std::vector<MOHPC::Network::serverAddress_t>& a, const std::vector<MOHPC::Network::serverAddress_t>& b)
+	{
+		if (a.size() != b.size()) {
+			return false;
+		}
+
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (memcmp(a[i].ip, b[i].ip, sizeof(a[i].ip)) || a[i].port != b[i].port) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void testPieces()
+	{
+		using namespace MOHPC::Network;
+
+		std::vector<serverAddress_t> expected;
+		const std::vector<uint8_t> reply = makeReply(1000, expected);
+
+		// the reply can be received in pieces of any size
+		const size_t pieceSizes[] = { 1, 5, 6, 7, 13, 512, reply.size() };
+		for (size_t pieceSize : pieceSizes)
+		{
+			MasterListDecoder decoder;
+			std::vector<serverAddress_t> addresses;
+
+			for (size_t offset = 0; offset < reply.size(); offset += pieceSize)
+			{
+				const size_t len = reply.size() - offset < pieceSize ? reply.size() - offset : pieceSize;
+				const bool finished = decoder.decode(reply.data() + offset, len, addresses);
+				assert(finished == (offset + len == reply.size()));
+			}
+
+			assert(decoder.isFinished());
+			assert(sameAddresses(addresses, expected));
+		}
+
+		// nothing is decoded past the end
+		MasterListDecoder decoder;
+		std::vector<serverAddress_t> addresses;
+		std::vector<uint8_t> trailing = reply;
+		trailing.insert(trailing.end(), 12, 0);
+		assert(decoder.decode(trailing.data(), trailing.size(), addresses));
+		assert(sameAddresses(addresses, expected));
+	}
+
+	void testEmptyCallback()
+	{
+		using namespace MOHPC;
+		using namespace MOHPC::Network;
+
+		std::vector<serverAddress_t> expected;
+		const std::vector<uint8_t> reply = makeReply(100, expected);
+
+		const SharedPtr<FakeMasterSocketFactory> factory = makeShared<FakeMasterSocketFactory>();
+		factory->master = makeShared<FakeMasterSocket>();
+		const char challenge[] = "\\basic\\\\secure\\ABCDEF";
+		factory->master->replies.emplace_back(challenge, challenge + sizeof(challenge) - 1);
+		factory->master->replies.push_back(reply);
+		ISocketFactory::set(factory);
+
+		const NetworkManagerPtr manager = makeShared<NetworkManager>();
+		ServerListPtr master = ServerList::create(manager, gameListType_e::mohaab);
+
+		// an empty callback must not be called when the list is received
+		bool done = false;
+		master->fetchAddresses(FoundServerAddressesCallback(), [&done]() { done = true; });
+		for (size_t i = 0; i < 10 && !done; ++i) {
+			manager->processTicks();
+		}
+
+		assert(done);
+		assert(factory->master->replies.empty());
+
+		master.reset();
+		ISocketFactory::set(ISocketFactoryWeakPtr());
+	}
+
+	void benchmarkDecode()
+	{
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numServers = 100000;
+		static constexpr size_t pieceSize = 512;
+
+		std::vector<serverAddress_t> expected;
+		const std::vector<uint8_t> reply = makeReply(numServers, expected);
+
+		std::vector<serverAddress_t> addresses;
+		MasterListDecoder decoder;
+
+		auto start = std::chrono::system_clock().now();
+		for (size_t offset = 0; offset < reply.size(); offset += pieceSize)
+		{
+			const size_t len = reply.size() - offset < pieceSize ? reply.size() - offset : pieceSize;
+			decoder.decode(reply.data() + offset, len, addresses);
+		}
+		auto end = std::chrono::system_clock().now();
+
+		assert(addresses.size() == numServers);
+
+		const double duration = std::chrono::duration<double>(end - start).count();
+		MOHPC_LOG(Log, "%zu servers decoded in %lf time (%lf MB/s)", numServers, duration, reply.size() / (duration * 1024 * 1024));
+	}
+};
+static CMasterListTest unitTest;
@@ -0,0 +1,275 @@
+#include <MOHPC/Common/Memory.h>
+#include <MOHPC/Common/Container.h>
+#include <MOHPC/Common/str.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_memory"
+
+class CMemoryTest : public IUnitTest
+{
+private:
+	class CountingAllocator : public MOHPC::IAllocator
+	{
+	public:
+		size_t numAllocated = 0;
+		size_t numDeallocated = 0;
+
+		void* allocate(size_t size) override
+		{
+			++numAllocated;
+			return malloc(size);
+		}
+
+		void deallocate(void* ptr, size_t size) override
+		{
+			++numDeallocated;
+			free(ptr);
+		}
+	};
+
+public:
+	virtual const char* name() override
+	{
+		return "Memory";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testPool();
+		testPoolThreads();
+		testAllocator();
+		testStats();
+		testArena();
+		benchmarkPool();
+	}
+
+private:
+	void testPool()
+	{
+		using namespace MOHPC;
+
+		PoolAllocator& pool = PoolAllocator::get();
+
+		std::vector<void*> blocks;
+		for (size_t size = 0; size <= PoolAllocator::maxPooledSize + 64; size += 8)
+		{
+			void* ptr = pool.allocate(size);
+			assert(ptr);
+			assert(!((uintptr_t)ptr & 15));
+			memset(ptr, (int)size, size);
+			blocks.push_back(ptr);
+		}
+
+		// blocks must not overlap
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			const size_t size = i * 8;
+			for (size_t j = 0; j < size; ++j) {
+				assert(((uint8_t*)blocks[i])[j] == (uint8_t)size);
+			}
+		}
+
+		for (size_t i = 0; i < blocks.size(); ++i) {
+			pool.deallocate(blocks[i], i * 8);
+		}
+
+		// a freed block is reused
+		void* first = pool.allocate(32);
+		pool.deallocate(first, 32);
+		void* second = pool.allocate(32);
+		assert(first == second);
+		pool.deallocate(second, 32);
+	}
+
+	void testPoolThreads()
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t numThreads = 4;
+		static constexpr size_t numBlocks = 10000;
+
+		std::vector<void*> blocks[numThreads];
+		std::vector<std::thread> threads;
+
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			threads.emplace_back([&blocks, i]()
+			{
+				PoolAllocator& pool = PoolAllocator::get();
+				for (size_t j = 0; j < numBlocks; ++j)
+				{
+					void* ptr = pool.allocate(48);
+					*(size_t*)ptr = i * numBlocks + j;
+					blocks[i].push_back(ptr);
+				}
+			});
+		}
+
+		for (std::thread& thread : threads) thread.join();
+		threads.clear();
+
+		// blocks are freed by another thread than the one that allocated them
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			threads.emplace_back([&blocks, i]()
+			{
+				PoolAllocator& pool = PoolAllocator::get();
+				const size_t other = (i + 1) % numThreads;
+				for (size_t j = 0; j < numBlocks; ++j)
+				{
+					assert(*(size_t*)blocks[other][j] == other * numBlocks + j);
+					pool.deallocate(blocks[other][j], 48);
+				}
+			});
+		}
+
+		for (std::thread& thread : threads) thread.join();
+	}
+
+	void testAllocator()
+	{
+		using namespace MOHPC;
+
+		CountingAllocator allocator;
+		setAllocator(&allocator);
+		assert(getAllocator() == &allocator);
+
+		void* ptr = allocateMemory(100);
+		{
+			Container<int> list;
+			list.AddObject(1);
+			str text = "allocated through the hook";
+		}
+		setAllocator(nullptr);
+		assert(getAllocator() != &allocator);
+		// the block, the list, the string and its characters
+		assert(allocator.numAllocated == 4);
+		assert(allocator.numDeallocated == 3);
+
+		// freed by the allocator it came from
+		freeMemory(ptr);
+		assert(allocator.numDeallocated == 4);
+	}
+
+	void testStats()
+	{
+		using namespace MOHPC;
+
+		const MemoryStats before = getMemoryStats(memoryTag_e::Network);
+
+		void* ptr;
+		void* untagged;
+		{
+			MemoryTagScope scope(memoryTag_e::Network);
+			assert(getMemoryTag() == memoryTag_e::Network);
+			{
+				MemoryTagScope nested(memoryTag_e::General);
+				untagged = allocateMemory(64);
+			}
+			ptr = allocateMemory(1000);
+		}
+		assert(getMemoryTag() == memoryTag_e::General);
+
+		MemoryStats stats = getMemoryStats(memoryTag_e::Network);
+		assert(stats.numAllocations == before.numAllocations + 1);
+		assert(stats.bytesInUse == before.bytesInUse + 1000);
+		assert(stats.peakBytesInUse >= stats.bytesInUse);
+
+		// the tag is the one it was allocated with
+		freeMemory(ptr);
+		freeMemory(untagged);
+		stats = getMemoryStats(memoryTag_e::Network);
+		assert(stats.numFrees == before.numFrees + 1);
+		assert(stats.bytesInUse == before.bytesInUse);
+	}
+
+	void testArena()
+	{
+		using namespace MOHPC;
+
+		const MemoryStats before = getMemoryStats(memoryTag_e::TIKI);
+
+		MemoryArena arena(memoryTag_e::TIKI, 1024);
+
+		void* small = arena.allocate(10);
+		void* other = arena.allocate(20);
+		assert(!((uintptr_t)small & 15) && !((uintptr_t)other & 15));
+		assert((uint8_t*)other >= (uint8_t*)small + 10);
+		// bigger than a chunk
+		void* big = arena.allocate(4096);
+		memset(big, 0, 4096);
+		// still taken from the first chunk
+		void* after = arena.allocate(16);
+		assert((uint8_t*)after == (uint8_t*)other + 32);
+
+		assert(arena.getUsedSize() == 16 + 32 + 4096 + 16);
+		assert(getMemoryStats(memoryTag_e::TIKI).numAllocations == before.numAllocations + 4);
+		assert(getMemoryStats(memoryTag_e::TIKI).bytesInUse == before.bytesInUse + arena.getUsedSize());
+
+		arena.reset();
+		assert(arena.getUsedSize() == 0);
+		assert(getMemoryStats(memoryTag_e::TIKI).numFrees == before.numFrees + 4);
+		assert(getMemoryStats(memoryTag_e::TIKI).bytesInUse == before.bytesInUse);
+
+		// usable again
+		assert(arena.allocate(100));
+
+		// the scope frees the blocks even when leaving through an exception
+		try
+		{
+			MemoryArenaScope arenaScope(arena);
+			arena.allocate(100);
+			throw std::runtime_error("load failed");
+		}
+		catch (const std::runtime_error&)
+		{
+		}
+		assert(arena.getUsedSize() == 0);
+		assert(getMemoryStats(memoryTag_e::TIKI).bytesInUse == before.bytesInUse);
+	}
+
+	void benchmarkPool()
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t numIterations = 100;
+		static constexpr size_t numBlocks = 10000;
+
+		std::vector<void*> blocks(numBlocks);
+		PoolAllocator& pool = PoolAllocator::get();
+		MallocAllocator& heap = MallocAllocator::get();
+
+		const auto poolStart = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numIterations; ++i)
+		{
+			for (size_t j = 0; j < numBlocks; ++j) blocks[j] = pool.allocate(16 + (j % 8) * 16);
+			for (size_t j = 0; j < numBlocks; ++j) pool.deallocate(blocks[j], 16 + (j % 8) * 16);
+		}
+		const auto poolEnd = std::chrono::system_clock().now();
+
+		for (size_t i = 0; i < numIterations; ++i)
+		{
+			for (size_t j = 0; j < numBlocks; ++j) blocks[j] = heap.allocate(16 + (j % 8) * 16);
+			for (size_t j = 0; j < numBlocks; ++j) heap.deallocate(blocks[j], 16 + (j % 8) * 16);
+		}
+		const auto heapEnd = std::chrono::system_clock().now();
+
+		MOHPC_LOG(
+			Log,
+			"%zu small blocks allocated and freed: pool %lld us, malloc %lld us",
+			numIterations * numBlocks,
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(poolEnd - poolStart).count(),
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(heapEnd - poolEnd).count()
+		);
+	}
+};
+static CMemoryTest unitTest;
@@ -0,0 +1,162 @@
+#include <MOHPC/Network/Metrics.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+#define MOHPC_LOG_NAMESPACE "test_netmetrics"
+
+class CNetworkMetricsTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Network metrics";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testHistogram();
+		testChannel();
+		testConcurrentRead();
+		benchmarkUpdates();
+	}
+
+private:
+	void testHistogram()
+	{
+		using namespace MOHPC::Network;
+
+		assert(MetricHistogram::getBucketNum(0) == 0);
+		assert(MetricHistogram::getBucketNum(1) == 1);
+		assert(MetricHistogram::getBucketNum(2) == 2);
+		assert(MetricHistogram::getBucketNum(3) == 2);
+		assert(MetricHistogram::getBucketNum(1000) == 10);
+		assert(MetricHistogram::getBucketNum(UINT64_MAX) == MetricHistogram::NUM_BUCKETS - 1);
+		assert(MetricHistogram::getBucketLimit(10) == 1023);
+
+		MetricHistogram histogram;
+		assert(histogram.getPercentile(50) == 0);
+
+		// 90 fast values and 10 slow values
+		for (size_t i = 0; i < 90; ++i) {
+			histogram.record(100);
+		}
+		for (size_t i = 0; i < 10; ++i) {
+			histogram.record(5000);
+		}
+
+		assert(histogram.getCount() == 100);
+		assert(histogram.getSum() == 90 * 100 + 10 * 5000);
+		assert(histogram.getMax() == 5000);
+		assert(histogram.getBucketCount(MetricHistogram::getBucketNum(100)) == 90);
+		assert(histogram.getPercentile(50) == 127);
+		assert(histogram.getPercentile(90) == 127);
+		// capped to the highest value
+		assert(histogram.getPercentile(99) == 5000);
+
+		histogram.reset();
+		assert(!histogram.getCount() && !histogram.getMax());
+	}
+
+	void testChannel()
+	{
+		using namespace MOHPC::Network;
+
+		const ChannelMetricsPtr total = ChannelMetrics::create();
+		const ChannelMetricsPtr server = ChannelMetrics::create(total);
+		const ChannelMetricsPtr client1 = ChannelMetrics::create(server);
+		const ChannelMetricsPtr client2 = ChannelMetrics::create();
+		client2->setParent(server);
+
+		client1->packetReceived(100);
+		client1->packetSent(1400);
+		client1->fragmentSent();
+		client2->packetReceived(50);
+		client2->packetsDropped(3);
+		client2->packetOutOfOrder();
+		server->packetReceived(20);
+
+		assert(client1->packetsIn.get() == 1 && client1->bytesIn.get() == 100);
+		assert(client2->droppedPackets.get() == 3);
+		assert(server->packetsIn.get() == 3 && server->bytesIn.get() == 170);
+		assert(total->packetsIn.get() == 3 && total->bytesIn.get() == 170);
+		assert(total->bytesOut.get() == 1400 && total->fragmentsOut.get() == 1);
+		assert(total->droppedPackets.get() == 3 && total->outOfOrderPackets.get() == 1);
+	}
+
+	void testConcurrentRead()
+	{
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numPackets = 200000;
+
+		const ChannelMetricsPtr metrics = ChannelMetrics::create();
+		MetricHistogram parseTime;
+		std::atomic<bool> done(false);
+
+		// another thread polls the metrics while they are updated
+		std::thread reader([&]()
+		{
+			uint64_t lastPackets = 0;
+			while (!done.load())
+			{
+				const uint64_t packets = metrics->packetsIn.get();
+				assert(packets >= lastPackets);
+				lastPackets = packets;
+				parseTime.getPercentile(99);
+			}
+		});
+
+		for (size_t i = 0; i < numPackets; ++i)
+		{
+			metrics->packetReceived(i % 1400);
+			parseTime.record(i % 200);
+		}
+
+		done = true;
+		reader.join();
+
+		assert(metrics->packetsIn.get() == numPackets);
+		assert(parseTime.getCount() == numPackets);
+		assert(parseTime.getMax() == 199);
+	}
+
+	void benchmarkUpdates()
+	{
+		using namespace MOHPC::Network;
+
+		static constexpr size_t numPackets = 10000000;
+
+		const ChannelMetricsPtr total = ChannelMetrics::create();
+		const ChannelMetricsPtr metrics = ChannelMetrics::create(total);
+		MetricHistogram histogram;
+
+		// what the channel does for each received packet
+		auto start = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numPackets; ++i) {
+			metrics->packetReceived(i & 1023);
+		}
+		auto end = std::chrono::system_clock().now();
+		const double packetDuration = std::chrono::duration<double>(end - start).count();
+
+		start = std::chrono::system_clock().now();
+		for (size_t i = 0; i < numPackets; ++i) {
+			histogram.record(i & 1023);
+		}
+		end = std::chrono::system_clock().now();
+
+		assert(total->packetsIn.get() == numPackets);
+
+		MOHPC_LOG(Log, "%zu packets counted in %lf time, %zu histogram values in %lf time",
+			numPackets,
+			packetDuration,
+			numPackets,
+			std::chrono::duration<double>(end - start).count()
+		);
+	}
+};
+static CNetworkMetricsTest unitTest;
@@ -0,0 +1,280 @@
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Formats/BSP.h>
+#include <MOHPC/Collision/Collision.h>
+#include <MOHPC/Network/pm/bg_public.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_pmove"
+
+class CPmoveTest : public IUnitTest
+{
+private:
+	class TestPmove : public MOHPC::Pmove
+	{
+	protected:
+		bool canLean(const MOHPC::usercmd_t& cmd) override
+		{
+			return true;
+		}
+
+		bool shouldClearLean() override
+		{
+			return false;
+		}
+	};
+
+	/**
+	 * User-defined collision for Pmove::move(Collision&), a flat floor at the height 0.
+	 */
+	class FloorCollision
+	{
+	public:
+		size_t numTraces = 0;
+		size_t numPointContents = 0;
+
+	public:
+		void trace(MOHPC::trace_t* results, const MOHPC::Vector& start, const MOHPC::Vector& mins, const MOHPC::Vector& maxs, const MOHPC::Vector& end, uintptr_t passEntityNum, uintptr_t contentMask, bool capsule, bool traceDeep)
+		{
+			using namespace MOHPC;
+
+			++numTraces;
+
+			*results = trace_t();
+			results->fraction = 1.f;
+			results->endpos = end;
+			results->entityNum = ENTITYNUM_NONE;
+
+			const float startBottom = start[2] + mins[2];
+			const float endBottom = end[2] + mins[2];
+			if (startBottom < 0.f)
+			{
+				results->fraction = 0.f;
+				results->endpos = start;
+				results->allsolid = results->startsolid = true;
+				results->entityNum = ENTITYNUM_WORLD;
+				return;
+			}
+
+			if (endBottom >= 0.f) {
+				return;
+			}
+
+			// stop a bit above the floor, like the world does
+			const float frac = (startBottom - 0.125f) / (startBottom - endBottom);
+			results->fraction = frac > 0.f ? frac : 0.f;
+			results->endpos = start + (end - start) * results->fraction;
+			results->plane.normal = Vector(0, 0, 1);
+			results->plane.dist = 0.f;
+			results->entityNum = ENTITYNUM_WORLD;
+		}
+
+		uint32_t pointContents(const MOHPC::Vector& point, uintptr_t passEntityNum)
+		{
+			++numPointContents;
+			return 0;
+		}
+	};
+
+	static constexpr size_t numPlayers = 64;
+	static constexpr size_t numCommands = 100;
+
+public:
+	virtual const char* name() override
+	{
+		return "Player movement";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		using namespace MOHPC;
+
+		customCollisionTest();
+
+		BSPPtr Asset = AM->LoadAsset<BSP>("/maps/dm/mohdm6.bsp");
+		if (!Asset) {
+			return;
+		}
+
+		CollisionWorldPtr cm = CollisionWorld::create();
+		Asset->FillCollisionWorld(*cm);
+
+		std::vector<playerState_t> callbackStates;
+		std::vector<playerState_t> worldStates;
+		std::vector<playerState_t> batchStates;
+		spawnPlayers(callbackStates);
+		worldStates = callbackStates;
+		batchStates = callbackStates;
+
+		TestPmove pmove;
+		pmove_t& pm = pmove.get();
+		pm.trace = [&cm](trace_t* results, const Vector& start, const Vector& mins, const Vector& maxs, const Vector& end, uintptr_t passEntityNum, uintptr_t contentMask, bool capsule, bool traceDeep)
+		{
+			cm->CM_BoxTrace(results, start, end, mins, maxs, 0, (uint32_t)contentMask, capsule);
+			results->entityNum = results->fraction != 1.f || results->startsolid ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+		};
+		pm.pointcontents = [&cm](const Vector& point, uintptr_t passEntityNum) -> uint32_t
+		{
+			return cm->CM_PointContents(point, 0);
+		};
+
+		double callbackTime = 0.0;
+		double worldTime = 0.0;
+		double batchTime = 0.0;
+
+		std::vector<pmoveBatch_t> batch(numPlayers);
+		for (size_t cmdNum = 1; cmdNum <= numCommands; ++cmdNum)
+		{
+			auto start = std::chrono::system_clock().now();
+			for (size_t i = 0; i < numPlayers; ++i)
+			{
+				pm.ps = &callbackStates[i];
+				pm.cmd = makeCommand(i, cmdNum);
+				pm.tracemask = ContentFlags::MASK_PLAYERSOLID;
+				pmove.move();
+			}
+			auto callbackEnd = std::chrono::system_clock().now();
+
+			for (size_t i = 0; i < numPlayers; ++i)
+			{
+				pm.ps = &worldStates[i];
+				pm.cmd = makeCommand(i, cmdNum);
+				pm.tracemask = ContentFlags::MASK_PLAYERSOLID;
+				pmove.move(*cm);
+			}
+			auto worldEnd = std::chrono::system_clock().now();
+
+			for (size_t i = 0; i < numPlayers; ++i)
+			{
+				batch[i].ps = &batchStates[i];
+				batch[i].cmd = makeCommand(i, cmdNum);
+				batch[i].tracemask = ContentFlags::MASK_PLAYERSOLID;
+			}
+			pmove.moveBatch(*cm, batch.data(), batch.size());
+			auto batchEnd = std::chrono::system_clock().now();
+
+			callbackTime += std::chrono::duration<double>(callbackEnd - start).count();
+			worldTime += std::chrono::duration<double>(worldEnd - callbackEnd).count();
+			batchTime += std::chrono::duration<double>(batchEnd - worldEnd).count();
+		}
+
+		// all ways of moving must give the same result
+		for (size_t i = 0; i < numPlayers; ++i)
+		{
+			assert(callbackStates[i].origin == worldStates[i].origin);
+			assert(callbackStates[i].velocity == worldStates[i].velocity);
+			assert(worldStates[i].origin == batchStates[i].origin);
+			assert(worldStates[i].velocity == batchStates[i].velocity);
+			assert(worldStates[i].commandTime == batchStates[i].commandTime);
+		}
+
+		MOHPC_LOG(Log, "%zu players, %zu commands: %lf time with callbacks, %lf time with world, %lf time with batch",
+			numPlayers,
+			numCommands,
+			callbackTime,
+			worldTime,
+			batchTime
+		);
+	}
+
+private:
+	void customCollisionTest()
+	{
+		using namespace MOHPC;
+
+		std::vector<playerState_t> callbackStates;
+		std::vector<playerState_t> customStates;
+		spawnPlayers(callbackStates);
+		for (playerState_t& ps : callbackStates) {
+			ps.origin[2] = 64.f;
+		}
+		customStates = callbackStates;
+
+		// the same floor, once through the callbacks of pmove_t and once as a template argument
+		FloorCollision callbackFloor;
+		FloorCollision floor;
+
+		TestPmove pmove;
+		pmove_t& pm = pmove.get();
+		pm.trace = [&callbackFloor](trace_t* results, const Vector& start, const Vector& mins, const Vector& maxs, const Vector& end, uintptr_t passEntityNum, uintptr_t contentMask, bool capsule, bool traceDeep)
+		{
+			callbackFloor.trace(results, start, mins, maxs, end, passEntityNum, contentMask, capsule, traceDeep);
+		};
+		pm.pointcontents = [&callbackFloor](const Vector& point, uintptr_t passEntityNum) -> uint32_t
+		{
+			return callbackFloor.pointContents(point, passEntityNum);
+		};
+
+		for (size_t cmdNum = 1; cmdNum <= numCommands; ++cmdNum)
+		{
+			for (size_t i = 0; i < numPlayers; ++i)
+			{
+				pm.ps = &callbackStates[i];
+				pm.cmd = makeCommand(i, cmdNum);
+				pm.tracemask = ContentFlags::MASK_PLAYERSOLID;
+				pmove.move();
+
+				pm.ps = &customStates[i];
+				pm.cmd = makeCommand(i, cmdNum);
+				pm.tracemask = ContentFlags::MASK_PLAYERSOLID;
+				pmove.move(floor);
+			}
+		}
+
+		// the functor was called directly and gave the same result as the callbacks
+		assert(floor.numTraces);
+		assert(floor.numTraces == callbackFloor.numTraces);
+		assert(floor.numPointContents == callbackFloor.numPointContents);
+		for (size_t i = 0; i < numPlayers; ++i)
+		{
+			assert(customStates[i].origin == callbackStates[i].origin);
+			assert(customStates[i].velocity == callbackStates[i].velocity);
+			assert(customStates[i].commandTime == callbackStates[i].commandTime);
+
+			// fell and walks on the floor
+			assert(customStates[i].groundEntityNum == ENTITYNUM_WORLD);
+			assert(customStates[i].origin[2] >= 0.f && customStates[i].origin[2] <= 0.25f);
+		}
+	}
+
+	void spawnPlayers(std::vector<MOHPC::playerState_t>& states)
+	{
+		using namespace MOHPC;
+
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> coord(-1024.f, 1024.f);
+
+		states.resize(numPlayers);
+		for (playerState_t& ps : states)
+		{
+			ps.origin = Vector(coord(rng), coord(rng), 256.f);
+			ps.gravity = DEFAULT_GRAVITY;
+			ps.speed = 250;
+			ps.stats[(size_t)playerstat_e::STAT_HEALTH] = 100;
+			ps.pm_type = pmType_e::Normal;
+			ps.groundEntityNum = ENTITYNUM_NONE;
+			ps.viewheight = DEFAULT_VIEWHEIGHT;
+		}
+	}
+
+	MOHPC::usercmd_t makeCommand(size_t playerNum, size_t cmdNum)
+	{
+		using namespace MOHPC;
+
+		usercmd_t cmd((uint32_t)(cmdNum * 16));
+		cmd.setAngles(0.f, (float)((playerNum * 37 + cmdNum) % 360), 0.f);
+		cmd.forwardmove = 127;
+		cmd.rightmove = (cmdNum / 20) % 2 ? 64 : -64;
+		if (!(cmdNum % 25)) {
+			cmd.buttons.flags |= BUTTON_RUN;
+		}
+
+		return cmd;
+	}
+};
+static CPmoveTest unitTest;
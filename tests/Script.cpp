@@ -0,0 +1,508 @@
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Managers/FileManager.h>
+#include <MOHPC/Managers/GameManager.h>
+#include <MOHPC/Managers/ScriptManager.h>
+#include <MOHPC/Script/ConstStr.h>
+#include <MOHPC/Script/GameScript.h>
+#include <MOHPC/Script/ScriptOpcodes.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_script"
+
+class CScriptTest : public IUnitTest
+{
+private:
+	struct compileResult_t
+	{
+		bool success;
+		// switch operands point to states of the script, they are cleared
+		std::vector<uint8_t> program;
+	};
+
+public:
+	virtual const char* name() override
+	{
+		return "Script compiler";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		using namespace MOHPC;
+
+		testSuperInstructions(AM);
+		testCompiledScript(AM);
+		testCompiledScriptDirectory(AM);
+		testColdConcurrentCompile(AM);
+
+		// read everything first, the file manager is only used from this thread
+		std::vector<std::string> sources;
+
+		FileEntryList files = AM->GetFileManager()->ListFilteredFiles("/global", "scr", true, false);
+		for (size_t i = 0; i < files.GetNumFiles(); ++i)
+		{
+			FilePtr file = AM->GetFileManager()->OpenFile(files.GetFileEntry(i)->GetStr().c_str());
+			if (!file) {
+				continue;
+			}
+
+			void* buffer;
+			const size_t length = (size_t)file->ReadBuffer(&buffer);
+			sources.emplace_back((const char*)buffer, length);
+		}
+
+		if (sources.empty())
+		{
+			MOHPC_LOG(Warning, "no global scripts found");
+			return;
+		}
+
+		size_t numThreads = std::thread::hardware_concurrency();
+		if (numThreads < 4) {
+			numThreads = 4;
+		}
+
+		// compiled on all threads first, so the strings of the scripts are added concurrently
+		// every thread compiles all scripts, starting at a different one so that the same script is compiled at the same time
+		std::vector<std::vector<compileResult_t>> results(numThreads);
+		std::vector<std::thread> threads;
+
+		const auto parallelStart = std::chrono::system_clock().now();
+		for (size_t t = 0; t < numThreads; ++t)
+		{
+			threads.emplace_back([this, &AM, &sources, &results, t]()
+			{
+				results[t].resize(sources.size());
+				for (size_t n = 0; n < sources.size(); ++n)
+				{
+					const size_t i = (n + t) % sources.size();
+					results[t][i] = compile(AM, sources[i]);
+				}
+			});
+		}
+
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+		const auto parallelEnd = std::chrono::system_clock().now();
+
+		// reference results, compiled one at a time with all the strings known
+		std::vector<compileResult_t> expected(sources.size());
+		const auto singleStart = std::chrono::system_clock().now();
+		for (size_t i = 0; i < sources.size(); ++i) {
+			expected[i] = compile(AM, sources[i]);
+		}
+		const auto singleEnd = std::chrono::system_clock().now();
+
+		for (size_t t = 0; t < numThreads; ++t)
+		{
+			for (size_t i = 0; i < sources.size(); ++i)
+			{
+				assert(results[t][i].success == expected[i].success);
+				assert(results[t][i].program == expected[i].program);
+			}
+		}
+
+		MOHPC_LOG(
+			Log,
+			"%zu scripts: %lld ms on one thread, %lld ms for %zu times the work on %zu threads",
+			sources.size(),
+			(long long)std::chrono::duration_cast<std::chrono::milliseconds>(singleEnd - singleStart).count(),
+			(long long)std::chrono::duration_cast<std::chrono::milliseconds>(parallelEnd - parallelStart).count(),
+			numThreads,
+			numThreads
+		);
+	}
+
+private:
+	void testColdConcurrentCompile(const MOHPC::AssetManagerPtr& AM)
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t numScriptsPerThread = 50;
+
+		size_t numThreads = std::thread::hardware_concurrency();
+		if (numThreads < 4) {
+			numThreads = 4;
+		}
+
+		ScriptManagerPtr Director = AM->GetManager<ScriptManager>();
+
+		// every script has its own strings, and strings shared by all threads, none of them are in the string table yet
+		std::vector<std::vector<std::string>> sources(numThreads);
+		std::vector<std::string> names;
+		for (size_t t = 0; t < numThreads; ++t)
+		{
+			for (size_t i = 0; i < numScriptsPerThread; ++i)
+			{
+				const std::string suffix = std::to_string(t) + "_" + std::to_string(i);
+				names.push_back("var_" + suffix);
+				names.push_back("label_" + suffix);
+				names.push_back("text_" + suffix);
+
+				sources[t].push_back(
+					"main:\n"
+					"local.var_" + suffix + " = \"text_" + suffix + "\"\n"
+					"level.shared_" + std::to_string(i) + " = local.var_" + suffix + "\n"
+					"thread label_" + suffix + " local.var_" + suffix + "\n"
+					"end\n"
+					"label_" + suffix + " local.shared_arg:\n"
+					"level.shared_value = local.shared_arg + " + std::to_string(i) + "\n"
+					"end\n"
+				);
+			}
+		}
+
+		for (size_t i = 0; i < numScriptsPerThread; ++i) {
+			names.push_back("shared_" + std::to_string(i));
+		}
+
+		for (const std::string& name : names) {
+			assert(Director->GetString(name.c_str()) == STRING_EMPTY);
+		}
+
+		// all threads wait for each other, so the strings are added at the same time
+		std::vector<std::vector<compileResult_t>> results(numThreads);
+		std::vector<std::thread> threads;
+		std::mutex startMutex;
+		std::condition_variable startCondition;
+		size_t numWaiting = 0;
+
+		for (size_t t = 0; t < numThreads; ++t)
+		{
+			threads.emplace_back([&, t]()
+			{
+				{
+					std::unique_lock<std::mutex> lock(startMutex);
+					if (++numWaiting == numThreads) {
+						startCondition.notify_all();
+					}
+					else {
+						startCondition.wait(lock, [&]() { return numWaiting == numThreads; });
+					}
+				}
+
+				for (size_t i = 0; i < sources[t].size(); ++i) {
+					results[t].push_back(compile(AM, sources[t][i]));
+				}
+			});
+		}
+
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		// no string was lost or added twice
+		for (const std::string& name : names)
+		{
+			const const_str index = Director->GetString(name.c_str());
+			assert(index != STRING_EMPTY);
+			assert(Director->GetString(index) == name.c_str());
+		}
+
+		// the strings are known now, so compiling again must give the same program
+		for (size_t t = 0; t < numThreads; ++t)
+		{
+			for (size_t i = 0; i < sources[t].size(); ++i)
+			{
+				const compileResult_t expected = compile(AM, sources[t][i]);
+				assert(results[t][i].success);
+				assert(results[t][i].success == expected.success);
+				assert(results[t][i].program == expected.program);
+			}
+		}
+	}
+
+	void testSuperInstructions(const MOHPC::AssetManagerPtr& AM)
+	{
+		using namespace MOHPC;
+
+		// every pair is executed with the condition both true and false,
+		// while loops also go through the backward jump
+		const char source[] =
+			"main:\n"
+			"local.i = 0\n"
+			"while (local.i < 10)\n"
+			"{\n"
+			"local.i = local.i + 1\n"
+			"}\n"
+			"game.less = local.i\n"
+			"local.i = 10\n"
+			"while (local.i > 3)\n"
+			"{\n"
+			"local.i = local.i - 1\n"
+			"}\n"
+			"game.greater = local.i\n"
+			"local.i = 0\n"
+			"while (local.i <= 4)\n"
+			"{\n"
+			"local.i = local.i + 1\n"
+			"}\n"
+			"game.lessEqual = local.i\n"
+			"local.i = 5\n"
+			"while (local.i >= -2)\n"
+			"{\n"
+			"local.i = local.i - 1\n"
+			"}\n"
+			"game.greaterEqual = local.i\n"
+			"local.i = 0\n"
+			"while (local.i != 7)\n"
+			"{\n"
+			"local.i = local.i + 1\n"
+			"}\n"
+			"game.inequality = local.i\n"
+			"local.i = 0\n"
+			"local.n = 0\n"
+			"while (local.i < 20)\n"
+			"{\n"
+			"local.i = local.i + 1\n"
+			"if (local.i == 5)\n"
+			"{\n"
+			"local.n = local.n + 1\n"
+			"}\n"
+			"}\n"
+			"game.equality = local.n\n"
+			"local.taken = 0\n"
+			"if (local.i == 20) { local.taken = local.taken + 1 }\n"
+			"if (local.i == 21) { local.taken = local.taken + 2 }\n"
+			"if (local.i != 20) { local.taken = local.taken + 4 }\n"
+			"if (local.i != 21) { local.taken = local.taken + 8 }\n"
+			"if (local.i < 21) { local.taken = local.taken + 16 }\n"
+			"if (local.i < 20) { local.taken = local.taken + 32 }\n"
+			"if (local.i > 19) { local.taken = local.taken + 64 }\n"
+			"if (local.i > 20) { local.taken = local.taken + 128 }\n"
+			"if (local.i <= 20) { local.taken = local.taken + 256 }\n"
+			"if (local.i <= 19) { local.taken = local.taken + 512 }\n"
+			"if (local.i >= 20) { local.taken = local.taken + 1024 }\n"
+			"if (local.i >= 21) { local.taken = local.taken + 2048 }\n"
+			"game.taken = local.taken\n"
+			"local.never = 0\n"
+			"while (local.i < 0)\n"
+			"{\n"
+			"local.never = local.never + 1\n"
+			"}\n"
+			"game.never = local.never\n"
+			"end\n";
+
+		GameScript* scr = new GameScript();
+		scr->InitAssetManager(AM);
+		scr->Load(source, sizeof(source) - 1);
+		assert(scr->successCompile);
+
+		// the second opcode of each pair must be kept
+		bool hasPlus = false, hasMinus = false;
+		bool hasJump[6] = { false };
+		const uint8_t jumpOpcodes[6] =
+		{
+			OP_BIN_EQUALITY_VAR_JUMP_FALSE4,
+			OP_BIN_INEQUALITY_VAR_JUMP_FALSE4,
+			OP_BIN_LESS_THAN_VAR_JUMP_FALSE4,
+			OP_BIN_GREATER_THAN_VAR_JUMP_FALSE4,
+			OP_BIN_LESS_THAN_OR_EQUAL_VAR_JUMP_FALSE4,
+			OP_BIN_GREATER_THAN_OR_EQUAL_VAR_JUMP_FALSE4
+		};
+
+		for (size_t i = 0; i + 2 < scr->m_ProgLength; ++i)
+		{
+			const uint8_t* p = scr->m_ProgBuffer + i;
+			hasPlus |= p[0] == OP_STORE_INT1_BIN_PLUS && p[2] == OP_BIN_PLUS;
+			hasMinus |= p[0] == OP_STORE_INT1_BIN_MINUS && p[2] == OP_BIN_MINUS;
+			for (size_t j = 0; j < 6; ++j) {
+				hasJump[j] |= p[0] == jumpOpcodes[j] && p[1] == OP_VAR_JUMP_FALSE4;
+			}
+		}
+
+		assert(hasPlus);
+		assert(hasMinus);
+		for (size_t j = 0; j < 6; ++j) {
+			assert(hasJump[j]);
+		}
+
+		ScriptManagerPtr Director = AM->GetManager<ScriptManager>();
+		Director->ExecuteThread(scr, "main");
+
+		// expected values are the ones of the unfused opcodes
+		ScriptVariableList* vars = AM->GetManager<GameManager>()->GetGame()->Vars();
+		assert(vars->GetVariable(Director->AddString("less"))->intValue() == 10);
+		assert(vars->GetVariable(Director->AddString("greater"))->intValue() == 3);
+		assert(vars->GetVariable(Director->AddString("lessEqual"))->intValue() == 5);
+		assert(vars->GetVariable(Director->AddString("greaterEqual"))->intValue() == -3);
+		assert(vars->GetVariable(Director->AddString("inequality"))->intValue() == 7);
+		assert(vars->GetVariable(Director->AddString("equality"))->intValue() == 1);
+		assert(vars->GetVariable(Director->AddString("taken"))->intValue() == 1 + 8 + 16 + 64 + 256 + 1024);
+		assert(vars->GetVariable(Director->AddString("never"))->intValue() == 0);
+
+		// the script has no file name, it was deleted with its thread
+	}
+
+	void testCompiledScript(const MOHPC::AssetManagerPtr& AM)
+	{
+		using namespace MOHPC;
+
+		const char source[] =
+			"main:\n"
+			"local.text = \"compiled\"\n"
+			"thread other local.text 2\n"
+			"end\n"
+			"other local.a local.b:\n"
+			"local.c = local.a + \" twice\"\n"
+			"wait local.b\n"
+			"end\n";
+
+		const uint64_t sourceHash = GameScript::GetSourceHash(source, sizeof(source) - 1);
+
+		GameScript* scr = new GameScript();
+		scr->InitAssetManager(AM);
+		scr->Load(source, sizeof(source) - 1);
+		assert(scr->successCompile);
+
+		Container<uint8_t> data;
+		assert(scr->SaveCompiled(sourceHash, data));
+
+		GameScript* loaded = new GameScript();
+		loaded->InitAssetManager(AM);
+		assert(loaded->LoadCompiled(data.Data(), data.NumObjects(), sourceHash));
+		assert(loaded->successCompile);
+
+		// the same strings and events are found again, so the program is identical
+		assert(loaded->m_ProgLength == scr->m_ProgLength);
+		assert(!memcmp(loaded->m_ProgBuffer, scr->m_ProgBuffer, scr->m_ProgLength));
+		assert(loaded->GetRequiredStackSize() == scr->GetRequiredStackSize());
+
+		ScriptManagerPtr Director = AM->GetManager<ScriptManager>();
+		const const_str labels[] = { Director->AddString("main"), Director->AddString("other") };
+		for (const const_str label : labels)
+		{
+			assert(scr->m_State->FindLabel(label));
+			assert(loaded->m_State->FindLabel(label) - loaded->m_ProgBuffer == scr->m_State->FindLabel(label) - scr->m_ProgBuffer);
+		}
+		assert(!loaded->m_State->FindLabel(Director->AddString("missing")));
+
+		// labels, relocations and the string table are written back the same
+		Container<uint8_t> reloaded;
+		assert(loaded->SaveCompiled(sourceHash, reloaded));
+		assert(reloaded.NumObjects() == data.NumObjects());
+		assert(!memcmp(reloaded.Data(), data.Data(), data.NumObjects()));
+
+		delete loaded;
+
+		// another source
+		loaded = new GameScript();
+		loaded->InitAssetManager(AM);
+		assert(!loaded->LoadCompiled(data.Data(), data.NumObjects(), sourceHash + 1));
+		assert(!loaded->m_ProgBuffer);
+		delete loaded;
+
+		// another format, the version follows the identifier
+		Container<uint8_t> otherVersion = data;
+		const uint32_t version = GameScript::COMPILED_VERSION + 1;
+		memcpy(otherVersion.Data() + 4, &version, sizeof(version));
+
+		loaded = new GameScript();
+		loaded->InitAssetManager(AM);
+		assert(!loaded->LoadCompiled(otherVersion.Data(), otherVersion.NumObjects(), sourceHash));
+		assert(!loaded->m_ProgBuffer);
+		delete loaded;
+
+		// corrupted data
+		Container<uint8_t> corrupted = data;
+		corrupted[corrupted.NumObjects() - 1] ^= 0xFF;
+
+		loaded = new GameScript();
+		loaded->InitAssetManager(AM);
+		assert(!loaded->LoadCompiled(corrupted.Data(), corrupted.NumObjects(), sourceHash));
+		delete loaded;
+
+		delete scr;
+	}
+
+	void testCompiledScriptDirectory(const MOHPC::AssetManagerPtr& AM)
+	{
+		using namespace MOHPC;
+
+		const char source[] =
+			"main:\n"
+			"local.a = 1\n"
+			"while (local.a < 10)\n"
+			"{\n"
+			"local.a = local.a * 2\n"
+			"}\n"
+			"end\n";
+
+		// a copy of the file has the same hash
+		const char* fileName = "global/compiled_test.scr";
+		const char* copyName = "global/compiled_test_copy.scr";
+		const uint64_t sourceHash = GameScript::GetSourceHash(source, sizeof(source) - 1);
+
+		AM->GetFileManager()->AddMemoryFile(fileName, source, sizeof(source) - 1);
+		AM->GetFileManager()->AddMemoryFile(copyName, source, sizeof(source) - 1);
+
+		ScriptManagerPtr Director = AM->GetManager<ScriptManager>();
+		Director->SetCompiledScriptDirectory(".");
+
+		// compiled and saved
+		GameScript* scr = Director->GetGameScript(fileName);
+		assert(scr->successCompile);
+
+		const str compiledPath = Director->GetCompiledScriptPath(sourceHash);
+		FILE* file = fopen(compiledPath.c_str(), "rb");
+		assert(file);
+		fclose(file);
+
+		Container<uint8_t> data;
+		assert(scr->SaveCompiled(sourceHash, data));
+
+		// the copy is loaded from the compiled script, with the source kept for errors
+		GameScript* loaded = Director->GetGameScript(copyName);
+		assert(loaded != scr);
+		assert(loaded->successCompile);
+		assert(loaded->m_SourceLength == sizeof(source) - 1);
+		assert(loaded->m_ProgLength == scr->m_ProgLength);
+		assert(!memcmp(loaded->m_ProgBuffer, scr->m_ProgBuffer, scr->m_ProgLength));
+
+		Container<uint8_t> loadedData;
+		assert(loaded->SaveCompiled(sourceHash, loadedData));
+		assert(loadedData.NumObjects() == data.NumObjects());
+		assert(!memcmp(loadedData.Data(), data.Data(), data.NumObjects()));
+
+		Director->SetCompiledScriptDirectory(nullptr);
+		remove(compiledPath.c_str());
+		AM->GetFileManager()->RemoveMemoryFile(fileName);
+		AM->GetFileManager()->RemoveMemoryFile(copyName);
+	}
+
+	compileResult_t compile(const MOHPC::AssetManagerPtr& AM, const std::string& source)
+	{
+		MOHPC::GameScript* scr = new MOHPC::GameScript();
+		scr->InitAssetManager(AM);
+		scr->Load(source.c_str(), source.length());
+
+		compileResult_t result;
+		result.success = scr->successCompile;
+		if (scr->m_ProgBuffer)
+		{
+			result.program.assign(scr->m_ProgBuffer, scr->m_ProgBuffer + scr->m_ProgLength);
+			for (size_t i = 0; i < scr->m_Relocations.NumObjects(); ++i)
+			{
+				const MOHPC::script_relocation_t& reloc = scr->m_Relocations[i];
+				if (reloc.type == MOHPC::scriptRelocationType_e::SwitchState) {
+					memset(result.program.data() + reloc.offset, 0, sizeof(MOHPC::StateScript*));
+				}
+			}
+		}
+
+		delete scr;
+		return result;
+	}
+};
+static CScriptTest unitTest;
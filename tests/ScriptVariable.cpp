@@ -0,0 +1,161 @@
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Managers/GameManager.h>
+#include <MOHPC/Managers/ScriptManager.h>
+#include <MOHPC/Script/GameScript.h>
+#include <MOHPC/Script/ScriptVariable.h>
+#include <MOHPC/Script/Listener.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <string>
+
+#define MOHPC_LOG_NAMESPACE "test_scriptvar"
+
+class CScriptVariableTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Script variable";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		using namespace MOHPC;
+
+		static_assert(sizeof(ScriptVariable) <= 16, "ScriptVariable must stay compact");
+
+		testConstString(AM);
+		benchmarkArithmetic();
+		benchmarkScript(AM);
+	}
+
+private:
+	void testConstString(const MOHPC::AssetManagerPtr& AM)
+	{
+		using namespace MOHPC;
+
+		Listener* owner = new Listener();
+		owner->InitAssetManager(AM);
+
+		{
+			ScriptVariableContext context(owner);
+			assert(ScriptVariableContext::GetOwner() == owner);
+
+			ScriptVariable var;
+			var.setConstStringValue(AM->GetManager<ScriptManager>()->AddString("test_constant"));
+			assert(var.stringValue() == "test_constant");
+
+			// copies share nothing with the original
+			ScriptVariable copy = var;
+			var.setIntValue(5);
+			assert(copy.stringValue() == "test_constant");
+		}
+
+		assert(ScriptVariableContext::GetOwner() == nullptr);
+
+		delete owner;
+	}
+
+	void benchmarkArithmetic()
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t numIterations = 2000000;
+
+		// what the VM does for: local.sum = local.sum + (local.i * 3 % 7) - 1; if (local.i < n)
+		ScriptVariable stack[8];
+		ScriptVariable sum;
+		sum.setIntValue(0);
+
+		const auto start = std::chrono::system_clock().now();
+
+		for (size_t i = 0; i < numIterations; ++i)
+		{
+			stack[0] = sum;
+			stack[1].setIntValue((int)i);
+			stack[2].setIntValue(3);
+			stack[1] *= stack[2];
+			stack[2].setIntValue(7);
+			stack[1] %= stack[2];
+			stack[0] += stack[1];
+			stack[1].setIntValue(1);
+			stack[0] -= stack[1];
+			sum = stack[0];
+
+			stack[0].setIntValue((int)i);
+			stack[1].setIntValue((int)numIterations);
+			stack[0].lessthan(stack[1]);
+			assert(stack[0].booleanValue());
+		}
+
+		const auto end = std::chrono::system_clock().now();
+
+		int expected = 0;
+		for (size_t i = 0; i < numIterations; ++i) {
+			expected += (int)(i * 3 % 7) - 1;
+		}
+
+		assert(sum.intValue() == expected);
+
+		const long long duration = (long long)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+		MOHPC_LOG(
+			Log,
+			"%zu bytes per variable, %zu iterations of 9 operations in %lld us",
+			sizeof(ScriptVariable),
+			numIterations,
+			duration
+		);
+	}
+
+	void benchmarkScript(const MOHPC::AssetManagerPtr& AM)
+	{
+		using namespace MOHPC;
+
+		static constexpr int numIterations = 200000;
+
+		// same arithmetic as benchmarkArithmetic(), executed by the VM
+		const std::string source =
+			"main:\n"
+			"local.sum = 0\n"
+			"local.i = 0\n"
+			"while (local.i < " + std::to_string(numIterations) + ")\n"
+			"{\n"
+			"local.sum = local.sum + (local.i * 3 % 7) - 1\n"
+			"local.i = local.i + 1\n"
+			"}\n"
+			"game.arithmetic_sum = local.sum\n"
+			"end\n";
+
+		GameScript* scr = new GameScript();
+		scr->InitAssetManager(AM);
+		scr->Load(source.c_str(), source.length());
+		assert(scr->successCompile);
+
+		ScriptManagerPtr Director = AM->GetManager<ScriptManager>();
+
+		const auto start = std::chrono::system_clock().now();
+		Director->ExecuteThread(scr, "main");
+		const auto end = std::chrono::system_clock().now();
+
+		int expected = 0;
+		for (int i = 0; i < numIterations; ++i) {
+			expected += i * 3 % 7 - 1;
+		}
+
+		ScriptVariableList* vars = AM->GetManager<GameManager>()->GetGame()->Vars();
+		assert(vars->GetVariable(Director->AddString("arithmetic_sum"))->intValue() == expected);
+
+		// the script has no file name, it was deleted with its thread
+
+		MOHPC_LOG(
+			Log,
+			"%d script loop iterations in %lld us",
+			numIterations,
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+		);
+	}
+};
+static CScriptVariableTest unitTest;
@@ -0,0 +1,163 @@
+#include <MOHPC/Network/Client/SnapshotPublisher.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_snappublish"
+
+class CSnapshotPublisherTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Snapshot publication";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		testSlots();
+		testConcurrentReaders();
+	}
+
+private:
+	static void fillSnapshot(MOHPC::Network::SnapshotInfo& snap, uint32_t messageNum)
+	{
+		snap.serverTime = messageNum * 50;
+		snap.numEntities = messageNum % 64;
+		for (size_t i = 0; i < snap.numEntities; ++i) {
+			snap.entities[i].number = (MOHPC::entityNum_t)(messageNum + i);
+		}
+	}
+
+	static bool checkSnapshot(const MOHPC::Network::SnapshotInfo& snap, uint32_t messageNum)
+	{
+		if (snap.serverTime != messageNum * 50 || snap.numEntities != messageNum % 64) {
+			return false;
+		}
+
+		for (size_t i = 0; i < snap.numEntities; ++i)
+		{
+			if (snap.entities[i].number != (MOHPC::entityNum_t)(messageNum + i)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void testSlots()
+	{
+		using namespace MOHPC::Network;
+
+		SnapshotPublisher publisher;
+		assert(!publisher.acquireLatest());
+		assert(!publisher.beginPublish());
+
+		publisher.enable();
+		assert(!publisher.acquireLatest());
+
+		// hold a reference to each published snapshot
+		std::vector<PublishedSnapshotRef> refs;
+		for (uint32_t messageNum = 1; messageNum <= SnapshotPublisher::NUM_SLOTS; ++messageNum)
+		{
+			SnapshotInfo* snap = publisher.beginPublish();
+			assert(snap);
+			fillSnapshot(*snap, messageNum);
+			publisher.endPublish(messageNum);
+
+			PublishedSnapshotRef ref = publisher.acquireLatest();
+			assert(ref.getMessageNum() == messageNum);
+			assert(ref.getPublication() == messageNum);
+			refs.push_back(std::move(ref));
+		}
+
+		// every slot is referenced
+		assert(!publisher.beginPublish());
+		assert(publisher.getNumSkipped() == 1);
+
+		// nothing was overwritten
+		for (size_t i = 0; i < refs.size(); ++i) {
+			assert(checkSnapshot(*refs[i], refs[i].getMessageNum()));
+		}
+
+		// releasing one is enough
+		refs[0].reset();
+		SnapshotInfo* snap = publisher.beginPublish();
+		assert(snap);
+		publisher.cancelPublish();
+		assert(publisher.acquireLatest().getMessageNum() == SnapshotPublisher::NUM_SLOTS);
+	}
+
+	void testConcurrentReaders()
+	{
+		using namespace MOHPC::Network;
+
+		static constexpr uint32_t numMessages = 20000;
+		static constexpr size_t numReaders = 3;
+
+		SnapshotPublisher publisher;
+		publisher.enable();
+
+		std::atomic<bool> done(false);
+		std::atomic<size_t> numReads(0);
+		std::atomic<size_t> numErrors(0);
+
+		auto reader = [&]()
+		{
+			uint32_t lastMessageNum = 0;
+			while (!done)
+			{
+				PublishedSnapshotRef ref = publisher.acquireLatest();
+				if (!ref) {
+					continue;
+				}
+
+				// always moving forward, and never torn
+				if (ref.getMessageNum() < lastMessageNum || !checkSnapshot(*ref, ref.getMessageNum())) {
+					++numErrors;
+				}
+
+				lastMessageNum = ref.getMessageNum();
+				++numReads;
+			}
+		};
+
+		std::vector<std::thread> readers;
+		for (size_t i = 0; i < numReaders; ++i) {
+			readers.emplace_back(reader);
+		}
+
+		auto start = std::chrono::system_clock().now();
+		for (uint32_t messageNum = 1; messageNum <= numMessages; ++messageNum)
+		{
+			SnapshotInfo* snap = publisher.beginPublish();
+			if (snap)
+			{
+				fillSnapshot(*snap, messageNum);
+				publisher.endPublish(messageNum);
+			}
+		}
+		auto end = std::chrono::system_clock().now();
+
+		done = true;
+		for (std::thread& thread : readers) {
+			thread.join();
+		}
+
+		assert(!numErrors);
+		assert(publisher.getNumPublished() + publisher.getNumSkipped() == numMessages);
+
+		MOHPC_LOG(Log, "%llu snapshots published (%llu skipped) in %lf time, %zu reads",
+			(unsigned long long)publisher.getNumPublished(),
+			(unsigned long long)publisher.getNumSkipped(),
+			std::chrono::duration<double>(end - start).count(),
+			numReads.load()
+		);
+	}
+};
+static CSnapshotPublisherTest unitTest;
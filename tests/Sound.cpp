@@ -0,0 +1,143 @@
+#include <MOHPC/Managers/AssetManager.h>
+#include <MOHPC/Managers/FileManager.h>
+#include <MOHPC/Formats/MP3Decoder.h>
+#include <MOHPC/Formats/Sound.h>
+#include <MOHPC/Log.h>
+#include "UnitTest.h"
+
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <string.h>
+#include <vector>
+
+#define MOHPC_LOG_NAMESPACE "test_sound"
+
+class CSoundTest : public IUnitTest
+{
+public:
+	virtual const char* name() override
+	{
+		return "Sound";
+	}
+
+	virtual void run(const MOHPC::AssetManagerPtr& AM) override
+	{
+		using namespace MOHPC;
+
+		std::vector<std::string> fileNames;
+		std::vector<std::string> files;
+
+		FileEntryList entries = AM->GetFileManager()->ListFilteredFiles("/sound/dialogue", "mp3", true, false);
+		for (size_t i = 0; i < entries.GetNumFiles(); ++i)
+		{
+			FilePtr file = AM->GetFileManager()->OpenFile(entries.GetFileEntry(i)->GetStr().c_str());
+			if (!file) {
+				continue;
+			}
+
+			void* buffer;
+			const size_t length = (size_t)file->ReadBuffer(&buffer);
+			fileNames.push_back(entries.GetFileEntry(i)->GetStr().c_str());
+			files.emplace_back((const char*)buffer, length);
+		}
+
+		if (files.empty())
+		{
+			MOHPC_LOG(Warning, "no dialog found");
+			return;
+		}
+
+		benchmarkDecode(files);
+		testAsset(AM, fileNames[0], files[0]);
+	}
+
+private:
+	void benchmarkDecode(const std::vector<std::string>& files)
+	{
+		using namespace MOHPC;
+
+		static constexpr size_t chunkSize = 1024;
+
+		double wholeDuration = 0;
+		double streamDuration = 0;
+		double audioDuration = 0;
+		size_t numBytes = 0;
+
+		std::vector<int16_t> whole;
+		std::vector<int16_t> streamed;
+		int16_t chunk[chunkSize * 2];
+
+		for (const std::string& file : files)
+		{
+			mp3Info_t info;
+			if (!MP3Decoder::GetInfo(file.data(), file.size(), info)) {
+				continue;
+			}
+
+			// whole file into one buffer sized from the headers
+			auto start = std::chrono::system_clock().now();
+			MP3Decoder wholeDecoder(file.data(), file.size());
+			wholeDecoder.prepare();
+			whole.resize(info.numSampleFrames * wholeDecoder.getNumChannels());
+			const size_t numSampleFrames = wholeDecoder.decode(whole.data(), info.numSampleFrames);
+			auto end = std::chrono::system_clock().now();
+			wholeDuration += std::chrono::duration<double>(end - start).count();
+
+			assert(numSampleFrames <= info.numSampleFrames);
+			assert(wholeDecoder.getNumChannels() <= 2);
+
+			// small chunks must give the same samples
+			start = std::chrono::system_clock().now();
+			MP3Decoder streamDecoder(file.data(), file.size());
+			streamDecoder.prepare();
+			streamed.clear();
+
+			size_t numDecoded;
+			while ((numDecoded = streamDecoder.decode(chunk, chunkSize)) != 0) {
+				streamed.insert(streamed.end(), chunk, chunk + numDecoded * streamDecoder.getNumChannels());
+			}
+			end = std::chrono::system_clock().now();
+			streamDuration += std::chrono::duration<double>(end - start).count();
+
+			assert(streamDecoder.isFinished());
+			assert(streamed.size() == numSampleFrames * wholeDecoder.getNumChannels());
+			assert(!memcmp(streamed.data(), whole.data(), streamed.size() * sizeof(int16_t)));
+
+			audioDuration += (double)numSampleFrames / wholeDecoder.getSampleRate();
+			numBytes += file.size();
+		}
+
+		MOHPC_LOG(Log, "%zu dialogs (%zu bytes, %lf seconds of audio) decoded in %lf time (whole file), %lf time (chunks of %zu)",
+			files.size(),
+			numBytes,
+			audioDuration,
+			wholeDuration,
+			streamDuration,
+			chunkSize
+		);
+	}
+
+	void testAsset(const MOHPC::AssetManagerPtr& AM, const std::string& fileName, const std::string& file)
+	{
+		using namespace MOHPC;
+
+		SoundPtr sound = AM->LoadAsset<Sound>(fileName.c_str());
+		assert(sound);
+
+		mp3Info_t info;
+		MP3Decoder::GetInfo(file.data(), file.size(), info);
+
+		// the asset is a wave file
+		const uint8_t* data = sound->GetData();
+		assert(sound->GetDataLength() >= 44);
+		assert(!memcmp(data, "RIFF", 4));
+		assert(!memcmp(data + 8, "WAVEfmt ", 8));
+		assert(!memcmp(data + 36, "data", 4));
+
+		const uint32_t pcmBytes = data[40] | (data[41] << 8) | (data[42] << 16) | (data[43] << 24);
+		assert(sound->GetDataLength() == 44 + pcmBytes);
+		assert(pcmBytes <= info.numSampleFrames * info.numChannels * sizeof(int16_t));
+	}
+};
+static CSoundTest unitTest;